@@ -0,0 +1,187 @@
+// Copyright (c) DeFi Blockchain Developers
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#include <blockprefetcher.h>
+#include <chain.h>
+#include <util/system.h>
+#include <util/time.h>
+#include <validation.h>
+
+std::unique_ptr<CBlockPrefetcher> g_blockprefetcher;
+
+CBlockPrefetcher::CBlockPrefetcher(const Consensus::Params& consensus_, int threadCount) : consensus(consensus_)
+{
+    stats.threads = threadCount;
+    for (int i = 0; i < threadCount; ++i) {
+        threads.emplace_back([this, i]() {
+            TraceThread(strprintf("prefetch.%i", i).c_str(), [this]() { ThreadLoad(); });
+        });
+    }
+}
+
+CBlockPrefetcher::~CBlockPrefetcher()
+{
+    Stop();
+}
+
+void CBlockPrefetcher::Interrupt()
+{
+    LOCK(cs);
+    interrupted = true;
+    cond.notify_all();
+}
+
+void CBlockPrefetcher::Stop()
+{
+    Interrupt();
+    for (auto& thread : threads) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+
+    LOCK(cs);
+    entries.clear();
+    queue.clear();
+}
+
+void CBlockPrefetcher::Prefetch(const CBlockIndex* tip, int height)
+{
+    if (!tip || tip->nHeight <= height) {
+        return;
+    }
+    const auto top = std::min(tip->nHeight, height + BLOCK_PREFETCH_DEPTH);
+
+    LOCK(cs);
+    if (interrupted) {
+        return;
+    }
+
+    // forget about the blocks of another chain
+    for (auto it = entries.begin(); it != entries.end();) {
+        const auto& entry = it->second;
+        if (!entry.loading && (entry.height <= height || entry.height > top || tip->GetAncestor(entry.height)->GetBlockHash() != it->first)) {
+            queue.erase({entry.height, it->first});
+            it = entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    bool added{false};
+    for (auto pindex = tip->GetAncestor(top); pindex && pindex->nHeight > height; pindex = pindex->pprev) {
+        if (!(pindex->nStatus & BLOCK_HAVE_DATA) || pindex->GetBlockHash() == consensus.hashGenesisBlock) {
+            continue;
+        }
+        const auto& hash = pindex->GetBlockHash();
+        if (entries.emplace(hash, Entry{pindex->nHeight, pindex->GetBlockPos(), pindex->minterKeyID}).second) {
+            queue.emplace(pindex->nHeight, hash);
+            added = true;
+        }
+    }
+    if (added) {
+        cond.notify_all();
+    }
+}
+
+std::shared_ptr<const CPrefetchedBlock> CBlockPrefetcher::Take(const CBlockIndex* pindex)
+{
+    const auto& hash = pindex->GetBlockHash();
+
+    WAIT_LOCK(cs, lock);
+    auto it = entries.find(hash);
+    if (it == entries.end()) {
+        ++stats.misses;
+        EraseUpTo(pindex->nHeight);
+        return {};
+    }
+
+    if (it->second.ready) {
+        ++stats.hits;
+    } else {
+        // entries being waited for are only erased here, so the iterator stays valid
+        const auto start = GetTimeMicros();
+        while (!it->second.ready && !interrupted) {
+            cond.wait(lock);
+        }
+        stats.waitTime += GetTimeMicros() - start;
+        ++stats.waits;
+    }
+
+    auto block = it->second.block;
+    if (block) {
+        stats.loadTime += it->second.loadTime;
+    } else {
+        ++stats.misses;
+    }
+    EraseUpTo(pindex->nHeight);
+    return block;
+}
+
+CBlockPrefetcher::Stats CBlockPrefetcher::GetStats() const
+{
+    LOCK(cs);
+    auto result = stats;
+    result.pending = entries.size();
+    return result;
+}
+
+void CBlockPrefetcher::EraseUpTo(int height)
+{
+    for (auto it = entries.begin(); it != entries.end();) {
+        const auto& entry = it->second;
+        if (!entry.loading && entry.height <= height) {
+            queue.erase({entry.height, it->first});
+            it = entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void CBlockPrefetcher::ThreadLoad()
+{
+    while (true) {
+        uint256 hash;
+        Entry entry;
+        {
+            WAIT_LOCK(cs, lock);
+            while (!interrupted && queue.empty()) {
+                cond.wait(lock);
+            }
+            if (interrupted) {
+                return;
+            }
+            hash = queue.begin()->second;
+            queue.erase(queue.begin());
+            auto& queued = entries.at(hash);
+            queued.loading = true;
+            entry = queued;
+        }
+
+        const auto start = GetTimeMicros();
+        std::shared_ptr<CPrefetchedBlock> prefetched;
+        auto block = std::make_shared<CBlock>();
+        if (ReadBlockFromDisk(*block, entry.pos, hash, entry.minterKeyID)) {
+            prefetched = std::make_shared<CPrefetchedBlock>();
+            prefetched->customTxs.reserve(block->vtx.size());
+            for (const auto& tx : block->vtx) {
+                // coinbase txs are not applied past genesis
+                prefetched->customTxs.push_back(tx->IsCoinBase() ? CCustomTxParsed{} : ParseCustomTx(*tx, consensus, entry.height));
+            }
+            prefetched->block = std::move(block);
+        }
+        const auto loadTime = GetTimeMicros() - start;
+
+        LOCK(cs);
+        auto it = entries.find(hash);
+        if (it != entries.end()) {
+            it->second.loading = false;
+            it->second.ready = true;
+            it->second.block = std::move(prefetched);
+            it->second.loadTime = loadTime;
+        }
+        cond.notify_all();
+    }
+}
@@ -0,0 +1,97 @@
+// Copyright (c) DeFi Blockchain Developers
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef DEFI_BLOCKPREFETCHER_H
+#define DEFI_BLOCKPREFETCHER_H
+
+#include <flatfile.h>
+#include <masternodes/mn_checks.h>
+#include <pubkey.h>
+#include <primitives/block.h>
+#include <sync.h>
+#include <uint256.h>
+
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <set>
+#include <thread>
+#include <vector>
+
+class CBlockIndex;
+
+extern WaitTimedRecursiveMutex cs_main;
+
+/** Default for -blockprefetch, threads reading blocks ahead of connecting them */
+static const int DEFAULT_BLOCK_PREFETCH_THREADS = 2;
+static const int MAX_BLOCK_PREFETCH_THREADS = 16;
+/** Blocks read ahead of the one being connected at most */
+static const int BLOCK_PREFETCH_DEPTH = 32;
+
+/** A block read from disk with its custom txs parsed, by position in the block */
+struct CPrefetchedBlock {
+    std::shared_ptr<const CBlock> block;
+    std::vector<CCustomTxParsed> customTxs;
+};
+
+/**
+ * Reads, deserializes and parses the custom txs of the blocks about to be connected
+ * on threads of its own, so that connecting a long run of blocks, as on reindex or
+ * initial download, doesn't stall on the disk. Only blocks of the chain being
+ * connected are read, at most BLOCK_PREFETCH_DEPTH ahead of the one connected.
+ */
+class CBlockPrefetcher
+{
+public:
+    struct Stats {
+        int threads{0};
+        size_t pending{0}; // blocks queued or ready
+        uint64_t hits{0}; // blocks taken ready
+        uint64_t waits{0}; // blocks taken while still being read
+        uint64_t misses{0}; // blocks read by the caller
+        int64_t loadTime{0}; // microseconds spent reading and parsing the blocks taken
+        int64_t waitTime{0}; // microseconds the caller waited for them
+    };
+
+    CBlockPrefetcher(const Consensus::Params& consensus_, int threads);
+    ~CBlockPrefetcher();
+
+    void Interrupt();
+    void Stop();
+
+    /** Queues the blocks of the chain of tip after height */
+    void Prefetch(const CBlockIndex* tip, int height) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+    /** The block if it was queued, waiting for it to be read, null if the caller has to read it */
+    std::shared_ptr<const CPrefetchedBlock> Take(const CBlockIndex* pindex);
+
+    Stats GetStats() const;
+
+private:
+    struct Entry {
+        int height;
+        FlatFilePos pos;
+        CKeyID minterKeyID;
+        bool loading{false};
+        bool ready{false};
+        std::shared_ptr<const CPrefetchedBlock> block; // null if reading failed
+        int64_t loadTime{0};
+    };
+
+    void ThreadLoad();
+    void EraseUpTo(int height) EXCLUSIVE_LOCKS_REQUIRED(cs);
+
+    const Consensus::Params& consensus;
+
+    mutable Mutex cs;
+    std::condition_variable cond;
+    std::map<uint256, Entry> entries GUARDED_BY(cs);
+    std::set<std::pair<int, uint256>> queue GUARDED_BY(cs); // lowest height first
+    bool interrupted GUARDED_BY(cs){false};
+    Stats stats GUARDED_BY(cs);
+    std::vector<std::thread> threads;
+};
+
+extern std::unique_ptr<CBlockPrefetcher> g_blockprefetcher;
+
+#endif // DEFI_BLOCKPREFETCHER_H
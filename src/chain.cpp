@@ -4,6 +4,24 @@
 // file LICENSE or http://www.opensource.org/licenses/mit-license.php.
 
 #include <chain.h>
+#include <sync.h>
+
+static Mutex cs_recoveredMinterKeys;
+static std::vector<const CBlockIndex*> recoveredMinterKeys GUARDED_BY(cs_recoveredMinterKeys);
+
+void AddRecoveredMinterKey(const CBlockIndex* pindex)
+{
+    LOCK(cs_recoveredMinterKeys);
+    recoveredMinterKeys.push_back(pindex);
+}
+
+std::vector<const CBlockIndex*> TakeRecoveredMinterKeys()
+{
+    std::vector<const CBlockIndex*> entries;
+    LOCK(cs_recoveredMinterKeys);
+    entries.swap(recoveredMinterKeys);
+    return entries;
+}
 
 /**
  * CChain implementation
@@ -134,8 +134,18 @@ enum BlockStatus: uint32_t {
     BLOCK_FAILED_MASK        =   BLOCK_FAILED_VALID | BLOCK_FAILED_CHILD,
 
     BLOCK_OPT_WITNESS       =   128, //!< block data in blk*.data was received with a witness-enforcing client
+
+    BLOCK_HAVE_MINTER_KEY   =   256, //!< (disk only) block index record holds the minter key recovered from sig
 };
 
+class CBlockIndex;
+
+/** Remember an entry loaded without its minter key once the key got recovered,
+ *  so that the next write of the block index saves it */
+void AddRecoveredMinterKey(const CBlockIndex* pindex);
+/** Take the entries remembered by AddRecoveredMinterKey */
+std::vector<const CBlockIndex*> TakeRecoveredMinterKeys();
+
 /** The block chain is a tree shaped structure starting with the
  * genesis block at the root, with each block potentially having multiple
  * candidates to be the next block. A blockindex may have multiple pprev pointing
@@ -192,7 +202,7 @@ public:
     uint256 stakeModifier; // hash modifier for proof-of-stake
     std::vector<unsigned char> sig;
 
-    // memory only
+    // recovered from sig, on disk only in records with BLOCK_HAVE_MINTER_KEY
     mutable CKeyID minterKeyID;
 
     //! (memory only) Sequential id assigned to distinguish order in which blocks are received.
@@ -279,6 +289,7 @@ public:
         block.deprecatedHeight = deprecatedHeight;
         block.mintedBlocks   = mintedBlocks;
         block.sig            = sig;
+        block.SetMinterKey(minterKeyID);
         return block;
     }
 
@@ -287,6 +298,9 @@ public:
         if (minterKeyID.IsNull()) {
             if (!GetBlockHeader().ExtractMinterKey(minterKeyID) && pprev)
                 throw std::runtime_error("Wrong minter public key, data is corrupt");
+            // only entries read from disk come without the key, see CBlockIndex(const CBlockHeader&)
+            if (!minterKeyID.IsNull())
+                AddRecoveredMinterKey(this);
         }
         return minterKeyID;
     }
@@ -397,6 +411,9 @@ public:
 
     explicit CDiskBlockIndex(const CBlockIndex* pindex) : CBlockIndex(*pindex) {
         hashPrev = (pprev ? pprev->GetBlockHash() : uint256());
+        if (!minterKeyID.IsNull()) {
+            nStatus |= BLOCK_HAVE_MINTER_KEY;
+        }
     }
 
     ADD_SERIALIZE_METHODS;
@@ -427,6 +444,10 @@ public:
         READWRITE(deprecatedHeight);
         READWRITE(mintedBlocks);
         READWRITE(sig);
+        // saves recovering the key on every restart. Older records go without it, and so
+        // do records rewritten by older versions, which keep the flag but drop the key.
+        if ((nStatus & BLOCK_HAVE_MINTER_KEY) && !(ser_action.ForRead() && s.empty()))
+            READWRITE(minterKeyID);
     }
 
     uint256 GetBlockHash() const
@@ -0,0 +1,108 @@
+// Copyright (c) DeFi Blockchain Developers
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#include <connectstats.h>
+#include <logging.h>
+
+CBlockConnectStatsCollector g_connectStats;
+
+UniValue CConnectPhaseStats::ToJSON() const
+{
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("time", time);
+    obj.pushKV("reads", reads);
+    obj.pushKV("writes", writes);
+    return obj;
+}
+
+CConnectPhaseStats& CBlockConnectStats::Phase(const std::string& name)
+{
+    for (auto& phase : phases) {
+        if (phase.first == name) {
+            return phase.second;
+        }
+    }
+    phases.emplace_back(name, CConnectPhaseStats{});
+    return phases.back().second;
+}
+
+UniValue CBlockConnectStats::ToJSON() const
+{
+    UniValue phasesObj(UniValue::VOBJ);
+    for (const auto& [name, phase] : phases) {
+        phasesObj.pushKV(name, phase.ToJSON());
+    }
+
+    UniValue customTxsObj(UniValue::VOBJ);
+    for (const auto& [type, txStats] : customTxs) {
+        auto txObj = txStats.ToJSON();
+        txObj.pushKV("count", static_cast<uint64_t>(txStats.count));
+        txObj.pushKV("undoSize", txStats.undoSize);
+        customTxsObj.pushKV(type, txObj);
+    }
+
+    UniValue undoObj(UniValue::VOBJ);
+    undoObj.pushKV("entries", static_cast<uint64_t>(undoEntries));
+    undoObj.pushKV("size", static_cast<uint64_t>(undoSize));
+    undoObj.pushKV("coinsSize", static_cast<uint64_t>(coinsUndoSize));
+
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("height", height);
+    obj.pushKV("hash", hash.GetHex());
+    obj.pushKV("timestamp", timestamp);
+    obj.pushKV("time", time);
+    obj.pushKV("undo", undoObj);
+    obj.pushKV("phases", phasesObj);
+    obj.pushKV("customTxs", customTxsObj);
+    return obj;
+}
+
+void CConnectSample::AddTo(CConnectPhaseStats& stats) const
+{
+    stats.time += GetTimeMicros() - time;
+    stats.reads += g_storageOpCounters.reads - ops.reads;
+    stats.writes += g_storageOpCounters.writes - ops.writes;
+    ++stats.count;
+}
+
+void CConnectPhases::Start(const std::string& name)
+{
+    if (!stats) {
+        return;
+    }
+    Stop();
+    current = &stats->Phase(name);
+    sample = {};
+}
+
+void CConnectPhases::Stop()
+{
+    if (current) {
+        sample.AddTo(*current);
+        current = nullptr;
+    }
+}
+
+void CBlockConnectStatsCollector::Add(CBlockConnectStats&& stats)
+{
+    if (logging) {
+        LogPrintf("connectstats: %s\n", stats.ToJSON().write());
+    }
+
+    LOCK(cs);
+    history.push_back(std::move(stats));
+}
+
+std::vector<CBlockConnectStats> CBlockConnectStatsCollector::Get(int minHeight, int maxHeight) const
+{
+    std::vector<CBlockConnectStats> result;
+
+    LOCK(cs);
+    for (const auto& stats : history) {
+        if (stats.height >= minHeight && stats.height <= maxHeight) {
+            result.push_back(stats);
+        }
+    }
+    return result;
+}
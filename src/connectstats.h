@@ -0,0 +1,103 @@
+// Copyright (c) DeFi Blockchain Developers
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef DEFI_CONNECTSTATS_H
+#define DEFI_CONNECTSTATS_H
+
+#include <flushablestorage.h>
+#include <sync.h>
+#include <uint256.h>
+#include <univalue.h>
+#include <util/time.h>
+
+#include <atomic>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <boost/circular_buffer.hpp>
+
+static const bool DEFAULT_CONNECT_STATS = true;
+static const bool DEFAULT_CONNECT_STATS_LOG = false;
+static const size_t CONNECT_STATS_HISTORY_SIZE = 1000;
+
+struct CConnectPhaseStats {
+    int64_t time{0}; // microseconds
+    uint64_t reads{0};
+    uint64_t writes{0};
+    uint32_t count{0};
+    uint64_t undoSize{0}; // of custom txs
+
+    UniValue ToJSON() const;
+};
+
+/** Timings and storage key operations of one connected block. */
+struct CBlockConnectStats {
+    int height{0};
+    uint256 hash;
+    int64_t timestamp{0};
+    int64_t time{0}; // microseconds, from reading the block to the end of ConnectTip
+    size_t undoEntries{0}; // custom state undo of the block-level events
+    size_t undoSize{0};
+    size_t coinsUndoSize{0}; // 0 if it was on disk already
+    std::vector<std::pair<std::string, CConnectPhaseStats>> phases; // in order of execution
+    std::map<std::string, CConnectPhaseStats> customTxs; // by custom tx type
+
+    CBlockConnectStats(int height, const uint256& hash) : height(height), hash(hash), timestamp(GetSystemTimeInSeconds()) {}
+
+    CConnectPhaseStats& Phase(const std::string& name);
+    UniValue ToJSON() const;
+};
+
+/** Time and storage key operations of the calling thread since construction. */
+struct CConnectSample {
+    int64_t time;
+    CStorageOpCounters ops;
+
+    CConnectSample() : time(GetTimeMicros()), ops(g_storageOpCounters) {}
+
+    void AddTo(CConnectPhaseStats& stats) const;
+};
+
+/**
+ * Measures consecutive phases of a block, starting a phase ends the previous one.
+ * Does nothing without stats to record into.
+ */
+class CConnectPhases {
+    CBlockConnectStats* stats;
+    CConnectPhaseStats* current{nullptr};
+    CConnectSample sample;
+
+public:
+    explicit CConnectPhases(CBlockConnectStats* stats) : stats(stats) {}
+    ~CConnectPhases() { Stop(); }
+
+    void Start(const std::string& name);
+    void Stop();
+};
+
+/**
+ * Keeps the stats of the most recently connected blocks.
+ */
+class CBlockConnectStatsCollector {
+    mutable Mutex cs;
+    boost::circular_buffer<CBlockConnectStats> history GUARDED_BY(cs);
+    std::atomic_bool active{DEFAULT_CONNECT_STATS};
+    std::atomic_bool logging{DEFAULT_CONNECT_STATS_LOG};
+
+public:
+    CBlockConnectStatsCollector() : history(CONNECT_STATS_HISTORY_SIZE) {}
+
+    bool IsActive() const { return active; }
+    void SetActive(bool isActive) { active = isActive; }
+    void SetLogging(bool isLogging) { logging = isLogging; }
+
+    void Add(CBlockConnectStats&& stats);
+    /// Stats of the blocks within the height range, oldest first
+    std::vector<CBlockConnectStats> Get(int minHeight, int maxHeight) const;
+};
+
+extern CBlockConnectStatsCollector g_connectStats;
+
+#endif // DEFI_CONNECTSTATS_H
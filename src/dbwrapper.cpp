@@ -97,21 +97,103 @@ static void SetMaxOpenFiles(leveldb::Options *options) {
              options->max_open_files, default_open_files);
 }
 
-static leveldb::Options GetOptions(size_t nCacheSize)
+static Mutex cs_dbwrappers;
+static std::vector<const CDBWrapper*> g_dbwrappers GUARDED_BY(cs_dbwrappers);
+
+static size_t CeilPowerOfTwo(size_t v)
+{
+    v--;
+    for (const size_t i: {1, 2, 4, 6, 16}) v |= v >> i;
+    v++;
+    return v;
+}
+
+CDBOptions::CDBOptions(size_t nCacheSize)
+    : blockCache(nCacheSize / 2),
+      writeBuffer(CeilPowerOfTwo(std::min(static_cast<size_t>(64) << 20, nCacheSize / 4))), // Max of 64mb -more is not useful
+      maxFileSize(0),
+      bloomBits(16),
+      compression(false)
+{
+}
+
+static bool ParseDBOptionArg(const std::string& arg, std::string& name, std::string& setting, int64_t& value, std::string& error)
+{
+    const auto dot = arg.find('.');
+    const auto eq = arg.find('=');
+    if (dot == std::string::npos || eq == std::string::npos || dot == 0 || dot > eq) {
+        error = strprintf("Invalid -dboption '%s', expected <db>.<setting>=<value>", arg);
+        return false;
+    }
+    name = arg.substr(0, dot);
+    setting = arg.substr(dot + 1, eq - dot - 1);
+    if (!ParseInt64(arg.substr(eq + 1), &value) || value < 0) {
+        error = strprintf("Invalid value in -dboption '%s'", arg);
+        return false;
+    }
+    if (setting != "blockcache" && setting != "writebuffer" && setting != "maxfilesize"
+    && setting != "bloombits" && setting != "compression") {
+        error = strprintf("Unknown setting in -dboption '%s', expected one of blockcache, writebuffer, maxfilesize, bloombits, compression", arg);
+        return false;
+    }
+    return true;
+}
+
+bool CheckDBOptionArgs(std::string& error)
+{
+    for (const auto& arg : gArgs.GetArgs("-dboption")) {
+        if (arg.empty()) {
+            continue;
+        }
+        std::string name, setting;
+        int64_t value;
+        if (!ParseDBOptionArg(arg, name, setting, value, error)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool CDBOptions::ApplyArgs(const std::string& name, std::string& error)
+{
+    for (const auto& arg : gArgs.GetArgs("-dboption")) {
+        if (arg.empty()) {
+            continue;
+        }
+        std::string argName, setting;
+        int64_t value;
+        if (!ParseDBOptionArg(arg, argName, setting, value, error)) {
+            return false;
+        }
+        if (argName != name) {
+            continue;
+        }
+        // sizes are given in MiB
+        if (setting == "blockcache") {
+            blockCache = static_cast<size_t>(value) << 20;
+        } else if (setting == "writebuffer") {
+            writeBuffer = static_cast<size_t>(value) << 20;
+        } else if (setting == "maxfilesize") {
+            maxFileSize = static_cast<size_t>(value) << 20;
+        } else if (setting == "bloombits") {
+            bloomBits = static_cast<int>(value);
+        } else if (setting == "compression") {
+            compression = value != 0;
+        }
+    }
+    return true;
+}
+
+static leveldb::Options GetOptions(const CDBOptions& dbOptions)
 {
-    const auto ceil_power_of_two = [](size_t v) {
-        v--;
-        for (const size_t i: {1, 2, 4, 6, 16}) v |= v >> i;
-        v++;
-        return v;
-    };
-    
     leveldb::Options options;
-    options.block_cache = leveldb::NewLRUCache(nCacheSize / 2);
-    options.write_buffer_size = ceil_power_of_two(std::min(static_cast<size_t>(64)
-     << 20, nCacheSize / 4)); // Max of 64mb -more is not useful
-    options.filter_policy = leveldb::NewBloomFilterPolicy(16);
-    options.compression = leveldb::kNoCompression;
+    options.block_cache = leveldb::NewLRUCache(dbOptions.blockCache);
+    options.write_buffer_size = dbOptions.writeBuffer;
+    if (dbOptions.maxFileSize) {
+        options.max_file_size = dbOptions.maxFileSize;
+    }
+    options.filter_policy = dbOptions.bloomBits ? leveldb::NewBloomFilterPolicy(dbOptions.bloomBits) : nullptr;
+    options.compression = dbOptions.compression ? leveldb::kSnappyCompression : leveldb::kNoCompression;
     options.info_log = new CDefiLevelDBLogger();
     if (leveldb::kMajorVersion > 1 || (leveldb::kMajorVersion == 1 && leveldb::kMinorVersion >= 16)) {
         // LevelDB versions before 1.16 consider short writes to be corruption. Only trigger error
@@ -122,15 +204,22 @@ static leveldb::Options GetOptions(size_t nCacheSize)
     return options;
 }
 
-CDBWrapper::CDBWrapper(const fs::path& path, size_t nCacheSize, bool fMemory, bool fWipe, bool obfuscate)
-    : m_name{path.stem().string()}
+CDBWrapper::CDBWrapper(const fs::path& path, const CDBOptions& dbOptions, bool fMemory, bool fWipe, bool obfuscate)
+    : m_name{path.stem().string()}, m_db_options{dbOptions}
 {
+    std::string error;
+    if (!m_db_options.ApplyArgs(m_name, error)) {
+        throw dbwrapper_error(error);
+    }
+    LogPrint(BCLog::LEVELDB, "LevelDB options of %s: blockcache=%u writebuffer=%u maxfilesize=%u bloombits=%d compression=%d\n",
+             m_name, m_db_options.blockCache, m_db_options.writeBuffer, m_db_options.maxFileSize, m_db_options.bloomBits, m_db_options.compression);
+
     penv = nullptr;
     readoptions.verify_checksums = true;
     iteroptions.verify_checksums = true;
     iteroptions.fill_cache = false;
     syncoptions.sync = true;
-    options = GetOptions(nCacheSize);
+    options = GetOptions(m_db_options);
     options.create_if_missing = true;
     if (fMemory) {
         penv = leveldb::NewMemEnv(leveldb::Env::Default());
@@ -172,10 +261,17 @@ CDBWrapper::CDBWrapper(const fs::path& path, size_t nCacheSize, bool fMemory, bo
     }
 
     LogPrintf("Using obfuscation key for %s: %s\n", path.string(), HexStr(obfuscate_key));
+
+    LOCK(cs_dbwrappers);
+    g_dbwrappers.push_back(this);
 }
 
 CDBWrapper::~CDBWrapper()
 {
+    {
+        LOCK(cs_dbwrappers);
+        g_dbwrappers.erase(std::remove(g_dbwrappers.begin(), g_dbwrappers.end(), this), g_dbwrappers.end());
+    }
     delete pdb;
     pdb = nullptr;
     delete options.filter_policy;
@@ -214,6 +310,37 @@ size_t CDBWrapper::DynamicMemoryUsage() const {
     return stoul(memory);
 }
 
+bool CDBWrapper::GetProperty(const std::string& property, std::string& value) const
+{
+    return pdb->GetProperty(property, &value);
+}
+
+std::vector<uint64_t> CDBWrapper::EstimatePrefixSizes() const
+{
+    // the range of a prefix ends where the next prefix starts, the last one ends with a longer key
+    std::vector<std::string> bounds;
+    for (int prefix = 0; prefix <= 0xff; ++prefix) {
+        bounds.emplace_back(1, static_cast<char>(prefix));
+    }
+    bounds.emplace_back(2, static_cast<char>(0xff));
+
+    std::vector<leveldb::Range> ranges;
+    for (size_t i = 0; i < bounds.size() - 1; ++i) {
+        ranges.emplace_back(bounds[i], bounds[i + 1]);
+    }
+    std::vector<uint64_t> sizes(ranges.size());
+    pdb->GetApproximateSizes(ranges.data(), ranges.size(), sizes.data());
+    return sizes;
+}
+
+void ForEachDBWrapper(const std::function<void(const CDBWrapper&)>& fn)
+{
+    LOCK(cs_dbwrappers);
+    for (const auto db : g_dbwrappers) {
+        fn(*db);
+    }
+}
+
 // Prefixed with null character to avoid collisions with other keys
 //
 // We must use a string constructor which specifies length so that we copy
@@ -244,6 +371,7 @@ bool CDBWrapper::IsEmpty()
 CDBIterator::~CDBIterator() { delete piter; }
 bool CDBIterator::Valid() const { return piter->Valid(); }
 void CDBIterator::SeekToFirst() { piter->SeekToFirst(); }
+void CDBIterator::SeekToLast() { piter->SeekToLast(); }
 void CDBIterator::Next() { piter->Next(); }
 void CDBIterator::Prev() { piter->Prev(); }
 
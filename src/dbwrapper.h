@@ -13,6 +13,8 @@
 #include <util/strencodings.h>
 #include <version.h>
 
+#include <functional>
+
 #include <leveldb/db.h>
 #include <leveldb/write_batch.h>
 
@@ -27,6 +29,26 @@ public:
 
 class CDBWrapper;
 
+/**
+ * LevelDB tuning of a database. Built from a cache size it splits the cache the
+ * way all databases used to, the fields can then be adjusted per database.
+ */
+struct CDBOptions {
+    size_t blockCache;  //!< bytes of LRU cache for uncompressed blocks
+    size_t writeBuffer; //!< bytes of memtable before it is written to a level-0 file
+    size_t maxFileSize; //!< bytes per table file, 0 keeps LevelDB's default
+    int bloomBits;      //!< bits per key of the bloom filter, 0 disables it
+    bool compression;   //!< snappy compression of blocks, if LevelDB is built with snappy
+
+    CDBOptions(size_t nCacheSize);
+
+    /** Apply the -dboption=<db>.<setting>=<value> arguments given for the named database */
+    bool ApplyArgs(const std::string& name, std::string& error);
+};
+
+/** Check the syntax of all -dboption arguments */
+bool CheckDBOptionArgs(std::string& error);
+
 /** These should be considered an implementation detail of the specific database.
  */
 namespace dbwrapper_private {
@@ -148,6 +170,7 @@ public:
     bool Valid() const;
 
     void SeekToFirst();
+    void SeekToLast();
 
     template<typename K> void Seek(const K& key) {
         CDataStream ssKey(SER_DISK, CLIENT_VERSION);
@@ -232,6 +255,9 @@ private:
     //! the name of this database
     std::string m_name;
 
+    //! the tuning this database got opened with
+    CDBOptions m_db_options;
+
     //! a key used for optional XOR-obfuscation of the database
     std::vector<unsigned char> obfuscate_key;
 
@@ -246,20 +272,21 @@ private:
 public:
     /**
      * @param[in] path        Location in the filesystem where leveldb data will be stored.
-     * @param[in] nCacheSize  Configures various leveldb cache settings.
+     * @param[in] dbOptions   Configures various leveldb cache settings, -dboption
+     *                        arguments for this database take precedence.
      * @param[in] fMemory     If true, use leveldb's memory environment.
      * @param[in] fWipe       If true, remove all existing data.
      * @param[in] obfuscate   If true, store data obfuscated via simple XOR. If false, XOR
      *                        with a zero'd byte array.
      */
-    CDBWrapper(const fs::path& path, size_t nCacheSize, bool fMemory = false, bool fWipe = false, bool obfuscate = false);
+    CDBWrapper(const fs::path& path, const CDBOptions& dbOptions, bool fMemory = false, bool fWipe = false, bool obfuscate = false);
     ~CDBWrapper();
 
     CDBWrapper(const CDBWrapper&) = delete;
     CDBWrapper& operator=(const CDBWrapper&) = delete;
 
     template <typename K, typename V>
-    bool Read(const K& key, V& value) const
+    bool Read(const K& key, V& value, const leveldb::Snapshot* snapshot = nullptr) const
     {
         CDataStream ssKey(SER_DISK, CLIENT_VERSION);
         ssKey.reserve(DBWRAPPER_PREALLOC_KEY_SIZE);
@@ -267,8 +294,10 @@ public:
         leveldb::Slice slKey(ssKey.data(), ssKey.size());
 //        leveldb::Slice slKey(SliceKey(key));
 
+        leveldb::ReadOptions options = readoptions;
+        options.snapshot = snapshot;
         std::string strValue;
-        leveldb::Status status = pdb->Get(readoptions, slKey, &strValue);
+        leveldb::Status status = pdb->Get(options, slKey, &strValue);
         if (!status.ok()) {
             if (status.IsNotFound())
                 return false;
@@ -294,7 +323,7 @@ public:
     }
 
     template <typename K>
-    bool Exists(const K& key) const
+    bool Exists(const K& key, const leveldb::Snapshot* snapshot = nullptr) const
     {
         CDataStream ssKey(SER_DISK, CLIENT_VERSION);
         ssKey.reserve(DBWRAPPER_PREALLOC_KEY_SIZE);
@@ -302,8 +331,10 @@ public:
         leveldb::Slice slKey(ssKey.data(), ssKey.size());
 //        leveldb::Slice slKey(SliceKey(key));
 
+        leveldb::ReadOptions options = readoptions;
+        options.snapshot = snapshot;
         std::string strValue;
-        leveldb::Status status = pdb->Get(readoptions, slKey, &strValue);
+        leveldb::Status status = pdb->Get(options, slKey, &strValue);
         if (!status.ok()) {
             if (status.IsNotFound())
                 return false;
@@ -326,6 +357,16 @@ public:
     // Get an estimate of LevelDB memory usage (in bytes).
     size_t DynamicMemoryUsage() const;
 
+    const std::string& GetName() const { return m_name; }
+
+    const CDBOptions& GetDBOptions() const { return m_db_options; }
+
+    // Get a LevelDB property such as "leveldb.stats", see leveldb/db.h.
+    bool GetProperty(const std::string& property, std::string& value) const;
+
+    // Approximate on-disk size of the keys starting with each byte, indexed by the byte.
+    std::vector<uint64_t> EstimatePrefixSizes() const;
+
     // not available for LevelDB; provide for compatibility with BDB
     bool Flush()
     {
@@ -343,6 +384,28 @@ public:
         return new CDBIterator(*this, pdb->NewIterator(iteroptions));
     }
 
+    /** Iterate over the database as of the given snapshot */
+    CDBIterator *NewIterator(const leveldb::Snapshot* snapshot) const
+    {
+        leveldb::ReadOptions options = iteroptions;
+        options.snapshot = snapshot;
+        return new CDBIterator(*this, pdb->NewIterator(options));
+    }
+
+    /**
+     * Consistent read view of the current contents of the database, for use with
+     * Read, Exists and NewIterator. Must be released with ReleaseSnapshot.
+     */
+    const leveldb::Snapshot* GetSnapshot() const
+    {
+        return pdb->GetSnapshot();
+    }
+
+    void ReleaseSnapshot(const leveldb::Snapshot* snapshot) const
+    {
+        pdb->ReleaseSnapshot(snapshot);
+    }
+
     /**
      * Return true if the database managed by this class contains no entries.
      */
@@ -381,4 +444,7 @@ public:
     }
 };
 
+/** Call fn for each open database, in order of opening. Databases can't close meanwhile. */
+void ForEachDBWrapper(const std::function<void(const CDBWrapper&)>& fn);
+
 #endif // DEFI_DBWRAPPER_H
@@ -5,9 +5,13 @@
 #ifndef DEFI_FLUSHABLESTORAGE_H
 #define DEFI_FLUSHABLESTORAGE_H
 
+#include <amount.h>
 #include <dbwrapper.h>
+#include <uint256.h>
+#include <array>
 #include <functional>
 #include <map>
+#include <set>
 #include <memusage.h>
 
 #include <optional>
@@ -38,11 +42,106 @@ static bool BytesToDbType(const TBytes& bytes, T& value) {
     return true;
 }
 
+// Keys of bounded size are encoded into a stack buffer byte for byte as the
+// serializer writes them, so the stored keys and their order stay the same.
+// maxSize is 0 for keys of unbounded size, those are serialized as before.
+template<typename T, typename = void>
+struct CKeyCodec {
+    static constexpr size_t maxSize = 0;
+};
+
+template<typename T>
+struct CKeyCodec<T, std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>>> {
+    static constexpr size_t maxSize = sizeof(T);
+    static constexpr size_t Encode(T value, unsigned char* out) {
+        auto n = static_cast<std::make_unsigned_t<T>>(value);
+        for (size_t i = 0; i < sizeof(T); ++i) {
+            out[i] = static_cast<unsigned char>(n >> (8 * i));
+        }
+        return sizeof(T);
+    }
+};
+
+template<>
+struct CKeyCodec<uint256> {
+    static constexpr size_t maxSize = 256 / 8;
+    static size_t Encode(const uint256& value, unsigned char* out) {
+        std::copy(value.begin(), value.end(), out);
+        return maxSize;
+    }
+};
+
+template<>
+struct CKeyCodec<DCT_ID> {
+    static constexpr size_t maxSize = (sizeof(uint32_t) * 8 + 6) / 7;
+    // VARINT, the most significant group first
+    static constexpr size_t Encode(DCT_ID id, unsigned char* out) {
+        unsigned char tmp[maxSize]{};
+        auto n = id.v;
+        size_t len = 0;
+        while (true) {
+            tmp[len] = (n & 0x7F) | (len ? 0x80 : 0x00);
+            if (n <= 0x7F) {
+                break;
+            }
+            n = (n >> 7) - 1;
+            ++len;
+        }
+        for (size_t i = 0; i <= len; ++i) {
+            out[i] = tmp[len - i];
+        }
+        return len + 1;
+    }
+};
+
+template<typename A, typename B>
+struct CKeyCodec<std::pair<A, B>, std::enable_if_t<CKeyCodec<A>::maxSize != 0 && CKeyCodec<B>::maxSize != 0>> {
+    static constexpr size_t maxSize = CKeyCodec<A>::maxSize + CKeyCodec<B>::maxSize;
+    static constexpr size_t Encode(const std::pair<A, B>& value, unsigned char* out) {
+        auto size = CKeyCodec<A>::Encode(value.first, out);
+        return size + CKeyCodec<B>::Encode(value.second, out + size);
+    }
+};
+
+// Key of prefix By encoded without allocating, as DbTypeToBytes(std::make_pair(By::prefix(), key))
+template<typename By, typename KeyType>
+class CStorageKey {
+    static_assert(CKeyCodec<KeyType>::maxSize != 0, "key size is unbounded");
+
+    std::array<unsigned char, 1 + CKeyCodec<KeyType>::maxSize> bytes{By::prefix()};
+    size_t size;
+
+public:
+    explicit CStorageKey(const KeyType& key) : size(1 + CKeyCodec<KeyType>::Encode(key, bytes.data() + 1)) {}
+
+    // The key in a buffer of the calling thread, valid until its next key of the type
+    const TBytes& Bytes() const {
+        static thread_local TBytes buffer;
+        buffer.assign(bytes.begin(), bytes.begin() + size);
+        return buffer;
+    }
+};
+
+// Whether the prefixes of keys kept in one storage are all different
+template<typename... By>
+constexpr bool UniqueStoragePrefixes() {
+    constexpr uint8_t prefixes[] = {By::prefix()...};
+    for (size_t i = 0; i < sizeof...(By); ++i) {
+        for (size_t j = i + 1; j < sizeof...(By); ++j) {
+            if (prefixes[i] == prefixes[j]) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
 // Key-Value storage iterator interface
 class CStorageKVIterator {
 public:
     virtual ~CStorageKVIterator() = default;
     virtual void Seek(const TBytes& key) = 0;
+    virtual void SeekToLast() = 0;
     virtual void Next() = 0;
     virtual void Prev() = 0;
     virtual bool Valid() = 0;
@@ -55,6 +154,7 @@ class CStorageKVEmptyIterator : public CStorageKVIterator {
 public:
     ~CStorageKVEmptyIterator() override = default;
     void Seek(const TBytes&) override {}
+    void SeekToLast() override {}
     void Next() override {}
     void Prev() override {}
     bool Valid() override { return false; }
@@ -74,6 +174,10 @@ public:
     virtual size_t SizeEstimate() const = 0;
     virtual void Discard() = 0;
     virtual bool Flush() = 0;
+    // Reclaim the space of erased keys within the range, if the storage supports it
+    virtual void Compact(const TBytes&, const TBytes&) {}
+    // Read-only copy of the flushed contents as of now, null if the storage can't make one
+    virtual std::unique_ptr<CStorageKV> Snapshot() const { return {}; }
 };
 
 // doesn't serialize/deserialize vector size
@@ -110,6 +214,9 @@ public:
     void Seek(const TBytes& key) override {
         it->Seek(refTBytes(key)); // lower_bound in fact
     }
+    void SeekToLast() override {
+        it->SeekToLast();
+    }
     void Next() override {
         it->Next();
     }
@@ -133,11 +240,49 @@ private:
     std::unique_ptr<CDBIterator> it;
 };
 
+// Read-only storage as of a LevelDB snapshot
+class CStorageLevelDBSnapshot : public CStorageKV {
+public:
+    explicit CStorageLevelDBSnapshot(const CDBWrapper& db_) : db(db_), snapshot(db.GetSnapshot()) {}
+    CStorageLevelDBSnapshot(const CStorageLevelDBSnapshot&) = delete;
+    ~CStorageLevelDBSnapshot() override {
+        db.ReleaseSnapshot(snapshot);
+    }
+
+    bool Exists(const TBytes& key) const override {
+        return db.Exists(refTBytes(key), snapshot);
+    }
+    bool Write(const TBytes&, const TBytes&) override {
+        return false;
+    }
+    bool Erase(const TBytes&) override {
+        return false;
+    }
+    bool Read(const TBytes& key, TBytes& value) const override {
+        auto rawVal = refTBytes(value);
+        return db.Read(refTBytes(key), rawVal, snapshot);
+    }
+    bool Flush() override {
+        return false;
+    }
+    void Discard() override {}
+    size_t SizeEstimate() const override {
+        return 0;
+    }
+    std::unique_ptr<CStorageKVIterator> NewIterator() override {
+        return std::make_unique<CStorageLevelDBIterator>(std::unique_ptr<CDBIterator>(db.NewIterator(snapshot)));
+    }
+
+private:
+    const CDBWrapper& db;
+    const leveldb::Snapshot* snapshot;
+};
+
 // LevelDB glue layer storage
 class CStorageLevelDB : public CStorageKV {
 public:
-    explicit CStorageLevelDB(const fs::path& dbName, std::size_t cacheSize, bool fMemory = false, bool fWipe = false)
-        : db{dbName, cacheSize, fMemory, fWipe}, batch(db) {}
+    explicit CStorageLevelDB(const fs::path& dbName, const CDBOptions& dbOptions, bool fMemory = false, bool fWipe = false)
+        : db{dbName, dbOptions, fMemory, fWipe}, batch(db) {}
     ~CStorageLevelDB() override = default;
 
     bool Exists(const TBytes& key) const override {
@@ -169,9 +314,12 @@ public:
     std::unique_ptr<CStorageKVIterator> NewIterator() override {
         return std::make_unique<CStorageLevelDBIterator>(std::unique_ptr<CDBIterator>(db.NewIterator()));
     }
-    void Compact(const TBytes& begin, const TBytes& end) {
+    void Compact(const TBytes& begin, const TBytes& end) override {
         db.CompactRange(refTBytes(begin), refTBytes(end));
     }
+    std::unique_ptr<CStorageKV> Snapshot() const override {
+        return std::make_unique<CStorageLevelDBSnapshot>(db);
+    }
     bool IsEmpty() {
         return db.IsEmpty();
     }
@@ -186,7 +334,7 @@ private:
 // Flushable Key-Value Storage Iterator
 class CFlushableStorageKVIterator : public CStorageKVIterator {
 public:
-    explicit CFlushableStorageKVIterator(std::unique_ptr<CStorageKVIterator>&& pIt, MapKV& map) : map(map), pIt(std::move(pIt)) {
+    explicit CFlushableStorageKVIterator(std::unique_ptr<CStorageKVIterator>&& pIt, const MapKV& map) : map(map), pIt(std::move(pIt)) {
         itState = Invalid;
     }
     CFlushableStorageKVIterator(const CFlushableStorageKVIterator&) = delete;
@@ -196,6 +344,11 @@ public:
         pIt->Seek(key);
         mIt = Advance(map.lower_bound(key), map.end(), std::greater<TBytes>{}, {});
     }
+    void SeekToLast() override {
+        pIt->SeekToLast();
+        auto end = Advance(map.rbegin(), map.rend(), std::less<TBytes>{}, {});
+        mIt = end == map.rend() ? map.begin() : std::prev(end.base());
+    }
     void Next() override {
         assert(Valid());
         mIt = Advance(mIt, map.end(), std::greater<TBytes>{}, Key());
@@ -280,11 +433,17 @@ public:
         return db.Exists(key);
     }
     bool Write(const TBytes& key, const TBytes& value) override {
-        changed[key] = value;
+        auto& change = changed[key] = value;
+        if (listener) {
+            listener(key, change);
+        }
         return true;
     }
     bool Erase(const TBytes& key) override {
-        changed[key] = {};
+        auto& change = changed[key] = {};
+        if (listener) {
+            listener(key, change);
+        }
         return true;
     }
     bool Read(const TBytes& key, TBytes& value) const override {
@@ -325,9 +484,355 @@ public:
         return changed;
     }
 
+    CStorageKV& GetParent() {
+        return db;
+    }
+    const CStorageKV& GetParent() const {
+        return db;
+    }
+
+    bool HasChanges(uint8_t prefix) const {
+        auto it = changed.lower_bound(TBytes{prefix});
+        return it != changed.end() && it->first[0] == prefix;
+    }
+
+    // Called with every write and erase, e.g. to keep an in-memory copy in sync
+    using Listener = std::function<void(const TBytes& key, const std::optional<TBytes>& value)>;
+    void SetListener(Listener listener_) {
+        listener = std::move(listener_);
+    }
+
 private:
     CStorageKV& db;
     MapKV changed;
+    Listener listener;
+};
+
+// Iterator over the union of storages that hold disjoint sets of keys
+class CStorageKVMergingIterator : public CStorageKVIterator {
+public:
+    explicit CStorageKVMergingIterator(std::vector<std::unique_ptr<CStorageKVIterator>>&& its) : its(std::move(its)) {}
+    CStorageKVMergingIterator(const CStorageKVMergingIterator&) = delete;
+    ~CStorageKVMergingIterator() override = default;
+
+    void Seek(const TBytes& key) override {
+        for (auto& it : its) {
+            it->Seek(key);
+        }
+        forward = true;
+        FindSmallest();
+    }
+    void SeekToLast() override {
+        for (auto& it : its) {
+            it->SeekToLast();
+        }
+        forward = false;
+        FindLargest();
+    }
+    void Next() override {
+        assert(Valid());
+        if (!forward) {
+            // the others are before the current key, move them after it
+            const auto key = current->Key();
+            for (auto& it : its) {
+                if (it.get() != current) {
+                    it->Seek(key);
+                }
+            }
+            forward = true;
+        }
+        current->Next();
+        FindSmallest();
+    }
+    void Prev() override {
+        assert(Valid());
+        if (forward) {
+            // the others are after the current key, move them before it
+            const auto key = current->Key();
+            for (auto& it : its) {
+                if (it.get() == current) {
+                    continue;
+                }
+                it->Seek(key);
+                if (it->Valid()) {
+                    it->Prev();
+                } else {
+                    it->SeekToLast();
+                }
+            }
+            forward = false;
+        }
+        current->Prev();
+        FindLargest();
+    }
+    bool Valid() override {
+        return current != nullptr;
+    }
+    TBytes Key() override {
+        assert(Valid());
+        return current->Key();
+    }
+    TBytes Value() override {
+        assert(Valid());
+        return current->Value();
+    }
+private:
+    template<typename Compare>
+    void Find(Compare comp) {
+        current = nullptr;
+        TBytes currentKey;
+        for (auto& it : its) {
+            if (!it->Valid()) {
+                continue;
+            }
+            auto key = it->Key();
+            if (!current || comp(key, currentKey)) {
+                current = it.get();
+                currentKey = std::move(key);
+            }
+        }
+    }
+    void FindSmallest() {
+        Find(std::less<TBytes>{});
+    }
+    void FindLargest() {
+        Find(std::greater<TBytes>{});
+    }
+    std::vector<std::unique_ptr<CStorageKVIterator>> its;
+    CStorageKVIterator* current{nullptr};
+    bool forward{true};
+};
+
+// Storage that keeps the keys of some prefixes in other storages than the primary one,
+// so that bulky data which is rarely read back, like undo, doesn't compete with the
+// rest for the cache and compactions of the primary database
+class CStoragePrefixRouter : public CStorageKV {
+public:
+    explicit CStoragePrefixRouter(std::shared_ptr<CStorageKV> primary_) : primary(std::move(primary_)) {
+        routes.fill(primary.get());
+    }
+    CStoragePrefixRouter(const CStoragePrefixRouter&) = delete;
+    ~CStoragePrefixRouter() override = default;
+
+    // Keep the keys starting with prefix in store. Keys already in the primary
+    // storage have to be moved over, see MoveStoragePrefix.
+    void Route(uint8_t prefix, std::shared_ptr<CStorageKV> store) {
+        routes[prefix] = store.get();
+        if (std::find(stores.begin(), stores.end(), store) == stores.end()) {
+            stores.push_back(std::move(store));
+        }
+    }
+    CStorageKV& StoreOf(const TBytes& key) const {
+        return key.empty() ? *primary : *routes[key[0]];
+    }
+
+    bool Exists(const TBytes& key) const override {
+        return StoreOf(key).Exists(key);
+    }
+    bool Write(const TBytes& key, const TBytes& value) override {
+        auto& store = StoreOf(key);
+        if (&store != primary.get()) {
+            erased.erase(key);
+        }
+        return store.Write(key, value);
+    }
+    bool Erase(const TBytes& key) override {
+        auto& store = StoreOf(key);
+        if (&store != primary.get()) {
+            erased[key] = &store; // see Flush
+            return true;
+        }
+        return store.Erase(key);
+    }
+    bool Read(const TBytes& key, TBytes& value) const override {
+        return StoreOf(key).Read(key, value);
+    }
+    bool Flush() override {
+        // Writes of the routed storages go before the primary one and their erasures
+        // after it. A crash in between can leave undo of blocks the state is not at,
+        // it is dropped on startup, but never the state of a block without its undo.
+        if (!FlushStores() || !primary->Flush()) {
+            return false;
+        }
+        if (erased.empty()) {
+            return true;
+        }
+        for (const auto& [key, store] : erased) {
+            store->Erase(key);
+        }
+        erased.clear();
+        return FlushStores();
+    }
+    void Discard() override {
+        for (const auto& store : stores) {
+            store->Discard();
+        }
+        erased.clear();
+        primary->Discard();
+    }
+    size_t SizeEstimate() const override {
+        auto size = primary->SizeEstimate() + memusage::DynamicUsage(erased);
+        for (const auto& store : stores) {
+            size += store->SizeEstimate();
+        }
+        return size;
+    }
+    std::unique_ptr<CStorageKVIterator> NewIterator() override {
+        if (stores.empty()) {
+            return primary->NewIterator();
+        }
+        std::vector<std::unique_ptr<CStorageKVIterator>> its;
+        its.push_back(primary->NewIterator());
+        for (const auto& store : stores) {
+            its.push_back(store->NewIterator());
+        }
+        return std::make_unique<CStorageKVMergingIterator>(std::move(its));
+    }
+    void Compact(const TBytes& begin, const TBytes& end) override {
+        if (begin.empty() || end.empty()) {
+            return;
+        }
+        std::set<CStorageKV*> compacted;
+        for (auto prefix = begin[0]; prefix <= end[0]; ++prefix) {
+            if (compacted.insert(routes[prefix]).second) {
+                routes[prefix]->Compact(begin, end);
+            }
+            if (prefix == 0xff) {
+                break;
+            }
+        }
+    }
+    std::unique_ptr<CStorageKV> Snapshot() const override {
+        std::shared_ptr<CStorageKV> primarySnapshot = primary->Snapshot();
+        if (!primarySnapshot) {
+            return {};
+        }
+        auto router = std::make_unique<CStoragePrefixRouter>(std::move(primarySnapshot));
+        for (const auto& store : stores) {
+            std::shared_ptr<CStorageKV> storeSnapshot = store->Snapshot();
+            if (!storeSnapshot) {
+                return {};
+            }
+            for (size_t prefix = 0; prefix < routes.size(); ++prefix) {
+                if (routes[prefix] == store.get()) {
+                    router->Route(static_cast<uint8_t>(prefix), storeSnapshot);
+                }
+            }
+        }
+        return router;
+    }
+    bool IsEmpty() {
+        auto it = NewIterator();
+        it->Seek({});
+        return !it->Valid();
+    }
+
+private:
+    bool FlushStores() {
+        for (const auto& store : stores) {
+            if (!store->Flush()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::shared_ptr<CStorageKV> primary;
+    std::vector<std::shared_ptr<CStorageKV>> stores; // the routed to ones
+    std::array<CStorageKV*, 256> routes;
+    std::map<TBytes, CStorageKV*> erased; // keys of the routed storages to erase on flush
+};
+
+// Move the keys starting with prefix from one storage to another, e.g. to or from a
+// routed storage. Moves batchSize bytes at a time, flushing the destination before
+// the source, so an interrupted move loses nothing and completes when run again.
+inline bool MoveStoragePrefix(CStorageKV& from, CStorageKV& to, uint8_t prefix, size_t& moved, size_t batchSize = 16 << 20) {
+    moved = 0;
+    while (true) {
+        std::vector<TBytes> keys;
+        {
+            size_t size = 0;
+            auto it = from.NewIterator();
+            for (it->Seek(TBytes{prefix}); it->Valid() && size < batchSize; it->Next()) {
+                auto key = it->Key();
+                if (key.empty() || key[0] != prefix) {
+                    break;
+                }
+                auto value = it->Value();
+                size += key.size() + value.size();
+                if (!to.Write(key, value)) {
+                    return false;
+                }
+                keys.push_back(std::move(key));
+            }
+        }
+        if (keys.empty()) {
+            return true;
+        }
+        if (!to.Flush()) {
+            return false;
+        }
+        for (const auto& key : keys) {
+            if (!from.Erase(key)) {
+                return false;
+            }
+        }
+        if (!from.Flush()) {
+            return false;
+        }
+        moved += keys.size();
+    }
+}
+
+// Read-only storage made of a snapshot of a storage and a frozen copy of the changes
+// not written to it yet. It never changes, so any thread can read it.
+class CStorageSnapshot : public CStorageKV {
+public:
+    CStorageSnapshot(const CStorageKV& db_, MapKV changed_)
+        : db(db_.Snapshot()), changed(std::move(changed_)) {
+        assert(db);
+    }
+    CStorageSnapshot(const CStorageSnapshot&) = delete;
+    ~CStorageSnapshot() override = default;
+
+    bool Exists(const TBytes& key) const override {
+        auto it = changed.find(key);
+        if (it != changed.end()) {
+            return bool(it->second);
+        }
+        return db->Exists(key);
+    }
+    bool Write(const TBytes&, const TBytes&) override {
+        return false;
+    }
+    bool Erase(const TBytes&) override {
+        return false;
+    }
+    bool Read(const TBytes& key, TBytes& value) const override {
+        auto it = changed.find(key);
+        if (it == changed.end()) {
+            return db->Read(key, value);
+        } else if (it->second) {
+            value = it->second.value();
+            return true;
+        } else {
+            return false;
+        }
+    }
+    bool Flush() override {
+        return false;
+    }
+    void Discard() override {}
+    size_t SizeEstimate() const override {
+        return memusage::DynamicUsage(changed);
+    }
+    std::unique_ptr<CStorageKVIterator> NewIterator() override {
+        return std::make_unique<CFlushableStorageKVIterator>(db->NewIterator(), changed);
+    }
+
+private:
+    const std::unique_ptr<CStorageKV> db;
+    const MapKV changed;
 };
 
 template<typename T>
@@ -435,6 +940,15 @@ CStorageIteratorWrapper<By, KeyType> NewKVIterator(const KeyType& key, MapKV& ma
     return it;
 }
 
+// Key operations of the calling thread on storage views, the block connect
+// stats take their difference around every phase of a block.
+struct CStorageOpCounters {
+    uint64_t reads{0};
+    uint64_t writes{0};
+};
+
+inline thread_local CStorageOpCounters g_storageOpCounters;
+
 class CStorageView {
 public:
     CStorageView() = default;
@@ -443,17 +957,24 @@ public:
 
     template<typename KeyType>
     bool Exists(const KeyType& key) const {
+        ++g_storageOpCounters.reads;
         return DB().Exists(DbTypeToBytes(key));
     }
     template<typename By, typename KeyType>
     bool ExistsBy(const KeyType& key) const {
-        return Exists(std::make_pair(By::prefix(), key));
+        if constexpr (CKeyCodec<KeyType>::maxSize != 0) {
+            ++g_storageOpCounters.reads;
+            return DB().Exists(CStorageKey<By, KeyType>(key).Bytes());
+        } else {
+            return Exists(std::make_pair(By::prefix(), key));
+        }
     }
 
     template<typename KeyType, typename ValueType>
     bool Write(const KeyType& key, const ValueType& value) {
         auto vKey = DbTypeToBytes(key);
         auto vValue = DbTypeToBytes(value);
+        ++g_storageOpCounters.writes;
         return DB().Write(vKey, vValue);
     }
     template<typename By, typename KeyType, typename ValueType>
@@ -464,6 +985,7 @@ public:
     template<typename KeyType>
     bool Erase(const KeyType& key) {
         auto vKey = DbTypeToBytes(key);
+        ++g_storageOpCounters.writes;
         return DB().Exists(vKey) && DB().Erase(vKey);
     }
     template<typename By, typename KeyType>
@@ -475,11 +997,18 @@ public:
     bool Read(const KeyType& key, ValueType& value) const {
         auto vKey = DbTypeToBytes(key);
         TBytes vValue;
+        ++g_storageOpCounters.reads;
         return DB().Read(vKey, vValue) && BytesToDbType(vValue, value);
     }
     template<typename By, typename KeyType, typename ValueType>
     bool ReadBy(const KeyType& key, ValueType& value) const {
-        return Read(std::make_pair(By::prefix(), key), value);
+        if constexpr (CKeyCodec<KeyType>::maxSize != 0) {
+            TBytes vValue;
+            ++g_storageOpCounters.reads;
+            return DB().Read(CStorageKey<By, KeyType>(key).Bytes(), vValue) && BytesToDbType(vValue, value);
+        } else {
+            return Read(std::make_pair(By::prefix(), key), value);
+        }
     }
     // second type of 'ReadBy' (may be 'GetBy'?)
     template<typename By, typename ResultType, typename KeyType>
@@ -500,12 +1029,24 @@ public:
         for(auto it = LowerBound<By>(start); it.Valid(); it.Next()) {
             boost::this_thread::interruption_point();
 
+            ++g_storageOpCounters.reads;
             if (!callback(it.Key(), it.Value())) {
                 break;
             }
         }
     }
 
+    // writes raw changes as collected by a flushable storage, nullopt values are erased
+    void ApplyChanges(const MapKV& changes) {
+        for (const auto& [key, value] : changes) {
+            if (value) {
+                DB().Write(key, *value);
+            } else {
+                DB().Erase(key);
+            }
+        }
+    }
+
     bool Flush() { return DB().Flush(); }
     void Discard() { DB().Discard(); }
     size_t SizeEstimate() const { return DB().SizeEstimate(); }
@@ -62,12 +62,87 @@ private:
 };
 
 
+/** Size of the pieces a streamed RPC result is sent in */
+static const size_t RPC_RESULT_CHUNK_SIZE = 64 * 1024;
+
+/** Streams the result of a single JSON-RPC request as a chunked HTTP reply.
+ * The reply starts with the first element of the result, so errors thrown
+ * after that end up next to the partial result instead of replacing it.
+ */
+class HTTPRPCResultWriter final : public JSONRPCResultWriter
+{
+public:
+    explicit HTTPRPCResultWriter(HTTPRequest* req) : m_req(req)
+    {
+    }
+    void Write(const UniValue& value) override
+    {
+        Next('[');
+        m_buffer += value.write();
+        Flush(false);
+    }
+    void Write(const std::string& key, const UniValue& value) override
+    {
+        Next('{');
+        m_buffer += UniValue(key).write();
+        m_buffer += ':';
+        m_buffer += value.write();
+        Flush(false);
+    }
+    bool Started() const
+    {
+        return m_open != 0;
+    }
+    /** Close the result, send the rest of the reply and return its total size */
+    size_t Finish(const UniValue& error, const UniValue& id)
+    {
+        m_buffer += m_open == '[' ? ']' : '}';
+        m_buffer += ",\"error\":" + error.write() + ",\"id\":" + id.write() + "}\n";
+        Flush(true);
+        m_req->WriteReplyEnd();
+        return m_size;
+    }
+private:
+    void Next(char open)
+    {
+        if (m_open) {
+            assert(m_open == open);
+            m_buffer += ',';
+            return;
+        }
+        m_open = open;
+        m_req->WriteHeader("Content-Type", "application/json");
+        m_req->WriteReplyStart(HTTP_OK);
+        m_buffer = "{\"result\":";
+        m_buffer += open;
+    }
+    void Flush(bool force)
+    {
+        if (m_buffer.empty() || (!force && m_buffer.size() < RPC_RESULT_CHUNK_SIZE)) {
+            return;
+        }
+        m_size += m_buffer.size();
+        bool sent = m_req->WriteReplyChunk(m_buffer);
+        m_buffer.clear();
+        if (!sent && !force) {
+            throw JSONRPCError(RPC_MISC_ERROR, "Client went away");
+        }
+    }
+
+    HTTPRequest* m_req;
+    char m_open{0};
+    std::string m_buffer;
+    size_t m_size{0};
+};
+
 /* Pre-base64-encoded authentication token */
 static std::string strRPCUserColonPass;
 /* Stored RPC timer interface (for unregistration) */
 static std::unique_ptr<HTTPRPCTimerInterface> httpRPCTimerInterface;
 /* The host to be used for CORS header */
 static std::string corsOriginHost;
+//! Number of threads executing the read-only calls of a batch at once
+static int rpcBatchParallelism{DEFAULT_RPC_BATCH_PARALLELISM};
 
 static void JSONErrorReply(HTTPRequest* req, const UniValue& objError, const UniValue& id)
 {
@@ -172,7 +247,7 @@ static bool CorsHandler(HTTPRequest *req) {
 
 static bool HTTPReq_JSONRPC(HTTPRequest* req, const std::string &)
 {
-    int64_t time = GetTimeMillis();
+    CRPCStatsCall statsCall;
     // Handle CORS
     if (CorsHandler(req))
         return true;
@@ -191,6 +266,7 @@ static bool HTTPReq_JSONRPC(HTTPRequest* req, const std::string &)
     }
 
     JSONRPCRequest jreq;
+    std::shared_ptr<HTTPRPCResultWriter> writer;
     jreq.peerAddr = req->GetPeer().ToString();
     if (!RPCAuthorized(authHeader.second, jreq.authUser)) {
         LogPrintf("ThreadRPCServer incorrect password attempt from %s\n", jreq.peerAddr);
@@ -218,27 +294,45 @@ static bool HTTPReq_JSONRPC(HTTPRequest* req, const std::string &)
         // singleton request
         if (valRequest.isObject()) {
             jreq.parse(valRequest);
+            statsCall.Start(jreq.strMethod);
+
+            writer = std::make_shared<HTTPRPCResultWriter>(req);
+            jreq.resultWriter = writer;
 
             UniValue result = tableRPC.execute(jreq);
 
+            if (writer->Started()) {
+                auto size = writer->Finish(NullUniValue, jreq.id);
+                statsCall.Add(size);
+                return true;
+            }
+
             // Send reply
             strReply = JSONRPCReply(result, NullUniValue, jreq.id);
 
         // array of requests
         } else if (valRequest.isArray())
-            strReply = JSONRPCExecBatch(jreq, valRequest.get_array());
+            strReply = JSONRPCExecBatch(jreq, valRequest.get_array(), EnqueueIdleHTTPWork, rpcBatchParallelism);
         else
             throw JSONRPCError(RPC_PARSE_ERROR, "Top-level object parse error");
 
         req->WriteHeader("Content-Type", "application/json");
         req->WriteReply(HTTP_OK, strReply);
 
-        if (statsRPC.isActive()) statsRPC.add(jreq.strMethod, GetTimeMillis() - time, strReply.length());
+        statsCall.Add(strReply.length());
     } catch (const UniValue& objError) {
-        JSONErrorReply(req, objError, jreq.id);
+        if (writer && writer->Started()) {
+            writer->Finish(objError, jreq.id);
+        } else {
+            JSONErrorReply(req, objError, jreq.id);
+        }
         return false;
     } catch (const std::exception& e) {
-        JSONErrorReply(req, JSONRPCError(RPC_PARSE_ERROR, e.what()), jreq.id);
+        if (writer && writer->Started()) {
+            writer->Finish(JSONRPCError(RPC_PARSE_ERROR, e.what()), jreq.id);
+        } else {
+            JSONErrorReply(req, JSONRPCError(RPC_PARSE_ERROR, e.what()), jreq.id);
+        }
         return false;
     }
     return true;
@@ -274,6 +368,7 @@ bool StartHTTPRPC()
 
     // Setup Cors origin host name from arg.
     corsOriginHost = gArgs.GetArg("-rpcallowcors", "");
+    rpcBatchParallelism = std::max<int>(gArgs.GetArg("-rpcbatchparallelism", DEFAULT_RPC_BATCH_PARALLELISM), 1);
 
     RegisterHTTPHandler("/", true, HTTPReq_JSONRPC);
     if (g_wallet_init_interface.HasWalletSupport()) {
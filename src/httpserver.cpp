@@ -15,6 +15,7 @@
 #include <sync.h>
 #include <ui_interface.h>
 
+#include <chrono>
 #include <deque>
 #include <memory>
 #include <stdio.h>
@@ -43,6 +44,9 @@
 /** Maximum size of http request (request line + headers) */
 static const size_t MAX_HEADERS_SIZE = 8192;
 
+/** Maximum size of a chunked reply waiting for the client before the worker producing it blocks */
+static const size_t MAX_PENDING_REPLY_SIZE = 4 * 1024 * 1024;
+
 /** HTTP request work item */
 class HTTPWorkItem final : public HTTPClosure
 {
@@ -76,6 +80,7 @@ private:
     std::deque<std::unique_ptr<WorkItem>> queue;
     bool running;
     size_t maxDepth;
+    size_t idle{0};
 
 public:
     explicit WorkQueue(size_t _maxDepth) : running(true),
@@ -98,6 +103,17 @@ public:
         cond.notify_one();
         return true;
     }
+    /** Enqueue a work item only if a worker is waiting to pick it up */
+    bool EnqueueIfIdle(WorkItem* item)
+    {
+        LOCK(cs);
+        if (queue.size() >= idle) {
+            return false;
+        }
+        queue.emplace_back(std::unique_ptr<WorkItem>(item));
+        cond.notify_one();
+        return true;
+    }
     /** Thread function */
     void Run()
     {
@@ -105,8 +121,10 @@ public:
             std::unique_ptr<WorkItem> i;
             {
                 WAIT_LOCK(cs, lock);
+                ++idle;
                 while (running && queue.empty())
                     cond.wait(lock);
+                --idle;
                 if (!running)
                     break;
                 i = std::move(queue.front());
@@ -339,6 +357,33 @@ static bool HTTPBindAddresses(struct evhttp* http)
     return !boundSockets.empty();
 }
 
+/** Work queue item running a function */
+class HTTPWorkFunction final : public HTTPClosure
+{
+public:
+    explicit HTTPWorkFunction(std::function<void()> _func) : func(std::move(_func)) {}
+    void operator()() override
+    {
+        func();
+    }
+
+private:
+    std::function<void()> func;
+};
+
+bool EnqueueIdleHTTPWork(std::function<void()> func)
+{
+    if (!workQueue) {
+        return false;
+    }
+    std::unique_ptr<HTTPWorkFunction> item(new HTTPWorkFunction(std::move(func)));
+    if (!workQueue->EnqueueIfIdle(item.get())) {
+        return false;
+    }
+    item.release(); /* queue took ownership */
+    return true;
+}
+
 /** Simple wrapper to set thread name and run work queue */
 static void HTTPWorkQueueRun(WorkQueue<HTTPClosure>* queue, int worker_num)
 {
@@ -519,6 +564,29 @@ void HTTPEvent::trigger(struct timeval* tv)
     else
         evtimer_add(ev, tv); // trigger after timeval passed
 }
+/** Chunked reply state, shared by the worker producing the reply and the http thread sending it.
+ */
+struct HTTPChunkedReply
+{
+    Mutex cs;
+    std::condition_variable cond;
+    /** Bytes handed to the http thread and not yet added to the connection */
+    size_t queued GUARDED_BY(cs){0};
+    /** Bytes added to the connection since its output buffer was last drained */
+    size_t buffered GUARDED_BY(cs){0};
+    /** Whether the client went away */
+    bool closed GUARDED_BY(cs){false};
+};
+
+/** Called by libevent once the connection wrote out all the reply chunks added so far */
+static void http_reply_drained_cb(struct evhttp_connection*, void* arg)
+{
+    HTTPChunkedReply* reply = static_cast<HTTPChunkedReply*>(arg);
+    LOCK(reply->cs);
+    reply->buffered = 0;
+    reply->cond.notify_all();
+}
+
 HTTPRequest::HTTPRequest(struct evhttp_request* _req) : req(_req),
                                                        replySent(false)
 {
@@ -526,6 +594,11 @@ HTTPRequest::HTTPRequest(struct evhttp_request* _req) : req(_req),
 HTTPRequest::~HTTPRequest()
 {
     if (!replySent) {
+        if (chunkedReply) {
+            // The reply was cut short, let the client see where it ends
+            WriteReplyEnd();
+            return;
+        }
         // Keep track of whether reply was sent to avoid request leaks
         LogPrintf("%s: Unhandled request\n", __func__);
         WriteReply(HTTP_INTERNAL, "Unhandled request");
@@ -578,7 +651,7 @@ void HTTPRequest::WriteHeader(const std::string& hdr, const std::string& value)
  */
 void HTTPRequest::WriteReply(int nStatus, const std::string& strReply)
 {
-    assert(!replySent && req);
+    assert(!replySent && !chunkedReply && req);
     if (ShutdownRequested()) {
         WriteHeader("Connection", "close");
     }
@@ -606,6 +679,96 @@ void HTTPRequest::WriteReply(int nStatus, const std::string& strReply)
     req = nullptr; // transferred back to main thread
 }
 
+void HTTPRequest::WriteReplyStart(int nStatus)
+{
+    assert(!replySent && !chunkedReply && req);
+    if (ShutdownRequested()) {
+        WriteHeader("Connection", "close");
+    }
+    chunkedReply = std::make_shared<HTTPChunkedReply>();
+    auto req_copy = req;
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, nStatus]{
+        if (evhttp_request_get_connection(req_copy)) {
+            evhttp_send_reply_start(req_copy, nStatus, nullptr);
+        }
+    });
+    ev->trigger(nullptr);
+}
+
+bool HTTPRequest::WriteReplyChunk(const std::string& chunk)
+{
+    assert(!replySent && chunkedReply && req);
+    auto req_copy = req;
+    auto reply = chunkedReply;
+    while (true) {
+        {
+            WAIT_LOCK(reply->cs, lock);
+            if (reply->closed || ShutdownRequested()) {
+                return false;
+            }
+            if (reply->queued + reply->buffered <= MAX_PENDING_REPLY_SIZE) {
+                reply->queued += chunk.size();
+                break;
+            }
+            if (reply->cond.wait_for(lock, std::chrono::milliseconds(100)) != std::cv_status::timeout) {
+                continue;
+            }
+        }
+        // libevent does not tell when a client goes away mid-reply, check every now and then
+        HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, reply]{
+            LOCK(reply->cs);
+            reply->closed = !evhttp_request_get_connection(req_copy);
+            reply->cond.notify_all();
+        });
+        ev->trigger(nullptr);
+    }
+
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, reply, chunk]{
+        bool added = false;
+        if (evhttp_request_get_connection(req_copy)) {
+            struct evbuffer* evb = evbuffer_new();
+            evbuffer_add(evb, chunk.data(), chunk.size());
+            evhttp_send_reply_chunk_with_cb(req_copy, evb, http_reply_drained_cb, reply.get());
+            added = evbuffer_get_length(evb) == 0;
+            evbuffer_free(evb);
+        }
+        LOCK(reply->cs);
+        reply->queued -= chunk.size();
+        if (added) {
+            reply->buffered += chunk.size();
+        }
+        reply->closed = !evhttp_request_get_connection(req_copy);
+        reply->cond.notify_all();
+    });
+    ev->trigger(nullptr);
+    return true;
+}
+
+void HTTPRequest::WriteReplyEnd()
+{
+    assert(!replySent && chunkedReply && req);
+    auto req_copy = req;
+    // Keeps the reply state alive until libevent replaces the drained callback
+    auto reply = chunkedReply;
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, reply]{
+        // Re-enable reading from the socket, see WriteReply. Done first as ending the
+        // reply may free the connection.
+        if (event_get_version_number() >= 0x02010600 && event_get_version_number() < 0x02020001) {
+            evhttp_connection* conn = evhttp_request_get_connection(req_copy);
+            if (conn) {
+                bufferevent* bev = evhttp_connection_get_bufferevent(conn);
+                if (bev) {
+                    bufferevent_enable(bev, EV_READ | EV_WRITE);
+                }
+            }
+        }
+        evhttp_send_reply_end(req_copy);
+    });
+    ev->trigger(nullptr);
+    replySent = true;
+    req = nullptr; // transferred back to main thread
+}
+
 CService HTTPRequest::GetPeer() const
 {
     evhttp_connection* con = evhttp_request_get_connection(req);
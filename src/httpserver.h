@@ -8,6 +8,7 @@
 #include <string>
 #include <stdint.h>
 #include <functional>
+#include <memory>
 
 static const int DEFAULT_HTTP_THREADS=4;
 static const int DEFAULT_HTTP_WORKQUEUE=16;
@@ -17,6 +18,7 @@ struct evhttp_request;
 struct event_base;
 class CService;
 class HTTPRequest;
+struct HTTPChunkedReply;
 
 /** Initialize HTTP server.
  * Call this before RegisterHTTPHandler or EventBase().
@@ -46,6 +48,11 @@ void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPR
 /** Unregister handler for prefix */
 void UnregisterHTTPHandler(const std::string &prefix, bool exactMatch);
 
+/** Run a function on an HTTP worker thread, only if one is idle.
+ * Returns false when the function was not queued.
+ */
+bool EnqueueIdleHTTPWork(std::function<void()> func);
+
 /** Return evhttp event base. This can be used by submodules to
  * queue timers or custom events.
  */
@@ -59,6 +66,7 @@ class HTTPRequest
 private:
     struct evhttp_request* req;
     bool replySent;
+    std::shared_ptr<HTTPChunkedReply> chunkedReply;
 
 public:
     explicit HTTPRequest(struct evhttp_request* req);
@@ -115,6 +123,30 @@ public:
      * main thread, do not call any other HTTPRequest methods after calling this.
      */
     void WriteReply(int nStatus, const std::string& strReply = "");
+
+    /**
+     * Start a chunked HTTP reply, for replies that are produced piece by piece.
+     * Send the pieces with WriteReplyChunk and finish with WriteReplyEnd.
+     *
+     * @note call WriteHeader before this, instead of WriteReply.
+     */
+    void WriteReplyStart(int nStatus);
+
+    /**
+     * Send a piece of a chunked reply. Blocks while too much of the reply
+     * is waiting for the client, so a slow client holds back the producer
+     * instead of growing the send buffer.
+     * Returns false if the client went away or the server is shutting down.
+     */
+    bool WriteReplyChunk(const std::string& chunk);
+
+    /**
+     * Finish a chunked reply.
+     *
+     * @note Same as for WriteReply, do not call any other HTTPRequest methods
+     * after calling this.
+     */
+    void WriteReplyEnd();
 };
 
 /** Event handler closure.
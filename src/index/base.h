@@ -70,6 +70,9 @@ protected:
 
     void ChainStateFlushed(const CBlockLocator& locator) override;
 
+    /// Whether the sync thread caught up and notifications keep the index in sync.
+    bool IsSynced() const { return m_synced; }
+
     /// Initialize internal state from the database and block index.
     virtual bool Init();
 
@@ -102,6 +105,10 @@ public:
 
     void Interrupt();
 
+    /// Get the last block the index is in sync with. After a reorg it may not
+    /// be on the active chain until the index has rewound.
+    const CBlockIndex* GetBestBlockIndex() const { return m_best_block_index.load(); }
+
     /// Start initializes the sync state and registers the instance as a
     /// ValidationInterface so that it stays in sync with blockchain updates.
     void Start();
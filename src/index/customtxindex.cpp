@@ -0,0 +1,238 @@
+// Copyright (c) DeFi Blockchain Developers
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#include <index/customtxindex.h>
+#include <chainparams.h>
+#include <masternodes/historychanges.h>
+#include <util/system.h>
+#include <validation.h>
+
+#include <set>
+
+/* The index database holds three kinds of records:
+ *
+ * [DB_CUSTOM_TX, txid] -> CCustomTxIndexEntry
+ * [DB_CUSTOM_TX_TYPE, uint8 type, uint32 height (BE), uint32 txn (BE)] -> txid
+ *     so that the transactions of a type can be paged through in chain order.
+ * [DB_CUSTOM_TX_HEIGHT, uint32 height (BE)] -> (block hash, txids)
+ *     used to erase the transactions of blocks that left the active chain.
+ */
+constexpr char DB_CUSTOM_TX = 'c';
+constexpr char DB_CUSTOM_TX_TYPE = 'y';
+constexpr char DB_CUSTOM_TX_HEIGHT = 'h';
+
+std::unique_ptr<CustomTxIndex> g_customtxindex;
+
+namespace {
+
+struct DBTypeKey {
+    CustomTxType type;
+    int height;
+    uint32_t txn;
+
+    DBTypeKey() : type(CustomTxType::None), height(0), txn(0) {}
+    DBTypeKey(CustomTxType type_in, int height_in, uint32_t txn_in) : type(type_in), height(height_in), txn(txn_in) {}
+
+    template<typename Stream>
+    void Serialize(Stream& s) const
+    {
+        ser_writedata8(s, DB_CUSTOM_TX_TYPE);
+        ser_writedata8(s, static_cast<uint8_t>(type));
+        ser_writedata32be(s, height);
+        ser_writedata32be(s, txn);
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s)
+    {
+        char prefix = ser_readdata8(s);
+        if (prefix != DB_CUSTOM_TX_TYPE) {
+            throw std::ios_base::failure("Invalid format for custom tx index DB type key");
+        }
+        type = static_cast<CustomTxType>(ser_readdata8(s));
+        height = ser_readdata32be(s);
+        txn = ser_readdata32be(s);
+    }
+};
+
+struct DBHeightKey {
+    int height;
+
+    DBHeightKey() : height(0) {}
+    explicit DBHeightKey(int height_in) : height(height_in) {}
+
+    template<typename Stream>
+    void Serialize(Stream& s) const
+    {
+        ser_writedata8(s, DB_CUSTOM_TX_HEIGHT);
+        ser_writedata32be(s, height);
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s)
+    {
+        char prefix = ser_readdata8(s);
+        if (prefix != DB_CUSTOM_TX_HEIGHT) {
+            throw std::ios_base::failure("Invalid format for custom tx index DB height key");
+        }
+        height = ser_readdata32be(s);
+    }
+};
+
+struct DBHeightVal {
+    uint256 block_hash;
+    std::vector<uint256> txids;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(block_hash);
+        READWRITE(txids);
+    }
+};
+
+}; // namespace
+
+/**
+ * Access to the custom tx index database (indexes/customtxindex/)
+ */
+class CustomTxIndex::DB : public BaseIndex::DB
+{
+public:
+    explicit DB(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    /// Erase the transactions of the blocks from the given height on.
+    bool EraseFrom(int height);
+};
+
+CustomTxIndex::DB::DB(size_t n_cache_size, bool f_memory, bool f_wipe) :
+    BaseIndex::DB(GetDataDir() / "indexes" / "customtxindex", n_cache_size, f_memory, f_wipe)
+{}
+
+bool CustomTxIndex::DB::EraseFrom(int height)
+{
+    CDBBatch batch(*this);
+    std::unique_ptr<CDBIterator> db_it(NewIterator());
+
+    DBHeightKey key(height);
+    for (db_it->Seek(key); db_it->Valid() && db_it->GetKey(key); db_it->Next()) {
+        DBHeightVal value;
+        if (!db_it->GetValue(value)) {
+            return error("%s: unable to read value in customtxindex at key (%c, %d)",
+                         __func__, DB_CUSTOM_TX_HEIGHT, key.height);
+        }
+        for (const auto& txid : value.txids) {
+            CCustomTxIndexEntry entry;
+            if (Read(std::make_pair(DB_CUSTOM_TX, txid), entry)) {
+                batch.Erase(DBTypeKey(entry.type, entry.height, entry.txn));
+            }
+            batch.Erase(std::make_pair(DB_CUSTOM_TX, txid));
+        }
+        batch.Erase(key);
+    }
+
+    return WriteBatch(batch);
+}
+
+CustomTxIndex::CustomTxIndex(size_t n_cache_size, bool f_memory, bool f_wipe)
+    : m_db(std::make_unique<CustomTxIndex::DB>(n_cache_size, f_memory, f_wipe))
+{}
+
+CustomTxIndex::~CustomTxIndex() {}
+
+void CustomTxIndex::CustomChangesConnected(const CBlockIndex* pindex, const std::shared_ptr<const CCustomChanges>& changes)
+{
+    LOCK(m_skipped_mutex);
+    m_skipped[pindex->nHeight] = {pindex->GetBlockHash(), changes->skippedTxs};
+}
+
+bool CustomTxIndex::WriteBlock(const CBlock& block, const CBlockIndex* pindex)
+{
+    const auto& consensus = Params().GetConsensus();
+
+    std::optional<std::set<uint256>> skipped;
+    {
+        LOCK(m_skipped_mutex);
+        auto it = m_skipped.find(pindex->nHeight);
+        if (it != m_skipped.end() && it->second.first == pindex->GetBlockHash()) {
+            skipped.emplace(it->second.second.begin(), it->second.second.end());
+        }
+        // lower heights left are of blocks that got disconnected
+        m_skipped.erase(m_skipped.begin(), m_skipped.upper_bound(pindex->nHeight));
+    }
+
+    CDBBatch batch(*m_db);
+    DBHeightVal height_value;
+    height_value.block_hash = pindex->GetBlockHash();
+
+    for (uint32_t txn = 0; txn < block.vtx.size(); ++txn) {
+        const auto& tx = *block.vtx[txn];
+        // Genesis coinbase holds the initial masternodes
+        if (tx.IsCoinBase() && pindex->nHeight > 0) {
+            continue;
+        }
+
+        std::vector<unsigned char> metadata;
+        const auto type = GuessCustomTxType(tx, metadata);
+        if (type == CustomTxType::None) {
+            continue;
+        }
+
+        CCustomTxIndexEntry entry;
+        entry.blockHash = pindex->GetBlockHash();
+        entry.height = pindex->nHeight;
+        entry.txn = txn;
+        entry.type = type;
+        if (skipped) {
+            entry.applied = !skipped->count(tx.GetHash());
+        } else {
+            // post Dakota a custom tx can't get into a block without being applied
+            entry.applied = pindex->nHeight >= consensus.DakotaHeight || !IsSkippedTx(tx.GetHash());
+        }
+
+        batch.Write(std::make_pair(DB_CUSTOM_TX, tx.GetHash()), entry);
+        batch.Write(DBTypeKey(type, pindex->nHeight, txn), tx.GetHash());
+        height_value.txids.push_back(tx.GetHash());
+    }
+
+    if (height_value.txids.empty()) {
+        return true;
+    }
+
+    batch.Write(DBHeightKey(pindex->nHeight), height_value);
+    return m_db->WriteBatch(batch);
+}
+
+bool CustomTxIndex::Rewind(const CBlockIndex* current_tip, const CBlockIndex* new_tip)
+{
+    assert(current_tip->GetAncestor(new_tip->nHeight) == new_tip);
+
+    if (!m_db->EraseFrom(new_tip->nHeight + 1)) {
+        return false;
+    }
+
+    return BaseIndex::Rewind(current_tip, new_tip);
+}
+
+BaseIndex::DB& CustomTxIndex::GetDB() const { return *m_db; }
+
+bool CustomTxIndex::FindCustomTx(const uint256& txid, CCustomTxIndexEntry& entry) const
+{
+    return m_db->Read(std::make_pair(DB_CUSTOM_TX, txid), entry);
+}
+
+void CustomTxIndex::ForEachCustomTx(CustomTxType type, std::function<bool(const uint256& txid, int height, uint32_t txn)> callback,
+                                    int start_height, uint32_t start_txn) const
+{
+    std::unique_ptr<CDBIterator> db_it(m_db->NewIterator());
+
+    DBTypeKey key(type, start_height, start_txn);
+    for (db_it->Seek(key); db_it->Valid() && db_it->GetKey(key) && key.type == type; db_it->Next()) {
+        uint256 txid;
+        if (!db_it->GetValue(txid) || !callback(txid, key.height, key.txn)) {
+            break;
+        }
+    }
+}
@@ -0,0 +1,103 @@
+// Copyright (c) DeFi Blockchain Developers
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef DEFI_INDEX_CUSTOMTXINDEX_H
+#define DEFI_INDEX_CUSTOMTXINDEX_H
+
+#include <index/base.h>
+#include <masternodes/mn_checks.h>
+#include <sync.h>
+
+#include <functional>
+#include <map>
+
+static const bool DEFAULT_CUSTOMTXINDEX = false;
+
+struct CCustomTxIndexEntry {
+    uint256 blockHash;
+    int height;
+    uint32_t txn;
+    CustomTxType type;
+    bool applied;
+
+    CCustomTxIndexEntry() : height(0), txn(0), type(CustomTxType::None), applied(false) {}
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(blockHash);
+        READWRITE(height);
+        READWRITE(txn);
+        if (ser_action.ForRead()) {
+            uint8_t code;
+            READWRITE(code);
+            type = static_cast<CustomTxType>(code);
+        } else {
+            uint8_t code = static_cast<uint8_t>(type);
+            READWRITE(code);
+        }
+        READWRITE(applied);
+    }
+};
+
+/**
+ * CustomTxIndex looks up the custom transactions of the active chain by txid,
+ * and by type and position in the chain. For every custom transaction it keeps
+ * the block, the position in the block, the type and whether the transaction
+ * got applied, so none of the queries has to read or decode blocks.
+ *
+ * The index is written asynchronously like the other indexes. Entries of blocks
+ * that got disconnected may linger until the index catches up, queries check
+ * their block against the active chain.
+ *
+ * Whether a transaction got applied comes with the DeFi changes of its block.
+ * Blocks the index reads from disk instead, while catching up, fall back to the
+ * transactions known to have failed.
+ */
+class CustomTxIndex final : public BaseIndex
+{
+protected:
+    class DB;
+
+private:
+    const std::unique_ptr<DB> m_db;
+
+    /// Custom transactions that failed to apply, of the connected blocks not
+    /// written yet, by height
+    Mutex m_skipped_mutex;
+    std::map<int, std::pair<uint256, std::vector<uint256>>> m_skipped GUARDED_BY(m_skipped_mutex);
+
+protected:
+    void CustomChangesConnected(const CBlockIndex* pindex, const std::shared_ptr<const CCustomChanges>& changes) override;
+
+    bool WriteBlock(const CBlock& block, const CBlockIndex* pindex) override;
+
+    bool Rewind(const CBlockIndex* current_tip, const CBlockIndex* new_tip) override;
+
+    BaseIndex::DB& GetDB() const override;
+
+    const char* GetName() const override { return "customtxindex"; }
+
+public:
+    /// Constructs the index, which becomes available to be queried.
+    explicit CustomTxIndex(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    // Destructor is declared because this class contains a unique_ptr to an incomplete type.
+    virtual ~CustomTxIndex() override;
+
+    /// Look up a custom transaction by hash. Returns false if it is not indexed.
+    bool FindCustomTx(const uint256& txid, CCustomTxIndexEntry& entry) const;
+
+    /// Iterate over the custom transactions of a type in chain order, starting
+    /// at the given height and position in the block, as long as callback
+    /// returns true.
+    void ForEachCustomTx(CustomTxType type, std::function<bool(const uint256& txid, int height, uint32_t txn)> callback,
+                         int start_height = 0, uint32_t start_txn = 0) const;
+};
+
+/// The global custom transaction index. May be null.
+extern std::unique_ptr<CustomTxIndex> g_customtxindex;
+
+#endif // DEFI_INDEX_CUSTOMTXINDEX_H
@@ -0,0 +1,361 @@
+// Copyright (c) DeFi Blockchain Developers
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#include <map>
+
+#include <index/historyindex.h>
+#include <masternodes/accountshistory.h>
+#include <masternodes/masternodes.h>
+#include <masternodes/vaulthistory.h>
+#include <util/system.h>
+#include <validation.h>
+
+/* The history databases keep their own formats, the index database only keeps the block
+ * locator and one entry per height that wrote history: the hash of the block, the raw keys
+ * it wrote and whether the history database was flushed with them. Every history key contains
+ * the height of the block that wrote it, so erasing these keys removes the block from the history.
+ *
+ * Keys for the height entries have the type [DB_HISTORY_KEYS, uint32 (BE)] so that the entries
+ * above a height can be found with a single seek when rewinding.
+ */
+constexpr char DB_HISTORY_KEYS = 'k';
+
+namespace {
+
+struct DBHeightKey {
+    int height;
+
+    DBHeightKey() : height(0) {}
+    explicit DBHeightKey(int height_in) : height(height_in) {}
+
+    template<typename Stream>
+    void Serialize(Stream& s) const
+    {
+        ser_writedata8(s, DB_HISTORY_KEYS);
+        ser_writedata32be(s, height);
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s)
+    {
+        char prefix = ser_readdata8(s);
+        if (prefix != DB_HISTORY_KEYS) {
+            throw std::ios_base::failure("Invalid format for history index DB height key");
+        }
+        height = ser_readdata32be(s);
+    }
+};
+
+struct DBVal {
+    uint256 block_hash;
+    std::vector<TBytes> keys;
+    bool applied{false};
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(block_hash);
+        READWRITE(keys);
+        READWRITE(applied);
+    }
+};
+
+}; // namespace
+
+static std::map<HistoryIndexType, HistoryIndex> g_history_indexes;
+
+static std::string HistoryIndexName(HistoryIndexType type)
+{
+    switch (type) {
+        case HistoryIndexType::Account: return "accounthistory";
+        case HistoryIndexType::Burn:    return "burnhistory";
+        case HistoryIndexType::Vault:   return "vaulthistory";
+        case HistoryIndexType::Pool:    return "poolhistory";
+        case HistoryIndexType::Oracle:  return "oraclehistory";
+    }
+    return {};
+}
+
+static const MapKV& SelectChanges(HistoryIndexType type, const CHistoryChanges& changes)
+{
+    switch (type) {
+        case HistoryIndexType::Account: return changes.accounts;
+        case HistoryIndexType::Burn:    return changes.burns;
+        case HistoryIndexType::Vault:   return changes.vaults;
+        case HistoryIndexType::Pool:    return changes.pools;
+        case HistoryIndexType::Oracle:  return changes.oracles;
+    }
+    assert(false);
+}
+
+static bool IsOnActiveChain(const uint256& block_hash)
+{
+    LOCK(cs_main);
+    const CBlockIndex* pindex = LookupBlockIndex(block_hash);
+    return pindex && ::ChainActive().Contains(pindex);
+}
+
+// Loan scheme updates are written on the validation path without the txid of the scheme
+// creation, which is only known from the history of earlier blocks.
+static void ResolveGlobalSchemes(CVaultHistoryView& view, MapKV& changes)
+{
+    for (auto& [rawKey, rawValue] : MapKV(changes)) {
+        std::pair<uint8_t, VaultGlobalSchemeKey> key;
+        if (rawKey.empty() || rawKey.front() != CVaultHistoryView::ByVaultGlobalSchemeKey::prefix()
+        || !rawValue || !BytesToDbType(rawKey, key) || !key.second.schemeCreationTxid.IsNull()) {
+            continue;
+        }
+
+        VaultGlobalSchemeValue value;
+        if (!BytesToDbType(*rawValue, value)) {
+            continue;
+        }
+
+        view.ForEachGlobalScheme([&](VaultGlobalSchemeKey const & schemeKey, CLazySerialize<VaultGlobalSchemeValue> lazyValue) {
+            if (lazyValue.get().loanScheme.identifier != value.loanScheme.identifier) {
+                return true;
+            }
+            key.second.schemeCreationTxid = schemeKey.schemeCreationTxid;
+            return false;
+        }, {key.second.blockHeight, key.second.txn, {}});
+
+        changes.erase(rawKey);
+        changes.emplace(DbTypeToBytes(key), std::move(rawValue));
+    }
+}
+
+HistoryIndex::HistoryIndex(HistoryIndexType type, CStorageView& storage,
+                           size_t n_cache_size, bool f_memory, bool f_wipe)
+    : m_type(type), m_storage(storage)
+{
+    const std::string index_name = HistoryIndexName(type);
+
+    fs::path path = GetDataDir() / "indexes" / index_name;
+    fs::create_directories(path);
+
+    m_name = index_name + " index";
+    m_db = std::make_unique<BaseIndex::DB>(path / "db", n_cache_size, f_memory, f_wipe);
+}
+
+bool HistoryIndex::Init()
+{
+    CBlockLocator locator;
+    if (!m_db->ReadBestBlock(locator)) {
+        // History databases used to be written along with the chain state, so a
+        // database without an index starts in sync with the current tip. That is
+        // also where a newly enabled history starts recording.
+        LOCK(cs_main);
+        if (::ChainActive().Tip()) {
+            CDBBatch batch(*m_db);
+            m_db->WriteBestBlock(batch, ::ChainActive().GetLocator());
+            if (!m_db->WriteBatch(batch)) {
+                return error("%s: Failed to initialize %s state", __func__, GetName());
+            }
+        }
+    }
+
+    if (!BaseIndex::Init()) {
+        return false;
+    }
+
+    // The node may have been stopped mid-rewind or reorged while the index was behind
+    const CBlockIndex* best_block_index = GetBestBlockIndex();
+    return EraseStale(best_block_index ? best_block_index->nHeight + 1 : 0);
+}
+
+bool HistoryIndex::EraseStale(int height)
+{
+    std::vector<std::pair<int, DBVal>> stale;
+    {
+        std::unique_ptr<CDBIterator> db_it(m_db->NewIterator());
+        DBHeightKey key(height);
+        for (db_it->Seek(key); db_it->Valid() && db_it->GetKey(key); db_it->Next()) {
+            DBVal value;
+            if (!db_it->GetValue(value)) {
+                return error("%s: unable to read value in %s at key (%c, %d)",
+                             __func__, GetName(), DB_HISTORY_KEYS, key.height);
+            }
+            if (!IsOnActiveChain(value.block_hash)) {
+                stale.emplace_back(key.height, std::move(value));
+            }
+        }
+    }
+
+    if (stale.empty()) {
+        return true;
+    }
+
+    MapKV erased;
+    for (const auto& entry : stale) {
+        for (const auto& key : entry.second.keys) {
+            erased.emplace(key, std::nullopt);
+        }
+    }
+    m_storage.ApplyChanges(erased);
+    if (!m_storage.Flush()) {
+        return error("%s: Failed to erase stale history of %s", __func__, GetName());
+    }
+
+    CDBBatch batch(*m_db);
+    for (const auto& entry : stale) {
+        batch.Erase(DBHeightKey(entry.first));
+    }
+    return m_db->WriteBatch(batch);
+}
+
+bool HistoryIndex::WriteBlock(const CBlock& block, const CBlockIndex* pindex)
+{
+    DBVal written;
+    if (m_db->Read(DBHeightKey(pindex->nHeight), written)) {
+        // Notifications queued while the sync thread caught up replay blocks
+        // that are already applied, their journal entries may be gone by now.
+        // A block stopped before its history got flushed is applied again,
+        // its journal entry is kept until the index moves past it.
+        if (written.block_hash == pindex->GetBlockHash()) {
+            if (written.applied) {
+                return true;
+            }
+        } else if (IsOnActiveChain(written.block_hash)) {
+            return true;
+        } else if (!EraseStale(pindex->nHeight)) {
+            return false;
+        }
+    }
+
+    std::optional<CHistoryChanges> journaled;
+    {
+        LOCK(cs_main);
+        journaled = pcustomcsview->GetHistoryChanges(pindex->nHeight);
+    }
+    // Blocks without history have no journal entry, one of another block means
+    // pindex got disconnected meanwhile and there is nothing to apply for it.
+    if (!journaled || journaled->blockHash != pindex->GetBlockHash()) {
+        return true;
+    }
+
+    auto changes = SelectChanges(m_type, *journaled);
+    if (changes.empty()) {
+        return true;
+    }
+
+    if (m_type == HistoryIndexType::Account) {
+        dynamic_cast<CAccountsHistoryView&>(m_storage).AddBalanceCheckpoints(changes, pindex->nHeight);
+    }
+    if (m_type == HistoryIndexType::Vault) {
+        ResolveGlobalSchemes(dynamic_cast<CVaultHistoryView&>(m_storage), changes);
+    }
+
+    DBVal value;
+    value.block_hash = pindex->GetBlockHash();
+    for (const auto& change : changes) {
+        value.keys.push_back(change.first);
+    }
+    // Keys go first, so whatever makes it to the history can be rewound, and
+    // the block is marked applied only once the history is flushed
+    if (!m_db->Write(DBHeightKey(pindex->nHeight), value)) {
+        return false;
+    }
+
+    m_storage.ApplyChanges(changes);
+    if (!m_storage.Flush()) {
+        return error("%s: Failed to write history of block %s to %s",
+                     __func__, pindex->GetBlockHash().ToString(), GetName());
+    }
+
+    value.applied = true;
+    return m_db->Write(DBHeightKey(pindex->nHeight), value);
+}
+
+bool HistoryIndex::Rewind(const CBlockIndex* current_tip, const CBlockIndex* new_tip)
+{
+    assert(current_tip->GetAncestor(new_tip->nHeight) == new_tip);
+
+    // Only history of blocks that left the active chain is erased, see WriteBlock
+    if (!EraseStale(new_tip->nHeight + 1)) {
+        return false;
+    }
+
+    return BaseIndex::Rewind(current_tip, new_tip);
+}
+
+void HistoryIndex::BlockDisconnected(const std::shared_ptr<const CBlock>& block)
+{
+    // BaseIndex rewinds on the next connected block only, while the history of
+    // a disconnected block has to go right away.
+    if (!IsSynced()) {
+        return;
+    }
+
+    const CBlockIndex* pindex;
+    {
+        LOCK(cs_main);
+        pindex = LookupBlockIndex(block->GetHash());
+    }
+    if (pindex && !EraseStale(pindex->nHeight)) {
+        error("%s: Failed to erase history of disconnected block %s from %s",
+              __func__, block->GetHash().ToString(), GetName());
+    }
+}
+
+HistoryIndex* GetHistoryIndex(HistoryIndexType type)
+{
+    auto it = g_history_indexes.find(type);
+    return it != g_history_indexes.end() ? &it->second : nullptr;
+}
+
+void ForEachHistoryIndex(std::function<void (HistoryIndex&)> fn)
+{
+    for (auto& entry : g_history_indexes) fn(entry.second);
+}
+
+bool InitHistoryIndex(HistoryIndexType type, CStorageView& storage,
+                      size_t n_cache_size, bool f_memory, bool f_wipe)
+{
+    auto result = g_history_indexes.emplace(std::piecewise_construct,
+                                            std::forward_as_tuple(type),
+                                            std::forward_as_tuple(type, storage,
+                                                                  n_cache_size, f_memory, f_wipe));
+    return result.second;
+}
+
+void DestroyAllHistoryIndexes()
+{
+    g_history_indexes.clear();
+}
+
+void SyncHistoryIndex(HistoryIndexType type)
+{
+    auto index = GetHistoryIndex(type);
+    // A synced index may still have disconnected blocks queued, which do not move the tip
+    if (index && index->BlockUntilSyncedToCurrentChain()) {
+        SyncWithValidationInterfaceQueue();
+    }
+}
+
+void PruneHistoryChanges(CCustomCSView& view, const CChain& chain)
+{
+    AssertLockHeld(cs_main);
+
+    // Without history indexes nothing consumes the journal
+    auto applied = chain.Height();
+    for (const auto& entry : g_history_indexes) {
+        const CBlockIndex* best_block_index = entry.second.GetBestBlockIndex();
+        const CBlockIndex* fork = best_block_index ? chain.FindFork(best_block_index) : nullptr;
+        applied = std::min(applied, fork ? fork->nHeight : -1);
+    }
+
+    std::vector<uint32_t> heights;
+    view.ForEachHistoryChanges([&](HistoryChangesKey const & key, CLazySerialize<CHistoryChanges>) {
+        if (key.height > static_cast<uint32_t>(applied)) {
+            return false;
+        }
+        heights.push_back(key.height);
+        return true;
+    });
+
+    for (const auto height : heights) {
+        view.DelHistoryChanges(height);
+    }
+}
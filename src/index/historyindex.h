@@ -0,0 +1,101 @@
+// Copyright (c) DeFi Blockchain Developers
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef DEFI_INDEX_HISTORYINDEX_H
+#define DEFI_INDEX_HISTORYINDEX_H
+
+#include <index/base.h>
+
+#include <functional>
+
+class CChain;
+class CCustomCSView;
+class CStorageView;
+
+enum class HistoryIndexType : uint8_t {
+    Account,
+    Burn,
+    Vault,
+    Pool,
+    Oracle,
+};
+
+/**
+ * HistoryIndex writes the account, burn, vault, pool or oracle history database. ConnectBlock
+ * only collects the history changes of a block and journals them next to the
+ * block's custom state (see CHistoryChangesView), the index applies them
+ * asynchronously so block validation never waits on history I/O.
+ *
+ * The index database holds the block locator and, for each height, the block
+ * hash and the keys written to the history database, used to rewind the
+ * history on reorgs.
+ */
+class HistoryIndex final : public BaseIndex
+{
+private:
+    const HistoryIndexType m_type;
+    std::string m_name;
+    std::unique_ptr<BaseIndex::DB> m_db;
+
+    /// The history database maintained by this index
+    CStorageView& m_storage;
+
+    /// Erase the history written from the given height on by blocks that are
+    /// no longer on the active chain.
+    bool EraseStale(int height);
+
+protected:
+    void BlockDisconnected(const std::shared_ptr<const CBlock>& block) override;
+
+    bool Init() override;
+
+    bool WriteBlock(const CBlock& block, const CBlockIndex* pindex) override;
+
+    bool Rewind(const CBlockIndex* current_tip, const CBlockIndex* new_tip) override;
+
+    BaseIndex::DB& GetDB() const override { return *m_db; }
+
+    const char* GetName() const override { return m_name.c_str(); }
+
+public:
+    /// Constructs the index, which becomes available to be queried.
+    explicit HistoryIndex(HistoryIndexType type, CStorageView& storage,
+                          size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    HistoryIndexType GetType() const { return m_type; }
+};
+
+/**
+ * Get a history index by type. Returns nullptr if index has not been initialized or was
+ * already destroyed.
+ */
+HistoryIndex* GetHistoryIndex(HistoryIndexType type);
+
+/** Iterate over all running history indexes, invoking fn on each. */
+void ForEachHistoryIndex(std::function<void (HistoryIndex&)> fn);
+
+/**
+ * Initialize a history index for the given type if one does not already exist. Returns true if
+ * a new index is created and false if one has already been initialized.
+ */
+bool InitHistoryIndex(HistoryIndexType type, CStorageView& storage,
+                      size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+/** Destroy all open history indexes. */
+void DestroyAllHistoryIndexes();
+
+/**
+ * Blocks until the history index of the given type has caught up with the
+ * active chain, so RPC results are consistent with the tip. No-op if the
+ * index is not running.
+ */
+void SyncHistoryIndex(HistoryIndexType type);
+
+/**
+ * Erase journaled history changes that all running history indexes have
+ * applied on the active chain.
+ */
+void PruneHistoryChanges(CCustomCSView& view, const CChain& chain) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
+#endif // DEFI_INDEX_HISTORYINDEX_H
@@ -13,14 +13,18 @@
 #include <amount.h>
 #include <banman.h>
 #include <blockfilter.h>
+#include <blockprefetcher.h>
 #include <chain.h>
 #include <chainparams.h>
 #include <compat/sanity.h>
+#include <connectstats.h>
 #include <consensus/validation.h>
 #include <fs.h>
 #include <httprpc.h>
 #include <httpserver.h>
 #include <index/blockfilterindex.h>
+#include <index/customtxindex.h>
+#include <index/historyindex.h>
 #include <index/txindex.h>
 #include <interfaces/chain.h>
 #include <key.h>
@@ -28,6 +32,8 @@
 #include <masternodes/accountshistory.h>
 #include <masternodes/anchors.h>
 #include <masternodes/masternodes.h>
+#include <masternodes/oraclehistory.h>
+#include <masternodes/poolhistory.h>
 #include <masternodes/vaulthistory.h>
 #include <miner.h>
 #include <net.h>
@@ -52,6 +58,7 @@
 #include <torcontrol.h>
 #include <txdb.h>
 #include <txmempool.h>
+#include <txvalidationqueue.h>
 #include <ui_interface.h>
 #include <util/moneystr.h>
 #include <util/system.h>
@@ -172,10 +179,18 @@ void Interrupt()
     InterruptMapPort();
     if (g_connman)
         g_connman->Interrupt();
+    if (g_txvalidationqueue)
+        g_txvalidationqueue->Interrupt();
+    if (g_blockprefetcher)
+        g_blockprefetcher->Interrupt();
     if (g_txindex) {
         g_txindex->Interrupt();
     }
+    if (g_customtxindex) {
+        g_customtxindex->Interrupt();
+    }
     ForEachBlockFilterIndex([](BlockFilterIndex& index) { index.Interrupt(); });
+    ForEachHistoryIndex([](HistoryIndex& index) { index.Interrupt(); });
 }
 
 void Shutdown(InitInterfaces& interfaces)
@@ -211,9 +226,12 @@ void Shutdown(InitInterfaces& interfaces)
     // Because these depend on each-other, we make sure that neither can be
     // using the other before destroying them.
     if (peerLogic) UnregisterValidationInterface(peerLogic.get());
+    if (g_txvalidationqueue) g_txvalidationqueue->Stop();
     if (g_connman) g_connman->Stop();
     if (g_txindex) g_txindex->Stop();
+    if (g_customtxindex) g_customtxindex->Stop();
     ForEachBlockFilterIndex([](BlockFilterIndex& index) { index.Stop(); });
+    ForEachHistoryIndex([](HistoryIndex& index) { index.Stop(); });
 
     StopTorControl();
 
@@ -221,14 +239,19 @@ void Shutdown(InitInterfaces& interfaces)
     // CScheduler/checkqueue threadGroup
     threadGroup.interrupt_all();
     threadGroup.join_all();
+    if (g_blockprefetcher) g_blockprefetcher->Stop();
 
     // After the threads that potentially access these pointers have been stopped,
     // destruct and reset all to nullptr.
+    g_txvalidationqueue.reset();
+    g_blockprefetcher.reset();
     peerLogic.reset();
     g_connman.reset();
     g_banman.reset();
     g_txindex.reset();
+    g_customtxindex.reset();
     DestroyAllBlockFilterIndexes();
+    DestroyAllHistoryIndexes();
 
     if (::mempool.IsLoaded() && gArgs.GetArg("-persistmempool", DEFAULT_PERSIST_MEMPOOL)) {
         DumpMempool(::mempool);
@@ -278,6 +301,7 @@ void Shutdown(InitInterfaces& interfaces)
         panchors.reset();
         panchorAwaitingConfirms.reset();
         panchorauths.reset();
+        ResetCustomCSSnapshot();
         pcustomcsview.reset();
         pcustomcsDB.reset();
         pblocktree.reset();
@@ -308,6 +332,7 @@ void Shutdown(InitInterfaces& interfaces)
     globalVerifyHandle.reset();
     ECC_Stop();
     LogPrintf("%s: done\n", __func__);
+    LogInstance().StopAsync();
 }
 
 /**
@@ -393,20 +418,24 @@ void SetupServerArgs()
     gArgs.AddArg("-spvwalletnotify=<cmd>", "Execute command when an SPV Bitcoin wallet transaction changes (%s in cmd is replaced by TxID)", ArgsManager::ALLOW_ANY, OptionsCategory::WALLET);
 #endif
     gArgs.AddArg("-blockreconstructionextratxn=<n>", strprintf("Extra transactions to keep in memory for compact block reconstructions (default: %u)", DEFAULT_BLOCK_RECONSTRUCTION_EXTRA_TXN), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-blockprefetch=<n>", strprintf("Set the number of threads reading blocks ahead of connecting them, as on reindex and initial download (0 to %d, 0 = disabled, default: %d)", MAX_BLOCK_PREFETCH_THREADS, DEFAULT_BLOCK_PREFETCH_THREADS), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     gArgs.AddArg("-blocksonly", strprintf("Whether to reject transactions from network peers. Transactions from the wallet, RPC and relay whitelisted inbound peers are not affected. (default: %u)", DEFAULT_BLOCKSONLY), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     gArgs.AddArg("-conf=<file>", strprintf("Specify configuration file. Relative paths will be prefixed by datadir location. (default: %s)", DEFI_CONF_FILENAME), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     gArgs.AddArg("-datadir=<dir>", "Specify data directory", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     gArgs.AddArg("-dbbatchsize", strprintf("Maximum database write batch size in bytes (default: %u)", nDefaultDbBatchSize), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::OPTIONS);
     gArgs.AddArg("-dbcache=<n>", strprintf("Maximum database cache size <n> MiB (%d to %d, default: %d). In addition, unused mempool memory is shared for this cache (see -maxmempool).", nMinDbCache, nMaxDbCache, nDefaultDbCache), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-dboption=<db>.<setting>=<n>", "Tune a LevelDB database by its directory name (enhancedcs, history, burn, vault, chainstate, index, txindex, ...). Settings are blockcache, writebuffer and maxfilesize in MiB, bloombits (0 disables the bloom filter) and compression (0 or 1, only effective when LevelDB is built with snappy). Can be specified multiple times", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     gArgs.AddArg("-debuglogfile=<file>", strprintf("Specify location of debug log file. Relative paths will be prefixed by a net-specific datadir location. (-nodebuglogfile to disable; default: %s)", DEFAULT_DEBUGLOGFILE), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     gArgs.AddArg("-feefilter", strprintf("Tell other nodes to filter invs to us by our mempool min fee (default: %u)", DEFAULT_FEEFILTER), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::OPTIONS);
     gArgs.AddArg("-includeconf=<file>", "Specify additional configuration file, relative to the -datadir path (only useable from configuration file, not command line)", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     gArgs.AddArg("-loadblock=<file>", "Imports blocks from external blk000??.dat file on startup", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     gArgs.AddArg("-maxmempool=<n>", strprintf("Keep the transaction memory pool below <n> megabytes (default: %u)", DEFAULT_MAX_MEMPOOL_SIZE), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-txvalidationthread", strprintf("Validate the transactions of peers on a thread of its own (default: %u)", DEFAULT_TX_VALIDATION_THREAD), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-maxtxvalidationqueue=<n>", strprintf("Keep at most <n> transactions of peers waiting for validation (default: %u)", DEFAULT_MAX_TX_VALIDATION_QUEUE), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     gArgs.AddArg("-maxorphantx=<n>", strprintf("Keep at most <n> unconnectable transactions in memory (default: %u)", DEFAULT_MAX_ORPHAN_TRANSACTIONS), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     gArgs.AddArg("-mempoolexpiry=<n>", strprintf("Do not keep transactions in the mempool longer than <n> hours (default: %u)", DEFAULT_MEMPOOL_EXPIRY), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     gArgs.AddArg("-minimumchainwork=<hex>", strprintf("Minimum work assumed to exist on a valid chain in hex (default: %s, testnet: %s)", defaultChainParams->GetConsensus().nMinimumChainWork.GetHex(), testnetChainParams->GetConsensus().nMinimumChainWork.GetHex()), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::OPTIONS); // omit for devnet
-    gArgs.AddArg("-par=<n>", strprintf("Set the number of script verification threads (%u to %d, 0 = auto, <0 = leave that many cores free, default: %d)",
+    gArgs.AddArg("-par=<n>", strprintf("Set the number of script and header signature verification threads (%u to %d, 0 = auto, <0 = leave that many cores free, default: %d)",
         -GetNumCores(), MAX_SCRIPTCHECK_THREADS, DEFAULT_SCRIPTCHECK_THREADS), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     gArgs.AddArg("-persistmempool", strprintf("Whether to save the mempool on shutdown and load on restart (default: %u)", DEFAULT_PERSIST_MEMPOOL), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     gArgs.AddArg("-pid=<file>", strprintf("Specify pid file. Relative paths will be prefixed by a net-specific datadir location. (default: %s)", DEFI_PID_FILENAME), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
@@ -421,8 +450,15 @@ void SetupServerArgs()
     hidden_args.emplace_back("-sysperms");
 #endif
     gArgs.AddArg("-txindex", strprintf("Maintain a full transaction index, used by the getrawtransaction rpc call (default: %u)", DEFAULT_TXINDEX), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-customtxindex", strprintf("Maintain an index of custom transactions by type and height, used by the listcustomtxs rpc call (default: %u)", DEFAULT_CUSTOMTXINDEX), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-enhancedcsundodb", strprintf("Keep the undo data of the custom state in a database of its own (enhancedcs_undo). Existing data gets moved on startup when switched (default: %u)", DEFAULT_ENHANCEDCS_UNDO_DB), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-undobundles", strprintf("Store the undo data of the custom state of each block in a single record, so that disconnecting and pruning a block take a single read and erase. Existing bundles get unpacked on startup when switched off (default: %u)", DEFAULT_UNDO_BUNDLES), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     gArgs.AddArg("-acindex", strprintf("Maintain a full account history index, tracking all accounts balances changes. Used by the listaccounthistory, getaccounthistory and accounthistorycount rpc calls (default: %u)", DEFAULT_ACINDEX), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-acbalancecheckpointentries=<n>", strprintf("Checkpoint the balances of an address in the account history once it has <n> history entries since the last checkpoint, bounding the cost of getaccount at a height (0 = disabled, default: %u)", DEFAULT_BALANCE_CHECKPOINT_ENTRIES), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-acbalancecheckpointblocks=<n>", strprintf("Checkpoint the balances of an address in the account history when it changes <n> blocks or more after the last checkpoint (0 = disabled, default: %u)", DEFAULT_BALANCE_CHECKPOINT_BLOCKS), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     gArgs.AddArg("-vaultindex", strprintf("Maintain a full vault history index, tracking all vault changes. Used by the listvaulthistory rpc call (default: %u)", DEFAULT_VAULTINDEX), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-poolindex", strprintf("Maintain a pool history index, tracking the reserves, prices, swap volume and fees of the pools per block. Used by the getpoolcandles rpc call (default: %u)", DEFAULT_POOLINDEX), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-oracleindex", strprintf("Maintain an oracle price history index, tracking the fixed interval prices and the prices submitted by oracles. Used by the getfixedintervalpriceat, listfixedintervalpricehistory and listoraclepricehistory rpc calls (default: %u)", DEFAULT_ORACLEINDEX), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     gArgs.AddArg("-blockfilterindex=<type>",
                  strprintf("Maintain an index of compact filters by block (default: %s, values: %s).", DEFAULT_BLOCKFILTERINDEX, ListBlockFilterTypes()) +
                  " If <type> is not supplied or if <type> = 1, indexes for all known types are enabled.",
@@ -515,6 +551,18 @@ void SetupServerArgs()
     gArgs.AddArg("-zmqpubhashtxhwm=<n>", strprintf("Set publish hash transaction outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
     gArgs.AddArg("-zmqpubrawblockhwm=<n>", strprintf("Set publish raw block outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
     gArgs.AddArg("-zmqpubrawtxhwm=<n>", strprintf("Set publish raw transaction outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
+    gArgs.AddArg("-zmqpubaccountdiffs=<address>", "Enable publish account balance diffs of connected blocks in <address>", ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
+    gArgs.AddArg("-zmqpubpoolreserves=<address>", "Enable publish pool reserve updates of connected blocks in <address>", ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
+    gArgs.AddArg("-zmqpubvaultstates=<address>", "Enable publish vault state changes and liquidation auctions of connected blocks in <address>", ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
+    gArgs.AddArg("-zmqpuboracleprices=<address>", "Enable publish fixed interval price updates of connected blocks in <address>", ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
+    gArgs.AddArg("-zmqpubfutureswaps=<address>", "Enable publish future swap settlements of connected blocks in <address>", ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
+    gArgs.AddArg("-zmqpubdefiundo=<address>", "Enable publish blocks whose DeFi changes got reverted by a reorg in <address>", ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
+    gArgs.AddArg("-zmqpubaccountdiffshwm=<n>", strprintf("Set publish account diffs outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
+    gArgs.AddArg("-zmqpubpoolreserveshwm=<n>", strprintf("Set publish pool reserves outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
+    gArgs.AddArg("-zmqpubvaultstateshwm=<n>", strprintf("Set publish vault states outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
+    gArgs.AddArg("-zmqpuboraclepriceshwm=<n>", strprintf("Set publish oracle prices outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
+    gArgs.AddArg("-zmqpubfutureswapshwm=<n>", strprintf("Set publish future swaps outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
+    gArgs.AddArg("-zmqpubdefiundohwm=<n>", strprintf("Set publish DeFi undo outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
 #else
     hidden_args.emplace_back("-zmqpubhashblock=<address>");
     hidden_args.emplace_back("-zmqpubhashtx=<address>");
@@ -524,6 +572,18 @@ void SetupServerArgs()
     hidden_args.emplace_back("-zmqpubhashtxhwm=<n>");
     hidden_args.emplace_back("-zmqpubrawblockhwm=<n>");
     hidden_args.emplace_back("-zmqpubrawtxhwm=<n>");
+    hidden_args.emplace_back("-zmqpubaccountdiffs=<address>");
+    hidden_args.emplace_back("-zmqpubpoolreserves=<address>");
+    hidden_args.emplace_back("-zmqpubvaultstates=<address>");
+    hidden_args.emplace_back("-zmqpuboracleprices=<address>");
+    hidden_args.emplace_back("-zmqpubfutureswaps=<address>");
+    hidden_args.emplace_back("-zmqpubdefiundo=<address>");
+    hidden_args.emplace_back("-zmqpubaccountdiffshwm=<n>");
+    hidden_args.emplace_back("-zmqpubpoolreserveshwm=<n>");
+    hidden_args.emplace_back("-zmqpubvaultstateshwm=<n>");
+    hidden_args.emplace_back("-zmqpuboraclepriceshwm=<n>");
+    hidden_args.emplace_back("-zmqpubfutureswapshwm=<n>");
+    hidden_args.emplace_back("-zmqpubdefiundohwm=<n>");
 #endif
 
     gArgs.AddArg("-checkblocks=<n>", strprintf("How many blocks to check at startup (default: %u, 0 = all)", DEFAULT_CHECKBLOCKS), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::DEBUG_TEST);
@@ -554,7 +614,11 @@ void SetupServerArgs()
     gArgs.AddArg("-rewardaddress", strprintf("Generate coins for selected address instead of masternode's owner"), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::DEBUG_TEST);
     gArgs.AddArg("-logips", strprintf("Include IP addresses in debug output (default: %u)", DEFAULT_LOGIPS), ArgsManager::ALLOW_ANY, OptionsCategory::DEBUG_TEST);
     gArgs.AddArg("-logtimestamps", strprintf("Prepend debug output with timestamp (default: %u)", DEFAULT_LOGTIMESTAMPS), ArgsManager::ALLOW_ANY, OptionsCategory::DEBUG_TEST);
+    gArgs.AddArg("-logasync", strprintf("Write the debug output from a thread of its own, dropping messages while its queue is full (default: %u)", DEFAULT_LOGASYNC), ArgsManager::ALLOW_ANY, OptionsCategory::DEBUG_TEST);
+    gArgs.AddArg("-logasyncbuffer=<n>", strprintf("Queue up to <n> messages for the debug output thread, requires -logasync (default: %u)", DEFAULT_LOGASYNC_BUFFER), ArgsManager::ALLOW_ANY, OptionsCategory::DEBUG_TEST);
     gArgs.AddArg("-logthreadnames", strprintf("Prepend debug output with name of the originating thread (only available on platforms supporting thread_local) (default: %u)", DEFAULT_LOGTHREADNAMES), ArgsManager::ALLOW_ANY, OptionsCategory::DEBUG_TEST);
+    gArgs.AddArg("-connectstats", strprintf("Keep timings of the phases of the last %u connected blocks for the getblockconnectstats rpc call (default: %u)", CONNECT_STATS_HISTORY_SIZE, DEFAULT_CONNECT_STATS), ArgsManager::ALLOW_ANY, OptionsCategory::DEBUG_TEST);
+    gArgs.AddArg("-connectstatslog", strprintf("Log the connect stats of every block as JSON, requires -connectstats (default: %u)", DEFAULT_CONNECT_STATS_LOG), ArgsManager::ALLOW_ANY, OptionsCategory::DEBUG_TEST);
     gArgs.AddArg("-logtimemicros", strprintf("Add microsecond precision to debug timestamps (default: %u)", DEFAULT_LOGTIMEMICROS), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::DEBUG_TEST);
     gArgs.AddArg("-mocktime=<n>", "Replace actual time with <n> seconds since epoch (default: 0)", ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::DEBUG_TEST);
     gArgs.AddArg("-maxsigcachesize=<n>", strprintf("Limit sum of signature cache and script execution cache sizes to <n> MiB (default: %u)", DEFAULT_MAX_SIG_CACHE_SIZE), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::DEBUG_TEST);
@@ -591,6 +655,7 @@ void SetupServerArgs()
     gArgs.AddArg("-rpcport=<port>", strprintf("Listen for JSON-RPC connections on <port> (default: %u, testnet: %u, devnet: %u, regtest: %u)", defaultBaseParams->RPCPort(), testnetBaseParams->RPCPort(), devnetBaseParams->RPCPort(), regtestBaseParams->RPCPort()), ArgsManager::ALLOW_ANY | ArgsManager::NETWORK_ONLY, OptionsCategory::RPC);
     gArgs.AddArg("-rpcserialversion", strprintf("Sets the serialization of raw transaction or block hex returned in non-verbose mode, non-segwit(0) or segwit(1) (default: %d)", DEFAULT_RPC_SERIALIZE_VERSION), ArgsManager::ALLOW_ANY, OptionsCategory::RPC);
     gArgs.AddArg("-rpcservertimeout=<n>", strprintf("Timeout during HTTP requests (default: %d)", DEFAULT_HTTP_SERVER_TIMEOUT), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::RPC);
+    gArgs.AddArg("-rpcbatchparallelism=<n>", strprintf("Set the number of threads executing the read-only calls of a batch request at once, taken from idle RPC threads (default: %d)", DEFAULT_RPC_BATCH_PARALLELISM), ArgsManager::ALLOW_ANY, OptionsCategory::RPC);
     gArgs.AddArg("-rpcthreads=<n>", strprintf("Set the number of threads to service RPC calls (default: %d)", DEFAULT_HTTP_THREADS), ArgsManager::ALLOW_ANY, OptionsCategory::RPC);
     gArgs.AddArg("-rpcuser=<user>", "Username for JSON-RPC connections", ArgsManager::ALLOW_ANY, OptionsCategory::RPC);
     gArgs.AddArg("-rpcworkqueue=<n>", strprintf("Set the depth of the work queue to service RPC calls (default: %d)", DEFAULT_HTTP_WORKQUEUE), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::RPC);
@@ -1022,10 +1087,17 @@ bool AppInitParameterInteraction()
         }
     }
 
+    std::string dbOptionError;
+    if (!CheckDBOptionArgs(dbOptionError)) {
+        return InitError(dbOptionError);
+    }
+
     // if using block pruning, then disallow txindex
     if (gArgs.GetArg("-prune", 0)) {
         if (gArgs.GetBoolArg("-txindex", DEFAULT_TXINDEX))
             return InitError(_("Prune mode is incompatible with -txindex.").translated);
+        if (gArgs.GetBoolArg("-customtxindex", DEFAULT_CUSTOMTXINDEX))
+            return InitError(_("Prune mode is incompatible with -customtxindex.").translated);
         if (!g_enabled_filter_types.empty()) {
             return InitError(_("Prune mode is incompatible with -blockfilterindex.").translated);
         }
@@ -1086,6 +1158,8 @@ bool AppInitParameterInteraction()
         mempool.setSanityCheck(1.0 / ratio);
     }
     fCheckBlockIndex = gArgs.GetBoolArg("-checkblockindex", chainparams.DefaultConsistencyChecks());
+    g_connectStats.SetActive(gArgs.GetBoolArg("-connectstats", DEFAULT_CONNECT_STATS));
+    g_connectStats.SetLogging(gArgs.GetBoolArg("-connectstatslog", DEFAULT_CONNECT_STATS_LOG));
     if (!gArgs.GetBoolArg("-checkpoints", DEFAULT_CHECKPOINTS_ENABLED)) {
         LogPrintf("conf: checkpoints disabled.\n");
         // Safe to const_cast, as we know it's always allocated, and is always in the global var
@@ -1344,6 +1418,13 @@ bool AppInitMain(InitInterfaces& interfaces)
             return InitError(strprintf("Could not open debug log file %s",
                 LogInstance().m_file_path.string()));
     }
+    if (gArgs.GetBoolArg("-logasync", DEFAULT_LOGASYNC)) {
+        const auto logAsyncBuffer = gArgs.GetArg("-logasyncbuffer", static_cast<int64_t>(DEFAULT_LOGASYNC_BUFFER));
+        if (logAsyncBuffer <= 0) {
+            return InitError(strprintf(_("Invalid -logasyncbuffer=%s, it has to be positive").translated, gArgs.GetArg("-logasyncbuffer", "")));
+        }
+        LogInstance().StartAsync(logAsyncBuffer);
+    }
 
     if (!LogInstance().m_log_timestamps)
         LogPrintf("Startup time: %s\n", FormatISO8601DateTime(GetTime()));
@@ -1376,10 +1457,12 @@ bool AppInitMain(InitInterfaces& interfaces)
     InitSignatureCache();
     InitScriptExecutionCache();
 
-    LogPrintf("Using %u threads for script verification\n", nScriptCheckThreads);
+    LogPrintf("Using %u threads for script and header signature verification\n", nScriptCheckThreads);
     if (nScriptCheckThreads) {
         for (int i=0; i<nScriptCheckThreads-1; i++)
             threadGroup.create_thread([i]() { return ThreadScriptCheck(i); });
+        for (int i=0; i<nScriptCheckThreads-1; i++)
+            threadGroup.create_thread([i]() { return ThreadSignatureRecovery(i); });
     }
 
     // Start the lightweight task scheduler thread
@@ -1439,6 +1522,16 @@ bool AppInitMain(InitInterfaces& interfaces)
 
     peerLogic.reset(new PeerLogicValidation(g_connman.get(), g_banman.get(), scheduler, gArgs.GetBoolArg("-enablebip61", DEFAULT_ENABLE_BIP61)));
     RegisterValidationInterface(peerLogic.get());
+    if (gArgs.GetBoolArg("-txvalidationthread", DEFAULT_TX_VALIDATION_THREAD)) {
+        const auto maxTxValidationQueue = gArgs.GetArg("-maxtxvalidationqueue", static_cast<int64_t>(DEFAULT_MAX_TX_VALIDATION_QUEUE));
+        if (maxTxValidationQueue <= 0) {
+            return InitError(strprintf(_("Invalid -maxtxvalidationqueue=%s, it has to be positive").translated, gArgs.GetArg("-maxtxvalidationqueue", "")));
+        }
+        auto validator = std::bind(&PeerLogicValidation::ProcessTransaction, peerLogic.get(), std::placeholders::_1, std::placeholders::_2);
+        const auto maxPeerTxValidationQueue = std::min<size_t>(maxTxValidationQueue, MAX_PEER_TX_VALIDATION_QUEUE);
+        g_txvalidationqueue.reset(new CTxValidationQueue(validator, maxTxValidationQueue, maxPeerTxValidationQueue));
+        g_txvalidationqueue->Start();
+    }
 
     // sanitize comments per BIP-0014, format user agent and check total size
     std::vector<std::string> uacomments;
@@ -1553,10 +1646,22 @@ bool AppInitMain(InitInterfaces& interfaces)
     nTotalCache = std::max(nTotalCache, nMinDbCache << 20); // total cache cannot be less than nMinDbCache
     nTotalCache = std::min(nTotalCache, nMaxDbCache << 20); // total cache cannot be greater than nMaxDbcache
     auto nCustomCacheSize = nTotalCache; // used for customs
+    // history databases are append-mostly and read back per account or vault, so a small cache will do
+    CDBOptions historyDBOptions(std::min(nCustomCacheSize / 8, nMaxHistoryDBCache << 20));
+    historyDBOptions.bloomBits = 10;
+    historyDBOptions.maxFileSize = 8 << 20;
+    historyDBOptions.compression = true;
+    // as is the undo of the custom state, only read back when blocks get disconnected
+    CDBOptions customUndoDBOptions(std::min(nCustomCacheSize / 8, nMaxCustomUndoDBCache << 20));
+    customUndoDBOptions.bloomBits = 10;
+    customUndoDBOptions.maxFileSize = 8 << 20;
+    customUndoDBOptions.compression = true;
     int64_t nBlockTreeDBCache = std::min(nTotalCache / 8, nMaxBlockDBCache << 20);
     nTotalCache -= nBlockTreeDBCache;
     int64_t nTxIndexCache = std::min(nTotalCache / 8, gArgs.GetBoolArg("-txindex", DEFAULT_TXINDEX) ? nMaxTxIndexCache << 20 : 0);
     nTotalCache -= nTxIndexCache;
+    int64_t nCustomTxIndexCache = std::min(nTotalCache / 8, gArgs.GetBoolArg("-customtxindex", DEFAULT_CUSTOMTXINDEX) ? nMaxTxIndexCache << 20 : 0);
+    nTotalCache -= nCustomTxIndexCache;
     int64_t filter_index_cache = 0;
     if (!g_enabled_filter_types.empty()) {
         size_t n_indexes = g_enabled_filter_types.size();
@@ -1575,11 +1680,16 @@ bool AppInitMain(InitInterfaces& interfaces)
     if (gArgs.GetBoolArg("-txindex", DEFAULT_TXINDEX)) {
         LogPrintf("* Using %.1f MiB for transaction index database\n", nTxIndexCache * (1.0 / 1024 / 1024));
     }
+    if (gArgs.GetBoolArg("-customtxindex", DEFAULT_CUSTOMTXINDEX)) {
+        LogPrintf("* Using %.1f MiB for custom transaction index database\n", nCustomTxIndexCache * (1.0 / 1024 / 1024));
+    }
     for (BlockFilterType filter_type : g_enabled_filter_types) {
         LogPrintf("* Using %.1f MiB for %s block filter index database\n",
                   filter_index_cache * (1.0 / 1024 / 1024), BlockFilterTypeName(filter_type));
     }
     LogPrintf("* Using %.1f MiB for chain state database\n", nCoinDBCache * (1.0 / 1024 / 1024));
+    LogPrintf("* Using %.1f MiB for custom state database\n", nCustomCacheSize * (1.0 / 1024 / 1024));
+    LogPrintf("* Using %.1f MiB block cache for each history database\n", historyDBOptions.blockCache * (1.0 / 1024 / 1024));
     LogPrintf("* Using %.1f MiB for in-memory UTXO set (plus up to %.1f MiB of unused mempool space)\n", nCoinCacheUsage * (1.0 / 1024 / 1024), nMempoolSizeMax * (1.0 / 1024 / 1024));
 
     bool fLoaded = false;
@@ -1659,34 +1769,130 @@ bool AppInitMain(InitInterfaces& interfaces)
                         "", CClientUIInterface::MSG_ERROR);
                 });
 
+                ResetCustomCSSnapshot();
                 pcustomcsDB.reset();
-                pcustomcsDB = std::make_unique<CStorageLevelDB>(GetDataDir() / "enhancedcs", nCustomCacheSize, false, fReset || fReindexChainState);
+                auto pcustomcsStateDB = std::make_shared<CStorageLevelDB>(GetDataDir() / "enhancedcs", nCustomCacheSize, false, fReset || fReindexChainState);
+                pcustomcsDB = std::make_unique<CStoragePrefixRouter>(pcustomcsStateDB);
+
+                // keep undo in a database of its own, moving it over if it got switched on or off
+                const auto undoPrefixes = {CUndosView::ByUndoKey::prefix(), CUndosView::ByUndoBundleKey::prefix()};
+                const auto undoDBPath = GetDataDir() / "enhancedcs_undo";
+                size_t movedUndos = 0;
+                bool movedAll = true;
+                if (gArgs.GetBoolArg("-enhancedcsundodb", DEFAULT_ENHANCEDCS_UNDO_DB)) {
+                    auto pcustomcsUndoDB = std::make_shared<CStorageLevelDB>(undoDBPath, customUndoDBOptions, false, fReset || fReindexChainState);
+                    for (auto undoPrefix : undoPrefixes) {
+                        pcustomcsDB->Route(undoPrefix, pcustomcsUndoDB);
+                        movedAll = movedAll && MoveStoragePrefix(*pcustomcsStateDB, *pcustomcsUndoDB, undoPrefix, movedUndos);
+                    }
+                } else if (fs::exists(undoDBPath)) {
+                    if (!fReset && !fReindexChainState) {
+                        CStorageLevelDB undoDB(undoDBPath, customUndoDBOptions);
+                        for (auto undoPrefix : undoPrefixes) {
+                            movedAll = movedAll && MoveStoragePrefix(undoDB, *pcustomcsStateDB, undoPrefix, movedUndos);
+                        }
+                    }
+                    if (movedAll) {
+                        fs::remove_all(undoDBPath);
+                    }
+                }
+                if (!movedAll) {
+                    strLoadError = _("Error moving undo data of the account database").translated;
+                    break;
+                }
+                if (movedUndos) {
+                    LogPrintf("Moved %u undo entries between enhancedcs and enhancedcs_undo\n", movedUndos);
+                }
+
                 pcustomcsview.reset();
                 pcustomcsview = std::make_unique<CCustomCSView>(*pcustomcsDB.get());
-                if (!fReset && !fReindexChainState) {
-                    if (!pcustomcsDB->IsEmpty() && pcustomcsview->GetDbVersion() != CCustomCSView::DbVersion) {
+                if (!fReset && !fReindexChainState && !pcustomcsDB->IsEmpty()) {
+                    auto dbVersion = pcustomcsview->GetDbVersion();
+                    if (dbVersion < 1 || dbVersion > CCustomCSView::DbVersion) {
                         strLoadError = _("Account database is unsuitable").translated;
                         break;
                     }
+                    if (dbVersion < 2) {
+                        // Version 2 indexes vaults by loan scheme, vault ratios fill in at the next ratio calculation
+                        LogPrintf("Indexing vaults by loan scheme...\n");
+                        pcustomcsview->IndexVaultSchemes();
+                    }
+                    if (dbVersion < 3) {
+                        // Version 3 keeps the ICX order book by token and price
+                        LogPrintf("Indexing ICX order book...\n");
+                        pcustomcsview->IndexICXOrderBook();
+                    }
+                    // Version 4 may hold block undo bundles (-undobundles), which older versions can't
+                    // read on disconnect. Earlier databases have none, so there is nothing to convert.
+                    if (dbVersion < 5) {
+                        // Version 5 writes every field of the history changes journal
+                        if (auto converted = pcustomcsview->ConvertHistoryChanges()) {
+                            LogPrintf("Converted %u history changes journal entries\n", converted);
+                        }
+                    }
                 }
 
                 // Ensure we are on latest DB version
                 pcustomcsview->SetDbVersion(CCustomCSView::DbVersion);
 
+                // undo is flushed ahead of the state it belongs to, drop what a crash left of it
+                const auto customHeight = static_cast<uint32_t>(pcustomcsview->GetLastHeight());
+                if (auto stale = pcustomcsview->EraseUndosAbove(customHeight)) {
+                    LogPrintf("Erased %u custom state undo entries above height %u\n", stale, customHeight);
+                }
+                if (!pcustomcsview->GetUndoCompleteHeight()) {
+                    pcustomcsview->SetUndoCompleteHeight(customHeight + 1);
+                }
+                pcustomcsview->EnableMasternodeRegistry();
+
+                // block undo bundles can't be read by per tx undo, unpack them when switched off
+                fUndoBundles = gArgs.GetBoolArg("-undobundles", DEFAULT_UNDO_BUNDLES);
+                if (!fUndoBundles) {
+                    if (auto unbundled = pcustomcsview->UnbundleUndos()) {
+                        LogPrintf("Unpacked the custom state undo of %u blocks\n", unbundled);
+                    }
+                }
+
                 // make account history db
                 paccountHistoryDB.reset();
                 if (gArgs.GetBoolArg("-acindex", DEFAULT_ACINDEX)) {
-                    paccountHistoryDB = std::make_unique<CAccountHistoryStorage>(GetDataDir() / "history", nCustomCacheSize, false, fReset || fReindexChainState);
+                    paccountHistoryDB = std::make_unique<CAccountHistoryStorage>(GetDataDir() / "history", historyDBOptions, false, fReset || fReindexChainState);
                 }
 
                 pburnHistoryDB.reset();
-                pburnHistoryDB = std::make_unique<CBurnHistoryStorage>(GetDataDir() / "burn", nCustomCacheSize, false, fReset || fReindexChainState);
+                pburnHistoryDB = std::make_unique<CBurnHistoryStorage>(GetDataDir() / "burn", historyDBOptions, false, fReset || fReindexChainState);
 
                 // Create vault history DB
                 pvaultHistoryDB.reset();
                 if (gArgs.GetBoolArg("-vaultindex", DEFAULT_VAULTINDEX)) {
-                    pvaultHistoryDB = std::make_unique<CVaultHistoryStorage>(GetDataDir() / "vault", nCustomCacheSize, false, fReset || fReindexChainState);
+                    pvaultHistoryDB = std::make_unique<CVaultHistoryStorage>(GetDataDir() / "vault", historyDBOptions, false, fReset || fReindexChainState);
+                }
+
+                // Create pool history DB
+                ppoolHistoryDB.reset();
+                if (gArgs.GetBoolArg("-poolindex", DEFAULT_POOLINDEX)) {
+                    ppoolHistoryDB = std::make_unique<CPoolHistoryStorage>(GetDataDir() / "poolhistory", historyDBOptions, false, fReset || fReindexChainState);
+                }
+
+                // Create oracle history DB
+                poracleHistoryDB.reset();
+                if (gArgs.GetBoolArg("-oracleindex", DEFAULT_ORACLEINDEX)) {
+                    poracleHistoryDB = std::make_unique<COracleHistoryStorage>(GetDataDir() / "oraclehistory", historyDBOptions, false, fReset || fReindexChainState);
+                }
+
+                // History changes of connected blocks are applied by the history indexes
+                // and published to the ZMQ DeFi topics
+                bool collectAccounts = paccountHistoryDB != nullptr;
+                bool collectVaults = pvaultHistoryDB != nullptr;
+#if ENABLE_ZMQ
+                if (g_zmq_notification_interface) {
+                    collectAccounts |= g_zmq_notification_interface->IsPublishing("pubaccountdiffs")
+                                    || g_zmq_notification_interface->IsPublishing("pubvaultstates")
+                                    || g_zmq_notification_interface->IsPublishing("pubfutureswaps");
+                    collectVaults |= g_zmq_notification_interface->IsPublishing("pubvaultstates");
                 }
+#endif
+                phistoryCollector = std::make_unique<CHistoryCollector>(collectAccounts, collectVaults, ppoolHistoryDB != nullptr, poracleHistoryDB != nullptr);
 
                 // If necessary, upgrade from older database format.
                 // This is a no-op if we cleared the coinsviewdb with -reindex or -reindex-chainstate
@@ -1807,11 +2013,44 @@ bool AppInitMain(InitInterfaces& interfaces)
         g_txindex->Start();
     }
 
+    if (gArgs.GetBoolArg("-customtxindex", DEFAULT_CUSTOMTXINDEX)) {
+        g_customtxindex = std::make_unique<CustomTxIndex>(nCustomTxIndexCache, false, fReindex);
+        g_customtxindex->Start();
+    }
+
     for (const auto& filter_type : g_enabled_filter_types) {
         InitBlockFilterIndex(filter_type, filter_index_cache, false, fReindex);
         GetBlockFilterIndex(filter_type)->Start();
     }
 
+    // History indexes only keep the keys written per block, the history itself
+    // lives in the databases opened along with the chain state
+    const int64_t history_index_cache = nMinDbCache << 20;
+    const auto checkpointEntries = gArgs.GetArg("-acbalancecheckpointentries", static_cast<int64_t>(DEFAULT_BALANCE_CHECKPOINT_ENTRIES));
+    if (checkpointEntries < 0 || checkpointEntries > std::numeric_limits<uint32_t>::max()) {
+        return InitError(strprintf(_("Invalid -acbalancecheckpointentries=%s").translated, gArgs.GetArg("-acbalancecheckpointentries", "")));
+    }
+    nBalanceCheckpointEntries = checkpointEntries;
+    const auto checkpointBlocks = gArgs.GetArg("-acbalancecheckpointblocks", static_cast<int64_t>(DEFAULT_BALANCE_CHECKPOINT_BLOCKS));
+    if (checkpointBlocks < 0 || checkpointBlocks > std::numeric_limits<uint32_t>::max()) {
+        return InitError(strprintf(_("Invalid -acbalancecheckpointblocks=%s").translated, gArgs.GetArg("-acbalancecheckpointblocks", "")));
+    }
+    nBalanceCheckpointBlocks = checkpointBlocks;
+    if (paccountHistoryDB) {
+        InitHistoryIndex(HistoryIndexType::Account, *paccountHistoryDB, history_index_cache, false, fReindex || fReindexChainState);
+    }
+    InitHistoryIndex(HistoryIndexType::Burn, *pburnHistoryDB, history_index_cache, false, fReindex || fReindexChainState);
+    if (pvaultHistoryDB) {
+        InitHistoryIndex(HistoryIndexType::Vault, *pvaultHistoryDB, history_index_cache, false, fReindex || fReindexChainState);
+    }
+    if (ppoolHistoryDB) {
+        InitHistoryIndex(HistoryIndexType::Pool, *ppoolHistoryDB, history_index_cache, false, fReindex || fReindexChainState);
+    }
+    if (poracleHistoryDB) {
+        InitHistoryIndex(HistoryIndexType::Oracle, *poracleHistoryDB, history_index_cache, false, fReindex || fReindexChainState);
+    }
+    ForEachHistoryIndex([](HistoryIndex& index) { index.Start(); });
+
     // ********************************************************* Step 9.a: load wallet
     for (const auto& client : interfaces.chain_clients) {
         if (!client->load()) {
@@ -1934,6 +2173,14 @@ bool AppInitMain(InitInterfaces& interfaces)
         vImportFiles.push_back(strFile);
     }
 
+    const auto prefetchThreads = gArgs.GetArg("-blockprefetch", DEFAULT_BLOCK_PREFETCH_THREADS);
+    if (prefetchThreads < 0 || prefetchThreads > MAX_BLOCK_PREFETCH_THREADS) {
+        return InitError(strprintf(_("Invalid -blockprefetch=%s, it has to be from 0 to %d").translated, gArgs.GetArg("-blockprefetch", ""), MAX_BLOCK_PREFETCH_THREADS));
+    }
+    if (prefetchThreads > 0) {
+        g_blockprefetcher.reset(new CBlockPrefetcher(chainparams.GetConsensus(), prefetchThreads));
+    }
+
     threadGroup.create_thread(std::bind(&ThreadImport, vImportFiles));
 
     // Wait for genesis block to be processed
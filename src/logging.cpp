@@ -77,6 +77,7 @@ bool BCLog::Logger::StartLogging()
 
 void BCLog::Logger::DisconnectTestLogger()
 {
+    StopAsync();
     std::lock_guard<std::mutex> scoped_lock(m_cs);
     m_buffering = true;
     if (m_fileout != nullptr) fclose(m_fileout);
@@ -250,9 +251,25 @@ void BCLog::Logger::LogPrintStr(const std::string& str)
         return;
     }
 
+    if (m_async) {
+        if (m_async_queue.full()) {
+            ++m_async_dropped;
+            ++m_async_unreported_drops;
+            return;
+        }
+        m_async_queue.push_back(std::move(str_prefixed));
+        m_async_cv.notify_one();
+        return;
+    }
+
+    WriteStr(str_prefixed);
+}
+
+void BCLog::Logger::WriteStr(const std::string& str)
+{
     if (m_print_to_console) {
         // print to console
-        fwrite(str_prefixed.data(), 1, str_prefixed.size(), stdout);
+        fwrite(str.data(), 1, str.size(), stdout);
         fflush(stdout);
     }
     if (m_print_to_file) {
@@ -268,10 +285,76 @@ void BCLog::Logger::LogPrintStr(const std::string& str)
                 m_fileout = new_fileout;
             }
         }
-        FileWriteStr(str_prefixed, m_fileout);
+        FileWriteStr(str, m_fileout);
+    }
+}
+
+void BCLog::Logger::StartAsync(size_t capacity)
+{
+    std::lock_guard<std::mutex> scoped_lock(m_cs);
+    if (m_async || capacity == 0) {
+        return;
+    }
+    m_async_queue.set_capacity(capacity);
+    m_async = true;
+    m_async_thread = std::thread(&BCLog::Logger::AsyncWriter, this);
+}
+
+void BCLog::Logger::StopAsync()
+{
+    {
+        std::lock_guard<std::mutex> scoped_lock(m_cs);
+        if (!m_async_thread.joinable()) {
+            return;
+        }
+        m_async_stop = true;
+    }
+    m_async_cv.notify_one();
+    m_async_thread.join();
+
+    std::lock_guard<std::mutex> scoped_lock(m_cs);
+    m_async_stop = false;
+}
+
+void BCLog::Logger::AsyncWriter()
+{
+    util::ThreadRename("logger");
+
+    std::vector<std::string> batch;
+    while (true) {
+        uint64_t dropped;
+        {
+            std::unique_lock<std::mutex> lock(m_cs);
+            m_async_cv.wait(lock, [this] { return m_async_stop || !m_async_queue.empty(); });
+            if (m_async_queue.empty()) {
+                // everything queued is written, go on synchronously from here
+                m_async = false;
+                return;
+            }
+            batch.assign(std::make_move_iterator(m_async_queue.begin()), std::make_move_iterator(m_async_queue.end()));
+            m_async_queue.clear();
+            dropped = m_async_unreported_drops;
+            m_async_unreported_drops = 0;
+        }
+
+        for (const auto& str : batch) {
+            WriteStr(str);
+        }
+        if (dropped) {
+            auto notice = strprintf("Dropped %u log messages, the async log queue was full\n", dropped);
+            WriteStr(m_log_timestamps ? FormatISO8601DateTime(GetTime()) + ' ' + notice : notice);
+        }
+        m_async_written += batch.size();
+        batch.clear();
     }
 }
 
+BCLog::Logger::AsyncStats BCLog::Logger::GetAsyncStats() const
+{
+    std::lock_guard<std::mutex> scoped_lock(m_cs);
+    return {m_async, m_async_queue.capacity(), m_async_queue.size(), m_async_written, m_async_dropped};
+}
+
 void BCLog::Logger::ShrinkDebugFile()
 {
     // Amount of debug.log to save at end when shrinking (must fit in memory)
@@ -11,17 +11,23 @@
 #include <util/time.h>
 
 #include <atomic>
+#include <condition_variable>
 #include <cstdint>
 #include <list>
 #include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 #include <unordered_map>
 
+#include <boost/circular_buffer.hpp>
+
 static const bool DEFAULT_LOGTIMEMICROS = false;
 static const bool DEFAULT_LOGIPS        = false;
 static const bool DEFAULT_LOGTIMESTAMPS = true;
 static const bool DEFAULT_LOGTHREADNAMES = false;
+static const bool DEFAULT_LOGASYNC = false;
+static const size_t DEFAULT_LOGASYNC_BUFFER = 65536;
 extern const char * const DEFAULT_DEBUGLOGFILE;
 
 extern bool fLogIPs;
@@ -84,7 +90,24 @@ namespace BCLog {
         /** Log categories bitfield. */
         std::atomic<uint32_t> m_categories{0};
 
+        /**
+         * When logging asynchronously, messages are queued for the writer thread,
+         * and dropped while the queue is full. Only the writer thread writes the
+         * outputs while m_async is set.
+         */
+        bool m_async{false};                                  // GUARDED_BY(m_cs)
+        bool m_async_stop{false};                             // GUARDED_BY(m_cs)
+        boost::circular_buffer<std::string> m_async_queue;    // GUARDED_BY(m_cs)
+        uint64_t m_async_unreported_drops{0};                 // GUARDED_BY(m_cs)
+        std::condition_variable m_async_cv;
+        std::thread m_async_thread;
+        std::atomic<uint64_t> m_async_written{0};
+        std::atomic<uint64_t> m_async_dropped{0};
+
         std::string LogTimestampStr(const std::string& str);
+        /** Write to the console and file outputs */
+        void WriteStr(const std::string& str);
+        void AsyncWriter();
 
     public:
         bool m_print_to_console = false;
@@ -112,6 +135,20 @@ namespace BCLog {
         /** Only for testing */
         void DisconnectTestLogger();
 
+        /** Write messages from a thread of their own, queueing up to capacity of them */
+        void StartAsync(size_t capacity);
+        /** Write the queued messages and go back to writing synchronously */
+        void StopAsync();
+
+        struct AsyncStats {
+            bool active;
+            size_t capacity;
+            size_t queued;
+            uint64_t written;
+            uint64_t dropped;
+        };
+        AsyncStats GetAsyncStats() const;
+
         void ShrinkDebugFile();
 
         uint32_t GetCategoryMask() const { return m_categories.load(); }
@@ -164,13 +201,14 @@ static inline void LogPrintf(const char* fmt, const Args&... args)
     }
 }
 
-template <typename... Args>
-static inline void LogPrint(const BCLog::LogFlags& category, const Args&... args)
-{
-    if (LogAcceptCategory((category))) {
-        LogPrintf(args...);
-    }
-}
+// Use a macro instead of a function for conditional logging to prevent
+// evaluating arguments when logging for the category is not enabled.
+#define LogPrint(category, ...)              \
+    do {                                     \
+        if (LogAcceptCategory((category))) { \
+            LogPrintf(__VA_ARGS__);          \
+        }                                    \
+    } while (0)
 
 /** Implementation that logs at most every x milliseconds. If the category is enabled, it does not time throttle */
 template <typename... Args>
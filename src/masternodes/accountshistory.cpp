@@ -5,6 +5,8 @@
 #include <masternodes/accountshistory.h>
 #include <masternodes/accounts.h>
 #include <masternodes/masternodes.h>
+#include <masternodes/oraclehistory.h>
+#include <masternodes/poolhistory.h>
 #include <masternodes/vaulthistory.h>
 #include <key_io.h>
 
@@ -30,126 +32,186 @@ Res CAccountsHistoryView::EraseAccountHistory(const AccountHistoryKey& key)
     return Res::Ok();
 }
 
-CAccountHistoryStorage::CAccountHistoryStorage(const fs::path& dbName, std::size_t cacheSize, bool fMemory, bool fWipe)
-    : CStorageView(new CStorageLevelDB(dbName, cacheSize, fMemory, fWipe))
+void CAccountsHistoryView::WriteBalanceCheckpoint(BalanceCheckpointKey const & key, CBalances const & balances)
 {
+    WriteBy<ByBalanceCheckpointKey>(key, balances);
 }
 
-CBurnHistoryStorage::CBurnHistoryStorage(const fs::path& dbName, std::size_t cacheSize, bool fMemory, bool fWipe)
-    : CStorageView(new CStorageLevelDB(dbName, cacheSize, fMemory, fWipe))
+void CAccountsHistoryView::ForEachBalanceCheckpoint(std::function<bool(BalanceCheckpointKey const &, CLazySerialize<CBalances>)> callback, BalanceCheckpointKey const & start)
 {
+    ForEach<ByBalanceCheckpointKey, BalanceCheckpointKey, CBalances>(callback, start);
 }
 
-CAccountsHistoryWriter::CAccountsHistoryWriter(CCustomCSView & storage, uint32_t height, uint32_t txn, const uint256& txid, uint8_t type,
-                                               CHistoryWriters* writers)
-    : CStorageView(new CFlushableStorageKV(static_cast<CStorageKV&>(storage.GetStorage()))), height(height), txn(txn),
-    txid(txid), type(type), writers(writers)
+std::optional<BalanceCheckpointKey> CAccountsHistoryView::GetBalanceCheckpoint(CScript const & owner, uint32_t height, TAmounts& balances)
 {
+    std::optional<BalanceCheckpointKey> checkpoint;
+    ForEachBalanceCheckpoint([&](BalanceCheckpointKey const & key, CLazySerialize<CBalances> valueLazy) {
+        if (key.owner == owner) {
+            checkpoint = key;
+            balances = valueLazy.get().balances;
+        }
+        return false;
+    }, {owner, height});
+    return checkpoint;
 }
 
-Res CAccountsHistoryWriter::AddBalance(CScript const & owner, CTokenAmount amount)
+uint32_t CAccountsHistoryView::SumAccountHistory(CScript const & owner, std::optional<uint32_t> checkpoint, uint32_t height, TAmounts& balances)
 {
-    auto res = CCustomCSView::AddBalance(owner, amount);
-    if (writers && amount.nValue != 0 && res.ok) {
-        writers->AddBalance(owner, amount, vaultID);
-    }
-
-    return res;
+    uint32_t count{0};
+    ForEachAccountHistory([&](AccountHistoryKey const & key, CLazySerialize<AccountHistoryValue> valueLazy) {
+        if (key.owner != owner || (checkpoint && key.blockHeight <= *checkpoint)) {
+            return false;
+        }
+        for (const auto& [id, amount] : valueLazy.get().diff) {
+            balances[id] += amount;
+        }
+        ++count;
+        return true;
+    }, {owner, height, std::numeric_limits<uint32_t>::max()});
+    return count;
 }
 
-Res CAccountsHistoryWriter::SubBalance(CScript const & owner, CTokenAmount amount)
+static CBalances NonZeroBalances(const TAmounts& amounts)
 {
-    auto res = CCustomCSView::SubBalance(owner, amount);
-    if (writers && res.ok && amount.nValue != 0) {
-        writers->SubBalance(owner, amount, vaultID);
+    CBalances balances;
+    for (const auto& [id, amount] : amounts) {
+        if (amount != 0) {
+            balances.balances.emplace(id, amount);
+        }
     }
+    return balances;
+}
 
-    return res;
+CBalances CAccountsHistoryView::GetBalancesAt(CScript const & owner, uint32_t height)
+{
+    TAmounts balances;
+    auto checkpoint = GetBalanceCheckpoint(owner, height, balances);
+    SumAccountHistory(owner, checkpoint ? std::make_optional(checkpoint->blockHeight) : std::nullopt, height, balances);
+    return NonZeroBalances(balances);
 }
 
-bool CAccountsHistoryWriter::Flush()
+void CAccountsHistoryView::AddBalanceCheckpoints(MapKV& changes, uint32_t height)
 {
-    if (writers) {
-        writers->Flush(height, txid, txn, type, vaultID);
+    if ((!nBalanceCheckpointEntries && !nBalanceCheckpointBlocks) || height == 0) {
+        return;
+    }
+
+    std::map<CScript, std::pair<TAmounts, uint32_t>> blockDiffs;
+    const auto prefix = ByAccountHistoryKey::prefix();
+    for (auto it = changes.lower_bound({prefix}); it != changes.end() && it->first.front() == prefix; ++it) {
+        std::pair<uint8_t, AccountHistoryKey> key;
+        AccountHistoryValue value;
+        if (!it->second || !BytesToDbType(it->first, key) || !BytesToDbType(*it->second, value)) {
+            continue;
+        }
+        auto& [diffs, count] = blockDiffs[key.second.owner];
+        for (const auto& [id, amount] : value.diff) {
+            diffs[id] += amount;
+        }
+        ++count;
+    }
+
+    for (auto& [owner, block] : blockDiffs) {
+        // the history of this height may be in already if the block is applied again
+        TAmounts balances;
+        auto checkpoint = GetBalanceCheckpoint(owner, height - 1, balances);
+        const auto checkpointHeight = checkpoint ? std::make_optional(checkpoint->blockHeight) : std::nullopt;
+        const auto count = SumAccountHistory(owner, checkpointHeight, height - 1, balances) + block.second;
+
+        if ((!nBalanceCheckpointEntries || count < nBalanceCheckpointEntries)
+        && (!nBalanceCheckpointBlocks || height - checkpointHeight.value_or(0) < nBalanceCheckpointBlocks)) {
+            continue;
+        }
+        for (const auto& [id, amount] : block.first) {
+            balances[id] += amount;
+        }
+        const auto key = std::make_pair(ByBalanceCheckpointKey::prefix(), BalanceCheckpointKey{owner, height});
+        changes[DbTypeToBytes(key)] = DbTypeToBytes(NonZeroBalances(balances));
     }
-    return CCustomCSView::Flush();
 }
 
-CAccountsHistoryEraser::CAccountsHistoryEraser(CCustomCSView & storage, uint32_t height, uint32_t txn, CHistoryErasers& erasers)
-    : CStorageView(new CFlushableStorageKV(static_cast<CStorageKV&>(storage.GetStorage()))), height(height), txn(txn), erasers(erasers)
+CAccountHistoryStorage::CAccountHistoryStorage(const fs::path& dbName, const CDBOptions& dbOptions, bool fMemory, bool fWipe)
+    : CStorageView(new CStorageLevelDB(dbName, dbOptions, fMemory, fWipe))
 {
 }
 
-Res CAccountsHistoryEraser::AddBalance(CScript const & owner, CTokenAmount)
+CAccountHistoryStorage::CAccountHistoryStorage(CStorageKV* storage)
+    : CStorageView(storage)
 {
-    erasers.AddBalance(owner, vaultID);
-    return Res::Ok();
 }
 
-Res CAccountsHistoryEraser::SubBalance(CScript const & owner, CTokenAmount)
+CBurnHistoryStorage::CBurnHistoryStorage(const fs::path& dbName, const CDBOptions& dbOptions, bool fMemory, bool fWipe)
+    : CStorageView(new CStorageLevelDB(dbName, dbOptions, fMemory, fWipe))
 {
-    erasers.SubBalance(owner, vaultID);
-    return Res::Ok();
 }
 
-bool CAccountsHistoryEraser::Flush()
+CBurnHistoryStorage::CBurnHistoryStorage(CStorageKV* storage)
+    : CStorageView(storage)
 {
-    erasers.Flush(height, txn, vaultID);
-    return Res::Ok(); // makes sure no changes are applyed to underlaying view
 }
 
-CHistoryErasers::CHistoryErasers(CAccountHistoryStorage* historyView, CBurnHistoryStorage* burnView, CVaultHistoryStorage* vaultView)
-    : historyView(historyView), burnView(burnView), vaultView(vaultView) {}
+CAccountsHistoryWriter::CAccountsHistoryWriter(CCustomCSView & storage, uint32_t height, uint32_t txn, const uint256& txid, uint8_t type,
+                                               CHistoryWriters* writers)
+    : CStorageView(new CFlushableStorageKV(static_cast<CStorageKV&>(storage.GetStorage()))), height(height), txn(txn),
+    txid(txid), type(type), writers(writers)
+{
+}
 
-void CHistoryErasers::AddBalance(const CScript& owner, const uint256& vaultID)
+Res CAccountsHistoryWriter::AddBalance(CScript const & owner, CTokenAmount amount)
 {
-    if (historyView) {
-        accounts.insert(owner);
-    }
-    if (burnView && owner == Params().GetConsensus().burnAddress) {
-        burnAccounts.insert(owner);
-    }
-    if (vaultView && !vaultID.IsNull()) {
-        vaults.insert(vaultID);
+    auto res = CCustomCSView::AddBalance(owner, amount);
+    if (writers && amount.nValue != 0 && res.ok) {
+        writers->AddBalance(owner, amount, vaultID);
     }
+
+    return res;
 }
 
-void CHistoryErasers::SubFeeBurn(const CScript& owner)
+Res CAccountsHistoryWriter::SubBalance(CScript const & owner, CTokenAmount amount)
 {
-    if (burnView) {
-        burnAccounts.insert(owner);
+    auto res = CCustomCSView::SubBalance(owner, amount);
+    if (writers && res.ok && amount.nValue != 0) {
+        writers->SubBalance(owner, amount, vaultID);
     }
+
+    return res;
 }
 
-void CHistoryErasers::SubBalance(const CScript& owner, const uint256& vaultID)
+Res CAccountsHistoryWriter::SetPoolPair(DCT_ID const & poolId, uint32_t height, CPoolPair const & pool)
 {
-    if (historyView) {
-        accounts.insert(owner);
-    }
-    if (burnView && owner == Params().GetConsensus().burnAddress) {
-        burnAccounts.insert(owner);
+    std::optional<CPoolPair> before;
+    if (writers && writers->CollectsPoolSwaps() && pool.swapEvent) {
+        before = GetPoolPair(poolId);
     }
-    if (vaultView && !vaultID.IsNull()) {
-        vaults.insert(vaultID);
+    auto res = CCustomCSView::SetPoolPair(poolId, height, pool);
+    if (before && res.ok) {
+        writers->AddPoolSwap(poolId, *before, pool);
     }
+
+    return res;
 }
 
-void CHistoryErasers::Flush(const uint32_t height, const uint32_t txn, const uint256& vaultID)
+Res CAccountsHistoryWriter::SetOracleData(const COracleId& oracleId, int64_t timestamp, const CTokenPrices& tokenPrices)
 {
-    if (historyView) {
-        for (const auto& account : accounts) {
-            historyView->EraseAccountHistory({account, height, txn});
-        }
+    auto res = CCustomCSView::SetOracleData(oracleId, timestamp, tokenPrices);
+    if (writers && res.ok) {
+        writers->AddOraclePrices(oracleId, timestamp, tokenPrices);
     }
-    if (burnView) {
-        for (const auto& account : burnAccounts) {
-            burnView->EraseAccountHistory({account, height, txn});
-        }
+
+    return res;
+}
+
+bool CAccountsHistoryWriter::Flush()
+{
+    if (writers) {
+        writers->Flush(height, txid, txn, type, vaultID);
     }
+    return CCustomCSView::Flush();
 }
 
-CHistoryWriters::CHistoryWriters(CAccountHistoryStorage* historyView, CBurnHistoryStorage* burnView, CVaultHistoryStorage* vaultView)
-    : historyView(historyView), burnView(burnView), vaultView(vaultView) {}
+CHistoryWriters::CHistoryWriters(CAccountHistoryStorage* historyView, CBurnHistoryStorage* burnView, CVaultHistoryStorage* vaultView,
+                                 CPoolSwapCollector* poolSwaps, COracleHistoryStorage* oracleView)
+    : historyView(historyView), burnView(burnView), poolSwaps(poolSwaps), oracleView(oracleView), vaultView(vaultView) {}
 
 extern std::string ScriptToString(CScript const& script);
 
@@ -186,6 +248,20 @@ void CHistoryWriters::SubBalance(const CScript& owner, const CTokenAmount amount
     }
 }
 
+void CHistoryWriters::AddPoolSwap(const DCT_ID& poolId, const CPoolPair& before, const CPoolPair& after)
+{
+    if (poolSwaps) {
+        swaps.emplace_back(poolId, before, after);
+    }
+}
+
+void CHistoryWriters::AddOraclePrices(const COracleId& oracleId, int64_t timestamp, const CTokenPrices& tokenPrices)
+{
+    if (oracleView) {
+        oraclePrices.emplace_back(oracleId, timestamp, tokenPrices);
+    }
+}
+
 void CHistoryWriters::Flush(const uint32_t height, const uint256& txid, const uint32_t txn, const uint8_t type, const uint256& vaultID)
 {
     if (historyView) {
@@ -212,7 +288,149 @@ void CHistoryWriters::Flush(const uint32_t height, const uint256& txid, const ui
             vaultView->WriteGlobalScheme({height, txn, globalLoanScheme.schemeCreationTxid}, {globalLoanScheme, type, txid});
         }
     }
+    if (poolSwaps) {
+        for (const auto& [poolId, before, after] : swaps) {
+            poolSwaps->AddSwap(poolId, before, after);
+        }
+    }
+    if (oracleView) {
+        for (const auto& [oracleId, timestamp, tokenPrices] : oraclePrices) {
+            for (const auto& [token, prices] : tokenPrices) {
+                for (const auto& [currency, price] : prices) {
+                    oracleView->WriteOraclePrice({token, currency, height, txn, oracleId}, {txid, timestamp, price});
+                }
+            }
+        }
+    }
+}
+
+void ApplySettlementCredits(CCustomCSView& view, uint32_t height, const std::map<CScript, std::vector<CSettlementCredit>>& credits,
+                            CAccountHistoryStorage* historyView)
+{
+    const auto writeHistory = [&](const CScript& owner, const CSettlementCredit& credit) {
+        if (historyView && credit.amount.nValue != 0) {
+            const TAmounts diff{{credit.amount.nTokenId, credit.amount.nValue}};
+            LogPrint(BCLog::ACCOUNTCHANGE, "AccountChange: txid=%s addr=%s change=%s\n", uint256().GetHex(), ScriptToString(owner), (CBalances{diff}.ToString()));
+            historyView->WriteAccountHistory({owner, height, credit.txn}, {{}, credit.type, diff});
+        }
+    };
+
+    for (const auto& [owner, ownerCredits] : credits) {
+        CBalances total;
+        auto summed = true;
+        for (const auto& credit : ownerCredits) {
+            summed = summed && total.Add(credit.amount).ok;
+        }
+
+        CCustomCSView ownerView(view);
+        if (summed && ownerView.AddBalances(owner, total)) {
+            ownerView.Flush();
+            for (const auto& credit : ownerCredits) {
+                writeHistory(owner, credit);
+            }
+            continue;
+        }
+
+        for (const auto& credit : ownerCredits) {
+            if (view.AddBalance(owner, credit.amount)) {
+                writeHistory(owner, credit);
+            }
+        }
+    }
+}
+
+// History is never read back on the validation path, so the collecting views
+// have nothing underneath their in-memory changes
+class CHistoryCollectorBase : public CStorageKV {
+public:
+    bool Exists(const TBytes&) const override { return false; }
+    bool Write(const TBytes&, const TBytes&) override { return false; }
+    bool Erase(const TBytes&) override { return false; }
+    bool Read(const TBytes&, TBytes&) const override { return false; }
+    std::unique_ptr<CStorageKVIterator> NewIterator() override { return std::make_unique<CStorageKVEmptyIterator>(); }
+    size_t SizeEstimate() const override { return 0; }
+    void Discard() override {}
+    bool Flush() override { return false; }
+};
+
+static CHistoryCollectorBase historyCollectorBase;
+
+CHistoryCollector::CHistoryCollector(bool accounts, bool vaults, bool pools, bool oracles)
+{
+    if (accounts) {
+        accountChanges = new CFlushableStorageKV(historyCollectorBase);
+        accountView = std::make_unique<CAccountHistoryStorage>(accountChanges);
+    }
+    burnChanges = new CFlushableStorageKV(historyCollectorBase);
+    burnView = std::make_unique<CBurnHistoryStorage>(burnChanges);
+    if (vaults) {
+        vaultChanges = new CFlushableStorageKV(historyCollectorBase);
+        vaultView = std::make_unique<CVaultHistoryStorage>(vaultChanges);
+    }
+    if (pools) {
+        poolChanges = new CFlushableStorageKV(historyCollectorBase);
+        poolView = std::make_unique<CPoolHistoryStorage>(poolChanges);
+        poolSwaps = std::make_unique<CPoolSwapCollector>();
+    }
+    if (oracles) {
+        oracleChanges = new CFlushableStorageKV(historyCollectorBase);
+        oracleView = std::make_unique<COracleHistoryStorage>(oracleChanges);
+    }
+}
+
+CHistoryCollector::~CHistoryCollector() = default;
+
+void CHistoryCollector::CollectState(uint32_t height, int64_t time, const MapKV& stateChanges)
+{
+    if (poolSwaps) {
+        poolSwaps->Flush(*poolView, height, time, stateChanges);
+    }
+    if (oracleView) {
+        oracleView->WriteFixedIntervalPrices(height, stateChanges);
+    }
+}
+
+CHistoryChanges CHistoryCollector::Take(const uint256& blockHash)
+{
+    CHistoryChanges changes{blockHash};
+    if (accountChanges) {
+        changes.accounts = std::move(accountChanges->GetRaw());
+    }
+    changes.burns = std::move(burnChanges->GetRaw());
+    if (vaultChanges) {
+        changes.vaults = std::move(vaultChanges->GetRaw());
+    }
+    if (poolChanges) {
+        changes.pools = std::move(poolChanges->GetRaw());
+    }
+    if (oracleChanges) {
+        changes.oracles = std::move(oracleChanges->GetRaw());
+    }
+    Discard();
+    return changes;
 }
 
+void CHistoryCollector::Discard()
+{
+    if (accountChanges) {
+        accountChanges->Discard();
+    }
+    burnChanges->Discard();
+    if (vaultChanges) {
+        vaultChanges->Discard();
+    }
+    if (poolChanges) {
+        poolChanges->Discard();
+        poolSwaps->Discard();
+    }
+    if (oracleChanges) {
+        oracleChanges->Discard();
+    }
+}
+
+uint32_t nBalanceCheckpointEntries = DEFAULT_BALANCE_CHECKPOINT_ENTRIES;
+uint32_t nBalanceCheckpointBlocks = DEFAULT_BALANCE_CHECKPOINT_BLOCKS;
+
 std::unique_ptr<CAccountHistoryStorage> paccountHistoryDB;
 std::unique_ptr<CBurnHistoryStorage> pburnHistoryDB;
+std::unique_ptr<CHistoryCollector> phistoryCollector;
@@ -8,10 +8,14 @@
 #include <amount.h>
 #include <flushablestorage.h>
 #include <masternodes/auctionhistory.h>
+#include <masternodes/historychanges.h>
 #include <masternodes/masternodes.h>
 #include <script/script.h>
 #include <uint256.h>
 
+class COracleHistoryStorage;
+class CPoolHistoryStorage;
+class CPoolSwapCollector;
 class CVaultHistoryView;
 class CVaultHistoryStorage;
 
@@ -56,6 +60,28 @@ struct AccountHistoryValue {
     }
 };
 
+// Balances of an owner after the block at blockHeight, newest first like the history
+struct BalanceCheckpointKey {
+    CScript owner;
+    uint32_t blockHeight;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(owner);
+
+        if (ser_action.ForRead()) {
+            READWRITE(WrapBigEndian(blockHeight));
+            blockHeight = ~blockHeight;
+        }
+        else {
+            uint32_t blockHeight_ = ~blockHeight;
+            READWRITE(WrapBigEndian(blockHeight_));
+        }
+    }
+};
+
 class CAccountsHistoryView : public virtual CStorageView
 {
 public:
@@ -64,21 +90,40 @@ public:
     Res EraseAccountHistory(AccountHistoryKey const & key);
     void ForEachAccountHistory(std::function<bool(AccountHistoryKey const &, CLazySerialize<AccountHistoryValue>)> callback, AccountHistoryKey const & start = {});
 
+    void WriteBalanceCheckpoint(BalanceCheckpointKey const & key, CBalances const & balances);
+    void ForEachBalanceCheckpoint(std::function<bool(BalanceCheckpointKey const &, CLazySerialize<CBalances>)> callback, BalanceCheckpointKey const & start = {});
+
+    // Balances of owner after the block at height, from its nearest checkpoint and the history since
+    CBalances GetBalancesAt(CScript const & owner, uint32_t height);
+    // Adds checkpoints of the owners a block's history changes touch, once they have
+    // nBalanceCheckpointEntries history entries or nBalanceCheckpointBlocks blocks since the last one
+    void AddBalanceCheckpoints(MapKV& changes, uint32_t height);
+
     // tags
     struct ByAccountHistoryKey { static constexpr uint8_t prefix() { return 'h'; } };
+    struct ByBalanceCheckpointKey { static constexpr uint8_t prefix() { return 'k'; } };
+
+private:
+    std::optional<BalanceCheckpointKey> GetBalanceCheckpoint(CScript const & owner, uint32_t height, TAmounts& balances);
+    // Sums the history of owner over heights after checkpoint up to height, returns the number of entries
+    uint32_t SumAccountHistory(CScript const & owner, std::optional<uint32_t> checkpoint, uint32_t height, TAmounts& balances);
 };
 
 class CAccountHistoryStorage : public CAccountsHistoryView
                              , public CAuctionHistoryView
 {
+    static_assert(UniqueStoragePrefixes<ByAccountHistoryKey, ByBalanceCheckpointKey, ByAuctionHistoryKey>(), "prefixes are equal");
+
 public:
-    CAccountHistoryStorage(const fs::path& dbName, std::size_t cacheSize, bool fMemory = false, bool fWipe = false);
+    CAccountHistoryStorage(const fs::path& dbName, const CDBOptions& dbOptions, bool fMemory = false, bool fWipe = false);
+    explicit CAccountHistoryStorage(CStorageKV* storage);
 };
 
 class CBurnHistoryStorage : public CAccountsHistoryView
 {
 public:
-    CBurnHistoryStorage(const fs::path& dbName, std::size_t cacheSize, bool fMemory = false, bool fWipe = false);
+    CBurnHistoryStorage(const fs::path& dbName, const CDBOptions& dbOptions, bool fMemory = false, bool fWipe = false);
+    explicit CBurnHistoryStorage(CStorageKV* storage);
 };
 
 class CHistoryWriters {
@@ -87,40 +132,28 @@ class CHistoryWriters {
     std::map<CScript, TAmounts> diffs;
     std::map<CScript, TAmounts> burnDiffs;
     std::map<uint256, std::map<CScript,TAmounts>> vaultDiffs;
+    CPoolSwapCollector* poolSwaps;
+    std::vector<std::tuple<DCT_ID, CPoolPair, CPoolPair>> swaps;
+    COracleHistoryStorage* oracleView;
+    std::vector<std::tuple<COracleId, int64_t, CTokenPrices>> oraclePrices;
 
 public:
     CVaultHistoryStorage* vaultView;
     CLoanSchemeCreation globalLoanScheme;
     std::string schemeID;
 
-    CHistoryWriters(CAccountHistoryStorage* historyView, CBurnHistoryStorage* burnView, CVaultHistoryStorage* vaultView);
+    CHistoryWriters(CAccountHistoryStorage* historyView, CBurnHistoryStorage* burnView, CVaultHistoryStorage* vaultView,
+                    CPoolSwapCollector* poolSwaps = nullptr, COracleHistoryStorage* oracleView = nullptr);
 
     void AddBalance(const CScript& owner, const CTokenAmount amount, const uint256& vaultID);
     void AddFeeBurn(const CScript& owner, const CAmount amount);
     void SubBalance(const CScript& owner, const CTokenAmount amount, const uint256& vaultID);
+    void AddPoolSwap(const DCT_ID& poolId, const CPoolPair& before, const CPoolPair& after);
+    bool CollectsPoolSwaps() const { return poolSwaps != nullptr; }
+    void AddOraclePrices(const COracleId& oracleId, int64_t timestamp, const CTokenPrices& tokenPrices);
     void Flush(const uint32_t height, const uint256& txid, const uint32_t txn, const uint8_t type, const uint256& vaultID);
 };
 
-class CHistoryErasers {
-    CAccountHistoryStorage* historyView;
-    CBurnHistoryStorage* burnView;
-    std::set<CScript> accounts;
-    std::set<CScript> burnAccounts;
-    std::set<uint256> vaults;
-
-public:
-    CVaultHistoryStorage* vaultView;
-    bool removeLoanScheme{false};
-    uint256 schemeCreationTxid;
-
-    CHistoryErasers(CAccountHistoryStorage* historyView, CBurnHistoryStorage* burnView, CVaultHistoryStorage* vaultView);
-
-    void AddBalance(const CScript& owner, const uint256& vaultID);
-    void SubFeeBurn(const CScript& owner);
-    void SubBalance(const CScript& owner, const uint256& vaultID);
-    void Flush(const uint32_t height, const uint32_t txn, const uint256& vaultID);
-};
-
 class CAccountsHistoryWriter : public CCustomCSView
 {
     const uint32_t height;
@@ -135,27 +168,61 @@ public:
     CAccountsHistoryWriter(CCustomCSView & storage, uint32_t height, uint32_t txn, const uint256& txid, uint8_t type, CHistoryWriters* writers);
     Res AddBalance(CScript const & owner, CTokenAmount amount) override;
     Res SubBalance(CScript const & owner, CTokenAmount amount) override;
+    Res SetPoolPair(DCT_ID const & poolId, uint32_t height, CPoolPair const & pool) override;
+    Res SetOracleData(const COracleId& oracleId, int64_t timestamp, const CTokenPrices& tokenPrices) override;
     bool Flush();
 };
 
-class CAccountsHistoryEraser : public CCustomCSView
-{
-    const uint32_t height;
-    const uint32_t txn;
-    CHistoryErasers& erasers;
+// A credit of a block event, such as futures settlement, made without a transaction
+struct CSettlementCredit {
+    CTokenAmount amount;
+    uint32_t txn;
+    uint8_t type;
+};
 
-public:
-    uint256 vaultID;
+// Adds the credits of each owner to the view at once. Every credit keeps its own account
+// history entry, written only if the credit applied: when the sum of an owner's credits
+// can't be added they are added one by one, as separate transactions would be.
+void ApplySettlementCredits(CCustomCSView& view, uint32_t height, const std::map<CScript, std::vector<CSettlementCredit>>& credits,
+                            CAccountHistoryStorage* historyView);
+
+// In-memory history views of the block being connected. Validation writes
+// history only here, ConnectTip moves the collected changes into the
+// CHistoryChangesView journal and the history indexes apply them later on.
+class CHistoryCollector {
+    CFlushableStorageKV* accountChanges{};
+    CFlushableStorageKV* burnChanges{};
+    CFlushableStorageKV* vaultChanges{};
+    CFlushableStorageKV* poolChanges{};
+    CFlushableStorageKV* oracleChanges{};
 
-    CAccountsHistoryEraser(CCustomCSView & storage, uint32_t height, uint32_t txn, CHistoryErasers& erasers);
-    Res AddBalance(CScript const & owner, CTokenAmount amount) override;
-    Res SubBalance(CScript const & owner, CTokenAmount amount) override;
-    bool Flush();
+public:
+    std::unique_ptr<CAccountHistoryStorage> accountView;
+    std::unique_ptr<CBurnHistoryStorage> burnView;
+    std::unique_ptr<CVaultHistoryStorage> vaultView;
+    std::unique_ptr<CPoolHistoryStorage> poolView;
+    std::unique_ptr<CPoolSwapCollector> poolSwaps;
+    std::unique_ptr<COracleHistoryStorage> oracleView;
+
+    CHistoryCollector(bool accounts, bool vaults, bool pools = false, bool oracles = false);
+    ~CHistoryCollector();
+
+    // Writes the history taken from the custom state records a block changed,
+    // pool reserves and fixed interval prices
+    void CollectState(uint32_t height, int64_t time, const MapKV& stateChanges);
+    CHistoryChanges Take(const uint256& blockHash);
+    void Discard();
 };
 
 extern std::unique_ptr<CAccountHistoryStorage> paccountHistoryDB;
 extern std::unique_ptr<CBurnHistoryStorage> pburnHistoryDB;
+extern std::unique_ptr<CHistoryCollector> phistoryCollector;
 
 static constexpr bool DEFAULT_ACINDEX = true;
+static constexpr uint32_t DEFAULT_BALANCE_CHECKPOINT_ENTRIES = 100;
+static constexpr uint32_t DEFAULT_BALANCE_CHECKPOINT_BLOCKS = 100000;
+
+extern uint32_t nBalanceCheckpointEntries;
+extern uint32_t nBalanceCheckpointBlocks;
 
 #endif //DEFI_MASTERNODES_ACCOUNTSHISTORY_H
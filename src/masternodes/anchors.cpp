@@ -18,7 +18,7 @@
 #include <validation.h>
 
 #include <algorithm>
-
+#include <deque>
 #include <tuple>
 
 std::unique_ptr<CAnchorAuthIndex> panchorauths;
@@ -56,15 +56,95 @@ bool CAnchorAuthMessage::SignWithKey(const CKey& key)
     return !signature.empty();
 }
 
+/// Recently recovered signers, as the same auths, confirms and sigs get checked over and over
+/// again: on receipt, on every lookup by signer and in the anchor txs.
+static constexpr size_t MAX_RECOVERED_SIGNERS = 10000;
+static Mutex cs_recoveredSigners;
+static std::map<uint256, CPubKey> recoveredSigners GUARDED_BY(cs_recoveredSigners);
+static std::deque<uint256> recoveredSignersOrder GUARDED_BY(cs_recoveredSigners);
+
+static uint256 RecoveredSignerKey(uint256 const & sigHash, std::vector<unsigned char> const & sig)
+{
+    return Hash(sigHash.begin(), sigHash.end(), sig.begin(), sig.end());
+}
+
+static bool GetRecoveredSigner(uint256 const & key, CPubKey & pubKey)
+{
+    LOCK(cs_recoveredSigners);
+    auto it = recoveredSigners.find(key);
+    if (it == recoveredSigners.end()) {
+        return false;
+    }
+    pubKey = it->second;
+    return true;
+}
+
+static void AddRecoveredSigner(uint256 const & key, CPubKey const & pubKey)
+{
+    LOCK(cs_recoveredSigners);
+    if (!recoveredSigners.emplace(key, pubKey).second) {
+        return;
+    }
+    recoveredSignersOrder.push_back(key);
+    if (recoveredSignersOrder.size() > MAX_RECOVERED_SIGNERS) {
+        recoveredSigners.erase(recoveredSignersOrder.front());
+        recoveredSignersOrder.pop_front();
+    }
+}
+
+static bool RecoverSigner(uint256 const & sigHash, std::vector<unsigned char> const & sig, CPubKey & pubKey)
+{
+    if (sig.empty()) {
+        return false;
+    }
+    const auto key = RecoveredSignerKey(sigHash, sig);
+    if (!GetRecoveredSigner(key, pubKey)) {
+        if (!pubKey.RecoverCompact(sigHash, sig)) {
+            pubKey = CPubKey{};
+        }
+        AddRecoveredSigner(key, pubKey);
+    }
+    return pubKey.IsValid();
+}
+
+size_t CheckSigs(uint256 const & sigHash, std::vector<std::vector<unsigned char>> const & sigs, std::set<CKeyID> const & keys)
+{
+    std::vector<CPubKey> pubKeys(sigs.size());
+    std::vector<size_t> pending;
+    std::vector<CCompactSignature> signatures;
+    for (size_t i = 0; i < sigs.size(); ++i) {
+        if (!GetRecoveredSigner(RecoveredSignerKey(sigHash, sigs[i]), pubKeys[i])) {
+            pending.push_back(i);
+            signatures.push_back({sigHash, sigs[i], {}});
+        }
+    }
+
+    RecoverCompactSignatures(signatures);
+
+    for (size_t i = 0; i < pending.size(); ++i) {
+        pubKeys[pending[i]] = signatures[i].pubKey;
+        AddRecoveredSigner(RecoveredSignerKey(sigHash, signatures[i].sig), signatures[i].pubKey);
+    }
+
+    std::set<CPubKey> uniqueKeys;
+    for (auto const & pubKey : pubKeys) {
+        if (!pubKey.IsValid() || keys.find(pubKey.GetID()) == keys.end())
+            return false;
+
+        uniqueKeys.insert(pubKey);
+    }
+    return uniqueKeys.size();
+}
+
 bool CAnchorAuthMessage::GetPubKey(CPubKey& pubKey) const
 {
-    return !signature.empty() && pubKey.RecoverCompact(GetSignHash(), signature);
+    return RecoverSigner(GetSignHash(), signature, pubKey);
 }
 
 CKeyID CAnchorAuthMessage::GetSigner() const
 {
     CPubKey pubKey;
-    return (!signature.empty() && pubKey.RecoverCompact(GetSignHash(), signature)) ? pubKey.GetID() : CKeyID{};
+    return RecoverSigner(GetSignHash(), signature, pubKey) ? pubKey.GetID() : CKeyID{};
 }
 
 CAnchor CAnchor::Create(const std::vector<CAnchorAuthMessage> & auths, CTxDestination const & rewardDest)
@@ -950,7 +1030,7 @@ uint256 CAnchorConfirmMessage::GetHash() const
 CKeyID CAnchorConfirmMessage::GetSigner() const
 {
     CPubKey pubKey;
-    return (!signature.empty() && pubKey.RecoverCompact(GetSignHash(), signature)) ? pubKey.GetID() : CKeyID{};
+    return RecoverSigner(GetSignHash(), signature, pubKey) ? pubKey.GetID() : CKeyID{};
 }
 
 bool CAnchorFinalizationMessage::CheckConfirmSigs()
@@ -493,19 +493,9 @@ public:
     void ForEachConfirm(std::function<void(Confirm const &)> callback) const;
 };
 
-template <typename TContainer>
-size_t CheckSigs(uint256 const & sigHash, TContainer const & sigs, std::set<CKeyID> const & keys)
-{
-    std::set<CPubKey> uniqueKeys;
-    for (auto const & sig : sigs) {
-        CPubKey pubkey;
-        if (!pubkey.RecoverCompact(sigHash, sig) || keys.find(pubkey.GetID()) == keys.end())
-            return false;
-
-        uniqueKeys.insert(pubkey);
-    }
-    return uniqueKeys.size();
-}
+/// Number of unique signers of sigHash, 0 if any of the sigs is not from one of the keys.
+/// Signers are recovered in parallel and remembered for the next checks of the same sigs.
+size_t CheckSigs(uint256 const & sigHash, std::vector<std::vector<unsigned char>> const & sigs, std::set<CKeyID> const & keys);
 
 /// dummy, unknown consensus rules yet. may be additional params needed (smth like 'height')
 /// even may be not here, but in CCustomCSView
@@ -537,7 +537,7 @@ Res ATTRIBUTES::RefundFuturesContracts(CCustomCSView &mnview, const uint32_t hei
 
         mnview.EraseFuturesUserValues(key);
 
-        CHistoryWriters subWriters{paccountHistoryDB.get(), nullptr, nullptr};
+        CHistoryWriters subWriters{phistoryCollector->accountView.get(), nullptr, nullptr};
         CAccountsHistoryWriter subView(mnview, height, txn--, {}, uint8_t(CustomTxType::FutureSwapRefund), &subWriters);
         auto res = subView.SubBalance(*contractAddressValue, value.source);
         if (!res) {
@@ -545,7 +545,7 @@ Res ATTRIBUTES::RefundFuturesContracts(CCustomCSView &mnview, const uint32_t hei
         }
         subView.Flush();
 
-        CHistoryWriters addWriters{paccountHistoryDB.get(), nullptr, nullptr};
+        CHistoryWriters addWriters{phistoryCollector->accountView.get(), nullptr, nullptr};
         CAccountsHistoryWriter addView(mnview, height, txn--, {}, uint8_t(CustomTxType::FutureSwapRefund), &addWriters);
         res = addView.AddBalance(key.owner, value.source);
         if (!res) {
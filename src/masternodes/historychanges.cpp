@@ -0,0 +1,58 @@
+// Copyright (c) DeFi Blockchain Developers
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#include <masternodes/historychanges.h>
+
+namespace {
+
+struct CLegacyHistoryChanges : CHistoryChanges {
+    template <typename Stream>
+    void Unserialize(Stream& s) {
+        s >> blockHash >> accounts >> burns >> vaults;
+        if (!s.empty()) {
+            s >> pools;
+        }
+        if (!s.empty()) {
+            s >> oracles;
+        }
+    }
+};
+
+} // namespace
+
+void CHistoryChangesView::ForEachHistoryChanges(std::function<bool(HistoryChangesKey const &, CLazySerialize<CHistoryChanges>)> callback, HistoryChangesKey const & start)
+{
+    ForEach<ByHistoryChangesKey, HistoryChangesKey, CHistoryChanges>(callback, start);
+}
+
+std::optional<CHistoryChanges> CHistoryChangesView::GetHistoryChanges(uint32_t height) const
+{
+    return ReadBy<ByHistoryChangesKey, CHistoryChanges>(HistoryChangesKey{height});
+}
+
+Res CHistoryChangesView::SetHistoryChanges(uint32_t height, CHistoryChanges const & changes)
+{
+    WriteBy<ByHistoryChangesKey>(HistoryChangesKey{height}, changes);
+    return Res::Ok();
+}
+
+Res CHistoryChangesView::DelHistoryChanges(uint32_t height)
+{
+    EraseBy<ByHistoryChangesKey>(HistoryChangesKey{height});
+    return Res::Ok();
+}
+
+uint32_t CHistoryChangesView::ConvertHistoryChanges()
+{
+    std::vector<std::pair<HistoryChangesKey, CHistoryChanges>> converted;
+    ForEach<ByHistoryChangesKey, HistoryChangesKey, CLegacyHistoryChanges>([&](HistoryChangesKey const & key, CLazySerialize<CLegacyHistoryChanges> changes) {
+        converted.emplace_back(key, changes.get());
+        return true;
+    });
+
+    for (const auto& [key, changes] : converted) {
+        WriteBy<ByHistoryChangesKey>(key, changes);
+    }
+    return converted.size();
+}
@@ -0,0 +1,82 @@
+// Copyright (c) DeFi Blockchain Developers
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef DEFI_MASTERNODES_HISTORYCHANGES_H
+#define DEFI_MASTERNODES_HISTORYCHANGES_H
+
+#include <flushablestorage.h>
+#include <masternodes/res.h>
+#include <serialize.h>
+#include <serialize_optional.h>
+#include <uint256.h>
+
+#include <memory>
+
+struct HistoryChangesKey {
+    uint32_t height;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(WrapBigEndian(height));
+    }
+};
+
+// Raw history database changes made by one connected block. They are applied
+// to the history databases by the history indexes, see index/historyindex.h
+struct CHistoryChanges {
+    uint256 blockHash;
+    MapKV accounts; // account and auction history
+    MapKV burns;
+    MapKV vaults;
+    MapKV pools;
+    MapKV oracles;
+
+    bool IsEmpty() const {
+        return accounts.empty() && burns.empty() && vaults.empty() && pools.empty() && oracles.empty();
+    }
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(blockHash);
+        READWRITE(accounts);
+        READWRITE(burns);
+        READWRITE(vaults);
+        READWRITE(pools);
+        READWRITE(oracles);
+    }
+};
+
+// DeFi changes of a block connected to the active chain, passed to validation
+// interface listeners. Besides the history it holds the block's changes of the
+// custom state records listeners follow: pool reserves and fixed interval prices,
+// and the custom transactions of the block that failed to apply.
+struct CCustomChanges {
+    std::shared_ptr<const CHistoryChanges> history;
+    MapKV state;
+    std::vector<uint256> skippedTxs;
+};
+
+// Journal of history changes of blocks the history indexes did not apply yet.
+// It is written next to the block's custom state so it survives a restart.
+class CHistoryChangesView : public virtual CStorageView {
+public:
+    void ForEachHistoryChanges(std::function<bool(HistoryChangesKey const &, CLazySerialize<CHistoryChanges>)> callback, HistoryChangesKey const & start = {});
+
+    std::optional<CHistoryChanges> GetHistoryChanges(uint32_t height) const;
+    Res SetHistoryChanges(uint32_t height, CHistoryChanges const & changes);
+    Res DelHistoryChanges(uint32_t height);
+
+    // Rewrites journal entries of database versions before 5, which end with the last
+    // non-empty of pools and oracles. Returns the number of entries converted.
+    uint32_t ConvertHistoryChanges();
+
+    // tags
+    struct ByHistoryChangesKey { static constexpr uint8_t prefix() { return 'E'; } };
+};
+
+#endif //DEFI_MASTERNODES_HISTORYCHANGES_H
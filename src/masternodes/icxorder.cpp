@@ -82,6 +82,7 @@ Res CICXOrderView::ICXCreateOrder(CICXOrderImpl const & order)
     OrderKey key(order.idToken, order.creationTx);
     WriteBy<ICXOrderCreationTx>(order.creationTx, order);
     WriteBy<ICXOrderOpenKey>(key, CICXOrder::STATUS_OPEN);
+    WriteBy<ICXOrderBookKey>(CICXOrderBookKey{order.idToken, order.orderType, order.orderPrice, order.creationTx}, CICXOrder::STATUS_OPEN);
     WriteBy<ICXOrderStatus>(StatusKey(order.creationHeight + order.expiry, order.creationTx), CICXOrder::STATUS_EXPIRED);
 
     return Res::Ok();
@@ -104,6 +105,7 @@ Res CICXOrderView::ICXCloseOrderTx(CICXOrderImpl const & order, uint8_t const st
     WriteBy<ICXOrderCreationTx>(order.creationTx, order);
     OrderKey key(order.idToken, order.creationTx);
     EraseBy<ICXOrderOpenKey>(key);
+    EraseBy<ICXOrderBookKey>(CICXOrderBookKey{order.idToken, order.orderType, order.orderPrice, order.creationTx});
     WriteBy<ICXOrderCloseKey>(key, status);
     EraseBy<ICXOrderStatus>(StatusKey(order.creationHeight + order.expiry, order.creationTx));
 
@@ -133,6 +135,26 @@ std::unique_ptr<CICXOrderView::CICXOrderImpl> CICXOrderView::HasICXOrderOpen(DCT
     return {};
 }
 
+void CICXOrderView::ForEachICXOrderBook(std::function<bool (CICXOrderBookKey const &, uint8_t)> callback, DCT_ID const & id, uint8_t orderType)
+{
+    ForEach<ICXOrderBookKey, CICXOrderBookKey, uint8_t>([&](CICXOrderBookKey const & key, uint8_t status) {
+        return key.idToken == id && callback(key, status);
+    }, CICXOrderBookKey{id, orderType, 0, {}});
+}
+
+void CICXOrderView::IndexICXOrderBook()
+{
+    std::vector<CICXOrderBookKey> keys;
+    ForEachICXOrderOpen([&](OrderKey const & key, uint8_t) {
+        if (auto order = GetICXOrderByCreationTx(key.second)) {
+            keys.push_back({order->idToken, order->orderType, order->orderPrice, order->creationTx});
+        }
+        return true;
+    });
+    for (const auto& key : keys) {
+        WriteBy<ICXOrderBookKey>(key, CICXOrder::STATUS_OPEN);
+    }
+}
 
 std::unique_ptr<CICXOrderView::CICXMakeOfferImpl> CICXOrderView::GetICXMakeOfferByCreationTx(uint256 const & txid) const
 {
@@ -373,6 +373,38 @@ struct CICXCloseOfferMessage : public CICXCloseOffer {
     }
 };
 
+// Open orders of a token by direction and then by price ascending, the best
+// price first as the price is of the asset sold in the asset bought
+struct CICXOrderBookKey {
+    DCT_ID idToken;
+    uint8_t orderType;
+    CAmount orderPrice;
+    uint256 creationTx;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(WrapBigEndian(idToken.v));
+        READWRITE(orderType);
+
+        if (ser_action.ForRead()) {
+            uint32_t high, low;
+            READWRITE(WrapBigEndian(high));
+            READWRITE(WrapBigEndian(low));
+            orderPrice = static_cast<CAmount>((uint64_t(high) << 32) | low);
+        }
+        else {
+            uint32_t high = static_cast<uint64_t>(orderPrice) >> 32;
+            uint32_t low = static_cast<uint64_t>(orderPrice) & 0xFFFFFFFF;
+            READWRITE(WrapBigEndian(high));
+            READWRITE(WrapBigEndian(low));
+        }
+
+        READWRITE(creationTx);
+    }
+};
+
 class CICXOrderView : public virtual CStorageView {
 public:
     static const CAmount DEFAULT_DFI_BTC_PRICE;
@@ -399,6 +431,9 @@ public:
     void ForEachICXOrderClose(std::function<bool (OrderKey const &, uint8_t)> callback, DCT_ID const & pair = {0});
     void ForEachICXOrderExpire(std::function<bool (StatusKey const &, uint8_t)> callback, uint32_t const & height = 0);
     std::unique_ptr<CICXOrderImpl> HasICXOrderOpen(DCT_ID const & tokenId, uint256 const & ordertxid);
+    void ForEachICXOrderBook(std::function<bool (CICXOrderBookKey const &, uint8_t)> callback, DCT_ID const & id, uint8_t orderType = 0);
+    // Fills the order book with the orders opened before it was kept
+    void IndexICXOrderBook();
 
     //MakeOffer
     std::unique_ptr<CICXMakeOfferImpl> GetICXMakeOfferByCreationTx(uint256 const & txid) const;
@@ -471,6 +506,7 @@ public:
     struct ICXOfferStatus             { static constexpr uint8_t prefix() { return 0x0B; } };
     struct ICXSubmitDFCHTLCStatus     { static constexpr uint8_t prefix() { return 0x0C; } };
     struct ICXSubmitEXTHTLCStatus     { static constexpr uint8_t prefix() { return 0x0D; } };
+    struct ICXOrderBookKey            { static constexpr uint8_t prefix() { return 0x0E; } };
 
     struct ICXVariables               { static constexpr uint8_t prefix() { return 0x0F; } };
 };
@@ -6,6 +6,7 @@
 #include <masternodes/anchors.h>
 #include <masternodes/govvariables/attributes.h>
 #include <masternodes/mn_checks.h>
+#include <masternodes/mnregistry.h>
 
 #include <chainparams.h>
 #include <consensus/merkle.h>
@@ -23,7 +24,32 @@
 #include <unordered_map>
 
 std::unique_ptr<CCustomCSView> pcustomcsview;
-std::unique_ptr<CStorageLevelDB> pcustomcsDB;
+std::unique_ptr<CStoragePrefixRouter> pcustomcsDB;
+bool fUndoBundles = DEFAULT_UNDO_BUNDLES;
+
+static Mutex cs_customcsSnapshot;
+static std::shared_ptr<CCustomCSSnapshot> customcsSnapshot GUARDED_BY(cs_customcsSnapshot);
+
+std::shared_ptr<CCustomCSSnapshot> GetCustomCSSnapshot()
+{
+    {
+        LOCK(cs_customcsSnapshot);
+        if (customcsSnapshot) {
+            return customcsSnapshot;
+        }
+    }
+    LOCK2(cs_main, cs_customcsSnapshot);
+    if (!customcsSnapshot) {
+        customcsSnapshot = std::make_shared<CCustomCSSnapshot>(::ChainActive().Tip(), *pcustomcsDB, pcustomcsview->GetStorage().GetRaw());
+    }
+    return customcsSnapshot;
+}
+
+void ResetCustomCSSnapshot()
+{
+    LOCK(cs_customcsSnapshot);
+    customcsSnapshot.reset();
+}
 
 int GetMnActivationDelay(int height)
 {
@@ -201,9 +227,55 @@ std::optional<uint256> CMasternodesView::GetMasternodeIdByOwner(const CKeyID & i
     return ReadBy<Owner, uint256>(id);
 }
 
-void CMasternodesView::ForEachMasternode(std::function<bool (const uint256 &, CLazySerialize<CMasternode>)> callback, uint256 const & start)
+void CMasternodesView::ForEachMasternode(std::function<bool (const uint256 &, CMasternode const &)> callback, uint256 const & start)
+{
+    if (auto mnRegistry = GetMasternodeRegistry()) {
+        mnRegistry->ForEach(callback, start);
+        return;
+    }
+    ForEach<ID, uint256, CMasternode>([&](uint256 const & id, CLazySerialize<CMasternode> node) {
+        return callback(id, node.get());
+    }, start);
+}
+
+void CMasternodesView::ForEachActiveMasternode(int height, std::function<bool (const uint256 &, CMasternode const &)> callback)
 {
-    ForEach<ID, uint256, CMasternode>(callback, start);
+    if (auto mnRegistry = GetMasternodeRegistry()) {
+        mnRegistry->ForEachActive(height, callback);
+        return;
+    }
+    ForEach<ID, uint256, CMasternode>([&](uint256 const & id, CLazySerialize<CMasternode> lazyNode) {
+        const auto& node = lazyNode.get();
+        return !node.IsActive(height) || callback(id, node);
+    });
+}
+
+size_t CMasternodesView::GetActiveMasternodeCount(int height)
+{
+    if (auto mnRegistry = GetMasternodeRegistry()) {
+        return mnRegistry->CountActive(height);
+    }
+    size_t count{0};
+    ForEachActiveMasternode(height, [&](uint256 const &, CMasternode const &) {
+        ++count;
+        return true;
+    });
+    return count;
+}
+
+const CMasternodeRegistry* CMasternodesView::GetMasternodeRegistry() const
+{
+    if (!registry) {
+        return nullptr;
+    }
+    for (auto storage = &DB(); storage != &registry->Storage();) {
+        auto flushable = dynamic_cast<const CFlushableStorageKV*>(storage);
+        if (!flushable || flushable->HasChanges(ID::prefix())) {
+            return nullptr;
+        }
+        storage = &flushable->GetParent();
+    }
+    return registry.get();
 }
 
 void CMasternodesView::IncrementMintedBy(const uint256& nodeId)
@@ -738,6 +810,20 @@ void CCustomCSView::SetDbVersion(int version)
     Write(DbVersion::prefix(), version);
 }
 
+void CCustomCSView::EnableMasternodeRegistry()
+{
+    auto& storage = GetStorage();
+    auto mnRegistry = std::make_shared<CMasternodeRegistry>(storage);
+    ForEach<CMasternodesView::ID, uint256, CMasternode>([&](uint256 const & id, CLazySerialize<CMasternode> node) {
+        mnRegistry->Set(id, node.get());
+        return true;
+    });
+    storage.SetListener([mnRegistry = mnRegistry.get()](const TBytes& key, const std::optional<TBytes>& value) {
+        mnRegistry->OnChange(key, value);
+    });
+    registry = std::move(mnRegistry);
+}
+
 CTeamView::CTeam CCustomCSView::CalcNextTeam(int height, const uint256 & stakeModifier)
 {
     if (stakeModifier == uint256())
@@ -746,10 +832,7 @@ CTeamView::CTeam CCustomCSView::CalcNextTeam(int height, const uint256 & stakeMo
     int anchoringTeamSize = Params().GetConsensus().mn.anchoringTeamSize;
 
     std::map<arith_uint256, CKeyID, std::less<arith_uint256>> priorityMN;
-    ForEachMasternode([&] (uint256 const & id, CMasternode node) {
-        if(!node.IsActive(height))
-            return true;
-
+    ForEachActiveMasternode(height, [&] (uint256 const & id, CMasternode const & node) {
         CDataStream ss{SER_GETHASH, PROTOCOL_VERSION};
         ss << id << stakeModifier;
         priorityMN.insert(std::make_pair(UintToArith256(Hash(ss.begin(), ss.end())), node.operatorAuthAddress));
@@ -786,10 +869,7 @@ void CCustomCSView::CalcAnchoringTeams(const uint256 & stakeModifier, const CBlo
 
     std::map<arith_uint256, CKeyID, std::less<arith_uint256>> authMN;
     std::map<arith_uint256, CKeyID, std::less<arith_uint256>> confirmMN;
-    ForEachMasternode([&] (uint256 const & id, CMasternode node) {
-        if(!node.IsActive(pindexNew->nHeight))
-            return true;
-
+    ForEachActiveMasternode(pindexNew->nHeight, [&] (uint256 const & id, CMasternode const & node) {
         // Not in our list of MNs from last week, skip.
         if (masternodeIDs.find(id) == masternodeIDs.end()) {
             return true;
@@ -849,14 +929,78 @@ void CCustomCSView::CreateAndRelayConfirmMessageIfNeed(const CAnchorIndex::Ancho
     }
 }
 
-void CCustomCSView::OnUndoTx(uint256 const & txid, uint32_t height)
+bool CCustomCSView::OnUndoTx(uint256 const & txid, uint32_t height, std::map<uint256, CUndo>* bundled)
 {
+    if (bundled) {
+        auto it = bundled->find(txid);
+        if (it != bundled->end()) {
+            CUndo::Revert(GetStorage(), it->second);
+            bundled->erase(it);
+            return true;
+        }
+    }
     const auto undo = GetUndo(UndoKey{height, txid});
     if (!undo) {
-        return; // not custom tx, or no changes done
+        return false; // not custom tx, or no changes done before the undo got complete
     }
     CUndo::Revert(GetStorage(), *undo); // revert the changes of this tx
     DelUndo(UndoKey{height, txid}); // erase undo data, it served its purpose
+    return true;
+}
+
+void CCustomCSView::BundleUndos(uint32_t height, std::vector<uint256> const & txids)
+{
+    auto& changes = GetStorage().GetRaw();
+
+    CUndoBundle bundle;
+    auto take = [&](uint256 const & txid) {
+        auto it = changes.find(DbTypeToBytes(std::make_pair(ByUndoKey::prefix(), UndoKey{height, txid})));
+        if (it == changes.end() || !it->second) {
+            return;
+        }
+        CUndo undo;
+        BytesToDbType(*it->second, undo);
+        bundle.undos.emplace_back(txid, std::move(undo));
+        // undo of the height only exists while its block is connected, so the record
+        // was written by this view and can be dropped without erasing it below
+        changes.erase(it);
+    };
+
+    take(uint256());
+    for (const auto& txid : txids) {
+        take(txid);
+    }
+    if (!bundle.undos.empty()) {
+        SetUndoBundle(height, bundle);
+    }
+}
+
+std::map<uint256, CUndo> CCustomCSView::TakeUndoBundle(uint32_t height)
+{
+    std::map<uint256, CUndo> undos;
+    if (auto bundle = GetUndoBundle(height)) {
+        for (auto& [txid, undo] : bundle->undos) {
+            undos.emplace(txid, std::move(undo));
+        }
+        DelUndoBundle(height);
+    }
+    return undos;
+}
+
+size_t CCustomCSView::UnbundleUndos()
+{
+    size_t count{0};
+    CCustomCSView unbundled(*this);
+    ForEachUndoBundle([&](UndoBundleKey const & key, CLazySerialize<CUndoBundle> bundle) {
+        for (const auto& [txid, undo] : bundle.get().undos) {
+            unbundled.SetUndo(UndoKey{key.height, txid}, undo);
+        }
+        unbundled.DelUndoBundle(key.height);
+        ++count;
+        return true;
+    });
+    unbundled.Flush();
+    return count;
 }
 
 bool CCustomCSView::CanSpend(const uint256 & txId, int height) const
@@ -12,6 +12,7 @@
 #include <masternodes/accounts.h>
 #include <masternodes/anchors.h>
 #include <masternodes/gv.h>
+#include <masternodes/historychanges.h>
 #include <masternodes/icxorder.h>
 #include <masternodes/incentivefunding.h>
 #include <masternodes/loan.h>
@@ -30,6 +31,7 @@
 #include <stdint.h>
 
 class CBlockIndex;
+class CMasternodeRegistry;
 class CTransaction;
 
 // Works instead of constants cause 'regtest' differs (don't want to overcharge chainparams)
@@ -178,13 +180,22 @@ class CMasternodesView : public virtual CStorageView
 {
     std::map<CKeyID, std::pair<uint32_t, int64_t>> minterTimeCache;
 
+protected:
+    // in-memory copy of the masternodes of the root view, shared with the views on top of it
+    std::shared_ptr<CMasternodeRegistry> registry;
+
 public:
 //    CMasternodesView() = default;
 
     std::optional<CMasternode> GetMasternode(uint256 const & id) const;
     std::optional<uint256> GetMasternodeIdByOperator(CKeyID const & id) const;
     std::optional<uint256> GetMasternodeIdByOwner(CKeyID const & id) const;
-    void ForEachMasternode(std::function<bool(uint256 const &, CLazySerialize<CMasternode>)> callback, uint256 const & start = uint256());
+    void ForEachMasternode(std::function<bool(uint256 const &, CMasternode const &)> callback, uint256 const & start = uint256());
+    // Masternodes active at height in no particular order
+    void ForEachActiveMasternode(int height, std::function<bool(uint256 const &, CMasternode const &)> callback);
+    size_t GetActiveMasternodeCount(int height);
+    // The registry if it matches the masternodes of this view, i.e. no view in between has changed any
+    const CMasternodeRegistry* GetMasternodeRegistry() const;
 
     void IncrementMintedBy(const uint256& nodeId);
     void DecrementMintedBy(const uint256& nodeId);
@@ -321,17 +332,10 @@ public:
     }
 };
 
-template<typename T>
-inline void CheckPrefix()
-{
-}
-
-template<typename T1, typename T2, typename... TN>
+template<typename... TN>
 inline void CheckPrefix()
 {
-    static_assert(T1::prefix() != T2::prefix(), "prefixes are equal");
-    CheckPrefix<T1, TN...>();
-    CheckPrefix<T2, TN...>();
+    static_assert(UniqueStoragePrefixes<TN...>(), "prefixes are equal");
 }
 
 class CCustomCSView
@@ -351,6 +355,7 @@ class CCustomCSView
         , public CICXOrderView
         , public CLoanView
         , public CVaultView
+        , public CHistoryChangesView
 {
     void CheckPrefixes()
     {
@@ -363,7 +368,7 @@ class CCustomCSView
             CTokensView             ::  ID, Symbol, CreationTx, LastDctId,
             CAccountsView           ::  ByBalanceKey, ByHeightKey, ByFuturesSwapKey,
             CCommunityBalancesView  ::  ById,
-            CUndosView              ::  ByUndoKey,
+            CUndosView              ::  ByUndoKey, ByUndoBundleKey, UndoCompleteHeight,
             CPoolPairView           ::  ByID, ByPair, ByShare, ByIDPair, ByPoolSwap, ByReserves, ByRewardPct, ByRewardLoanPct,
                                         ByPoolReward, ByDailyReward, ByCustomReward, ByTotalLiquidity, ByDailyLoanReward,
                                         ByPoolLoanReward, ByTokenDexFeePct,
@@ -375,11 +380,14 @@ class CCustomCSView
                                         ICXCloseOfferCreationTx, ICXOrderOpenKey, ICXOrderCloseKey, ICXMakeOfferOpenKey,
                                         ICXMakeOfferCloseKey, ICXSubmitDFCHTLCOpenKey, ICXSubmitDFCHTLCCloseKey,
                                         ICXSubmitEXTHTLCOpenKey, ICXSubmitEXTHTLCCloseKey, ICXClaimDFCHTLCKey,
-                                        ICXOrderStatus, ICXOfferStatus, ICXSubmitDFCHTLCStatus, ICXSubmitEXTHTLCStatus, ICXVariables,
+                                        ICXOrderStatus, ICXOfferStatus, ICXSubmitDFCHTLCStatus, ICXSubmitEXTHTLCStatus, ICXOrderBookKey,
+                                        ICXVariables,
             CLoanView               ::  LoanSetCollateralTokenCreationTx, LoanSetCollateralTokenKey, LoanSetLoanTokenCreationTx,
                                         LoanSetLoanTokenKey, LoanSchemeKey, DefaultLoanSchemeKey, DelayedLoanSchemeKey,
                                         DestroyLoanSchemeKey, LoanInterestByVault, LoanTokenAmount, LoanLiquidationPenalty, LoanInterestV2ByVault,
-            CVaultView              ::  VaultKey, OwnerVaultKey, CollateralKey, AuctionBatchKey, AuctionHeightKey, AuctionBidKey
+            CVaultView              ::  VaultKey, OwnerVaultKey, CollateralKey, AuctionBatchKey, AuctionHeightKey, AuctionBidKey,
+                                        SchemeVaultKey, VaultRatioKey, RatioVaultKey,
+            CHistoryChangesView     ::  ByHistoryChangesKey
         >();
     }
 private:
@@ -388,7 +396,7 @@ private:
 
 public:
     // Increase version when underlaying tables are changed
-    static constexpr const int DbVersion = 1;
+    static constexpr const int DbVersion = 5;
 
     CCustomCSView()
     {
@@ -406,8 +414,13 @@ public:
         : CStorageView(new CFlushableStorageKV(other.DB()))
     {
         CheckPrefixes();
+        registry = other.registry;
     }
 
+    // Keeps the masternodes in memory from now on, for this view and the caches upon it.
+    // This view must never be discarded.
+    void EnableMasternodeRegistry();
+
     // cause depends on current mns:
     CTeamView::CTeam CalcNextTeam(int height, uint256 const & stakeModifier);
 
@@ -418,7 +431,16 @@ public:
     void CreateAndRelayConfirmMessageIfNeed(const CAnchorIndex::AnchorRec* anchor, const uint256 & btcTxHash, const CKey &masternodeKey);
 
     // simplified version of undo, without any unnecessary undo data
-    void OnUndoTx(uint256 const & txid, uint32_t height);
+    // bundled holds the undo of the block when it was stored as a bundle, see TakeUndoBundle
+    // returns whether the tx had undo
+    bool OnUndoTx(uint256 const & txid, uint32_t height, std::map<uint256, CUndo>* bundled = nullptr);
+
+    // Moves the undo of the block at height, written by this view, from per tx records into a bundle
+    void BundleUndos(uint32_t height, std::vector<uint256> const & txids);
+    // Reads and erases the undo bundle of the block at height, by txid
+    std::map<uint256, CUndo> TakeUndoBundle(uint32_t height);
+    // Turns all undo bundles back into per tx records, returns the number of bundles
+    size_t UnbundleUndos();
 
     bool CanSpend(const uint256 & txId, int height) const;
 
@@ -452,8 +474,36 @@ public:
 
 std::map<CKeyID, CKey> AmISignerNow(int height, CAnchorData::CTeam const & team);
 
-/** Global DB and view that holds enhanced chainstate data (should be protected by cs_main) */
-extern std::unique_ptr<CStorageLevelDB> pcustomcsDB;
+static const bool DEFAULT_ENHANCEDCS_UNDO_DB = true;
+static const bool DEFAULT_UNDO_BUNDLES = true;
+
+/** Store the custom state undo of connected blocks as one bundle per block */
+extern bool fUndoBundles;
+
+/** Global DB and view that holds enhanced chainstate data (should be protected by cs_main).
+ *  Undo data can be routed to a database of its own, see -enhancedcsundodb. */
+extern std::unique_ptr<CStoragePrefixRouter> pcustomcsDB;
 extern std::unique_ptr<CCustomCSView> pcustomcsview;
 
+/** Enhanced chainstate data as of a chain tip, readable without cs_main */
+struct CCustomCSSnapshot
+{
+    const CBlockIndex* tip;
+    CStorageSnapshot storage;
+
+    CCustomCSSnapshot(const CBlockIndex* tip_, const CStorageKV& db, MapKV changed)
+        : tip(tip_), storage(db, std::move(changed)) {}
+};
+
+/**
+ * Snapshot of pcustomcsview at the active chain tip, for RPCs that read a lot of
+ * it and should not keep blocks from connecting meanwhile. Build a CCustomCSView
+ * on its storage and hold on to the snapshot for as long as the view is used.
+ * A snapshot is made on first use after the tip changed, taking cs_main briefly.
+ */
+std::shared_ptr<CCustomCSSnapshot> GetCustomCSSnapshot();
+
+/** Drop the current snapshot, called whenever pcustomcsview moves to another tip */
+void ResetCustomCSSnapshot();
+
 #endif // DEFI_MASTERNODES_MASTERNODES_H
@@ -3447,270 +3447,6 @@ public:
     }
 };
 
-class CCustomTxRevertVisitor : public CCustomTxVisitor
-{
-    Res EraseHistory(const CScript& owner) const {
-        // notify account changes, no matter Sub or Add
-       return mnview.AddBalance(owner, {});
-    }
-
-public:
-    using CCustomTxVisitor::CCustomTxVisitor;
-
-    template<typename T>
-    Res operator()(const T&) const {
-        return Res::Ok();
-    }
-
-    Res operator()(const CCreateMasterNodeMessage& obj) const {
-        auto res = CheckMasternodeCreationTx();
-        return !res ? res : mnview.UnCreateMasternode(tx.GetHash());
-    }
-
-    Res operator()(const CResignMasterNodeMessage& obj) const {
-        auto res = HasCollateralAuth(obj);
-        return !res ? res : mnview.UnResignMasternode(obj, tx.GetHash());
-    }
-
-    Res operator()(const CCreateTokenMessage& obj) const {
-        auto res = CheckTokenCreationTx();
-        return !res ? res : mnview.RevertCreateToken(tx.GetHash());
-    }
-
-    Res operator()(const CCreatePoolPairMessage& obj) const {
-        //check foundation auth
-        if (!HasFoundationAuth()) {
-            return Res::Err("tx not from foundation member");
-        }
-        auto pool = mnview.GetPoolPair(obj.poolPair.idTokenA, obj.poolPair.idTokenB);
-        if (!pool) {
-            return Res::Err("no such poolPair tokenA %s, tokenB %s",
-                            obj.poolPair.idTokenA.ToString(),
-                            obj.poolPair.idTokenB.ToString());
-        }
-        return mnview.RevertCreateToken(tx.GetHash());
-    }
-
-    Res operator()(const CMintTokensMessage& obj) const {
-        for (const auto& kv : obj.balances) {
-            DCT_ID tokenId = kv.first;
-            auto token = mnview.GetToken(tokenId);
-            if (!token) {
-                return Res::Err("token %s does not exist!", tokenId.ToString());
-            }
-            auto tokenImpl = static_cast<const CTokenImplementation&>(*token);
-            const Coin& coin = coins.AccessCoin(COutPoint(tokenImpl.creationTx, 1));
-            EraseHistory(coin.out.scriptPubKey);
-        }
-        return Res::Ok();
-    }
-
-    Res operator()(const CPoolSwapMessage& obj) const {
-        EraseHistory(obj.to);
-        return EraseHistory(obj.from);
-    }
-
-    Res operator()(const CPoolSwapMessageV2& obj) const {
-        return (*this)(obj.swapInfo);
-    }
-
-    Res operator()(const CLiquidityMessage& obj) const {
-        for (const auto& kv : obj.from) {
-            EraseHistory(kv.first);
-        }
-        return EraseHistory(obj.shareAddress);
-    }
-
-    Res operator()(const CRemoveLiquidityMessage& obj) const {
-        return EraseHistory(obj.from);
-    }
-
-    Res operator()(const CUtxosToAccountMessage& obj) const {
-        for (const auto& account : obj.to) {
-            EraseHistory(account.first);
-        }
-        return Res::Ok();
-    }
-
-    Res operator()(const CAccountToUtxosMessage& obj) const {
-        return EraseHistory(obj.from);
-    }
-
-    Res operator()(const CAccountToAccountMessage& obj) const {
-        for (const auto& account : obj.to) {
-            EraseHistory(account.first);
-        }
-        return EraseHistory(obj.from);
-    }
-
-    Res operator()(const CSmartContractMessage& obj) const {
-        for (const auto& account : obj.accounts) {
-            EraseHistory(account.first);
-        }
-        return Res::Ok();
-    }
-
-    Res operator()(const CFutureSwapMessage& obj) const {
-        EraseHistory(obj.owner);
-        return Res::Ok();
-    }
-
-    Res operator()(const CAnyAccountsToAccountsMessage& obj) const {
-        for (const auto& account : obj.to) {
-            EraseHistory(account.first);
-        }
-        for (const auto& account : obj.from) {
-            EraseHistory(account.first);
-        }
-        return Res::Ok();
-    }
-
-    Res operator()(const CICXCreateOrderMessage& obj) const {
-        if (obj.orderType == CICXOrder::TYPE_INTERNAL) {
-            auto hash = tx.GetHash();
-            EraseHistory({hash.begin(), hash.end()});
-            EraseHistory(obj.ownerAddress);
-        }
-        return Res::Ok();
-    }
-
-    Res operator()(const CICXMakeOfferMessage& obj) const {
-        auto hash = tx.GetHash();
-        EraseHistory({hash.begin(), hash.end()});
-        return EraseHistory(obj.ownerAddress);
-    }
-
-    Res operator()(const CICXSubmitDFCHTLCMessage& obj) const {
-        auto offer = mnview.GetICXMakeOfferByCreationTx(obj.offerTx);
-        if (!offer)
-            return Res::Err("offer with creation tx %s does not exists!", obj.offerTx.GetHex());
-
-        auto order = mnview.GetICXOrderByCreationTx(offer->orderTx);
-        if (!order)
-            return Res::Err("order with creation tx %s does not exists!", offer->orderTx.GetHex());
-
-        EraseHistory(offer->ownerAddress);
-        if (order->orderType == CICXOrder::TYPE_INTERNAL) {
-            CScript orderTxidAddr(order->creationTx.begin(), order->creationTx.end());
-            CScript offerTxidAddr(offer->creationTx.begin(), offer->creationTx.end());
-            EraseHistory(orderTxidAddr);
-            EraseHistory(offerTxidAddr);
-            EraseHistory(consensus.burnAddress);
-        }
-        auto hash = tx.GetHash();
-        return EraseHistory({hash.begin(), hash.end()});
-    }
-
-    Res operator()(const CICXSubmitEXTHTLCMessage& obj) const {
-        auto offer = mnview.GetICXMakeOfferByCreationTx(obj.offerTx);
-        if (!offer)
-            return Res::Err("order with creation tx %s does not exists!", obj.offerTx.GetHex());
-
-        auto order = mnview.GetICXOrderByCreationTx(offer->orderTx);
-        if (!order)
-            return Res::Err("order with creation tx %s does not exists!", offer->orderTx.GetHex());
-
-        if (order->orderType == CICXOrder::TYPE_EXTERNAL) {
-            CScript offerTxidAddr(offer->creationTx.begin(), offer->creationTx.end());
-            EraseHistory(offerTxidAddr);
-            EraseHistory(offer->ownerAddress);
-            EraseHistory(consensus.burnAddress);
-        }
-        return Res::Ok();
-    }
-
-    Res operator()(const CICXClaimDFCHTLCMessage& obj) const {
-        auto dfchtlc = mnview.GetICXSubmitDFCHTLCByCreationTx(obj.dfchtlcTx);
-        if (!dfchtlc)
-            return Res::Err("dfc htlc with creation tx %s does not exists!", obj.dfchtlcTx.GetHex());
-
-        auto offer = mnview.GetICXMakeOfferByCreationTx(dfchtlc->offerTx);
-        if (!offer)
-            return Res::Err("offer with creation tx %s does not exists!", dfchtlc->offerTx.GetHex());
-
-        auto order = mnview.GetICXOrderByCreationTx(offer->orderTx);
-        if (!order)
-            return Res::Err("order with creation tx %s does not exists!", offer->orderTx.GetHex());
-
-        CScript htlcTxidAddr(dfchtlc->creationTx.begin(), dfchtlc->creationTx.end());
-        EraseHistory(htlcTxidAddr);
-        EraseHistory(order->ownerAddress);
-        if (order->orderType == CICXOrder::TYPE_INTERNAL)
-            EraseHistory(offer->ownerAddress);
-        return Res::Ok();
-    }
-
-    Res operator()(const CICXCloseOrderMessage& obj) const {
-        std::unique_ptr<CICXOrderImplemetation> order;
-        if (!(order = mnview.GetICXOrderByCreationTx(obj.orderTx)))
-            return Res::Err("order with creation tx %s does not exists!", obj.orderTx.GetHex());
-
-        if (order->orderType == CICXOrder::TYPE_INTERNAL) {
-            CScript txidAddr(order->creationTx.begin(), order->creationTx.end());
-            EraseHistory(txidAddr);
-            EraseHistory(order->ownerAddress);
-        }
-        return Res::Ok();
-    }
-
-    Res operator()(const CICXCloseOfferMessage& obj) const {
-        std::unique_ptr<CICXMakeOfferImplemetation> offer;
-        if (!(offer = mnview.GetICXMakeOfferByCreationTx(obj.offerTx)))
-            return Res::Err("offer with creation tx %s does not exists!", obj.offerTx.GetHex());
-
-        CScript txidAddr(offer->creationTx.begin(), offer->creationTx.end());
-        EraseHistory(txidAddr);
-        return EraseHistory(offer->ownerAddress);
-    }
-
-    Res operator()(const CDepositToVaultMessage& obj) const {
-        return EraseHistory(obj.from);
-    }
-
-    Res operator()(const CCloseVaultMessage& obj) const {
-        return EraseHistory(obj.to);
-    }
-
-    Res operator()(const CLoanTakeLoanMessage& obj) const {
-        const auto vault = mnview.GetVault(obj.vaultId);
-        if (!vault)
-            return Res::Err("Vault <%s> not found", obj.vaultId.GetHex());
-
-        return EraseHistory(!obj.to.empty() ? obj.to : vault->ownerAddress);
-    }
-
-    Res operator()(const CWithdrawFromVaultMessage& obj) const {
-        return EraseHistory(obj.to);
-    }
-
-    Res operator()(const CLoanPaybackLoanMessage& obj) const {
-        const auto vault = mnview.GetVault(obj.vaultId);
-        if (!vault)
-            return Res::Err("Vault <%s> not found", obj.vaultId.GetHex());
-
-        EraseHistory(obj.from);
-        EraseHistory(consensus.burnAddress);
-        return EraseHistory(vault->ownerAddress);
-    }
-
-    Res operator()(const CLoanPaybackLoanV2Message& obj) const {
-        const auto vault = mnview.GetVault(obj.vaultId);
-        if (!vault)
-            return Res::Err("Vault <%s> not found", obj.vaultId.GetHex());
-
-        EraseHistory(obj.from);
-        EraseHistory(consensus.burnAddress);
-        return EraseHistory(vault->ownerAddress);
-    }
-
-    Res operator()(const CAuctionBidMessage& obj) const {
-        if (auto bid = mnview.GetAuctionBid({obj.vaultId, obj.index}))
-            EraseHistory(bid->first);
-
-        return EraseHistory(obj.from);
-    }
-};
-
 Res CustomMetadataParse(uint32_t height, const Consensus::Params& consensus, const std::vector<unsigned char>& metadata, CCustomTxMessage& txMessage) {
     try {
         return boost::apply_visitor(CCustomMetadataParseVisitor(height, consensus, metadata), txMessage);
@@ -3783,16 +3519,6 @@ Res CustomTxVisit(CCustomCSView& mnview, const CCoinsViewCache& coins, const CTr
     }
 }
 
-Res CustomTxRevert(CCustomCSView& mnview, const CCoinsViewCache& coins, const CTransaction& tx, uint32_t height, const Consensus::Params& consensus, const CCustomTxMessage& txMessage) {
-    try {
-        return boost::apply_visitor(CCustomTxRevertVisitor(tx, height, coins, mnview, consensus), txMessage);
-    } catch (const std::exception& e) {
-        return Res::Err(e.what());
-    } catch (...) {
-        return Res::Err("unexpected error");
-    }
-}
-
 bool ShouldReturnNonFatalError(const CTransaction& tx, uint32_t height) {
     static const std::map<uint32_t, uint256> skippedTx = {
         { 471222, uint256S("0ab0b76352e2d865761f4c53037041f33e1200183d55cdf6b09500d6f16b7329") },
@@ -3801,44 +3527,6 @@ bool ShouldReturnNonFatalError(const CTransaction& tx, uint32_t height) {
     return it != skippedTx.end() && it->second == tx.GetHash();
 }
 
-Res RevertCustomTx(CCustomCSView& mnview, const CCoinsViewCache& coins, const CTransaction& tx, const Consensus::Params& consensus, uint32_t height, uint32_t txn, CHistoryErasers& erasers) {
-    if (tx.IsCoinBase() && height > 0) { // genesis contains custom coinbase txs
-        return Res::Ok();
-    }
-    auto res = Res::Ok();
-    std::vector<unsigned char> metadata;
-    auto txType = GuessCustomTxType(tx, metadata);
-    switch(txType)
-    {
-        case CustomTxType::CreateMasternode:
-        case CustomTxType::ResignMasternode:
-        case CustomTxType::CreateToken:
-        case CustomTxType::CreatePoolPair:
-            // Enable these in the future
-        case CustomTxType::None:
-            return res;
-        default:
-            break;
-    }
-    auto txMessage = customTypeToMessage(txType);
-    CAccountsHistoryEraser view(mnview, height, txn, erasers);
-    if ((res = CustomMetadataParse(height, consensus, metadata, txMessage))) {
-        res = CustomTxRevert(view, coins, tx, height, consensus, txMessage);
-
-        // Track burn fee
-        if (txType == CustomTxType::CreateToken
-        || txType == CustomTxType::CreateMasternode
-        || txType == CustomTxType::Vault) {
-            erasers.SubFeeBurn(tx.vout[0].scriptPubKey);
-        }
-    }
-    if (!res) {
-        res.msg = strprintf("%sRevertTx: %s", ToString(txType), res.msg);
-        return res;
-    }
-    return (view.Flush(), res);
-}
-
 void PopulateVaultHistoryData(CHistoryWriters* writers, CAccountsHistoryWriter& view, const CCustomTxMessage& txMessage, const CustomTxType txType, const uint32_t height, const uint32_t txn, const uint256& txid) {
     if (txType == CustomTxType::Vault) {
         auto obj = boost::get<CVaultMessage>(txMessage);
@@ -3890,15 +3578,32 @@ void PopulateVaultHistoryData(CHistoryWriters* writers, CAccountsHistoryWriter&
     }
 }
 
-Res ApplyCustomTx(CCustomCSView& mnview, const CCoinsViewCache& coins, const CTransaction& tx, const Consensus::Params& consensus, uint32_t height, uint64_t time, uint32_t txn, CHistoryWriters* writers) {
+CCustomTxParsed ParseCustomTx(const CTransaction& tx, const Consensus::Params& consensus, uint32_t height) {
+    CCustomTxParsed parsed;
+    std::vector<unsigned char> metadata;
+    const auto metadataValidation = height >= static_cast<uint32_t>(consensus.FortCanningHeight);
+
+    parsed.type = GuessCustomTxType(tx, metadata, metadataValidation);
+    if (parsed.type == CustomTxType::None || (metadataValidation && parsed.type == CustomTxType::Reject)) {
+        return parsed;
+    }
+    parsed.message = customTypeToMessage(parsed.type);
+    parsed.res = CustomMetadataParse(height, consensus, metadata, parsed.message);
+    return parsed;
+}
+
+Res ApplyCustomTx(CCustomCSView& mnview, const CCoinsViewCache& coins, const CTransaction& tx, const Consensus::Params& consensus, uint32_t height, uint64_t time, uint32_t txn, CHistoryWriters* writers, const CCustomTxParsed* parsed) {
     auto res = Res::Ok();
     if (tx.IsCoinBase() && height > 0) { // genesis contains custom coinbase txs
         return res;
     }
-    std::vector<unsigned char> metadata;
+    std::optional<CCustomTxParsed> parsedHere;
+    if (!parsed) {
+        parsed = &parsedHere.emplace(ParseCustomTx(tx, consensus, height));
+    }
     const auto metadataValidation = height >= static_cast<uint32_t>(consensus.FortCanningHeight);
 
-    auto txType = GuessCustomTxType(tx, metadata, metadataValidation);
+    const auto txType = parsed->type;
     if (txType == CustomTxType::None) {
         return res;
     }
@@ -3906,10 +3611,10 @@ Res ApplyCustomTx(CCustomCSView& mnview, const CCoinsViewCache& coins, const CTr
     if (metadataValidation && txType == CustomTxType::Reject) {
         return Res::ErrCode(CustomTxErrCodes::Fatal, "Invalid custom transaction");
     }
-    auto txMessage = customTypeToMessage(txType);
+    const auto& txMessage = parsed->message;
     CAccountsHistoryWriter view(mnview, height, txn, tx.GetHash(), uint8_t(txType), writers);
-    if ((res = CustomMetadataParse(height, consensus, metadata, txMessage))) {
-        if (pvaultHistoryDB && writers) {
+    if ((res = parsed->res)) {
+        if (writers && writers->vaultView) {
            PopulateVaultHistoryData(writers, view, txMessage, txType, height, txn, tx.GetHash());
         }
         res = CustomTxVisit(view, coins, tx, height, consensus, txMessage, time, txn);
@@ -3949,10 +3654,8 @@ Res ApplyCustomTx(CCustomCSView& mnview, const CCoinsViewCache& coins, const CTr
     auto undo = CUndo::Construct(mnview.GetStorage(), flushable.GetRaw());
     // flush changes
     view.Flush();
-    // write undo
-    if (!undo.before.empty()) {
-        mnview.SetUndo(UndoKey{height, tx.GetHash()}, undo);
-    }
+    // write undo, an empty one too so a lost undo can be told from a tx that changed nothing
+    mnview.SetUndo(UndoKey{height, tx.GetHash()}, undo);
     return res;
 }
 
@@ -23,7 +23,6 @@ class CAccountsHistoryView;
 class CCustomTxVisitor;
 class CVaultHistoryView;
 class CHistoryWriters;
-class CHistoryErasers;
 
 enum CustomTxErrCodes : uint32_t {
     NotSpecified = 0,
@@ -169,6 +168,9 @@ inline CustomTxType CustomTxCodeToType(uint8_t ch) {
 std::string ToString(CustomTxType type);
 CustomTxType FromString(const std::string& str);
 
+// known custom txs that failed to apply before Dakota, see skipped_txs.cpp
+bool IsSkippedTx(const uint256& hash);
+
 // it's disabled after Dakota height
 inline bool NotAllowedToFail(CustomTxType txType, int height) {
     return (height < Params().GetConsensus().DakotaHeight
@@ -381,11 +383,19 @@ typedef boost::variant<
 > CCustomTxMessage;
 
 CCustomTxMessage customTypeToMessage(CustomTxType txType);
+
+/** Type and message of a custom tx, parsed ahead of applying it */
+struct CCustomTxParsed {
+    CustomTxType type{CustomTxType::None};
+    CCustomTxMessage message;
+    Res res = Res::Ok(); // of parsing the metadata
+};
+
 bool IsMempooledCustomTxCreate(const CTxMemPool& pool, const uint256& txid);
 Res RpcInfo(const CTransaction& tx, uint32_t height, CustomTxType& type, UniValue& results);
 Res CustomMetadataParse(uint32_t height, const Consensus::Params& consensus, const std::vector<unsigned char>& metadata, CCustomTxMessage& txMessage);
-Res ApplyCustomTx(CCustomCSView& mnview, const CCoinsViewCache& coins, const CTransaction& tx, const Consensus::Params& consensus, uint32_t height, uint64_t time = 0, uint32_t txn = 0, CHistoryWriters* writers = nullptr);
-Res RevertCustomTx(CCustomCSView& mnview, const CCoinsViewCache& coins, const CTransaction& tx, const Consensus::Params& consensus, uint32_t height,  uint32_t txn, CHistoryErasers& erasers);
+CCustomTxParsed ParseCustomTx(const CTransaction& tx, const Consensus::Params& consensus, uint32_t height);
+Res ApplyCustomTx(CCustomCSView& mnview, const CCoinsViewCache& coins, const CTransaction& tx, const Consensus::Params& consensus, uint32_t height, uint64_t time = 0, uint32_t txn = 0, CHistoryWriters* writers = nullptr, const CCustomTxParsed* parsed = nullptr);
 Res CustomTxVisit(CCustomCSView& mnview, const CCoinsViewCache& coins, const CTransaction& tx, uint32_t height, const Consensus::Params& consensus, const CCustomTxMessage& txMessage, uint64_t time, uint32_t txn = 0);
 ResVal<uint256> ApplyAnchorRewardTx(CCustomCSView& mnview, const CTransaction& tx, int height, const uint256& prevStakeModifier, const std::vector<unsigned char>& metadata, const Consensus::Params& consensusParams);
 ResVal<uint256> ApplyAnchorRewardTxPlus(CCustomCSView& mnview, const CTransaction& tx, int height, const std::vector<unsigned char>& metadata, const Consensus::Params& consensusParams);
@@ -5,6 +5,7 @@
 #include <regex>
 #include <masternodes/mn_rpc.h>
 #include <base58.h>
+#include <index/customtxindex.h>
 #include <policy/settings.h>
 #include <masternodes/govvariables/attributes.h>
 
@@ -232,6 +233,39 @@ void CWalletCoinsUnlocker::AddLockedCoin(const COutPoint& coin) {
     coins.push_back(coin);
 }
 
+CHistoryResult::CHistoryResult(const JSONRPCRequest& request, uint32_t limit) :
+    stream(request, UniValue::VARR), limit(limit) {
+}
+
+void CHistoryResult::Add(uint32_t height, UniValue record) {
+    records[height].push_back(std::move(record));
+    if (++pending > limit) {
+        // the lowest record falls out of the limit
+        auto lowest = std::prev(records.end());
+        lowest->second.pop_back();
+        if (lowest->second.empty()) {
+            records.erase(lowest);
+        }
+        --pending;
+    }
+}
+
+void CHistoryResult::Flush(uint32_t height) {
+    auto end = records.upper_bound(height);
+    for (auto it = records.begin(); it != end; it = records.erase(it)) {
+        for (const auto& record : it->second) {
+            stream.push_back(record);
+        }
+        limit -= it->second.size();
+        pending -= it->second.size();
+    }
+}
+
+UniValue CHistoryResult::get() {
+    Flush(0);
+    return stream.get();
+}
+
 CTransactionRef signsend(CMutableTransaction& mtx, CWalletCoinsUnlocker& pwallet, CTransactionRef optAuthTx) {
     return send(sign(mtx, pwallet, optAuthTx), optAuthTx);
 }
@@ -809,19 +843,28 @@ UniValue isappliedcustomtx(const JSONRPCRequest& request) {
 
     RPCTypeCheck(request.params, {UniValue::VSTR, UniValue::VNUM}, false);
 
-    LOCK(cs_main);
-
     UniValue result(UniValue::VBOOL);
     result.setBool(false);
 
     uint256 txHash = ParseHashV(request.params[0], "txid");
     int blockHeight = request.params[1].get_int();
 
+    CCustomTxIndexEntry entry;
+    const bool indexed = g_customtxindex && g_customtxindex->BlockUntilSyncedToCurrentChain()
+                      && g_customtxindex->FindCustomTx(txHash, entry);
+
+    LOCK(cs_main);
+
     auto blockindex = ::ChainActive()[blockHeight];
     if (!blockindex) {
         return result;
     }
 
+    if (indexed && entry.blockHash == blockindex->GetBlockHash()) {
+        result.setBool(entry.applied);
+        return result;
+    }
+
     uint256 hashBlock;
     CTransactionRef tx;
     if (!GetTransaction(txHash, tx, Params().GetConsensus(), hashBlock, blockindex)) {
@@ -850,6 +893,135 @@ UniValue isappliedcustomtx(const JSONRPCRequest& request) {
 }
 
 
+UniValue listcustomtxs(const JSONRPCRequest& request) {
+    RPCHelpMan{"listcustomtxs",
+               "\nReturns the custom transactions of a type in the active chain, in chain order. Requires -customtxindex.\n",
+               {
+                    {"type", RPCArg::Type::STR, RPCArg::Optional::NO, "Custom transaction type, as reported by getcustomtx"},
+                    {"options", RPCArg::Type::OBJ, RPCArg::Optional::OMITTED, "",
+                        {
+                            {"minHeight", RPCArg::Type::NUM, RPCArg::Optional::OMITTED, "First block height to list transactions of (default = 0)"},
+                            {"maxHeight", RPCArg::Type::NUM, RPCArg::Optional::OMITTED, "Last block height to list transactions of (default = chain tip)"},
+                            {"start", RPCArg::Type::STR_HEX, RPCArg::Optional::OMITTED,
+                                "Optional txid to continue from, typically the last txid from previous request"},
+                            {"including_start", RPCArg::Type::BOOL, RPCArg::Optional::OMITTED,
+                                "If true, then iterate including starting position. False by default"},
+                            {"limit", RPCArg::Type::NUM, RPCArg::Optional::OMITTED, "Maximum number of transactions to return, 100 by default"},
+                        },
+                    },
+               },
+               RPCResult{
+                       "[{...}, ...]     (array) Json objects with txid, type, blockHeight, blockHash, txn and valid\n"
+               },
+               RPCExamples{
+                       HelpExampleCli("listcustomtxs", "PoolSwap '{\"minHeight\":1000,\"maxHeight\":2000}'")
+                       + HelpExampleRpc("listcustomtxs", "\"PoolSwap\", {\"minHeight\":1000,\"maxHeight\":2000}")
+               },
+    }.Check(request);
+
+    if (!g_customtxindex) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Custom transaction index is not enabled. Use -customtxindex.");
+    }
+
+    RPCTypeCheck(request.params, {UniValue::VSTR, UniValue::VOBJ}, true);
+
+    const auto type = FromString(request.params[0].get_str());
+    if (type == CustomTxType::None) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid custom transaction type: " + request.params[0].get_str());
+    }
+
+    int minHeight = 0;
+    int maxHeight = std::numeric_limits<int>::max();
+    size_t limit = 100;
+    uint256 start;
+    bool including_start = false;
+
+    if (request.params.size() > 1) {
+        UniValue optionsObj = request.params[1].get_obj();
+        RPCTypeCheckObj(optionsObj,
+            {
+                {"minHeight", UniValueType(UniValue::VNUM)},
+                {"maxHeight", UniValueType(UniValue::VNUM)},
+                {"start", UniValueType(UniValue::VSTR)},
+                {"including_start", UniValueType(UniValue::VBOOL)},
+                {"limit", UniValueType(UniValue::VNUM)},
+            }, true, true);
+
+        if (!optionsObj["minHeight"].isNull()) {
+            minHeight = optionsObj["minHeight"].get_int();
+        }
+        if (!optionsObj["maxHeight"].isNull()) {
+            maxHeight = optionsObj["maxHeight"].get_int();
+        }
+        if (minHeight < 0 || maxHeight < minHeight) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid height range");
+        }
+        if (!optionsObj["start"].isNull()) {
+            start = ParseHashV(optionsObj["start"], "start");
+        }
+        if (!optionsObj["including_start"].isNull()) {
+            including_start = optionsObj["including_start"].getBool();
+        }
+        if (!optionsObj["limit"].isNull()) {
+            limit = (size_t) optionsObj["limit"].get_int64();
+        }
+        if (limit == 0) {
+            limit = std::numeric_limits<decltype(limit)>::max();
+        }
+    }
+
+    g_customtxindex->BlockUntilSyncedToCurrentChain();
+
+    int startHeight = minHeight;
+    uint32_t startTxn = 0;
+    if (!start.IsNull()) {
+        CCustomTxIndexEntry entry;
+        if (!g_customtxindex->FindCustomTx(start, entry) || entry.type != type) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "start transaction not found for type " + ToString(type));
+        }
+        startHeight = std::max(startHeight, entry.height);
+        if (startHeight == entry.height) {
+            startTxn = entry.txn + (including_start ? 0 : 1);
+        }
+    }
+
+    UniValue ret(UniValue::VARR);
+
+    // the index is scanned without cs_main, entries are checked against the chain of the tip as of now
+    const CBlockIndex* tip;
+    {
+        LOCK(cs_main);
+        tip = ::ChainActive().Tip();
+    }
+    maxHeight = std::min(maxHeight, tip->nHeight);
+
+    g_customtxindex->ForEachCustomTx(type, [&](const uint256& txid, int height, uint32_t txn) {
+        if (height > maxHeight) {
+            return false;
+        }
+
+        // entries of disconnected blocks stay until the index catches up
+        CCustomTxIndexEntry entry;
+        const auto blockindex = tip->GetAncestor(height);
+        if (!g_customtxindex->FindCustomTx(txid, entry) || entry.blockHash != blockindex->GetBlockHash()) {
+            return true;
+        }
+
+        UniValue obj(UniValue::VOBJ);
+        obj.pushKV("txid", txid.GetHex());
+        obj.pushKV("type", ToString(type));
+        obj.pushKV("blockHeight", height);
+        obj.pushKV("blockHash", entry.blockHash.GetHex());
+        obj.pushKV("txn", (uint64_t) txn);
+        obj.pushKV("valid", entry.applied);
+        ret.push_back(obj);
+
+        return --limit != 0;
+    }, startHeight, startTxn);
+
+    return ret;
+}
+
 static std::string GetContractCall(const std::string& str) {
     if (str == "DFIP2201") {
         return "dbtcdfiswap";
@@ -954,6 +1126,7 @@ static const CRPCCommand commands[] =
     {"blockchain",  "getgov",                &getgov,                {"name"}},
     {"blockchain",  "listgovs",              &listgovs,              {"prefix"}},
     {"blockchain",  "isappliedcustomtx",     &isappliedcustomtx,     {"txid", "blockHeight"}},
+    {"blockchain",  "listcustomtxs",         &listcustomtxs,         {"type", "options"}},
     {"blockchain",  "listsmartcontracts",    &listsmartcontracts,    {}},
     {"blockchain",  "clearmempool",          &clearmempool,          {} },
 };
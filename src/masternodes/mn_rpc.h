@@ -48,8 +48,26 @@ public:
     void AddLockedCoin(const COutPoint& coin);
 };
 
+/**
+ * Result of the history RPCs: records by descending height, in the order they
+ * were added at the same height, up to a limit. Flushed records are streamed,
+ * which a walk by descending height does as it goes. Until then no more than
+ * the limit of records is held.
+ */
+class CHistoryResult {
+    RPCResultStream stream;
+    std::map<uint32_t, std::vector<UniValue>, std::greater<uint32_t>> records;
+    size_t pending{0};
+    uint32_t limit;
+public:
+    CHistoryResult(const JSONRPCRequest& request, uint32_t limit);
+    void Add(uint32_t height, UniValue record);
+    /** Stream the records at the height and above, none of them may be added afterwards */
+    void Flush(uint32_t height);
+    UniValue get();
+};
+
 // common functions
-bool IsSkippedTx(const uint256& hash);
 int chainHeight(interfaces::Chain::Lock& locked_chain);
 CMutableTransaction fund(CMutableTransaction& mtx, CWalletCoinsUnlocker& pwallet, CTransactionRef optAuthTx, CCoinControl* coin_control = nullptr);
 CTransactionRef signsend(CMutableTransaction& mtx, CWalletCoinsUnlocker& pwallet, CTransactionRef optAuthTx);
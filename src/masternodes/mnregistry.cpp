@@ -0,0 +1,164 @@
+// Copyright (c) DeFi Blockchain Developers
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#include <masternodes/mnregistry.h>
+#include <chainparams.h>
+
+#include <climits>
+
+void CMasternodeRegistry::Set(uint256 const & id, CMasternode const & node)
+{
+    Entry entry{node, 0, INT_MAX};
+    if (node.creationHeight != 0) {
+        entry.activeFrom = node.creationHeight + GetMnActivationDelay(node.creationHeight);
+    }
+    if (node.resignHeight != -1) {
+        entry.activeTo = node.resignHeight;
+    }
+
+    LOCK(cs);
+    auto it = nodes.find(id);
+    if (it != nodes.end()) {
+        Remove(it);
+    }
+    nodes.emplace(id, entry);
+    byActiveTo.emplace(entry.activeTo, id);
+    AddCountChange(entry.activeFrom, entry.activeTo, 1);
+}
+
+void CMasternodeRegistry::Erase(uint256 const & id)
+{
+    LOCK(cs);
+    auto it = nodes.find(id);
+    if (it != nodes.end()) {
+        Remove(it);
+    }
+}
+
+void CMasternodeRegistry::OnChange(const TBytes& key, const std::optional<TBytes>& value)
+{
+    if (key.empty() || key[0] != CMasternodesView::ID::prefix()) {
+        return;
+    }
+
+    std::pair<uint8_t, uint256> mnKey;
+    if (!BytesToDbType(key, mnKey)) {
+        return;
+    }
+
+    CMasternode node;
+    if (value && BytesToDbType(*value, node)) {
+        Set(mnKey.second, node);
+    } else {
+        Erase(mnKey.second);
+    }
+}
+
+void CMasternodeRegistry::Remove(std::map<uint256, Entry>::iterator it)
+{
+    const auto& [id, entry] = *it;
+    auto range = byActiveTo.equal_range(entry.activeTo);
+    for (auto idIt = range.first; idIt != range.second; ++idIt) {
+        if (idIt->second == id) {
+            byActiveTo.erase(idIt);
+            break;
+        }
+    }
+    AddCountChange(entry.activeFrom, entry.activeTo, -1);
+    nodes.erase(it);
+}
+
+void CMasternodeRegistry::AddCountChange(int from, int to, int delta)
+{
+    // resigned before it got activated
+    if (from >= to) {
+        return;
+    }
+
+    auto add = [&](int height, int64_t change) {
+        auto it = countChanges.emplace(height, 0).first;
+        it->second += change;
+        if (it->second == 0) {
+            countChanges.erase(it);
+        }
+    };
+    add(from, delta);
+    if (to != INT_MAX) {
+        add(to, -delta);
+    }
+
+    if (from <= countHeight && countHeight < to) {
+        activeCount += delta;
+    }
+}
+
+size_t CMasternodeRegistry::Count() const
+{
+    LOCK(cs);
+    return nodes.size();
+}
+
+size_t CMasternodeRegistry::CountActive(int height) const
+{
+    LOCK(cs);
+    if (height < Params().GetConsensus().EunosPayaHeight) {
+        size_t count{0};
+        for (const auto& [id, entry] : nodes) {
+            count += entry.node.IsActive(height);
+        }
+        return count;
+    }
+
+    if (height > countHeight) {
+        for (auto it = countChanges.upper_bound(countHeight); it != countChanges.end() && it->first <= height; ++it) {
+            activeCount += it->second;
+        }
+    } else {
+        for (auto it = countChanges.upper_bound(height); it != countChanges.end() && it->first <= countHeight; ++it) {
+            activeCount -= it->second;
+        }
+    }
+    countHeight = height;
+    return activeCount;
+}
+
+std::optional<CMasternode> CMasternodeRegistry::Get(uint256 const & id) const
+{
+    LOCK(cs);
+    auto it = nodes.find(id);
+    if (it == nodes.end()) {
+        return {};
+    }
+    return it->second.node;
+}
+
+void CMasternodeRegistry::ForEach(Callback callback, uint256 const & start) const
+{
+    LOCK(cs);
+    for (auto it = nodes.lower_bound(start); it != nodes.end(); ++it) {
+        if (!callback(it->first, it->second.node)) {
+            break;
+        }
+    }
+}
+
+void CMasternodeRegistry::ForEachActive(int height, Callback callback) const
+{
+    LOCK(cs);
+    if (height < Params().GetConsensus().EunosPayaHeight) {
+        for (const auto& [id, entry] : nodes) {
+            if (entry.node.IsActive(height) && !callback(id, entry.node)) {
+                break;
+            }
+        }
+        return;
+    }
+
+    for (auto it = byActiveTo.upper_bound(height); it != byActiveTo.end(); ++it) {
+        const auto& entry = nodes.at(it->second);
+        if (entry.activeFrom <= height && !callback(it->second, entry.node)) {
+            break;
+        }
+    }
+}
@@ -0,0 +1,73 @@
+// Copyright (c) DeFi Blockchain Developers
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef DEFI_MASTERNODES_MNREGISTRY_H
+#define DEFI_MASTERNODES_MNREGISTRY_H
+
+#include <masternodes/masternodes.h>
+#include <sync.h>
+
+#include <functional>
+#include <map>
+#include <optional>
+
+/**
+ * In-memory copy of the masternodes of a flushable storage, kept in sync by listening
+ * to its writes, so it follows undo as well. Nodes are indexed by the heights they are
+ * active until. As of EunosPaya, activation and resign delays no longer depend on the
+ * height asked for, so a node is active within the fixed range of heights
+ * [activeFrom, activeTo), which makes walking the active set and counting it cheap.
+ * Below EunosPaya every node gets checked, still without reading the database.
+ *
+ * The storage must never be discarded, as that isn't reported to listeners. Callbacks
+ * run under the registry lock and must not write masternodes.
+ */
+class CMasternodeRegistry
+{
+public:
+    using Callback = std::function<bool(uint256 const &, CMasternode const &)>;
+
+    explicit CMasternodeRegistry(const CStorageKV& storage_) : storage(storage_) {}
+
+    // The storage this is a copy of
+    const CStorageKV& Storage() const { return storage; }
+
+    void Set(uint256 const & id, CMasternode const & node);
+    void Erase(uint256 const & id);
+    // Keeps in sync with a raw write or erase of the storage
+    void OnChange(const TBytes& key, const std::optional<TBytes>& value);
+
+    size_t Count() const;
+    // Number of nodes active at height, constant time when asked for the same or
+    // a nearby height as the last time
+    size_t CountActive(int height) const;
+
+    std::optional<CMasternode> Get(uint256 const & id) const;
+    // In order of id from start on, like CMasternodesView::ForEachMasternode
+    void ForEach(Callback callback, uint256 const & start = {}) const;
+    // Nodes active at height in no particular order
+    void ForEachActive(int height, Callback callback) const;
+
+private:
+    struct Entry {
+        CMasternode node;
+        int activeFrom;
+        int activeTo;
+    };
+
+    void Remove(std::map<uint256, Entry>::iterator it) EXCLUSIVE_LOCKS_REQUIRED(cs);
+    void AddCountChange(int from, int to, int delta) EXCLUSIVE_LOCKS_REQUIRED(cs);
+
+    mutable Mutex cs;
+    const CStorageKV& storage;
+    std::map<uint256, Entry> nodes GUARDED_BY(cs);
+    std::multimap<int, uint256> byActiveTo GUARDED_BY(cs);
+    // active count changes by height, +1 at activeFrom and -1 at activeTo
+    std::map<int, int64_t> countChanges GUARDED_BY(cs);
+    // active count at countHeight, moved along by CountActive, none are active before genesis
+    mutable int countHeight GUARDED_BY(cs){-1};
+    mutable int64_t activeCount GUARDED_BY(cs){0};
+};
+
+#endif // DEFI_MASTERNODES_MNREGISTRY_H
@@ -0,0 +1,50 @@
+// Copyright (c) DeFi Blockchain Developers
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#include <masternodes/oraclehistory.h>
+
+void COracleHistoryView::WriteOraclePrice(OraclePriceHistoryKey const & key, OraclePriceHistoryValue const & value)
+{
+    WriteBy<ByOraclePriceKey>(key, value);
+}
+
+void COracleHistoryView::ForEachOraclePrice(std::function<bool(OraclePriceHistoryKey const &, CLazySerialize<OraclePriceHistoryValue>)> callback, OraclePriceHistoryKey const & start)
+{
+    ForEach<ByOraclePriceKey, OraclePriceHistoryKey, OraclePriceHistoryValue>(callback, start);
+}
+
+void COracleHistoryView::WriteFixedIntervalPrice(FixedIntervalPriceHistoryKey const & key, CFixedIntervalPrice const & value)
+{
+    WriteBy<ByFixedIntervalPriceKey>(key, value);
+}
+
+void COracleHistoryView::ForEachFixedIntervalPrice(std::function<bool(FixedIntervalPriceHistoryKey const &, CLazySerialize<CFixedIntervalPrice>)> callback, FixedIntervalPriceHistoryKey const & start)
+{
+    ForEach<ByFixedIntervalPriceKey, FixedIntervalPriceHistoryKey, CFixedIntervalPrice>(callback, start);
+}
+
+void COracleHistoryView::WriteFixedIntervalPrices(uint32_t height, const MapKV& stateChanges)
+{
+    const auto prefix = COracleView::FixedIntervalPriceKey::prefix();
+    for (auto it = stateChanges.lower_bound({prefix}); it != stateChanges.end() && it->first.front() == prefix; ++it) {
+        std::pair<uint8_t, CTokenCurrencyPair> key;
+        CFixedIntervalPrice price;
+        if (!it->second || !BytesToDbType(it->first, key) || !BytesToDbType(*it->second, price)) {
+            continue;
+        }
+        WriteFixedIntervalPrice({key.second.first, key.second.second, height}, price);
+    }
+}
+
+COracleHistoryStorage::COracleHistoryStorage(const fs::path& dbName, const CDBOptions& dbOptions, bool fMemory, bool fWipe)
+    : CStorageView(new CStorageLevelDB(dbName, dbOptions, fMemory, fWipe))
+{
+}
+
+COracleHistoryStorage::COracleHistoryStorage(CStorageKV* storage)
+    : CStorageView(storage)
+{
+}
+
+std::unique_ptr<COracleHistoryStorage> poracleHistoryDB;
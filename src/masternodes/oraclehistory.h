@@ -0,0 +1,113 @@
+// Copyright (c) DeFi Blockchain Developers
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef DEFI_MASTERNODES_ORACLEHISTORY_H
+#define DEFI_MASTERNODES_ORACLEHISTORY_H
+
+#include <amount.h>
+#include <flushablestorage.h>
+#include <masternodes/oracles.h>
+#include <uint256.h>
+
+// Keys of both histories are ordered by token, currency and then by height
+// descending, so the first record at or below a height is the one at it
+struct OraclePriceHistoryKey {
+    std::string token;
+    std::string currency;
+    uint32_t blockHeight;
+    uint32_t txn; // for order in block
+    COracleId oracleId;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(token);
+        READWRITE(currency);
+
+        if (ser_action.ForRead()) {
+            READWRITE(WrapBigEndian(blockHeight));
+            blockHeight = ~blockHeight;
+            READWRITE(WrapBigEndian(txn));
+            txn = ~txn;
+        }
+        else {
+            uint32_t blockHeight_ = ~blockHeight;
+            READWRITE(WrapBigEndian(blockHeight_));
+            uint32_t txn_ = ~txn;
+            READWRITE(WrapBigEndian(txn_));
+        }
+
+        READWRITE(oracleId);
+    }
+};
+
+struct OraclePriceHistoryValue {
+    uint256 txid;
+    int64_t timestamp;
+    CAmount price;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(txid);
+        READWRITE(timestamp);
+        READWRITE(price);
+    }
+};
+
+struct FixedIntervalPriceHistoryKey {
+    std::string token;
+    std::string currency;
+    uint32_t blockHeight;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(token);
+        READWRITE(currency);
+
+        if (ser_action.ForRead()) {
+            READWRITE(WrapBigEndian(blockHeight));
+            blockHeight = ~blockHeight;
+        }
+        else {
+            uint32_t blockHeight_ = ~blockHeight;
+            READWRITE(WrapBigEndian(blockHeight_));
+        }
+    }
+};
+
+class COracleHistoryView : public virtual CStorageView
+{
+public:
+    void WriteOraclePrice(OraclePriceHistoryKey const & key, OraclePriceHistoryValue const & value);
+    void ForEachOraclePrice(std::function<bool(OraclePriceHistoryKey const &, CLazySerialize<OraclePriceHistoryValue>)> callback, OraclePriceHistoryKey const & start = {});
+
+    void WriteFixedIntervalPrice(FixedIntervalPriceHistoryKey const & key, CFixedIntervalPrice const & value);
+    void ForEachFixedIntervalPrice(std::function<bool(FixedIntervalPriceHistoryKey const &, CLazySerialize<CFixedIntervalPrice>)> callback, FixedIntervalPriceHistoryKey const & start = {});
+
+    // Writes the fixed interval prices set by a block, taken from the block's changes of the custom state
+    void WriteFixedIntervalPrices(uint32_t height, const MapKV& stateChanges);
+
+    struct ByOraclePriceKey { static constexpr uint8_t prefix() { return 0x01; } };
+    struct ByFixedIntervalPriceKey { static constexpr uint8_t prefix() { return 0x02; } };
+};
+
+class COracleHistoryStorage : public COracleHistoryView
+{
+    static_assert(UniqueStoragePrefixes<ByOraclePriceKey, ByFixedIntervalPriceKey>(), "prefixes are equal");
+
+public:
+    COracleHistoryStorage(const fs::path& dbName, const CDBOptions& dbOptions, bool fMemory = false, bool fWipe = false);
+    explicit COracleHistoryStorage(CStorageKV* storage);
+};
+
+extern std::unique_ptr<COracleHistoryStorage> poracleHistoryDB;
+
+static constexpr bool DEFAULT_ORACLEINDEX = false;
+
+#endif //DEFI_MASTERNODES_ORACLEHISTORY_H
@@ -140,7 +140,7 @@ public:
     Res RemoveOracle(const COracleId& oracleId);
 
     /// store registered oracle data
-    Res SetOracleData(const COracleId& oracleId, int64_t timestamp, const CTokenPrices& tokenPrices);
+    virtual Res SetOracleData(const COracleId& oracleId, int64_t timestamp, const CTokenPrices& tokenPrices);
 
     /// deserialize oracle instance from database
     ResVal<COracle> GetOracleData(const COracleId& oracleId) const;
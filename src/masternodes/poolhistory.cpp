@@ -0,0 +1,86 @@
+// Copyright (c) DeFi Blockchain Developers
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#include <masternodes/poolhistory.h>
+
+#include <arith_uint256.h>
+
+CAmount PoolReservePrice(CAmount reserveA, CAmount reserveB)
+{
+    if (reserveA <= 0 || reserveB <= 0) {
+        return 0;
+    }
+    return static_cast<CAmount>((arith_uint256(reserveB) * arith_uint256(COIN) / arith_uint256(reserveA)).GetLow64());
+}
+
+void CPoolHistoryView::WritePoolHistory(PoolHistoryKey const & key, PoolHistoryValue const & value)
+{
+    WriteBy<ByPoolHistoryKey>(key, value);
+}
+
+void CPoolHistoryView::ForEachPoolHistory(std::function<bool(PoolHistoryKey const &, CLazySerialize<PoolHistoryValue>)> callback, PoolHistoryKey const & start)
+{
+    ForEach<ByPoolHistoryKey, PoolHistoryKey, PoolHistoryValue>(callback, start);
+}
+
+CPoolHistoryStorage::CPoolHistoryStorage(const fs::path& dbName, const CDBOptions& dbOptions, bool fMemory, bool fWipe)
+    : CStorageView(new CStorageLevelDB(dbName, dbOptions, fMemory, fWipe))
+{
+}
+
+CPoolHistoryStorage::CPoolHistoryStorage(CStorageKV* storage)
+    : CStorageView(storage)
+{
+}
+
+void CPoolSwapCollector::AddSwap(DCT_ID const & poolId, CPoolPair const & before, CPoolPair const & after)
+{
+    auto it = pools.find(poolId);
+    if (it == pools.end()) {
+        const auto open = PoolReservePrice(before.reserveA, before.reserveB);
+        it = pools.emplace(poolId, PoolHistoryValue{}).first;
+        it->second.openPrice = it->second.highPrice = it->second.lowPrice = open;
+    }
+    auto& value = it->second;
+
+    // the swapped in amount went to the reserve but its commission, the swapped out one left it
+    const auto commissionA = after.blockCommissionA - before.blockCommissionA;
+    const auto commissionB = after.blockCommissionB - before.blockCommissionB;
+    value.volumeA += std::abs(after.reserveA - before.reserveA) + commissionA;
+    value.volumeB += std::abs(after.reserveB - before.reserveB) + commissionB;
+    value.commissionA += commissionA;
+    value.commissionB += commissionB;
+    ++value.swaps;
+
+    const auto price = PoolReservePrice(after.reserveA, after.reserveB);
+    value.highPrice = std::max(value.highPrice, price);
+    value.lowPrice = value.lowPrice ? std::min(value.lowPrice, price) : price;
+}
+
+void CPoolSwapCollector::Flush(CPoolHistoryView& view, uint32_t height, int64_t time, const MapKV& stateChanges)
+{
+    const auto prefix = CPoolPairView::ByReserves::prefix();
+    for (auto it = stateChanges.lower_bound({prefix}); it != stateChanges.end() && it->first.front() == prefix; ++it) {
+        std::pair<uint8_t, DCT_ID> key;
+        PoolReservesValue reserves;
+        if (!it->second || !BytesToDbType(it->first, key) || !BytesToDbType(*it->second, reserves)) {
+            continue;
+        }
+        auto& value = pools[key.second];
+        value.reserveA = reserves.reserveA;
+        value.reserveB = reserves.reserveB;
+    }
+
+    for (auto& [poolId, value] : pools) {
+        value.time = time;
+        if (!value.swaps) {
+            // reserves changed by liquidity only, the price of the block is the closing one
+            value.openPrice = value.highPrice = value.lowPrice = PoolReservePrice(value.reserveA, value.reserveB);
+        }
+        view.WritePoolHistory({poolId, height}, value);
+    }
+    pools.clear();
+}
+
+std::unique_ptr<CPoolHistoryStorage> ppoolHistoryDB;
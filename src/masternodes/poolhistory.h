@@ -0,0 +1,95 @@
+// Copyright (c) DeFi Blockchain Developers
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef DEFI_MASTERNODES_POOLHISTORY_H
+#define DEFI_MASTERNODES_POOLHISTORY_H
+
+#include <amount.h>
+#include <flushablestorage.h>
+#include <masternodes/poolpairs.h>
+
+#include <map>
+
+struct PoolHistoryKey {
+    DCT_ID poolID;
+    uint32_t height;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(WrapBigEndian(poolID.v));
+        READWRITE(WrapBigEndian(height));
+    }
+};
+
+// State and trading of a pool in one block. Prices are of token A in token B,
+// with COIN precision, open is the price before the first swap of the block.
+struct PoolHistoryValue {
+    int64_t time{0};
+    CAmount reserveA{0};
+    CAmount reserveB{0};
+    CAmount openPrice{0};
+    CAmount highPrice{0};
+    CAmount lowPrice{0};
+    CAmount volumeA{0};
+    CAmount volumeB{0};
+    CAmount commissionA{0};
+    CAmount commissionB{0};
+    uint32_t swaps{0};
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(time);
+        READWRITE(reserveA);
+        READWRITE(reserveB);
+        READWRITE(openPrice);
+        READWRITE(highPrice);
+        READWRITE(lowPrice);
+        READWRITE(volumeA);
+        READWRITE(volumeB);
+        READWRITE(commissionA);
+        READWRITE(commissionB);
+        READWRITE(swaps);
+    }
+};
+
+// Price of token A in token B at the reserves, zero for an empty pool
+CAmount PoolReservePrice(CAmount reserveA, CAmount reserveB);
+
+class CPoolHistoryView : public virtual CStorageView
+{
+public:
+    void WritePoolHistory(PoolHistoryKey const & key, PoolHistoryValue const & value);
+    void ForEachPoolHistory(std::function<bool(PoolHistoryKey const &, CLazySerialize<PoolHistoryValue>)> callback, PoolHistoryKey const & start = {});
+
+    struct ByPoolHistoryKey { static constexpr uint8_t prefix() { return 0x01; } };
+};
+
+class CPoolHistoryStorage : public CPoolHistoryView
+{
+public:
+    CPoolHistoryStorage(const fs::path& dbName, const CDBOptions& dbOptions, bool fMemory = false, bool fWipe = false);
+    explicit CPoolHistoryStorage(CStorageKV* storage);
+};
+
+// Swaps of the pools in the block being connected
+class CPoolSwapCollector {
+    std::map<DCT_ID, PoolHistoryValue> pools;
+
+public:
+    void AddSwap(DCT_ID const & poolId, CPoolPair const & before, CPoolPair const & after);
+    // Writes the pools that swapped or changed reserves in the block, taken from
+    // the block's changes of the custom state
+    void Flush(CPoolHistoryView& view, uint32_t height, int64_t time, const MapKV& stateChanges);
+    void Discard() { pools.clear(); }
+};
+
+extern std::unique_ptr<CPoolHistoryStorage> ppoolHistoryDB;
+
+static constexpr bool DEFAULT_POOLINDEX = false;
+
+#endif //DEFI_MASTERNODES_POOLHISTORY_H
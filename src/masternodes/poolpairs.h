@@ -193,6 +193,19 @@ struct PoolHeightKey {
     }
 };
 
+struct PoolReservesValue {
+    CAmount reserveA;
+    CAmount reserveB;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(reserveA);
+        READWRITE(reserveB);
+    }
+};
+
 enum RewardType
 {
     Commission = 127,
@@ -208,7 +221,7 @@ std::string RewardTypeToString(RewardType type);
 class CPoolPairView : public virtual CStorageView
 {
 public:
-    Res SetPoolPair(const DCT_ID &poolId, uint32_t height, CPoolPair const & pool);
+    virtual Res SetPoolPair(const DCT_ID &poolId, uint32_t height, CPoolPair const & pool);
     Res UpdatePoolPair(DCT_ID const & poolId, uint32_t height, bool status, CAmount const & commission, CScript const & ownerAddress, CBalances const & rewards);
 
     std::optional<CPoolPair> GetPoolPair(const DCT_ID &poolId) const;
@@ -1,13 +1,18 @@
+#include <index/historyindex.h>
 #include <masternodes/accountshistory.h>
 #include <masternodes/govvariables/attributes.h>
 #include <masternodes/mn_rpc.h>
 
-std::string tokenAmountString(CTokenAmount const& amount) {
-    const auto token = pcustomcsview->GetToken(amount.nTokenId);
+std::string tokenAmountString(CCustomCSView& view, CTokenAmount const& amount) {
+    const auto token = view.GetToken(amount.nTokenId);
     const auto valueString = ValueFromAmount(amount.nValue).getValStr();
     return valueString + "@" + token->CreateSymbolKey(amount.nTokenId);
 }
 
+std::string tokenAmountString(CTokenAmount const& amount) {
+    return tokenAmountString(*pcustomcsview, amount);
+}
+
 UniValue AmountsToJSON(TAmounts const & diffs) {
     UniValue obj(UniValue::VARR);
 
@@ -17,7 +22,7 @@ UniValue AmountsToJSON(TAmounts const & diffs) {
     return obj;
 }
 
-UniValue accountToJSON(CScript const& owner, CTokenAmount const& amount, bool verbose, bool indexed_amounts) {
+UniValue accountToJSON(CCustomCSView& view, CScript const& owner, CTokenAmount const& amount, bool verbose, bool indexed_amounts) {
     // encode CScript into JSON
     UniValue ownerObj(UniValue::VOBJ);
     ScriptPubKeyToUniv(owner, ownerObj, true);
@@ -40,7 +45,7 @@ UniValue accountToJSON(CScript const& owner, CTokenAmount const& amount, bool ve
         obj.pushKV("amount", amountObj);
     }
     else {
-        obj.pushKV("amount", tokenAmountString(amount));
+        obj.pushKV("amount", tokenAmountString(view, amount));
     }
 
     return obj;
@@ -323,11 +328,11 @@ UniValue listaccounts(const JSONRPCRequest& request) {
         isMineOnly = request.params[3].get_bool();
     }
 
-    UniValue ret(UniValue::VARR);
+    RPCResultStream ret(request, UniValue::VARR);
 
-    LOCK(cs_main);
-    CCustomCSView mnview(*pcustomcsview);
-    auto targetHeight = ::ChainActive().Height() + 1;
+    auto snapshot = GetCustomCSSnapshot();
+    CCustomCSView mnview(snapshot->storage);
+    auto targetHeight = snapshot->tip->nHeight + 1;
 
     mnview.ForEachAccount([&](CScript const & account) {
 
@@ -342,7 +347,7 @@ UniValue listaccounts(const JSONRPCRequest& request) {
             if (account != owner) {
                 return false;
             }
-            ret.push_back(accountToJSON(owner, balance, verbose, indexed_amounts));
+            ret.push_back(accountToJSON(mnview, owner, balance, verbose, indexed_amounts));
             return --limit != 0;
         }, {account, start.tokenID});
 
@@ -350,7 +355,7 @@ UniValue listaccounts(const JSONRPCRequest& request) {
         return limit != 0;
     }, start.owner);
 
-    return ret;
+    return ret.get();
 }
 
 UniValue getaccount(const JSONRPCRequest& request) {
@@ -373,12 +378,16 @@ UniValue getaccount(const JSONRPCRequest& request) {
                     },
                     {"indexed_amounts", RPCArg::Type::BOOL, RPCArg::Optional::OMITTED,
                         "Format of amounts output (default = false): (true: obj = {tokenid:amount,...}, false: array = [\"amount@tokenid\"...])"},
+                    {"height", RPCArg::Type::NUM, RPCArg::Optional::OMITTED,
+                        "Return the balances after the block at this height, taken from the account history (requires -acindex)."
+                        " Pool rewards not claimed by then are not included"},
                 },
                 RPCResult{
                        "{...}     (array) Json object with order information\n"
                 },
                 RPCExamples{
                        HelpExampleCli("getaccount", "owner_address")
+                       + HelpExampleCli("getaccount", "owner_address '{}' false 1000")
                 },
     }.Check(request);
 
@@ -420,9 +429,32 @@ UniValue getaccount(const JSONRPCRequest& request) {
         ret.setObject();
     }
 
-    LOCK(cs_main);
-    CCustomCSView mnview(*pcustomcsview);
-    auto targetHeight = ::ChainActive().Height() + 1;
+    auto snapshot = GetCustomCSSnapshot();
+    CCustomCSView mnview(snapshot->storage);
+    auto targetHeight = snapshot->tip->nHeight + 1;
+
+    if (request.params.size() > 3 && !request.params[3].isNull()) {
+        if (!paccountHistoryDB) {
+            throw JSONRPCError(RPC_INVALID_REQUEST, "-acindex is needed for account balances at a height");
+        }
+        const auto height = request.params[3].get_int64();
+        SyncHistoryIndex(HistoryIndexType::Account);
+        {
+            LOCK(cs_main);
+            if (height < 0 || height > ::ChainActive().Height()) {
+                throw JSONRPCError(RPC_INVALID_PARAMETER, "Block height out of range");
+            }
+        }
+
+        const auto balances = paccountHistoryDB->GetBalancesAt(reqOwner, height);
+        for (auto it = balances.balances.lower_bound(start); it != balances.balances.end() && limit != 0; ++it, --limit) {
+            if (indexed_amounts)
+                ret.pushKV(it->first.ToString(), ValueFromAmount(it->second));
+            else
+                ret.push_back(tokenAmountString(mnview, {it->first, it->second}));
+        }
+        return ret;
+    }
 
     mnview.CalculateOwnerRewards(reqOwner, targetHeight);
 
@@ -434,7 +466,7 @@ UniValue getaccount(const JSONRPCRequest& request) {
         if (indexed_amounts)
             ret.pushKV(balance.nTokenId.ToString(), ValueFromAmount(balance.nValue));
         else
-            ret.push_back(tokenAmountString(balance));
+            ret.push_back(tokenAmountString(mnview, balance));
 
         limit--;
         return limit != 0;
@@ -1066,9 +1098,20 @@ UniValue listaccounthistory(const JSONRPCRequest& request) {
     std::set<uint256> txs;
     const bool shouldSearchInWallet = (tokenFilter.empty() || tokenFilter == "DFI") && CustomTxType::None == txType;
 
-    auto hasToken = [&tokenFilter](TAmounts const & diffs) {
+    SyncHistoryIndex(HistoryIndexType::Account);
+    // the snapshot keeps cs_main free while the result is streamed
+    auto snapshot = GetCustomCSSnapshot();
+    CCustomCSView view(snapshot->storage);
+    const auto tipHeight = uint32_t(snapshot->tip->nHeight);
+    CHistoryResult result(request, limit);
+
+    // the history of a single account comes by descending height, as it's output,
+    // unless the wallet's transactions are merged in
+    const bool ordered = !account.empty() && !shouldSearchInWallet;
+
+    auto hasToken = [&](TAmounts const & diffs) {
         for (auto const & diff : diffs) {
-            auto token = pcustomcsview->GetToken(diff.first);
+            auto token = view.GetToken(diff.first);
             auto const tokenIdStr = token->CreateSymbolKey(diff.first);
             if(tokenIdStr == tokenFilter) {
                 return true;
@@ -1077,12 +1120,7 @@ UniValue listaccounthistory(const JSONRPCRequest& request) {
         return false;
     };
 
-    LOCK(cs_main);
-    CCustomCSView view(*pcustomcsview);
-    CCoinsViewCache coins(&::ChainstateActive().CoinsTip());
-    std::map<uint32_t, UniValue, std::greater<uint32_t>> ret;
-
-    maxBlockHeight = std::min(maxBlockHeight, uint32_t(::ChainActive().Height()));
+    maxBlockHeight = std::min(maxBlockHeight, tipHeight);
     depth = std::min(depth, maxBlockHeight);
 
     const auto startBlock = maxBlockHeight - depth;
@@ -1144,8 +1182,7 @@ UniValue listaccounthistory(const JSONRPCRequest& request) {
         }
 
         if (accountRecord && (tokenFilter.empty() || hasToken(value.diff))) {
-            auto& array = ret.emplace(workingHeight, UniValue::VARR).first->second;
-            array.push_back(accounthistoryToJSON(key, value));
+            result.Add(workingHeight, accounthistoryToJSON(key, value));
             if (shouldSearchInWallet) {
                 txs.insert(value.txid);
             }
@@ -1156,8 +1193,7 @@ UniValue listaccounthistory(const JSONRPCRequest& request) {
             onPoolRewards(view, key.owner, workingHeight, lastHeight,
                 [&](int32_t height, DCT_ID poolId, RewardType type, CTokenAmount amount) {
                     if (tokenFilter.empty() || hasToken({{amount.nTokenId, amount.nValue}})) {
-                        auto& array = ret.emplace(height, UniValue::VARR).first->second;
-                        array.push_back(rewardhistoryToJSON(key.owner, height, poolId, type, amount));
+                        result.Add(height, rewardhistoryToJSON(key.owner, height, poolId, type, amount));
                         count ? --count : 0;
                     }
                 }
@@ -1165,6 +1201,9 @@ UniValue listaccounthistory(const JSONRPCRequest& request) {
         }
 
         lastHeight = workingHeight;
+        if (ordered) {
+            result.Flush(workingHeight);
+        }
 
         return count != 0 || isMine;
     };
@@ -1180,6 +1219,9 @@ UniValue listaccounthistory(const JSONRPCRequest& request) {
             if (!isMatchOwner(key.owner)) {
                 return false;
             }
+            if (key.blockHeight > tipHeight) {
+                return true; // not in the snapshot yet
+            }
             CScopeAccountReverter(view, key.owner, value.diff);
             return true;
         }, {account, std::numeric_limits<uint32_t>::max(), std::numeric_limits<uint32_t>::max()});
@@ -1200,23 +1242,13 @@ UniValue listaccounthistory(const JSONRPCRequest& request) {
                 if (txn != std::numeric_limits<uint32_t>::max() && height == maxBlockHeight && nIndex > txn ) {
                     return true;
                 }
-                auto& array = ret.emplace(index->nHeight, UniValue::VARR).first->second;
-                array.push_back(outputEntryToJSON(entry, index, pwtx));
+                result.Add(index->nHeight, outputEntryToJSON(entry, index, pwtx));
                 return --count != 0;
             }
         );
     }
 
-    UniValue slice(UniValue::VARR);
-    for (auto it = ret.cbegin(); limit != 0 && it != ret.cend(); ++it) {
-        const auto& array = it->second.get_array();
-        for (size_t i = 0; limit != 0 && i < array.size(); ++i) {
-            slice.push_back(array[i]);
-            --limit;
-        }
-    }
-
-    return slice;
+    return result.get();
 }
 
 UniValue getaccounthistory(const JSONRPCRequest& request) {
@@ -1248,6 +1280,7 @@ UniValue getaccounthistory(const JSONRPCRequest& request) {
     uint32_t blockHeight = request.params[1].get_int();
     uint32_t txn = request.params[2].get_int();
 
+    SyncHistoryIndex(HistoryIndexType::Account);
     LOCK(cs_main);
 
     UniValue result(UniValue::VOBJ);
@@ -1345,9 +1378,15 @@ UniValue listburnhistory(const JSONRPCRequest& request) {
 
     std::set<uint256> txs;
 
-    auto hasToken = [&tokenFilter](TAmounts const & diffs) {
+    SyncHistoryIndex(HistoryIndexType::Burn);
+    auto snapshot = GetCustomCSSnapshot();
+    CCustomCSView view(snapshot->storage);
+    // burns of different owners are merged by height, so they're streamed once all are found
+    CHistoryResult result(request, limit);
+
+    auto hasToken = [&](TAmounts const & diffs) {
         for (auto const & diff : diffs) {
-            auto token = pcustomcsview->GetToken(diff.first);
+            auto token = view.GetToken(diff.first);
             auto const tokenIdStr = token->CreateSymbolKey(diff.first);
             if(tokenIdStr == tokenFilter) {
                 return true;
@@ -1356,12 +1395,7 @@ UniValue listburnhistory(const JSONRPCRequest& request) {
         return false;
     };
 
-    LOCK(cs_main);
-    CCustomCSView view(*pcustomcsview);
-    CCoinsViewCache coins(&::ChainstateActive().CoinsTip());
-    std::map<uint32_t, UniValue, std::greater<uint32_t>> ret;
-
-    maxBlockHeight = std::min(maxBlockHeight, uint32_t(::ChainActive().Height()));
+    maxBlockHeight = std::min(maxBlockHeight, uint32_t(snapshot->tip->nHeight));
     depth = std::min(depth, maxBlockHeight);
 
     const auto startBlock = maxBlockHeight - depth;
@@ -1391,8 +1425,7 @@ UniValue listburnhistory(const JSONRPCRequest& request) {
             return true;
         }
 
-        auto& array = ret.emplace(key.blockHeight, UniValue::VARR).first->second;
-        array.push_back(accounthistoryToJSON(key, value));
+        result.Add(key.blockHeight, accounthistoryToJSON(key, value));
 
         --count;
 
@@ -1402,16 +1435,7 @@ UniValue listburnhistory(const JSONRPCRequest& request) {
     AccountHistoryKey startKey{{}, maxBlockHeight, std::numeric_limits<uint32_t>::max()};
     pburnHistoryDB->ForEachAccountHistory(shouldContinueToNextAccountHistory, startKey);
 
-    UniValue slice(UniValue::VARR);
-    for (auto it = ret.cbegin(); limit != 0 && it != ret.cend(); ++it) {
-        const auto& array = it->second.get_array();
-        for (size_t i = 0; limit != 0 && i < array.size(); ++i) {
-            slice.push_back(array[i]);
-            --limit;
-        }
-    }
-
-    return slice;
+    return result.get();
 }
 
 UniValue accounthistorycount(const JSONRPCRequest& request) {
@@ -1504,6 +1528,7 @@ UniValue accounthistorycount(const JSONRPCRequest& request) {
         return false;
     };
 
+    SyncHistoryIndex(HistoryIndexType::Account);
     LOCK(cs_main);
     CCustomCSView view(*pcustomcsview);
     CCoinsViewCache coins(&::ChainstateActive().CoinsTip());
@@ -1840,6 +1865,8 @@ UniValue getburninfo(const JSONRPCRequest& request) {
         return true;
     };
 
+    SyncHistoryIndex(HistoryIndexType::Burn);
+
     AccountHistoryKey startKey{{}, std::numeric_limits<uint32_t>::max(), std::numeric_limits<uint32_t>::max()};
     pburnHistoryDB->ForEachAccountHistory(calcBurn, startKey);
 
@@ -2342,7 +2369,7 @@ static const CRPCCommand commands[] =
 //  category        name                     actor (function)        params
 //  -------------   ------------------------ ----------------------  ----------
     {"accounts",    "listaccounts",          &listaccounts,          {"pagination", "verbose", "indexed_amounts", "is_mine_only"}},
-    {"accounts",    "getaccount",            &getaccount,            {"owner", "pagination", "indexed_amounts"}},
+    {"accounts",    "getaccount",            &getaccount,            {"owner", "pagination", "indexed_amounts", "height"}},
     {"accounts",    "gettokenbalances",      &gettokenbalances,      {"pagination", "indexed_amounts", "symbol_lookup"}},
     {"accounts",    "utxostoaccount",        &utxostoaccount,        {"amounts", "inputs"}},
     {"accounts",    "sendutxosfrom",         &sendutxosfrom,         {"from", "to", "amount", "change"}},
@@ -1121,7 +1121,8 @@ UniValue icxgetorder(const JSONRPCRequest& request) {
 
 UniValue icxlistorders(const JSONRPCRequest& request) {
     RPCHelpMan{"icx_listorders",
-                "\nEXPERIMENTAL warning: ICX and Atomic Swap are experimental features. You might end up losing your funds. USE IT AT YOUR OWN RISK.\n\nReturn information about orders.\n",
+                "\nEXPERIMENTAL warning: ICX and Atomic Swap are experimental features. You might end up losing your funds. USE IT AT YOUR OWN RISK.\n\nReturn information about orders.\n"
+                "Open orders of a token and chain are listed by order type, the lowest price first.\n",
                 {
                         {"by", RPCArg::Type::OBJ, RPCArg::Optional::OMITTED, "",
                             {
@@ -1199,7 +1200,12 @@ UniValue icxlistorders(const JSONRPCRequest& request) {
         if (closed)
             pcustomcsview->ForEachICXOrderClose(orderkeylambda, prefix);
         else
-            pcustomcsview->ForEachICXOrderOpen(orderkeylambda, prefix);
+        {
+            // open orders of each direction best price first
+            pcustomcsview->ForEachICXOrderBook([&](CICXOrderBookKey const & key, uint8_t status) {
+                return orderkeylambda({key.idToken, key.creationTx}, status);
+            }, prefix);
+        }
 
         return ret;
     }
@@ -4,6 +4,9 @@
 
 #include <masternodes/mn_rpc.h>
 
+#include <index/historyindex.h>
+#include <masternodes/oraclehistory.h>
+
 extern CTokenCurrencyPair DecodePriceFeedUni(const UniValue& value);
 extern CTokenCurrencyPair DecodePriceFeedString(const std::string& value);
 /// names of oracle json fields
@@ -1124,6 +1127,225 @@ UniValue listfixedintervalprices(const JSONRPCRequest& request) {
     return listPrice;
 }
 
+namespace {
+    struct PriceHistoryRange {
+        uint32_t maxBlockHeight = std::numeric_limits<uint32_t>::max();
+        uint32_t depth = std::numeric_limits<uint32_t>::max();
+        uint32_t limit = 100;
+        COracleId oracleId;
+    };
+
+    PriceHistoryRange DecodePriceHistoryRange(const UniValue& optionsObj, bool oracleFilter) {
+        PriceHistoryRange range;
+        std::map<std::string, UniValueType> types{
+            {"maxBlockHeight", UniValueType(UniValue::VNUM)},
+            {"depth", UniValueType(UniValue::VNUM)},
+            {"limit", UniValueType(UniValue::VNUM)},
+        };
+        if (oracleFilter) {
+            types.emplace(oraclefields::OracleId, UniValueType(UniValue::VSTR));
+        }
+        RPCTypeCheckObj(optionsObj, types, true, true);
+
+        if (!optionsObj["maxBlockHeight"].isNull()) {
+            range.maxBlockHeight = (uint32_t) optionsObj["maxBlockHeight"].get_int64();
+        }
+        if (!optionsObj["depth"].isNull()) {
+            range.depth = (uint32_t) optionsObj["depth"].get_int64();
+        }
+        if (!optionsObj["limit"].isNull()) {
+            range.limit = (uint32_t) optionsObj["limit"].get_int64();
+        }
+        if (range.limit == 0) {
+            range.limit = std::numeric_limits<decltype(range.limit)>::max();
+        }
+        if (oracleFilter && !optionsObj[oraclefields::OracleId].isNull()) {
+            range.oracleId = ParseHashV(optionsObj[oraclefields::OracleId], oraclefields::OracleId);
+        }
+        return range;
+    }
+
+    UniValue FixedIntervalPriceHistoryToJSON(FixedIntervalPriceHistoryKey const & key, CFixedIntervalPrice const & price) {
+        UniValue obj{UniValue::VOBJ};
+        obj.pushKV("priceFeedId", key.token + "/" + key.currency);
+        obj.pushKV("blockHeight", (uint64_t) key.blockHeight);
+        obj.pushKV("activePrice", ValueFromAmount(price.priceRecord[0]));
+        obj.pushKV("nextPrice", ValueFromAmount(price.priceRecord[1]));
+        obj.pushKV("timestamp", price.timestamp);
+        return obj;
+    }
+}
+
+UniValue getfixedintervalpriceat(const JSONRPCRequest& request) {
+    RPCHelpMan{"getfixedintervalpriceat",
+                "Get the fixed interval price of a given pair as it was at a block height.\n"
+                "Requires -oracleindex.\n",
+                {
+                    {"fixedIntervalPriceId", RPCArg::Type::STR_HEX, RPCArg::Optional::NO, "token/currency pair to use for price of token"},
+                    {"height", RPCArg::Type::NUM, RPCArg::Optional::NO, "Block height"},
+                },
+                RPCResult{
+                       "\"json\"          (string) json-object having following fields:\n"
+                       "                  `activePrice` - price used for loan calculations at the height\n"
+                       "                  `nextPrice` - next price to be assigned to pair.\n"
+                       "                  `blockHeight` - height of the block that set the prices.\n"
+                       "                  `timestamp` - timestamp of active price.\n"
+                },
+                RPCExamples{
+                        HelpExampleCli("getfixedintervalpriceat", "TSLA/USD 1000")
+                },
+    }.Check(request);
+
+    if (!poracleHistoryDB) {
+        throw JSONRPCError(RPC_INVALID_REQUEST, "-oracleindex is needed for price history");
+    }
+
+    UniValue objPrice{UniValue::VOBJ};
+    objPrice.pushKV("fixedIntervalPriceId", request.params[0].getValStr());
+    auto pairId = DecodePriceFeedUni(objPrice);
+    auto height = request.params[1].get_int64();
+    if (height < 0) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Block height out of range");
+    }
+
+    SyncHistoryIndex(HistoryIndexType::Oracle);
+    LOCK(cs_main);
+    if (height > ::ChainActive().Height()) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Block height out of range");
+    }
+
+    std::optional<UniValue> result;
+    poracleHistoryDB->ForEachFixedIntervalPrice([&](FixedIntervalPriceHistoryKey const & key, CLazySerialize<CFixedIntervalPrice> valueLazy) {
+        if (key.token == pairId.first && key.currency == pairId.second) {
+            result = FixedIntervalPriceHistoryToJSON(key, valueLazy.get());
+        }
+        return false;
+    }, {pairId.first, pairId.second, uint32_t(height)});
+
+    if (!result) {
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, strprintf("No fixed interval price for %s/%s at height %d", pairId.first, pairId.second, height));
+    }
+    return *result;
+}
+
+UniValue listfixedintervalpricehistory(const JSONRPCRequest& request) {
+    RPCHelpMan{"listfixedintervalpricehistory",
+                "Get the fixed interval prices of a given pair set by each block, newest first.\n"
+                "Requires -oracleindex.\n",
+                {
+                    {"fixedIntervalPriceId", RPCArg::Type::STR_HEX, RPCArg::Optional::NO, "token/currency pair to use for price of token"},
+                    {"options", RPCArg::Type::OBJ, RPCArg::Optional::OMITTED, "",
+                        {
+                            {"maxBlockHeight", RPCArg::Type::NUM, RPCArg::Optional::OMITTED,
+                             "Optional height to iterate from (downto genesis block), (default = chaintip)."},
+                            {"depth", RPCArg::Type::NUM, RPCArg::Optional::OMITTED,
+                             "Maximum depth, from the genesis block is the default"},
+                            {"limit", RPCArg::Type::NUM, RPCArg::Optional::OMITTED,
+                             "Maximum number of records to return, 100 by default"},
+                        },
+                    },
+                },
+                RPCResult{
+                       "[{},{}...]     (array) Objects with the prices and the height of the block that set them\n"
+                },
+                RPCExamples{
+                        HelpExampleCli("listfixedintervalpricehistory", "TSLA/USD '{\"maxBlockHeight\":1000,\"depth\":100}'")
+                },
+    }.Check(request);
+
+    if (!poracleHistoryDB) {
+        throw JSONRPCError(RPC_INVALID_REQUEST, "-oracleindex is needed for price history");
+    }
+
+    UniValue objPrice{UniValue::VOBJ};
+    objPrice.pushKV("fixedIntervalPriceId", request.params[0].getValStr());
+    auto pairId = DecodePriceFeedUni(objPrice);
+    auto range = DecodePriceHistoryRange(request.params.size() > 1 ? request.params[1].get_obj() : UniValue(UniValue::VOBJ), false);
+
+    SyncHistoryIndex(HistoryIndexType::Oracle);
+    LOCK(cs_main);
+    range.maxBlockHeight = std::min(range.maxBlockHeight, uint32_t(::ChainActive().Height()));
+    const auto startBlock = range.maxBlockHeight - std::min(range.depth, range.maxBlockHeight);
+
+    UniValue ret{UniValue::VARR};
+    poracleHistoryDB->ForEachFixedIntervalPrice([&](FixedIntervalPriceHistoryKey const & key, CLazySerialize<CFixedIntervalPrice> valueLazy) {
+        if (key.token != pairId.first || key.currency != pairId.second || key.blockHeight < startBlock) {
+            return false;
+        }
+        ret.push_back(FixedIntervalPriceHistoryToJSON(key, valueLazy.get()));
+        return --range.limit != 0;
+    }, {pairId.first, pairId.second, range.maxBlockHeight});
+
+    return ret;
+}
+
+UniValue listoraclepricehistory(const JSONRPCRequest& request) {
+    RPCHelpMan{"listoraclepricehistory",
+                "Get the prices of a given pair submitted by oracles, newest first.\n"
+                "Requires -oracleindex.\n",
+                {
+                    {"fixedIntervalPriceId", RPCArg::Type::STR_HEX, RPCArg::Optional::NO, "token/currency pair"},
+                    {"options", RPCArg::Type::OBJ, RPCArg::Optional::OMITTED, "",
+                        {
+                            {"oracleid", RPCArg::Type::STR_HEX, RPCArg::Optional::OMITTED,
+                             "Filter by oracle"},
+                            {"maxBlockHeight", RPCArg::Type::NUM, RPCArg::Optional::OMITTED,
+                             "Optional height to iterate from (downto genesis block), (default = chaintip)."},
+                            {"depth", RPCArg::Type::NUM, RPCArg::Optional::OMITTED,
+                             "Maximum depth, from the genesis block is the default"},
+                            {"limit", RPCArg::Type::NUM, RPCArg::Optional::OMITTED,
+                             "Maximum number of records to return, 100 by default"},
+                        },
+                    },
+                },
+                RPCResult{
+                       "[{},{}...]     (array) Objects with the submitted prices\n"
+                },
+                RPCExamples{
+                        HelpExampleCli("listoraclepricehistory", "TSLA/USD '{\"maxBlockHeight\":1000,\"depth\":100}'")
+                },
+    }.Check(request);
+
+    if (!poracleHistoryDB) {
+        throw JSONRPCError(RPC_INVALID_REQUEST, "-oracleindex is needed for price history");
+    }
+
+    UniValue objPrice{UniValue::VOBJ};
+    objPrice.pushKV("fixedIntervalPriceId", request.params[0].getValStr());
+    auto pairId = DecodePriceFeedUni(objPrice);
+    auto range = DecodePriceHistoryRange(request.params.size() > 1 ? request.params[1].get_obj() : UniValue(UniValue::VOBJ), true);
+
+    SyncHistoryIndex(HistoryIndexType::Oracle);
+    LOCK(cs_main);
+    range.maxBlockHeight = std::min(range.maxBlockHeight, uint32_t(::ChainActive().Height()));
+    const auto startBlock = range.maxBlockHeight - std::min(range.depth, range.maxBlockHeight);
+
+    UniValue ret{UniValue::VARR};
+    OraclePriceHistoryKey startKey{pairId.first, pairId.second, range.maxBlockHeight, std::numeric_limits<uint32_t>::max(), {}};
+    poracleHistoryDB->ForEachOraclePrice([&](OraclePriceHistoryKey const & key, CLazySerialize<OraclePriceHistoryValue> valueLazy) {
+        if (key.token != pairId.first || key.currency != pairId.second || key.blockHeight < startBlock) {
+            return false;
+        }
+        if (!range.oracleId.IsNull() && key.oracleId != range.oracleId) {
+            return true;
+        }
+        const auto& value = valueLazy.get();
+        UniValue obj{UniValue::VOBJ};
+        obj.pushKV(oraclefields::OracleId, key.oracleId.GetHex());
+        obj.pushKV(oraclefields::Token, key.token);
+        obj.pushKV(oraclefields::Currency, key.currency);
+        obj.pushKV("blockHeight", (uint64_t) key.blockHeight);
+        obj.pushKV("txn", (uint64_t) key.txn);
+        obj.pushKV("txid", value.txid.GetHex());
+        obj.pushKV(oraclefields::Timestamp, value.timestamp);
+        obj.pushKV(oraclefields::RawPrice, ValueFromAmount(value.price));
+        ret.push_back(obj);
+        return --range.limit != 0;
+    }, startKey);
+
+    return ret;
+}
+
 UniValue getfutureswapblock(const JSONRPCRequest& request) {
     RPCHelpMan{"getfutureswapblock",
                "Get the next block that futures will execute and update on.\n",
@@ -1165,6 +1387,9 @@ static const CRPCCommand commands[] =
     {"oracles",     "listprices",              &listprices,               {"pagination"}},
     {"oracles",     "getfixedintervalprice",   &getfixedintervalprice,    {"fixedIntervalPriceId"}},
     {"oracles",     "listfixedintervalprices", &listfixedintervalprices,  {"pagination"}},
+    {"oracles",     "getfixedintervalpriceat", &getfixedintervalpriceat,  {"fixedIntervalPriceId", "height"}},
+    {"oracles",     "listfixedintervalpricehistory", &listfixedintervalpricehistory, {"fixedIntervalPriceId", "options"}},
+    {"oracles",     "listoraclepricehistory",  &listoraclepricehistory,   {"fixedIntervalPriceId", "options"}},
     {"oracles",     "getfutureswapblock",         &getfutureswapblock,          {}},
 };
 
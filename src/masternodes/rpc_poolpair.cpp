@@ -1,6 +1,9 @@
 #include <masternodes/mn_rpc.h>
 
-UniValue poolToJSON(DCT_ID const& id, CPoolPair const& pool, CToken const& token, bool verbose) {
+#include <index/historyindex.h>
+#include <masternodes/poolhistory.h>
+
+UniValue poolToJSON(CCustomCSView& view, DCT_ID const& id, CPoolPair const& pool, CToken const& token, bool verbose) {
     UniValue poolObj(UniValue::VOBJ);
     poolObj.pushKV("symbol", token.symbol);
     poolObj.pushKV("name", token.name);
@@ -9,18 +12,18 @@ UniValue poolToJSON(DCT_ID const& id, CPoolPair const& pool, CToken const& token
     poolObj.pushKV("idTokenB", pool.idTokenB.ToString());
 
     if (verbose) {
-        if (const auto dexFee = pcustomcsview->GetDexFeeInPct(id, pool.idTokenA)) {
+        if (const auto dexFee = view.GetDexFeeInPct(id, pool.idTokenA)) {
             poolObj.pushKV("dexFeePctTokenA", ValueFromAmount(dexFee));
             poolObj.pushKV("dexFeeInPctTokenA", ValueFromAmount(dexFee));
         }
-        if (const auto dexFee = pcustomcsview->GetDexFeeOutPct(id, pool.idTokenB)) {
+        if (const auto dexFee = view.GetDexFeeOutPct(id, pool.idTokenB)) {
             poolObj.pushKV("dexFeePctTokenB", ValueFromAmount(dexFee));
             poolObj.pushKV("dexFeeOutPctTokenB", ValueFromAmount(dexFee));
         }
-        if (const auto dexFee = pcustomcsview->GetDexFeeInPct(id, pool.idTokenB)) {
+        if (const auto dexFee = view.GetDexFeeInPct(id, pool.idTokenB)) {
             poolObj.pushKV("dexFeeInPctTokenB", ValueFromAmount(dexFee));
         }
-        if (const auto dexFee = pcustomcsview->GetDexFeeOutPct(id, pool.idTokenA)) {
+        if (const auto dexFee = view.GetDexFeeOutPct(id, pool.idTokenA)) {
             poolObj.pushKV("dexFeeOutPctTokenA", ValueFromAmount(dexFee));
         }
         poolObj.pushKV("reserveA", ValueFromAmount(pool.reserveA));
@@ -55,7 +58,7 @@ UniValue poolToJSON(DCT_ID const& id, CPoolPair const& pool, CToken const& token
                 ++next_it;
 
                 // Get token balance
-                const auto balance = pcustomcsview->GetBalance(pool.ownerAddress, it->first).nValue;
+                const auto balance = view.GetBalance(pool.ownerAddress, it->first).nValue;
 
                 // Make there's enough to pay reward otherwise remove it
                 if (balance < it->second) {
@@ -210,13 +213,14 @@ UniValue listpoolpairs(const JSONRPCRequest& request) {
         }
     }
 
-    LOCK(cs_main);
+    auto snapshot = GetCustomCSSnapshot();
+    CCustomCSView view(snapshot->storage);
 
     UniValue ret(UniValue::VOBJ);
-    pcustomcsview->ForEachPoolPair([&](DCT_ID const & id, CPoolPair pool) {
-        const auto token = pcustomcsview->GetToken(id);
+    view.ForEachPoolPair([&](DCT_ID const & id, CPoolPair pool) {
+        const auto token = view.GetToken(id);
         if (token) {
-            ret.pushKVs(poolToJSON(id, pool, *token, verbose));
+            ret.pushKVs(poolToJSON(view, id, pool, *token, verbose));
             limit--;
         }
 
@@ -249,14 +253,15 @@ UniValue getpoolpair(const JSONRPCRequest& request) {
         verbose = request.params[1].getBool();
     }
 
-    LOCK(cs_main);
+    auto snapshot = GetCustomCSSnapshot();
+    CCustomCSView view(snapshot->storage);
 
     DCT_ID id;
-    auto token = pcustomcsview->GetTokenGuessId(request.params[0].getValStr(), id);
+    auto token = view.GetTokenGuessId(request.params[0].getValStr(), id);
     if (token) {
-        auto pool = pcustomcsview->GetPoolPair(id);
+        auto pool = view.GetPoolPair(id);
         if (pool) {
-            return poolToJSON(id, *pool, *token, verbose);
+            return poolToJSON(view, id, *pool, *token, verbose);
         }
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Pool not found");
     }
@@ -1219,17 +1224,18 @@ UniValue listpoolshares(const JSONRPCRequest& request) {
         }
     }
 
-    LOCK(cs_main);
+    auto snapshot = GetCustomCSSnapshot();
+    CCustomCSView view(snapshot->storage);
 
     PoolShareKey startKey{ start, CScript{} };
 //    startKey.poolID = start;
 //    startKey.owner = CScript(0);
 
-    UniValue ret(UniValue::VOBJ);
-    pcustomcsview->ForEachPoolShare([&](DCT_ID const & poolId, CScript const & provider, uint32_t) {
-        const CTokenAmount tokenAmount = pcustomcsview->GetBalance(provider, poolId);
+    RPCResultStream ret(request, UniValue::VOBJ);
+    view.ForEachPoolShare([&](DCT_ID const & poolId, CScript const & provider, uint32_t) {
+        const CTokenAmount tokenAmount = view.GetBalance(provider, poolId);
         if(tokenAmount.nValue) {
-            const auto poolPair = pcustomcsview->GetPoolPair(poolId);
+            const auto poolPair = view.GetPoolPair(poolId);
             if(poolPair) {
                 if (isMineOnly) {
                     if (IsMineCached(*pwallet, provider) == ISMINE_SPENDABLE) {
@@ -1246,6 +1252,186 @@ UniValue listpoolshares(const JSONRPCRequest& request) {
         return limit != 0;
     }, startKey);
 
+    return ret.get();
+}
+
+UniValue getpoolcandles(const JSONRPCRequest& request) {
+    RPCHelpMan{"getpoolcandles",
+               "\nReturns open, high, low and close prices, volume and fees of a pool over intervals of block time.\n"
+               "Prices are of token A in token B. Blocks not changing the pool's reserves are not accounted.\n"
+               "Block times are not strictly ordered, a block timed before the interval of the block preceding it\n"
+               "is accounted in that interval, so intervals are returned once and in order.\n"
+               "Requires -poolindex.\n",
+               {
+                       {"key", RPCArg::Type::STR, RPCArg::Optional::NO,
+                        "One of the keys may be specified (id/symbol/creationTx)"},
+                       {"options", RPCArg::Type::OBJ, RPCArg::Optional::OMITTED, "",
+                        {
+                                {"interval", RPCArg::Type::NUM, RPCArg::Optional::OMITTED,
+                                 "Interval length in seconds, 3600 by default"},
+                                {"startHeight", RPCArg::Type::NUM, RPCArg::Optional::OMITTED,
+                                 "First block height, genesis block by default"},
+                                {"endHeight", RPCArg::Type::NUM, RPCArg::Optional::OMITTED,
+                                 "Last block height, chain tip by default"},
+                                {"startTime", RPCArg::Type::NUM, RPCArg::Optional::OMITTED,
+                                 "Blocks before this time are skipped"},
+                                {"endTime", RPCArg::Type::NUM, RPCArg::Optional::OMITTED,
+                                 "Blocks after this time are skipped"},
+                                {"limit", RPCArg::Type::NUM, RPCArg::Optional::OMITTED,
+                                 "Maximum number of intervals to return, 100 by default, 0 for no limit"},
+                        },
+                       },
+               },
+               RPCResult{
+                       "[{},{}...]     (array) Objects with interval information, oldest first\n"
+               },
+               RPCExamples{
+                       HelpExampleCli("getpoolcandles", "GOLD-DFI '{\"interval\":86400,\"startHeight\":1000}'")
+                       + HelpExampleRpc("getpoolcandles", "\"GOLD-DFI\", {\"interval\":86400}")
+               },
+    }.Check(request);
+
+    if (!ppoolHistoryDB) {
+        throw JSONRPCError(RPC_INVALID_REQUEST, "-poolindex is needed for pool history");
+    }
+
+    int64_t interval = 3600;
+    uint32_t startHeight = 0;
+    uint32_t endHeight = std::numeric_limits<uint32_t>::max();
+    std::optional<int64_t> startTime, endTime;
+    uint32_t limit = 100;
+
+    if (request.params.size() > 1) {
+        UniValue optionsObj = request.params[1].get_obj();
+        RPCTypeCheckObj(optionsObj,
+            {
+                {"interval", UniValueType(UniValue::VNUM)},
+                {"startHeight", UniValueType(UniValue::VNUM)},
+                {"endHeight", UniValueType(UniValue::VNUM)},
+                {"startTime", UniValueType(UniValue::VNUM)},
+                {"endTime", UniValueType(UniValue::VNUM)},
+                {"limit", UniValueType(UniValue::VNUM)},
+            }, true, true);
+
+        if (!optionsObj["interval"].isNull()) {
+            interval = optionsObj["interval"].get_int64();
+            if (interval <= 0) {
+                throw JSONRPCError(RPC_INVALID_PARAMETER, "interval should be positive");
+            }
+        }
+        if (!optionsObj["startHeight"].isNull()) {
+            startHeight = (uint32_t) optionsObj["startHeight"].get_int64();
+        }
+        if (!optionsObj["endHeight"].isNull()) {
+            endHeight = (uint32_t) optionsObj["endHeight"].get_int64();
+        }
+        if (!optionsObj["startTime"].isNull()) {
+            startTime = optionsObj["startTime"].get_int64();
+        }
+        if (!optionsObj["endTime"].isNull()) {
+            endTime = optionsObj["endTime"].get_int64();
+        }
+        if (!optionsObj["limit"].isNull()) {
+            limit = (uint32_t) optionsObj["limit"].get_int64();
+        }
+    }
+    if (limit == 0) {
+        limit = std::numeric_limits<decltype(limit)>::max();
+    }
+
+    DCT_ID id;
+    {
+        auto snapshot = GetCustomCSSnapshot();
+        CCustomCSView view(snapshot->storage);
+        if (!view.GetTokenGuessId(request.params[0].getValStr(), id) || !view.GetPoolPair(id)) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Pool not found");
+        }
+    }
+
+    SyncHistoryIndex(HistoryIndexType::Pool);
+    LOCK(cs_main);
+
+    endHeight = std::min(endHeight, uint32_t(::ChainActive().Height()));
+    if (startTime) {
+        // block times are only roughly ordered, the first block at the time bounds the search
+        const auto pindex = ::ChainActive().FindEarliestAtLeast(*startTime, startHeight);
+        if (!pindex) {
+            return UniValue(UniValue::VARR);
+        }
+        startHeight = std::max(startHeight, uint32_t(pindex->nHeight));
+    }
+
+    UniValue ret(UniValue::VARR);
+    std::optional<PoolHistoryValue> candle;
+    int64_t candleTime{0};
+    uint32_t firstHeight{0}, lastHeight{0}, blocks{0};
+
+    auto pushCandle = [&]() {
+        UniValue obj(UniValue::VOBJ);
+        obj.pushKV("time", candleTime);
+        obj.pushKV("startHeight", uint64_t(firstHeight));
+        obj.pushKV("endHeight", uint64_t(lastHeight));
+        obj.pushKV("blocks", uint64_t(blocks));
+        obj.pushKV("open", ValueFromAmount(candle->openPrice));
+        obj.pushKV("high", ValueFromAmount(candle->highPrice));
+        obj.pushKV("low", ValueFromAmount(candle->lowPrice));
+        obj.pushKV("close", ValueFromAmount(PoolReservePrice(candle->reserveA, candle->reserveB)));
+        obj.pushKV("reserveA", ValueFromAmount(candle->reserveA));
+        obj.pushKV("reserveB", ValueFromAmount(candle->reserveB));
+        obj.pushKV("volumeA", ValueFromAmount(candle->volumeA));
+        obj.pushKV("volumeB", ValueFromAmount(candle->volumeB));
+        obj.pushKV("commissionA", ValueFromAmount(candle->commissionA));
+        obj.pushKV("commissionB", ValueFromAmount(candle->commissionB));
+        obj.pushKV("swaps", uint64_t(candle->swaps));
+        ret.push_back(obj);
+    };
+
+    ppoolHistoryDB->ForEachPoolHistory([&](PoolHistoryKey const & key, CLazySerialize<PoolHistoryValue> valueLazy) {
+        if (key.poolID != id || key.height > endHeight) {
+            return false;
+        }
+
+        const auto& value = valueLazy.get();
+        if ((startTime && value.time < *startTime) || (endTime && value.time > *endTime)) {
+            return true;
+        }
+
+        // a block timed before the current interval goes into it, intervals never repeat
+        const auto time = value.time - value.time % interval;
+        if (candle && time > candleTime) {
+            pushCandle();
+            candle.reset();
+            if (ret.size() >= limit) {
+                return false;
+            }
+        }
+
+        if (!candle) {
+            candle = value;
+            candleTime = time;
+            firstHeight = key.height;
+            blocks = 0;
+        } else {
+            candle->highPrice = std::max(candle->highPrice, value.highPrice);
+            candle->lowPrice = std::min(candle->lowPrice, value.lowPrice);
+            candle->reserveA = value.reserveA;
+            candle->reserveB = value.reserveB;
+            candle->volumeA += value.volumeA;
+            candle->volumeB += value.volumeB;
+            candle->commissionA += value.commissionA;
+            candle->commissionB += value.commissionB;
+            candle->swaps += value.swaps;
+        }
+        lastHeight = key.height;
+        ++blocks;
+
+        return true;
+    }, PoolHistoryKey{id, startHeight});
+
+    if (candle && ret.size() < limit) {
+        pushCandle();
+    }
+
     return ret;
 }
 
@@ -1263,6 +1449,7 @@ static const CRPCCommand commands[] =
     {"poolpair",    "compositeswap",            &compositeswap,             {"metadata", "inputs"}},
     {"poolpair",    "listpoolshares",           &listpoolshares,            {"pagination", "verbose", "is_mine_only"}},
     {"poolpair",    "testpoolswap",             &testpoolswap,              {"metadata", "path", "verbose"}},
+    {"poolpair",    "getpoolcandles",           &getpoolcandles,            {"key", "options"}},
 };
 
 void RegisterPoolpairRPCCommands(CRPCTable& tableRPC) {
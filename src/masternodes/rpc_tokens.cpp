@@ -2,6 +2,7 @@
 
 #include <masternodes/govvariables/attributes.h>
 
+#include <index/customtxindex.h>
 #include <index/txindex.h>
 
 UniValue createtoken(const JSONRPCRequest& request) {
@@ -519,6 +520,17 @@ UniValue getcustomtx(const JSONRPCRequest& request)
             }
         }
 
+        // The custom tx index knows the block of a custom tx, which saves the full txindex
+        CCustomTxIndexEntry entry;
+        if (!blockindex && g_customtxindex && g_customtxindex->BlockUntilSyncedToCurrentChain()
+        && g_customtxindex->FindCustomTx(hash, entry)) {
+            LOCK(cs_main);
+            auto pindex = ::ChainActive()[entry.height];
+            if (pindex && pindex->GetBlockHash() == entry.blockHash) {
+                blockindex = pindex;
+            }
+        }
+
         bool f_txindex_ready{false};
         if (g_txindex && !blockindex) {
             f_txindex_ready = g_txindex->BlockUntilSyncedToCurrentChain();
@@ -1,3 +1,4 @@
+#include <index/historyindex.h>
 #include <masternodes/accountshistory.h>
 #include <masternodes/auctionhistory.h>
 #include <masternodes/mn_rpc.h>
@@ -434,6 +435,14 @@ UniValue listvaults(const JSONRPCRequest& request) {
                             {
                                 "verbose", RPCArg::Type::BOOL, RPCArg::Optional::OMITTED,
                                 "Flag for verbose list (default = false), otherwise only ids, ownerAddress, loanSchemeIds and state are listed"
+                            },
+                            {
+                                "minRatio", RPCArg::Type::NUM, RPCArg::Optional::OMITTED,
+                                "Minimum collateralization ratio in percent. Vaults are then listed by ratio, lowest first"
+                            },
+                            {
+                                "maxRatio", RPCArg::Type::NUM, RPCArg::Optional::OMITTED,
+                                "Maximum collateralization ratio in percent. Vaults are then listed by ratio, lowest first"
                             }
                         },
                     },
@@ -442,7 +451,7 @@ UniValue listvaults(const JSONRPCRequest& request) {
                         {
                             {
                                 "start", RPCArg::Type::STR_HEX, RPCArg::Optional::OMITTED,
-                                "Optional first key to iterate from, in lexicographical order. "
+                                "Optional first key to iterate from, in lexicographical order or from its ratio when listed by ratio. "
                                 "Typically it's set to last ID from previous request."
                             },
                             {
@@ -466,10 +475,12 @@ UniValue listvaults(const JSONRPCRequest& request) {
                        + HelpExampleCli("listvaults", "'{\"loanSchemeId\": \"LOAN1502\"}'")
                        + HelpExampleCli("listvaults", "'{\"loanSchemeId\": \"LOAN1502\"}' '{\"start\":\"3ef9fd5bd1d0ce94751e6286710051361e8ef8fac43cca9cb22397bf0d17e013\", ""\"including_start\": true, ""\"limit\":100}'")
                        + HelpExampleCli("listvaults", "{} '{\"start\":\"3ef9fd5bd1d0ce94751e6286710051361e8ef8fac43cca9cb22397bf0d17e013\", ""\"including_start\": true, ""\"limit\":100}'")
+                       + HelpExampleCli("listvaults", "'{\"minRatio\": 150, \"maxRatio\": 200}'")
                        + HelpExampleRpc("listvaults", "")
                        + HelpExampleRpc("listvaults", R"({"loanSchemeId": "LOAN1502"})")
                        + HelpExampleRpc("listvaults", R"({"loanSchemeId": "LOAN1502"}, {"start":"3ef9fd5bd1d0ce94751e6286710051361e8ef8fac43cca9cb22397bf0d17e013", "including_start": true, "limit":100})")
                        + HelpExampleRpc("listvaults", R"({}, {"start":"3ef9fd5bd1d0ce94751e6286710051361e8ef8fac43cca9cb22397bf0d17e013", "including_start": true, "limit":100})")
+                       + HelpExampleRpc("listvaults", R"({"minRatio": 150, "maxRatio": 200})")
                },
     }.Check(request);
 
@@ -477,6 +488,8 @@ UniValue listvaults(const JSONRPCRequest& request) {
     std::string loanSchemeId;
     VaultState state{VaultState::Unknown};
     bool verbose{false};
+    bool byRatio{false};
+    uint32_t minRatio{0}, maxRatio{std::numeric_limits<uint32_t>::max()};
     if (request.params.size() > 0) {
         UniValue optionsObj = request.params[0].get_obj();
         if (!optionsObj["ownerAddress"].isNull()) {
@@ -491,6 +504,20 @@ UniValue listvaults(const JSONRPCRequest& request) {
         if (!optionsObj["verbose"].isNull()) {
             verbose = optionsObj["verbose"].getBool();
         }
+        auto parseRatio = [&](const std::string& key) {
+            auto ratio = optionsObj[key].get_int64();
+            if (ratio < 0 || ratio > std::numeric_limits<uint32_t>::max()) {
+                throw JSONRPCError(RPC_INVALID_PARAMETER, key + " out of range");
+            }
+            byRatio = true;
+            return uint32_t(ratio);
+        };
+        if (!optionsObj["minRatio"].isNull()) {
+            minRatio = parseRatio("minRatio");
+        }
+        if (!optionsObj["maxRatio"].isNull()) {
+            maxRatio = parseRatio("maxRatio");
+        }
     }
 
     // parse pagination
@@ -520,7 +547,7 @@ UniValue listvaults(const JSONRPCRequest& request) {
 
     LOCK(cs_main);
 
-    pcustomcsview->ForEachVault([&](const CVaultId& vaultId, const CVaultData& data) {
+    auto pushVault = [&](const CVaultId& vaultId, const CVaultData& data) {
         if (!including_start)
         {
             including_start = true;
@@ -544,7 +571,35 @@ UniValue listvaults(const JSONRPCRequest& request) {
             limit--;
         }
         return limit != 0;
-    }, start, ownerAddress);
+    };
+
+    if (!byRatio) {
+        pcustomcsview->ForEachVault(pushVault, start, ownerAddress, loanSchemeId);
+        return valueArr;
+    }
+
+    // Served from the ratio index, which only holds vaults that had their ratio
+    // calculated with valid prices and are not under liquidation.
+    auto startRatio = minRatio;
+    if (!start.IsNull()) {
+        auto ratio = pcustomcsview->GetVaultRatio(start);
+        if (!ratio) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "start vault has no collateralization ratio");
+        }
+        startRatio = std::max(minRatio, *ratio);
+        if (*ratio < minRatio) {
+            including_start = true;
+            start = {};
+        }
+    }
+
+    pcustomcsview->ForEachVaultRatio([&](const CVaultId& vaultId, uint32_t ratio) {
+        if (ratio > maxRatio) {
+            return false;
+        }
+        auto data = pcustomcsview->GetVault(vaultId);
+        return !data || pushVault(vaultId, *data);
+    }, startRatio, start);
 
     return valueArr;
 }
@@ -1190,6 +1245,7 @@ UniValue listauctionhistory(const JSONRPCRequest& request) {
         filter = DecodeScriptTxId(account, {start.owner, start.vaultId});
     }
 
+    SyncHistoryIndex(HistoryIndexType::Account);
     LOCK(cs_main);
     UniValue ret(UniValue::VARR);
 
@@ -1386,9 +1442,15 @@ UniValue listvaulthistory(const JSONRPCRequest& request) {
 
     std::set<uint256> txs;
 
-    auto hasToken = [&tokenFilter](TAmounts const & diffs) {
+    SyncHistoryIndex(HistoryIndexType::Vault);
+    auto snapshot = GetCustomCSSnapshot();
+    CCustomCSView view(snapshot->storage);
+    // vault transactions, states and schemes are merged by height, so they're streamed once all are found
+    CHistoryResult result(request, limit);
+
+    auto hasToken = [&](TAmounts const & diffs) {
         for (auto const & diff : diffs) {
-            auto token = pcustomcsview->GetToken(diff.first);
+            auto token = view.GetToken(diff.first);
             auto const tokenIdStr = token->CreateSymbolKey(diff.first);
             if(tokenIdStr == tokenFilter) {
                 return true;
@@ -1397,10 +1459,7 @@ UniValue listvaulthistory(const JSONRPCRequest& request) {
         return false;
     };
 
-    LOCK(cs_main);
-    std::map<uint32_t, UniValue, std::greater<uint32_t>> ret;
-
-    maxBlockHeight = std::min(maxBlockHeight, uint32_t(::ChainActive().Height()));
+    maxBlockHeight = std::min(maxBlockHeight, uint32_t(snapshot->tip->nHeight));
     depth = std::min(depth, maxBlockHeight);
 
     const auto startBlock = maxBlockHeight - depth;
@@ -1431,8 +1490,7 @@ UniValue listvaulthistory(const JSONRPCRequest& request) {
             return true;
         }
 
-        auto& array = ret.emplace(key.blockHeight, UniValue::VARR).first->second;
-        array.push_back(historyToJSON(key, value));
+        result.Add(key.blockHeight, historyToJSON(key, value));
 
         return --count != 0;
     };
@@ -1455,8 +1513,7 @@ UniValue listvaulthistory(const JSONRPCRequest& request) {
 
         const auto & value = valueLazy.get();
 
-        auto& array = ret.emplace(key.blockHeight, UniValue::VARR).first->second;
-        array.push_back(stateToJSON(key, value));
+        result.Add(key.blockHeight, stateToJSON(key, value));
 
         return --count != 0;
     };
@@ -1497,8 +1554,7 @@ UniValue listvaulthistory(const JSONRPCRequest& request) {
             return false;
         }, {key.blockHeight, value.txn});
 
-        auto& array = ret.emplace(key.blockHeight, UniValue::VARR).first->second;
-        array.push_back(schemeToJSON(key, {loanScheme, value.category, value.txid}));
+        result.Add(key.blockHeight, schemeToJSON(key, {loanScheme, value.category, value.txid}));
 
         return --count != 0;
     };
@@ -1542,24 +1598,14 @@ UniValue listvaulthistory(const JSONRPCRequest& request) {
                     return true;
                 }
 
-                auto& array = ret.emplace(key.blockHeight, UniValue::VARR).first->second;
-                array.push_back(schemeToJSON({vaultID, key.blockHeight}, value));
+                result.Add(key.blockHeight, schemeToJSON({vaultID, key.blockHeight}, value));
 
                 return --count != 0;
             }, {endHeight, std::numeric_limits<uint32_t>::max(), it->second});
         }
     }
 
-    UniValue slice(UniValue::VARR);
-    for (auto it = ret.cbegin(); limit != 0 && it != ret.cend(); ++it) {
-        const auto& array = it->second.get_array();
-        for (size_t i = 0; limit != 0 && i < array.size(); ++i) {
-            slice.push_back(array[i]);
-            --limit;
-        }
-    }
-
-    return slice;
+    return result.get();
 }
 
 UniValue estimateloan(const JSONRPCRequest& request) {
@@ -60,5 +60,27 @@ struct CUndo {
     }
 };
 
+struct UndoBundleKey {
+    uint32_t height;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(WrapBigEndian(height));
+    }
+};
+
+// The undo of all the custom txs of a block, block level changes ("zero hash") first, then in tx order
+struct CUndoBundle {
+    std::vector<std::pair<uint256, CUndo>> undos;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(undos);
+    }
+};
 
 #endif //DEFI_MASTERNODES_UNDO_H
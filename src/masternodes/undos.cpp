@@ -30,3 +30,61 @@ std::optional<CUndo> CUndosView::GetUndo(UndoKey const & key) const
     }
     return {};
 }
+
+void CUndosView::ForEachUndoBundle(std::function<bool(UndoBundleKey const &, CLazySerialize<CUndoBundle>)> callback, UndoBundleKey const & start)
+{
+    ForEach<ByUndoBundleKey, UndoBundleKey, CUndoBundle>(callback, start);
+}
+
+std::optional<CUndoBundle> CUndosView::GetUndoBundle(uint32_t height) const
+{
+    return ReadBy<ByUndoBundleKey, CUndoBundle>(UndoBundleKey{height});
+}
+
+Res CUndosView::SetUndoBundle(uint32_t height, CUndoBundle const & bundle)
+{
+    WriteBy<ByUndoBundleKey>(UndoBundleKey{height}, bundle);
+    return Res::Ok();
+}
+
+Res CUndosView::DelUndoBundle(uint32_t height)
+{
+    EraseBy<ByUndoBundleKey>(UndoBundleKey{height});
+    return Res::Ok();
+}
+
+size_t CUndosView::EraseUndosAbove(uint32_t height)
+{
+    std::vector<UndoKey> undos;
+    ForEachUndo([&](UndoKey const & key, CLazySerialize<CUndo>) {
+        undos.push_back(key);
+        return true;
+    }, UndoKey{height + 1, {}});
+    std::vector<uint32_t> bundles;
+    ForEachUndoBundle([&](UndoBundleKey const & key, CLazySerialize<CUndoBundle>) {
+        bundles.push_back(key.height);
+        return true;
+    }, UndoBundleKey{height + 1});
+
+    for (const auto& key : undos) {
+        DelUndo(key);
+    }
+    for (const auto& bundleHeight : bundles) {
+        DelUndoBundle(bundleHeight);
+    }
+    return undos.size() + bundles.size();
+}
+
+std::optional<uint32_t> CUndosView::GetUndoCompleteHeight() const
+{
+    uint32_t height;
+    if (Read(UndoCompleteHeight::prefix(), height)) {
+        return height;
+    }
+    return {};
+}
+
+void CUndosView::SetUndoCompleteHeight(uint32_t height)
+{
+    Write(UndoCompleteHeight::prefix(), height);
+}
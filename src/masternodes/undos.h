@@ -17,8 +17,23 @@ public:
     Res SetUndo(UndoKey const & key, CUndo const & undo);
     Res DelUndo(UndoKey const & key);
 
+    void ForEachUndoBundle(std::function<bool(UndoBundleKey const &, CLazySerialize<CUndoBundle>)> callback, UndoBundleKey const & start = {});
+
+    std::optional<CUndoBundle> GetUndoBundle(uint32_t height) const;
+    Res SetUndoBundle(uint32_t height, CUndoBundle const & bundle);
+    Res DelUndoBundle(uint32_t height);
+
+    // Erases the undo of blocks above height, left by a crash between flushing the undo and the state
+    size_t EraseUndosAbove(uint32_t height);
+
+    // Every custom tx applied in blocks from this height on has an undo record, an empty one if it changed nothing
+    std::optional<uint32_t> GetUndoCompleteHeight() const;
+    void SetUndoCompleteHeight(uint32_t height);
+
     // tags
-    struct ByUndoKey { static constexpr uint8_t prefix() { return 'u'; } };
+    struct ByUndoKey       { static constexpr uint8_t prefix() { return 'u'; } };
+    struct ByUndoBundleKey { static constexpr uint8_t prefix() { return 'e'; } };
+    struct UndoCompleteHeight { static constexpr uint8_t prefix() { return 'N'; } };
 };
 
 
@@ -16,10 +16,34 @@ struct CAuctionKey {
     }
 };
 
+// Ratio index key, ordered by ratio first
+struct CVaultRatioKey {
+    uint32_t ratio;
+    CVaultId vaultId;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action)
+    {
+        READWRITE(WrapBigEndian(ratio));
+        READWRITE(vaultId);
+    }
+};
+
 Res CVaultView::StoreVault(const CVaultId& vaultId, const CVaultData& vault)
 {
+    if (auto stored = GetVault(vaultId)) {
+        if (stored->ownerAddress != vault.ownerAddress) {
+            EraseBy<OwnerVaultKey>(std::make_pair(stored->ownerAddress, vaultId));
+        }
+        if (stored->schemeId != vault.schemeId) {
+            EraseBy<SchemeVaultKey>(std::make_pair(stored->schemeId, vaultId));
+        }
+    }
     WriteBy<VaultKey>(vaultId, vault);
     WriteBy<OwnerVaultKey>(std::make_pair(vault.ownerAddress, vaultId), '\0');
+    WriteBy<SchemeVaultKey>(std::make_pair(vault.schemeId, vaultId), '\0');
     return Res::Ok();
 }
 
@@ -32,6 +56,8 @@ Res CVaultView::EraseVault(const CVaultId& vaultId)
     EraseBy<VaultKey>(vaultId);
     EraseBy<CollateralKey>(vaultId);
     EraseBy<OwnerVaultKey>(std::make_pair(vault->ownerAddress, vaultId));
+    EraseBy<SchemeVaultKey>(std::make_pair(vault->schemeId, vaultId));
+    EraseVaultRatio(vaultId);
     return Res::Ok();
 }
 
@@ -47,25 +73,78 @@ Res CVaultView::UpdateVault(const CVaultId& vaultId, const CVaultMessage& newVau
         return Res::Err("Vault <%s> not found", vaultId.GetHex());
     }
 
-    EraseBy<OwnerVaultKey>(std::make_pair(vault->ownerAddress, vaultId));
-
     vault->ownerAddress = newVault.ownerAddress;
     vault->schemeId = newVault.schemeId;
 
     return StoreVault(vaultId, *vault);
 }
 
-void CVaultView::ForEachVault(std::function<bool(const CVaultId&, const CVaultData&)> callback, const CVaultId& start, const CScript& ownerAddress)
+void CVaultView::ForEachVault(std::function<bool(const CVaultId&, const CVaultData&)> callback, const CVaultId& start, const CScript& ownerAddress, const std::string& schemeId)
 {
-    if (ownerAddress.empty()) {
-        ForEach<VaultKey, CVaultId, CVaultData>(callback, start);
-    } else {
+    if (!ownerAddress.empty()) {
         ForEach<OwnerVaultKey, std::pair<CScript, CVaultId>, char>([&](const std::pair<CScript, CVaultId>& key, const char) {
-            return callback(key.second, *GetVault(key.second));
+            return key.first == ownerAddress && callback(key.second, *GetVault(key.second));
         }, std::make_pair(ownerAddress, start));
+    } else if (!schemeId.empty()) {
+        ForEach<SchemeVaultKey, std::pair<std::string, CVaultId>, char>([&](const std::pair<std::string, CVaultId>& key, const char) {
+            if (key.first != schemeId) {
+                return false;
+            }
+            // vaults restored by undo data written before the index existed may be stale here
+            auto vault = GetVault(key.second);
+            return !vault || vault->schemeId != schemeId || callback(key.second, *vault);
+        }, std::make_pair(schemeId, start));
+    } else {
+        ForEach<VaultKey, CVaultId, CVaultData>(callback, start);
     }
 }
 
+void CVaultView::IndexVaultSchemes()
+{
+    std::vector<std::pair<std::string, CVaultId>> keys;
+    ForEach<VaultKey, CVaultId, CVaultData>([&](const CVaultId& vaultId, const CVaultData& vault) {
+        keys.emplace_back(vault.schemeId, vaultId);
+        return true;
+    });
+    for (const auto& key : keys) {
+        WriteBy<SchemeVaultKey>(key, '\0');
+    }
+}
+
+Res CVaultView::SetVaultRatio(const CVaultId& vaultId, uint32_t ratio)
+{
+    if (auto stored = GetVaultRatio(vaultId)) {
+        if (*stored == ratio) {
+            return Res::Ok();
+        }
+        EraseBy<RatioVaultKey>(CVaultRatioKey{*stored, vaultId});
+    }
+    WriteBy<VaultRatioKey>(vaultId, ratio);
+    WriteBy<RatioVaultKey>(CVaultRatioKey{ratio, vaultId}, '\0');
+    return Res::Ok();
+}
+
+Res CVaultView::EraseVaultRatio(const CVaultId& vaultId)
+{
+    if (auto stored = GetVaultRatio(vaultId)) {
+        EraseBy<RatioVaultKey>(CVaultRatioKey{*stored, vaultId});
+        EraseBy<VaultRatioKey>(vaultId);
+    }
+    return Res::Ok();
+}
+
+std::optional<uint32_t> CVaultView::GetVaultRatio(const CVaultId& vaultId) const
+{
+    return ReadBy<VaultRatioKey, uint32_t>(vaultId);
+}
+
+void CVaultView::ForEachVaultRatio(std::function<bool(const CVaultId&, uint32_t)> callback, uint32_t minRatio, const CVaultId& start)
+{
+    ForEach<RatioVaultKey, CVaultRatioKey, char>([&](const CVaultRatioKey& key, const char) {
+        return callback(key.vaultId, key.ratio);
+    }, CVaultRatioKey{minRatio, start});
+}
+
 Res CVaultView::AddVaultCollateral(const CVaultId& vaultId, CTokenAmount amount)
 {
     CBalances amounts;
@@ -88,6 +167,7 @@ Res CVaultView::SubVaultCollateral(const CVaultId& vaultId, CTokenAmount amount)
     }
     if (amounts->balances.empty()) {
         EraseBy<CollateralKey>(vaultId);
+        EraseVaultRatio(vaultId);
     } else {
         WriteBy<CollateralKey>(vaultId, *amounts);
     }
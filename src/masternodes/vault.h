@@ -160,7 +160,17 @@ public:
     Res EraseVault(const CVaultId&);
     std::optional<CVaultData> GetVault(const CVaultId&) const;
     Res UpdateVault(const CVaultId& vaultId, const CVaultMessage& newVault);
-    void ForEachVault(std::function<bool(const CVaultId&, const CVaultData&)> callback, const CVaultId& start = {}, const CScript& ownerAddress = {});
+    void ForEachVault(std::function<bool(const CVaultId&, const CVaultData&)> callback, const CVaultId& start = {}, const CScript& ownerAddress = {}, const std::string& schemeId = {});
+
+    // Collateralization ratio of the vault in percent as of the last ratio calculation,
+    // kept for vaults with collaterals and valid prices only.
+    Res SetVaultRatio(const CVaultId& vaultId, uint32_t ratio);
+    Res EraseVaultRatio(const CVaultId& vaultId);
+    std::optional<uint32_t> GetVaultRatio(const CVaultId& vaultId) const;
+    void ForEachVaultRatio(std::function<bool(const CVaultId&, uint32_t)> callback, uint32_t minRatio = 0, const CVaultId& start = {});
+
+    // Builds the loan scheme index of vaults stored before it was introduced
+    void IndexVaultSchemes();
 
     Res AddVaultCollateral(const CVaultId& vaultId, CTokenAmount amount);
     Res SubVaultCollateral(const CVaultId& vaultId, CTokenAmount amount);
@@ -187,6 +197,9 @@ public:
     struct AuctionBatchKey  { static constexpr uint8_t prefix() { return 0x23; } };
     struct AuctionHeightKey { static constexpr uint8_t prefix() { return 0x24; } };
     struct AuctionBidKey    { static constexpr uint8_t prefix() { return 0x25; } };
+    struct SchemeVaultKey   { static constexpr uint8_t prefix() { return 0x26; } };
+    struct VaultRatioKey    { static constexpr uint8_t prefix() { return 0x27; } };
+    struct RatioVaultKey    { static constexpr uint8_t prefix() { return 0x28; } };
 };
 
 #endif // DEFI_MASTERNODES_VAULT_H
@@ -96,8 +96,13 @@ void CVaultHistoryView::EraseGlobalScheme(const VaultGlobalSchemeKey& key)
     EraseBy<ByVaultGlobalSchemeKey>(key);
 }
 
-CVaultHistoryStorage::CVaultHistoryStorage(const fs::path& dbName, std::size_t cacheSize, bool fMemory, bool fWipe)
-        : CStorageView(new CStorageLevelDB(dbName, cacheSize, fMemory, fWipe))
+CVaultHistoryStorage::CVaultHistoryStorage(const fs::path& dbName, const CDBOptions& dbOptions, bool fMemory, bool fWipe)
+        : CStorageView(new CStorageLevelDB(dbName, dbOptions, fMemory, fWipe))
+{
+}
+
+CVaultHistoryStorage::CVaultHistoryStorage(CStorageKV* storage)
+        : CStorageView(storage)
 {
 }
 
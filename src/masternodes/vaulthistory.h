@@ -182,8 +182,11 @@ public:
 
 class CVaultHistoryStorage : public CVaultHistoryView
 {
+    static_assert(UniqueStoragePrefixes<ByVaultHistoryKey, ByVaultStateKey, ByVaultSchemeKey, ByVaultGlobalSchemeKey>(), "prefixes are equal");
+
 public:
-    CVaultHistoryStorage(const fs::path& dbName, std::size_t cacheSize, bool fMemory = false, bool fWipe = false);
+    CVaultHistoryStorage(const fs::path& dbName, const CDBOptions& dbOptions, bool fMemory = false, bool fWipe = false);
+    explicit CVaultHistoryStorage(CStorageKV* storage);
 };
 
 extern std::unique_ptr<CVaultHistoryStorage> pvaultHistoryDB;
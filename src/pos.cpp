@@ -10,7 +10,7 @@
 #include <sync.h>
 #include <validation.h>
 
-extern RecursiveMutex cs_main;
+extern WaitTimedRecursiveMutex cs_main;
 
 namespace pos {
 
@@ -38,8 +38,9 @@ bool CheckHeaderSignature(const CBlockHeader& blockHeader) {
         return false;
     }
 
-    CPubKey recoveredPubKey{};
-    if (!recoveredPubKey.RecoverCompact(blockHeader.GetHashToSign(), blockHeader.sig)) {
+    // the key may have been recovered already, see ProcessNewBlockHeaders
+    CKeyID minter;
+    if (!blockHeader.ExtractMinterKey(minter)) {
         LogPrintf("CheckBlockSignature: Bad Block - malformed signature\n");
         return false;
     }
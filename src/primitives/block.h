@@ -21,7 +21,7 @@
 class CBlockHeader
 {
     // memory only
-    mutable CPubKey recoveredPubKey;
+    mutable CKeyID minterKeyID;
 
 public:
     // header
@@ -54,6 +54,9 @@ public:
         READWRITE(deprecatedHeight);
         READWRITE(mintedBlocks);
         READWRITE(sig);
+        if (ser_action.ForRead()) {
+            minterKeyID.SetNull();
+        }
     }
 
     void SetNull()
@@ -67,7 +70,7 @@ public:
         deprecatedHeight = 0;
         mintedBlocks = 0;
         sig = {};
-        recoveredPubKey = CPubKey{};
+        minterKeyID.SetNull();
     }
 
     bool IsNull() const
@@ -86,15 +89,23 @@ public:
 
     bool ExtractMinterKey(CKeyID &key) const
     {
-        if (!recoveredPubKey.IsValid()) {
+        if (minterKeyID.IsNull()) {
+            CPubKey recoveredPubKey;
             if (!recoveredPubKey.RecoverCompact(GetHashToSign(), sig)) {
                 return false;
             }
+            minterKeyID = recoveredPubKey.GetID();
         }
 
-        key = recoveredPubKey.GetID();
+        key = minterKeyID;
         return true;
     }
+
+    /** Reuse the minter key recovered from this header before, e.g. the one of its block index */
+    void SetMinterKey(const CKeyID& key) const
+    {
+        minterKeyID = key;
+    }
 };
 
 
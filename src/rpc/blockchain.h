@@ -11,7 +11,7 @@
 #include <stdint.h>
 #include <vector>
 
-extern RecursiveMutex cs_main;
+extern WaitTimedRecursiveMutex cs_main;
 
 class CBlock;
 class CBlockIndex;
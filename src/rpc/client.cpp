@@ -208,6 +208,7 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "listaccounts", 3, "is_mine_only" },
     { "getaccount", 1, "pagination" },
     { "getaccount", 2, "indexed_amounts" },
+    { "getaccount", 3, "height" },
     { "gettokenbalances", 0, "pagination" },
     { "gettokenbalances", 1, "indexed_amounts" },
     { "gettokenbalances", 2, "symbol_lookup" },
@@ -301,6 +302,7 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "listpoolshares", 0, "pagination" },
     { "listpoolshares", 1, "verbose" },
     { "listpoolshares", 2, "is_mine_only" },
+    { "getpoolcandles", 1, "options" },
 
     { "listaccounthistory", 1, "options" },
     { "getaccounthistory", 1, "blockHeight" },
@@ -316,6 +318,8 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "setgovheight", 2, "inputs" },
 
     { "isappliedcustomtx", 1, "blockHeight" },
+    { "listcustomtxs", 1, "options" },
+    { "getblockconnectstats", 0, "options" },
     { "sendtokenstoaddress", 0, "from" },
     { "sendtokenstoaddress", 1, "to" },
     { "getanchorteams", 0, "blockHeight" },
@@ -336,6 +340,9 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "listprices", 0, "pagination" },
     { "getprice", 0, "request" },
     { "listfixedintervalprices", 0, "pagination" },
+    { "getfixedintervalpriceat", 1, "height" },
+    { "listfixedintervalpricehistory", 1, "options" },
+    { "listoraclepricehistory", 1, "options" },
 
     { "spv_claimhtlc", 3, "feerate" },
     { "spv_refundhtlc", 2, "feerate" },
@@ -242,6 +242,7 @@ static UniValue getmininginfo(const JSONRPCRequest& request)
             "  \"networkhashps\": nnn,      (numeric) The network hashes per second\n"
             "  \"pooledtx\": n              (numeric) The size of the mempool\n"
             "  \"chain\": \"xxxx\",         (string)  current network name as defined in BIP70 (main, test, regtest)\n"
+            "  \"activemasternodes\": nnn, (numeric) The number of masternodes active at the next block\n"
             "  \"isoperator\": true|false   (boolean) Local master nodes are available or not \n"
             "  \"masternodes\": []          (array)   an array of objects which includes each master node information\n"
             "  \"warnings\": \"...\"        (string)  any network and blockchain warnings\n"
@@ -264,6 +265,7 @@ static UniValue getmininginfo(const JSONRPCRequest& request)
     obj.pushKV("networkhashps",    getnetworkhashps(request));
     obj.pushKV("pooledtx",         (uint64_t)mempool.size());
     obj.pushKV("chain",            Params().NetworkIDString());
+    obj.pushKV("activemasternodes", static_cast<uint64_t>(pcustomcsview->GetActiveMasternodeCount(height + 1)));
 
     bool genCoins = gArgs.GetBoolArg("-gen", DEFAULT_GENERATE);
 
@@ -6,6 +6,7 @@
 #ifndef DEFI_RPC_REQUEST_H
 #define DEFI_RPC_REQUEST_H
 
+#include <memory>
 #include <string>
 
 #include <univalue.h>
@@ -24,6 +25,21 @@ void DeleteAuthCookie();
 /** Parse JSON-RPC batch reply into a vector */
 std::vector<UniValue> JSONRPCProcessBatchReply(const UniValue &in, size_t num);
 
+/**
+ * Sends the elements of an array or object result to the client as they are
+ * produced, for results too large to be built in memory first. Both methods
+ * throw if the client went away.
+ */
+class JSONRPCResultWriter
+{
+public:
+    virtual ~JSONRPCResultWriter() {}
+    /** Write the next element of an array result */
+    virtual void Write(const UniValue& value) = 0;
+    /** Write the next member of an object result */
+    virtual void Write(const std::string& key, const UniValue& value) = 0;
+};
+
 class JSONRPCRequest
 {
 public:
@@ -34,6 +50,8 @@ public:
     std::string URI;
     std::string authUser;
     std::string peerAddr;
+    /** Set when the result may be streamed, see RPCResultStream */
+    std::shared_ptr<JSONRPCResultWriter> resultWriter;
 
     JSONRPCRequest() : id(NullUniValue), params(NullUniValue), fHelp(false) {}
     void parse(const UniValue& valRequest);
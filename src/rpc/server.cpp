@@ -17,6 +17,9 @@
 #include <boost/algorithm/string/classification.hpp>
 #include <boost/algorithm/string/split.hpp>
 
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
 #include <memory> // for unique_ptr
 #include <unordered_map>
 
@@ -358,11 +361,99 @@ static UniValue JSONRPCExecOne(JSONRPCRequest jreq, const UniValue& req)
     return rpc_result;
 }
 
-std::string JSONRPCExecBatch(const JSONRPCRequest& jreq, const UniValue& vReq)
+// Calls that only read may run in any order within a batch
+static bool IsReadOnlyBatchRequest(const UniValue& req)
 {
+    if (!req.isObject() || !req["method"].isStr()) {
+        return false;
+    }
+    const auto& method = req["method"].get_str();
+    if (method == "getnewaddress" || method == "getrawchangeaddress") {
+        return false;
+    }
+    for (const auto prefix : {"get", "list", "is", "decode", "estimate", "validate"}) {
+        if (method.compare(0, strlen(prefix), prefix) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+namespace {
+
+struct ParallelBatch {
+    const JSONRPCRequest& jreq;
+    const UniValue& vReq;
+    std::vector<UniValue>& replies;
+    const size_t end;
+    std::atomic<size_t> next;
+
+    Mutex cs;
+    std::condition_variable cond;
+    size_t completed GUARDED_BY(cs){0};
+
+    ParallelBatch(const JSONRPCRequest& jreq, const UniValue& vReq, std::vector<UniValue>& replies, size_t begin, size_t end)
+        : jreq(jreq), vReq(vReq), replies(replies), end(end), next(begin) {}
+
+    // Executes elements until none are left. Requests and replies are only
+    // touched for claimed elements, so late helpers may find the batch gone.
+    void Run()
+    {
+        size_t done = 0;
+        for (auto i = next++; i < end; i = next++) {
+            replies[i] = JSONRPCExecOne(jreq, vReq[i]);
+            ++done;
+        }
+        if (done) {
+            LOCK(cs);
+            completed += done;
+            cond.notify_all();
+        }
+    }
+};
+
+} // namespace
+
+static void JSONRPCExecParallel(const JSONRPCRequest& jreq, const UniValue& vReq, std::vector<UniValue>& replies,
+                                size_t begin, size_t end, const RPCWorkDispatcher& dispatch, int parallelism)
+{
+    auto batch = std::make_shared<ParallelBatch>(jreq, vReq, replies, begin, end);
+
+    const auto helpers = std::min<size_t>(parallelism - 1, end - begin - 1);
+    for (size_t i = 0; i < helpers; i++) {
+        if (!dispatch([batch]() { batch->Run(); })) {
+            break;
+        }
+    }
+
+    // The calling thread works through the elements too, so the batch completes
+    // even when every other worker is busy.
+    batch->Run();
+
+    WAIT_LOCK(batch->cs, lock);
+    batch->cond.wait(lock, [&]() { return batch->completed == end - begin; });
+}
+
+std::string JSONRPCExecBatch(const JSONRPCRequest& jreq, const UniValue& vReq, const RPCWorkDispatcher& dispatch, int parallelism)
+{
+    std::vector<UniValue> replies(vReq.size());
+    for (size_t reqIdx = 0; reqIdx < vReq.size();) {
+        auto end = reqIdx;
+        while (dispatch && parallelism > 1 && end < vReq.size() && IsReadOnlyBatchRequest(vReq[end])) {
+            ++end;
+        }
+        if (end - reqIdx > 1) {
+            JSONRPCExecParallel(jreq, vReq, replies, reqIdx, end, dispatch, parallelism);
+            reqIdx = end;
+        } else {
+            replies[reqIdx] = JSONRPCExecOne(jreq, vReq[reqIdx]);
+            ++reqIdx;
+        }
+    }
+
     UniValue ret(UniValue::VARR);
-    for (unsigned int reqIdx = 0; reqIdx < vReq.size(); reqIdx++)
-        ret.push_back(JSONRPCExecOne(jreq, vReq[reqIdx]));
+    for (const auto& reply : replies)
+        ret.push_back(reply);
 
     return ret.write() + "\n";
 }
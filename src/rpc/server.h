@@ -164,7 +164,20 @@ extern CRPCTable tableRPC;
 void StartRPC();
 void InterruptRPC();
 void StopRPC();
-std::string JSONRPCExecBatch(const JSONRPCRequest& jreq, const UniValue& vReq);
+
+/** Default number of read-only elements of a batch request executed at once */
+static const int DEFAULT_RPC_BATCH_PARALLELISM = 4;
+
+/** Queues work on another thread, returns false when it can't */
+typedef std::function<bool(std::function<void()>)> RPCWorkDispatcher;
+
+/**
+ * Executes a batch request. Consecutive read-only calls run on up to parallelism
+ * threads, the calling one and those work is dispatched to, every other call
+ * runs alone and in order. Replies keep the order of the requests.
+ */
+std::string JSONRPCExecBatch(const JSONRPCRequest& jreq, const UniValue& vReq,
+                             const RPCWorkDispatcher& dispatch = {}, int parallelism = 1);
 
 // Retrieves any serialization flags requested in command line argument
 int RPCSerializationFlags();
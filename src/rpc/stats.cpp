@@ -1,22 +1,31 @@
 #include <rpc/stats.h>
+#include <blockprefetcher.h>
+#include <connectstats.h>
+#include <dbwrapper.h>
+#include <logging.h>
 #include <rpc/server.h>
 #include <rpc/util.h>
+#include <txvalidationqueue.h>
+#include <util/threadnames.h>
+
+#include <cctype>
+#include <sstream>
 
 bool CRPCStats::isActive() { return active.load(); }
 void CRPCStats::setActive(bool isActive) { active.store(isActive); }
 
 std::optional<RPCStats> CRPCStats::get(const std::string& name) {
-    CLockFreeGuard lock(lock_stats);
+    LOCK(cs_stats);
 
     auto it = map.find(name);
-    if (it == map.end()) {
+    if (it == map.end() || !it->second.count) {
         return {};
     }
     return it->second;
 }
 
 std::map<std::string, RPCStats> CRPCStats::getMap() {
-    CLockFreeGuard lock(lock_stats);
+    LOCK(cs_stats);
     return map;
 }
 
@@ -41,7 +50,7 @@ void CRPCStats::load() {
     UniValue arr(UniValue::VARR);
     arr.read((const std::string)line);
 
-    CLockFreeGuard lock(lock_stats);
+    LOCK(cs_stats);
     for (const auto &val : arr.getValues()) {
         auto name = val["name"].get_str();
         map[name] = RPCStats::fromJSON(val);
@@ -71,15 +80,67 @@ UniValue RPCStats::toJSON() {
         historyArr.push_back(historyObj);
     }
 
+    UniValue percentilesObj(UniValue::VOBJ),
+             histogramArr(UniValue::VARR),
+             lockWaitObj(UniValue::VOBJ),
+             executionObj(UniValue::VOBJ),
+             threadsObj(UniValue::VOBJ);
+
+    percentilesObj.pushKV("p50", percentile(0.5));
+    percentilesObj.pushKV("p90", percentile(0.9));
+    percentilesObj.pushKV("p99", percentile(0.99));
+
+    for (const auto bucket : histogram) {
+        histogramArr.push_back(bucket);
+    }
+
+    lockWaitObj.pushKV("total", lockWait);
+    lockWaitObj.pushKV("avg", count ? lockWait / count : 0);
+    executionObj.pushKV("total", execution);
+    executionObj.pushKV("avg", count ? execution / count : 0);
+
+    for (const auto& [threadName, thread] : threads) {
+        UniValue threadObj(UniValue::VOBJ);
+        threadObj.pushKV("count", thread.count);
+        threadObj.pushKV("latency", thread.latency);
+        threadsObj.pushKV(threadName, threadObj);
+    }
+
     stats.pushKV("name", name);
     stats.pushKV("count", count);
     stats.pushKV("lastUsedTime", lastUsedTime);
     stats.pushKV("latency", latencyObj);
     stats.pushKV("payload", payloadObj);
     stats.pushKV("history", historyArr);
+    stats.pushKV("percentiles", percentilesObj);
+    stats.pushKV("histogram", histogramArr);
+    stats.pushKV("lockWait", lockWaitObj);
+    stats.pushKV("execution", executionObj);
+    stats.pushKV("inFlight", inFlight);
+    stats.pushKV("maxInFlight", maxInFlight);
+    stats.pushKV("threads", threadsObj);
     return stats;
 }
 
+int64_t RPCStats::percentile(double share) const {
+    int64_t total = 0;
+    for (const auto bucket : histogram) {
+        total += bucket;
+    }
+    if (!total) {
+        return 0;
+    }
+
+    int64_t seen = 0;
+    for (size_t i = 0; i < histogram.size(); i++) {
+        seen += histogram[i];
+        if (seen >= share * total) {
+            return int64_t{1} << i;
+        }
+    }
+    return int64_t{1} << (histogram.size() - 1);
+}
+
 RPCStats RPCStats::fromJSON(UniValue json) {
     RPCStats stats;
 
@@ -116,32 +177,111 @@ RPCStats RPCStats::fromJSON(UniValue json) {
             stats.history.push_back(historyEntry);
         }
     }
+
+    // Stats saved by earlier versions have no latency distribution
+    if (!json["histogram"].isNull()) {
+        const auto& histogramArr = json["histogram"].get_array();
+        for (size_t i = 0; i < histogramArr.size() && i < stats.histogram.size(); i++) {
+            stats.histogram[i] = histogramArr[i].get_int64();
+        }
+    }
+    if (!json["lockWait"].isNull()) {
+        stats.lockWait = json["lockWait"]["total"].get_int64();
+    }
+    if (!json["execution"].isNull()) {
+        stats.execution = json["execution"]["total"].get_int64();
+    }
+    if (!json["maxInFlight"].isNull()) {
+        stats.maxInFlight = json["maxInFlight"].get_int64();
+    }
+    if (!json["threads"].isNull()) {
+        const auto& threadsObj = json["threads"].get_obj();
+        for (const auto& threadName : threadsObj.getKeys()) {
+            stats.threads[threadName] = {
+                threadsObj[threadName]["count"].get_int64(),
+                threadsObj[threadName]["latency"].get_int64()
+            };
+        }
+    }
     return stats;
 }
 
-void CRPCStats::add(const std::string& name, const int64_t latency, const int64_t payload)
+void CRPCStats::start(const std::string& name)
+{
+    LOCK(cs_stats);
+    auto& stats = map[name];
+    stats.maxInFlight = std::max(stats.maxInFlight, ++stats.inFlight);
+}
+
+void CRPCStats::finish(const std::string& name)
+{
+    LOCK(cs_stats);
+    auto it = map.find(name);
+    if (it != map.end() && it->second.inFlight > 0) {
+        --it->second.inFlight;
+    }
+}
+
+void CRPCStats::add(const std::string& name, const int64_t latencyMicros, const int64_t payload, const int64_t lockWait)
 {
-    auto stats = CRPCStats::get(name);
-    if (stats) {
-        stats->count++;
-        stats->lastUsedTime = GetSystemTimeInSeconds();
-        stats->latency = {
-            std::min(latency, stats->latency.min),
-            stats->latency.avg + (latency - stats->latency.avg) / stats->count,
-            std::max(latency, stats->latency.max)
+    const auto latency = latencyMicros / 1000;
+    size_t bucket = 0;
+    while (bucket + 1 < RPC_STATS_LATENCY_BUCKETS && (int64_t{1} << bucket) <= latencyMicros) {
+        ++bucket;
+    }
+    const auto& threadName = util::ThreadGetInternalName();
+
+    LOCK(cs_stats);
+    auto& stats = map[name];
+    if (stats.count) {
+        stats.count++;
+        stats.lastUsedTime = GetSystemTimeInSeconds();
+        stats.latency = {
+            std::min(latency, stats.latency.min),
+            stats.latency.avg + (latency - stats.latency.avg) / stats.count,
+            std::max(latency, stats.latency.max)
         };
-        stats->payload = {
-            std::min(payload, stats->payload.min),
-            stats->payload.avg + (payload - stats->payload.avg) / stats->count,
-            std::max(payload, stats->payload.max)
+        stats.payload = {
+            std::min(payload, stats.payload.min),
+            stats.payload.avg + (payload - stats.payload.avg) / stats.count,
+            std::max(payload, stats.payload.max)
         };
     } else {
-        stats = { name, latency, payload };
+        // keeps the in flight counters of a first call
+        RPCStats first{ name, latency, payload };
+        first.inFlight = stats.inFlight;
+        first.maxInFlight = stats.maxInFlight;
+        stats = std::move(first);
     }
-    stats->history.push_back({ stats->lastUsedTime, latency, payload });
+    stats.history.push_back({ stats.lastUsedTime, latency, payload });
+    stats.histogram[bucket]++;
+    stats.lockWait += lockWait;
+    stats.execution += latencyMicros - lockWait;
+    auto& thread = stats.threads[threadName.empty() ? "unknown" : threadName];
+    thread.count++;
+    thread.latency += latencyMicros;
+}
 
-    CLockFreeGuard lock(lock_stats);
-    map[name] = *stats;
+CRPCStatsCall::~CRPCStatsCall()
+{
+    if (!name.empty()) {
+        statsRPC.finish(name);
+    }
+}
+
+void CRPCStatsCall::Start(const std::string& method)
+{
+    if (statsRPC.isActive() && name.empty()) {
+        name = method;
+        statsRPC.start(name);
+    }
+}
+
+void CRPCStatsCall::Add(const int64_t payload)
+{
+    if (statsRPC.isActive() && !name.empty()) {
+        statsRPC.add(name, GetTimeMicros() - startTime, payload, g_lockWaitMicros - lockWaitStart);
+    }
 }
 
 UniValue CRPCStats::toJSON() {
@@ -149,6 +289,10 @@ UniValue CRPCStats::toJSON() {
 
     UniValue ret(UniValue::VARR);
     for (auto &[_, stats] : map) {
+        // only in flight so far
+        if (!stats.count) {
+            continue;
+        }
         ret.push_back(stats.toJSON());
     }
     return ret;
@@ -176,6 +320,13 @@ static UniValue getrpcstats(const JSONRPCRequest& request)
             "           \"payload\":   (numeric)\n"
             "       }\n"
             "  ]\n"
+            "  \"percentiles\":        (json object) Upper bounds of the p50, p90 and p99 latency in microseconds.\n"
+            "  \"histogram\":          (json array) Number of calls by latency, entry i counts calls under 2^i microseconds.\n"
+            "  \"lockWait\":           (json object) Total and average microseconds spent waiting for cs_main.\n"
+            "  \"execution\":          (json object) Total and average microseconds spent otherwise.\n"
+            "  \"inFlight\":           (numeric) Number of calls currently executing.\n"
+            "  \"maxInFlight\":        (numeric) Highest number of calls executing at once.\n"
+            "  \"threads\":            (json object) Number of calls and total latency in microseconds by RPC worker thread.\n"
             "}"
         },
         RPCExamples{
@@ -217,6 +368,13 @@ static UniValue listrpcstats(const JSONRPCRequest& request)
             "           \"payload\":   (numeric)\n"
             "       }\n"
             "  ]\n"
+            "  \"percentiles\":        (json object) Upper bounds of the p50, p90 and p99 latency in microseconds.\n"
+            "  \"histogram\":          (json array) Number of calls by latency, entry i counts calls under 2^i microseconds.\n"
+            "  \"lockWait\":           (json object) Total and average microseconds spent waiting for cs_main.\n"
+            "  \"execution\":          (json object) Total and average microseconds spent otherwise.\n"
+            "  \"inFlight\":           (numeric) Number of calls currently executing.\n"
+            "  \"maxInFlight\":        (numeric) Highest number of calls executing at once.\n"
+            "  \"threads\":            (json object) Number of calls and total latency in microseconds by RPC worker thread.\n"
             " }\n"
             "]"
         },
@@ -233,12 +391,312 @@ static UniValue listrpcstats(const JSONRPCRequest& request)
     return statsRPC.toJSON();
 }
 
+static UniValue getblockconnectstats(const JSONRPCRequest& request)
+{
+    RPCHelpMan{"getblockconnectstats",
+        "\nGet timings, storage key reads and writes and undo sizes of the phases of recently connected blocks.\n",
+        {
+            {"options", RPCArg::Type::OBJ, RPCArg::Optional::OMITTED, "",
+                {
+                    {"minHeight", RPCArg::Type::NUM, RPCArg::Optional::OMITTED, "Lowest block height to return stats of (default = 0)"},
+                    {"maxHeight", RPCArg::Type::NUM, RPCArg::Optional::OMITTED, "Highest block height to return stats of (default = chain tip)"},
+                    {"limit", RPCArg::Type::NUM, RPCArg::Optional::OMITTED, "Maximum number of blocks to return, 10 by default, 0 for all"},
+                    {"slowest", RPCArg::Type::BOOL, RPCArg::Optional::OMITTED, "Return the slowest blocks first instead of the most recent ones (default = false)"},
+                },
+            },
+        },
+        RPCResult{
+            "[\n"
+            " {\n"
+            "  \"height\":             (numeric) The block height.\n"
+            "  \"hash\":               (string) The block hash.\n"
+            "  \"timestamp\":          (numeric) Time the block got connected.\n"
+            "  \"time\":               (numeric) Time to connect the block in microseconds.\n"
+            "  \"undo\":               (json object) Entries and size of the custom state undo of the block events, size of the UTXO undo.\n"
+            "  \"phases\":             (json object) Time, key reads and key writes of every phase.\n"
+            "  \"customTxs\":          (json object) Count, time, key reads, key writes and undo size by custom transaction type.\n"
+            " }\n"
+            "]"
+        },
+        RPCExamples{
+            HelpExampleCli("getblockconnectstats", "'{\"slowest\":true,\"limit\":5}'") +
+            HelpExampleRpc("getblockconnectstats", "{\"slowest\":true,\"limit\":5}")
+        },
+    }.Check(request);
+
+    if (!g_connectStats.IsActive()) {
+        throw JSONRPCError(RPC_INVALID_REQUEST, "Block connect stats are disabled. Use -connectstats.");
+    }
+
+    int minHeight = 0;
+    int maxHeight = std::numeric_limits<int>::max();
+    size_t limit = 10;
+    bool slowest = false;
+
+    if (!request.params[0].isNull()) {
+        RPCTypeCheckArgument(request.params[0], UniValue::VOBJ);
+        const UniValue& optionsObj = request.params[0].get_obj();
+        RPCTypeCheckObj(optionsObj,
+            {
+                {"minHeight", UniValueType(UniValue::VNUM)},
+                {"maxHeight", UniValueType(UniValue::VNUM)},
+                {"limit", UniValueType(UniValue::VNUM)},
+                {"slowest", UniValueType(UniValue::VBOOL)},
+            }, true, true);
+
+        if (!optionsObj["minHeight"].isNull()) {
+            minHeight = optionsObj["minHeight"].get_int();
+        }
+        if (!optionsObj["maxHeight"].isNull()) {
+            maxHeight = optionsObj["maxHeight"].get_int();
+        }
+        if (!optionsObj["limit"].isNull()) {
+            limit = (size_t) optionsObj["limit"].get_int64();
+        }
+        if (!optionsObj["slowest"].isNull()) {
+            slowest = optionsObj["slowest"].get_bool();
+        }
+    }
+    if (limit == 0) {
+        limit = std::numeric_limits<decltype(limit)>::max();
+    }
+
+    auto blocks = g_connectStats.Get(minHeight, maxHeight);
+    if (slowest) {
+        std::stable_sort(blocks.begin(), blocks.end(), [](const CBlockConnectStats& a, const CBlockConnectStats& b) {
+            return a.time > b.time;
+        });
+    } else {
+        std::reverse(blocks.begin(), blocks.end());
+    }
+
+    UniValue ret(UniValue::VARR);
+    for (const auto& stats : blocks) {
+        if (ret.size() >= limit) {
+            break;
+        }
+        ret.push_back(stats.ToJSON());
+    }
+    return ret;
+}
+
+static UniValue getdbstats(const JSONRPCRequest& request)
+{
+    RPCHelpMan{"getdbstats",
+        "\nGet the LevelDB options, internal stats and approximate on-disk size per key prefix of the open databases.\n",
+        {
+            {"name", RPCArg::Type::STR, RPCArg::Optional::OMITTED, "Only return the database with this directory name, e.g. enhancedcs"},
+        },
+        RPCResult{
+            "[\n"
+            " {\n"
+            "  \"name\":               (string) The directory name of the database.\n"
+            "  \"options\":            (json object) Block cache, write buffer and max file size in bytes, bloom filter bits and compression.\n"
+            "  \"memoryUsage\":        (numeric) Approximate memory usage of the memtables and block cache in bytes.\n"
+            "  \"size\":               (numeric) Approximate on-disk size in bytes.\n"
+            "  \"prefixes\":           (json object) Approximate on-disk size in bytes by first key byte, as a character if printable, in hex otherwise.\n"
+            "  \"stats\":              (json array) Lines of the LevelDB compaction stats per level.\n"
+            " }\n"
+            "]"
+        },
+        RPCExamples{
+            HelpExampleCli("getdbstats", "enhancedcs") +
+            HelpExampleRpc("getdbstats", "\"enhancedcs\"")
+        },
+    }.Check(request);
+
+    const std::string name = request.params[0].isNull() ? "" : request.params[0].get_str();
+
+    UniValue ret(UniValue::VARR);
+    ForEachDBWrapper([&](const CDBWrapper& db) {
+        if (!name.empty() && db.GetName() != name) {
+            return;
+        }
+
+        const auto& dbOptions = db.GetDBOptions();
+        UniValue optionsObj(UniValue::VOBJ);
+        optionsObj.pushKV("blockCache", static_cast<uint64_t>(dbOptions.blockCache));
+        optionsObj.pushKV("writeBuffer", static_cast<uint64_t>(dbOptions.writeBuffer));
+        optionsObj.pushKV("maxFileSize", static_cast<uint64_t>(dbOptions.maxFileSize));
+        optionsObj.pushKV("bloomBits", dbOptions.bloomBits);
+        optionsObj.pushKV("compression", dbOptions.compression);
+
+        uint64_t size = 0;
+        UniValue prefixesObj(UniValue::VOBJ);
+        const auto sizes = db.EstimatePrefixSizes();
+        for (size_t prefix = 0; prefix < sizes.size(); ++prefix) {
+            if (sizes[prefix] == 0) {
+                continue;
+            }
+            size += sizes[prefix];
+            const auto key = std::isprint(prefix) ? std::string(1, static_cast<char>(prefix)) : strprintf("0x%02x", prefix);
+            prefixesObj.pushKV(key, sizes[prefix]);
+        }
+
+        UniValue statsArr(UniValue::VARR);
+        std::string stats;
+        if (db.GetProperty("leveldb.stats", stats)) {
+            std::istringstream lines(stats);
+            for (std::string line; std::getline(lines, line);) {
+                if (!line.empty()) {
+                    statsArr.push_back(line);
+                }
+            }
+        }
+
+        UniValue dbObj(UniValue::VOBJ);
+        dbObj.pushKV("name", db.GetName());
+        dbObj.pushKV("options", optionsObj);
+        dbObj.pushKV("memoryUsage", static_cast<uint64_t>(db.DynamicMemoryUsage()));
+        dbObj.pushKV("size", size);
+        dbObj.pushKV("prefixes", prefixesObj);
+        dbObj.pushKV("stats", statsArr);
+        ret.push_back(dbObj);
+    });
+
+    if (!name.empty() && ret.empty()) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Database %s is not open", name));
+    }
+    return ret;
+}
+
+static UniValue getlogstats(const JSONRPCRequest& request)
+{
+    RPCHelpMan{"getlogstats",
+        "\nGet the state of the debug output thread enabled by -logasync.\n",
+        {},
+        RPCResult{
+            "{\n"
+            "  \"async\":              (bool) Whether messages are written from the debug output thread.\n"
+            "  \"capacity\":           (numeric) The number of messages that can be queued.\n"
+            "  \"queued\":             (numeric) The number of messages waiting to be written.\n"
+            "  \"written\":            (numeric) The number of messages written by the thread.\n"
+            "  \"dropped\":            (numeric) The number of messages dropped while the queue was full.\n"
+            "}"
+        },
+        RPCExamples{
+            HelpExampleCli("getlogstats", "") +
+            HelpExampleRpc("getlogstats", "")
+        },
+    }.Check(request);
+
+    const auto stats = LogInstance().GetAsyncStats();
+
+    UniValue ret(UniValue::VOBJ);
+    ret.pushKV("async", stats.active);
+    ret.pushKV("capacity", static_cast<uint64_t>(stats.capacity));
+    ret.pushKV("queued", static_cast<uint64_t>(stats.queued));
+    ret.pushKV("written", stats.written);
+    ret.pushKV("dropped", stats.dropped);
+    return ret;
+}
+
+static UniValue gettxvalidationstats(const JSONRPCRequest& request)
+{
+    RPCHelpMan{"gettxvalidationstats",
+        "\nGet the state of the transaction validation thread enabled by -txvalidationthread.\n"
+        "Times are in microseconds.\n",
+        {},
+        RPCResult{
+            "{\n"
+            "  \"active\":             (bool) Whether transactions of peers are validated on the thread.\n"
+            "  \"queued\":             (numeric) The number of transactions waiting for validation.\n"
+            "  \"peers\":              (numeric) The number of peers with transactions waiting.\n"
+            "  \"blockpending\":       (bool) Whether validation is held back by a block being processed.\n"
+            "  \"processed\":          (numeric) The number of transactions validated.\n"
+            "  \"dropped\":            (numeric) The number of transactions dropped as their peer disconnected.\n"
+            "  \"waittime\": {         (json object) Time spent in the queue.\n"
+            "    \"avg\":              (numeric) Average\n"
+            "    \"max\":              (numeric) Maximum\n"
+            "  },\n"
+            "  \"validationtime\": {   (json object) Time spent validating, including the orphans resolved.\n"
+            "    \"avg\":              (numeric) Average\n"
+            "    \"max\":              (numeric) Maximum\n"
+            "  }\n"
+            "}"
+        },
+        RPCExamples{
+            HelpExampleCli("gettxvalidationstats", "") +
+            HelpExampleRpc("gettxvalidationstats", "")
+        },
+    }.Check(request);
+
+    CTxValidationQueue::Stats stats;
+    if (g_txvalidationqueue) {
+        stats = g_txvalidationqueue->GetStats();
+    }
+
+    auto time = [&](int64_t total, int64_t max) {
+        UniValue obj(UniValue::VOBJ);
+        obj.pushKV("avg", stats.processed ? total / static_cast<int64_t>(stats.processed) : 0);
+        obj.pushKV("max", max);
+        return obj;
+    };
+
+    UniValue ret(UniValue::VOBJ);
+    ret.pushKV("active", g_txvalidationqueue != nullptr);
+    ret.pushKV("queued", static_cast<uint64_t>(stats.queued));
+    ret.pushKV("peers", static_cast<uint64_t>(stats.peers));
+    ret.pushKV("blockpending", stats.blockPending);
+    ret.pushKV("processed", stats.processed);
+    ret.pushKV("dropped", stats.dropped);
+    ret.pushKV("waittime", time(stats.waitTime, stats.maxWaitTime));
+    ret.pushKV("validationtime", time(stats.validationTime, stats.maxValidationTime));
+    return ret;
+}
+
+static UniValue getblockprefetchstats(const JSONRPCRequest& request)
+{
+    RPCHelpMan{"getblockprefetchstats",
+        "\nGet the state of the threads reading blocks ahead of connecting them, enabled by -blockprefetch.\n"
+        "Times are in microseconds.\n",
+        {},
+        RPCResult{
+            "{\n"
+            "  \"threads\":            (numeric) The number of threads reading blocks.\n"
+            "  \"pending\":            (numeric) The number of blocks queued or read and not yet connected.\n"
+            "  \"hits\":               (numeric) The number of blocks read before they were connected.\n"
+            "  \"waits\":              (numeric) The number of blocks connected while still being read.\n"
+            "  \"misses\":             (numeric) The number of blocks read when connecting them.\n"
+            "  \"loadtime\":           (numeric) Time spent reading and parsing the blocks connected.\n"
+            "  \"waittime\":           (numeric) Time spent waiting for blocks being read.\n"
+            "  \"savedtime\":          (numeric) Stall time saved, the load time not waited for.\n"
+            "}"
+        },
+        RPCExamples{
+            HelpExampleCli("getblockprefetchstats", "") +
+            HelpExampleRpc("getblockprefetchstats", "")
+        },
+    }.Check(request);
+
+    CBlockPrefetcher::Stats stats;
+    if (g_blockprefetcher) {
+        stats = g_blockprefetcher->GetStats();
+    }
+
+    UniValue ret(UniValue::VOBJ);
+    ret.pushKV("threads", stats.threads);
+    ret.pushKV("pending", static_cast<uint64_t>(stats.pending));
+    ret.pushKV("hits", stats.hits);
+    ret.pushKV("waits", stats.waits);
+    ret.pushKV("misses", stats.misses);
+    ret.pushKV("loadtime", stats.loadTime);
+    ret.pushKV("waittime", stats.waitTime);
+    ret.pushKV("savedtime", std::max<int64_t>(0, stats.loadTime - stats.waitTime));
+    return ret;
+}
+
 // clang-format off
 static const CRPCCommand commands[] =
 { //  category              name                      actor (function)         argNames
   //  --------------------- ------------------------  -----------------------  ----------
     { "stats",              "getrpcstats",            &getrpcstats,            {"command"} },
     { "stats",              "listrpcstats",           &listrpcstats,           {} },
+    { "stats",              "getblockconnectstats",   &getblockconnectstats,   {"options"} },
+    { "stats",              "getdbstats",             &getdbstats,             {"name"} },
+    { "stats",              "getlogstats",            &getlogstats,            {} },
+    { "stats",              "gettxvalidationstats",   &gettxvalidationstats,   {} },
+    { "stats",              "getblockprefetchstats",  &getblockprefetchstats,  {} },
 };
 // clang-format on
 
@@ -1,8 +1,10 @@
 #ifndef DEFI_RPC_STATS_H
 #define DEFI_RPC_STATS_H
 
+#include <array>
 #include <map>
 #include <stdint.h>
+#include <sync.h>
 #include <univalue.h>
 #include <util/time.h>
 #include <util/system.h>
@@ -11,6 +13,8 @@
 
 const char * const DEFAULT_STATSFILE = "stats.log";
 static const uint8_t RPC_STATS_HISTORY_SIZE = 5;
+// Bucket i counts calls that took less than 2^i microseconds and at least 2^(i-1)
+static const size_t RPC_STATS_LATENCY_BUCKETS = 32;
 const bool DEFAULT_RPC_STATS = true;
 
 struct MinMaxStatEntry {
@@ -29,13 +33,24 @@ struct StatHistoryEntry {
     int64_t payload;
 };
 
+struct RPCThreadStats {
+    int64_t count{0};
+    int64_t latency{0}; // total, in microseconds
+};
+
 struct RPCStats {
     std::string name;
-    int64_t lastUsedTime;
+    int64_t lastUsedTime{0};
     MinMaxStatEntry latency;
     MinMaxStatEntry payload;
-    int64_t count;
+    int64_t count{0};
     boost::circular_buffer<StatHistoryEntry> history;
+    std::array<int64_t, RPC_STATS_LATENCY_BUCKETS> histogram{};
+    int64_t lockWait{0};  // total time waiting for cs_main, in microseconds
+    int64_t execution{0}; // total time otherwise, in microseconds
+    int64_t inFlight{0};
+    int64_t maxInFlight{0};
+    std::map<std::string, RPCThreadStats> threads;
 
     RPCStats() : history(RPC_STATS_HISTORY_SIZE) {}
 
@@ -45,6 +60,8 @@ struct RPCStats {
             count = 1;
     };
 
+    /// Upper bound of the latency of the given share of calls, in microseconds
+    int64_t percentile(double share) const;
     UniValue toJSON();
     static RPCStats fromJSON(UniValue json);
 };
@@ -55,14 +72,18 @@ struct RPCStats {
 class CRPCStats
 {
 private:
-    std::atomic_bool lock_stats{false};
-    std::map<std::string, RPCStats> map;
+    Mutex cs_stats;
+    std::map<std::string, RPCStats> map GUARDED_BY(cs_stats);
     std::atomic_bool active{DEFAULT_RPC_STATS};
 
 public:
     bool isActive();
     void setActive(bool isActive);
-    void add(const std::string& name, const int64_t latency, const int64_t payload);
+    /// Counts a call as in flight until the matching add or finish
+    void start(const std::string& name);
+    void finish(const std::string& name);
+    /// latency and lockWait in microseconds
+    void add(const std::string& name, const int64_t latency, const int64_t payload, const int64_t lockWait = 0);
     std::optional<RPCStats> get(const std::string& name);
     std::map<std::string, RPCStats> getMap();
     UniValue toJSON();
@@ -72,4 +93,23 @@ public:
 
 extern CRPCStats statsRPC;
 
+/**
+ * Measures an RPC request from construction, including the time the calling
+ * thread waits for cs_main. Requests that end without Add are not recorded.
+ */
+class CRPCStatsCall
+{
+    std::string name;
+    const int64_t startTime;
+    const int64_t lockWaitStart;
+
+public:
+    CRPCStatsCall() : startTime(GetTimeMicros()), lockWaitStart(g_lockWaitMicros) {}
+    ~CRPCStatsCall();
+
+    /// Counts the request as in flight for the given RPC
+    void Start(const std::string& name);
+    void Add(const int64_t payload);
+};
+
 #endif // DEFI_RPC_STATS_H
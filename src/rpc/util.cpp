@@ -745,3 +745,39 @@ std::vector<CScript> EvalDescriptorStringOrObject(const UniValue& scanobject, Fl
     }
     return ret;
 }
+
+RPCResultStream::RPCResultStream(const JSONRPCRequest& request, UniValue::VType type)
+    : m_writer(request.resultWriter), m_result(type)
+{
+}
+
+void RPCResultStream::push_back(const UniValue& value)
+{
+    assert(m_result.isArray());
+    if (m_writer) {
+        m_writer->Write(value);
+    } else {
+        m_result.push_back(value);
+    }
+    ++m_size;
+}
+
+void RPCResultStream::pushKV(const std::string& key, const UniValue& value)
+{
+    assert(m_result.isObject());
+    if (m_writer) {
+        m_writer->Write(key, value);
+    } else {
+        m_result.pushKV(key, value);
+    }
+    ++m_size;
+}
+
+void RPCResultStream::pushKVs(const UniValue& obj)
+{
+    const auto& keys = obj.getKeys();
+    const auto& values = obj.getValues();
+    for (size_t i = 0; i < keys.size(); ++i) {
+        pushKV(keys[i], values[i]);
+    }
+}
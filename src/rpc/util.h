@@ -262,4 +262,29 @@ private:
     const RPCExamples m_examples;
 };
 
+/**
+ * Array or object result of a listing RPC. If the request allows it, elements
+ * are streamed to the client as they are pushed and the result is never built
+ * in memory, otherwise they are collected as usual.
+ */
+class RPCResultStream
+{
+public:
+    RPCResultStream(const JSONRPCRequest& request, UniValue::VType type);
+
+    void push_back(const UniValue& value);
+    void pushKV(const std::string& key, const UniValue& value);
+    void pushKVs(const UniValue& obj);
+
+    size_t size() const { return m_size; }
+
+    /** The collected result, which is empty if the elements were streamed */
+    UniValue get() { return std::move(m_result); }
+
+private:
+    std::shared_ptr<JSONRPCResultWriter> m_writer;
+    UniValue m_result;
+    size_t m_size{0};
+};
+
 #endif // DEFI_RPC_UTIL_H
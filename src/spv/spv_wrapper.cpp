@@ -29,7 +29,7 @@
 
 #include <boost/algorithm/string/replace.hpp>
 
-extern RecursiveMutex cs_main;
+extern WaitTimedRecursiveMutex cs_main;
 
 RecursiveMutex cs_spvcallback;
 
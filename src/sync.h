@@ -106,6 +106,32 @@ using CCriticalSection = RecursiveMutex;
 /** Wrapped mutex: supports waiting but not recursive locking */
 using Mutex = AnnotatedMixin<std::mutex>;
 
+/** Microseconds the calling thread waited for contended WaitTimedMixin mutexes. */
+inline thread_local int64_t g_lockWaitMicros = 0;
+
+/**
+ * Mixin that adds the time spent waiting for the mutex when it is contended to
+ * g_lockWaitMicros, so callers can tell waiting for the lock from execution.
+ */
+template <typename PARENT>
+class LOCKABLE WaitTimedMixin : public AnnotatedMixin<PARENT>
+{
+public:
+    void lock() EXCLUSIVE_LOCK_FUNCTION()
+    {
+        if (!PARENT::try_lock()) {
+            const auto start = std::chrono::steady_clock::now();
+            PARENT::lock();
+            g_lockWaitMicros += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+        }
+    }
+
+    using UniqueLock = std::unique_lock<WaitTimedMixin>;
+};
+
+/** Recursive mutex that accounts for the time waited for it, used for cs_main */
+using WaitTimedRecursiveMutex = WaitTimedMixin<std::recursive_mutex>;
+
 #ifdef DEBUG_LOCKCONTENTION
 
 #define AssertLockHeld(cs) AssertLockHeldInternal(#cs, __FILE__, __LINE__, &cs)
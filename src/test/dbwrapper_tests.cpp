@@ -41,6 +41,47 @@ BOOST_AUTO_TEST_CASE(dbwrapper)
     }
 }
 
+BOOST_AUTO_TEST_CASE(dbwrapper_options)
+{
+    CDBOptions defaults(8 << 20);
+    BOOST_CHECK_EQUAL(defaults.blockCache, 4 << 20);
+    BOOST_CHECK_EQUAL(defaults.writeBuffer, 2 << 20);
+    BOOST_CHECK_EQUAL(defaults.bloomBits, 16);
+    BOOST_CHECK(!defaults.compression);
+
+    gArgs.ForceSetArg("-dboption", "dbwrapper_options.bloombits=10");
+    std::string error;
+    BOOST_CHECK(CheckDBOptionArgs(error));
+    {
+        CDBWrapper dbw(GetDataDir() / "dbwrapper_options", defaults, true, false, false);
+        BOOST_CHECK_EQUAL(dbw.GetDBOptions().bloomBits, 10);
+        BOOST_CHECK_EQUAL(dbw.GetDBOptions().blockCache, defaults.blockCache);
+
+        // every key written under prefix 'a' is accounted to it
+        for (int i = 0; i < 1000; ++i) {
+            BOOST_CHECK(dbw.Write(std::make_pair('a', i), InsecureRand256()));
+        }
+        dbw.CompactRange('a', 'b');
+        const auto sizes = dbw.EstimatePrefixSizes();
+        BOOST_CHECK_EQUAL(sizes.size(), 256);
+        BOOST_CHECK_GT(sizes['a'], 1000 * sizeof(uint256));
+        BOOST_CHECK_EQUAL(sizes['b'], 0);
+
+        size_t count = 0;
+        ForEachDBWrapper([&](const CDBWrapper& db) {
+            count += db.GetName() == "dbwrapper_options";
+        });
+        BOOST_CHECK_EQUAL(count, 1);
+    }
+
+    gArgs.ForceSetArg("-dboption", "dbwrapper_options.cache=10");
+    BOOST_CHECK(!CheckDBOptionArgs(error));
+    gArgs.ForceSetArg("-dboption", "dbwrapper_options.bloombits");
+    BOOST_CHECK(!CheckDBOptionArgs(error));
+    gArgs.ForceSetArg("-dboption", "");
+    BOOST_CHECK(CheckDBOptionArgs(error));
+}
+
 // Test batch operations
 BOOST_AUTO_TEST_CASE(dbwrapper_batch)
 {
@@ -1,6 +1,9 @@
 #include <test/setup_common.h>
 
+#include <chainparams.h>
 #include <masternodes/masternodes.h>
+#include <masternodes/mnregistry.h>
+#include <masternodes/undo.h>
 
 #include <boost/test/unit_test.hpp>
 
@@ -115,4 +118,84 @@ BOOST_AUTO_TEST_CASE(retrieve_last_time_multi)
     BOOST_CHECK_EQUAL(time2001[3], 2000);
 }
 
+// Active masternodes as read from the storage of the view, bypassing the registry
+static size_t CountActiveInStorage(CCustomCSView& view, int height)
+{
+    CCustomCSView plain(view.GetStorage());
+    BOOST_CHECK(!plain.GetMasternodeRegistry());
+    return plain.GetActiveMasternodeCount(height);
+}
+
+BOOST_AUTO_TEST_CASE(masternode_registry)
+{
+    const auto registry = pcustomcsview->GetMasternodeRegistry();
+    BOOST_REQUIRE(registry);
+
+    const int height = Params().GetConsensus().EunosPayaHeight + 1000;
+    const int activationDelay = GetMnActivationDelay(height);
+    const auto total = registry->Count();
+    const auto genesisCount = registry->CountActive(height);
+    BOOST_CHECK_EQUAL(genesisCount, CountActiveInStorage(*pcustomcsview, height));
+
+    CMasternode mn;
+    std::vector<unsigned char> vec(20, '7');
+    CKeyID minter(uint160{vec});
+    mn.operatorType = 1;
+    mn.ownerType = 1;
+    mn.operatorAuthAddress = minter;
+    mn.ownerAuthAddress = minter;
+    mn.creationHeight = height;
+    uint256 mnId = uint256S("7777777777777777777777777777777777777777777777777777777777777777");
+
+    // Changes of a cache view are not in the registry until flushed
+    CCustomCSView mnview(*pcustomcsview.get());
+    BOOST_REQUIRE(mnview.CreateMasternode(mnId, mn, 0));
+    BOOST_CHECK(!mnview.GetMasternodeRegistry());
+    BOOST_CHECK(!registry->Get(mnId));
+    BOOST_CHECK_EQUAL(mnview.GetActiveMasternodeCount(height + activationDelay), genesisCount + 1);
+    mnview.Flush();
+
+    BOOST_CHECK(registry->Get(mnId));
+    BOOST_CHECK_EQUAL(registry->Count(), total + 1);
+    for (int h : {height + activationDelay, height, height + activationDelay - 1, height + 2 * activationDelay}) {
+        BOOST_CHECK_EQUAL(registry->CountActive(h), CountActiveInStorage(*pcustomcsview, h));
+    }
+    BOOST_CHECK_EQUAL(registry->CountActive(height + activationDelay - 1), genesisCount);
+    BOOST_CHECK_EQUAL(registry->CountActive(height + activationDelay), genesisCount + 1);
+
+    size_t active{0};
+    bool found{false};
+    pcustomcsview->ForEachActiveMasternode(height + activationDelay, [&](uint256 const & id, CMasternode const & node) {
+        ++active;
+        found |= id == mnId;
+        return true;
+    });
+    BOOST_CHECK(found);
+    BOOST_CHECK_EQUAL(active, genesisCount + 1);
+
+    // Resign, then revert it as an undo would
+    const int resignHeight = height + 2 * activationDelay;
+    CCustomCSView resignView(*pcustomcsview.get());
+    BOOST_REQUIRE(resignView.ResignMasternode(mnId, uint256S("01"), resignHeight));
+    auto undo = CUndo::Construct(pcustomcsview->GetStorage(), resignView.GetStorage().GetRaw());
+    resignView.Flush();
+
+    BOOST_CHECK_EQUAL(registry->Get(mnId)->resignHeight, resignHeight);
+    BOOST_CHECK_EQUAL(registry->CountActive(resignHeight - 1), genesisCount + 1);
+    BOOST_CHECK_EQUAL(registry->CountActive(resignHeight), genesisCount);
+    BOOST_CHECK_EQUAL(registry->CountActive(resignHeight), CountActiveInStorage(*pcustomcsview, resignHeight));
+
+    CUndo::Revert(pcustomcsview->GetStorage(), undo);
+    BOOST_CHECK_EQUAL(registry->Get(mnId)->resignHeight, -1);
+    BOOST_CHECK_EQUAL(registry->CountActive(resignHeight), genesisCount + 1);
+    BOOST_CHECK_EQUAL(registry->CountActive(resignHeight), CountActiveInStorage(*pcustomcsview, resignHeight));
+
+    // Undo of the creation
+    CCustomCSView eraseView(*pcustomcsview.get());
+    BOOST_REQUIRE(eraseView.UnCreateMasternode(mnId));
+    eraseView.Flush();
+    BOOST_CHECK(!registry->Get(mnId));
+    BOOST_CHECK_EQUAL(registry->CountActive(resignHeight), genesisCount);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
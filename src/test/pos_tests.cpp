@@ -211,4 +211,59 @@ BOOST_AUTO_TEST_CASE(check_subnode)
 }
 
 
+BOOST_AUTO_TEST_CASE(disk_block_index_minter_key)
+{
+    uint256 masternodeID = testMasternodeKeys.begin()->first;
+    CKey minterKey = testMasternodeKeys.begin()->second.operatorKey;
+
+    uint256 prev_hash = uint256S("1234567890abcdef1234567890abcdef1234567890abcdef1234567890abcdef");
+    std::shared_ptr<CBlock> block = FinalizeBlock(Block(prev_hash, 1, 1), masternodeID, minterKey, prev_hash);
+
+    uint256 hash = block->GetHash();
+    CBlockIndex index(*block);
+    index.phashBlock = &hash;
+    BOOST_CHECK(index.minterKeyID == minterKey.GetPubKey().GetID());
+
+    // the key goes to disk along with the header, not into the in-memory status
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    ss << CDiskBlockIndex(&index);
+    CDiskBlockIndex diskindex;
+    ss >> diskindex;
+    BOOST_CHECK(diskindex.nStatus & BLOCK_HAVE_MINTER_KEY);
+    BOOST_CHECK(!(index.nStatus & BLOCK_HAVE_MINTER_KEY));
+    BOOST_CHECK(diskindex.minterKeyID == index.minterKeyID);
+    BOOST_CHECK(ss.empty());
+
+    // and blocks read back reuse it
+    CBlockHeader header = diskindex.GetBlockHeader();
+    CKeyID minter;
+    BOOST_CHECK(header.ExtractMinterKey(minter));
+    BOOST_CHECK(minter == index.minterKeyID);
+
+    // records without it still load
+    index.minterKeyID.SetNull();
+    ss << CDiskBlockIndex(&index);
+    CDiskBlockIndex olddiskindex;
+    ss >> olddiskindex;
+    BOOST_CHECK(!(olddiskindex.nStatus & BLOCK_HAVE_MINTER_KEY));
+    BOOST_CHECK(olddiskindex.minterKeyID.IsNull());
+    BOOST_CHECK(ss.empty());
+
+    // and get written back once their key is recovered
+    TakeRecoveredMinterKeys();
+    CBlockIndex prev;
+    prev.phashBlock = &prev_hash;
+    index.pprev = &prev;
+    BOOST_CHECK(index.minterKey() == minterKey.GetPubKey().GetID());
+    auto recovered = TakeRecoveredMinterKeys();
+    BOOST_CHECK(recovered.size() == 1 && recovered[0] == &index);
+    index.minterKey();
+    BOOST_CHECK(TakeRecoveredMinterKeys().empty());
+    ss << CDiskBlockIndex(&index);
+    CDiskBlockIndex backfilled;
+    ss >> backfilled;
+    BOOST_CHECK(backfilled.nStatus & BLOCK_HAVE_MINTER_KEY);
+    BOOST_CHECK(backfilled.minterKeyID == minterKey.GetPubKey().GetID());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
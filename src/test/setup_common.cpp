@@ -11,6 +11,7 @@
 #include <consensus/validation.h>
 #include <crypto/sha256.h>
 #include <init.h>
+#include <masternodes/accountshistory.h>
 #include <masternodes/anchors.h>
 #include <masternodes/masternodes.h>
 #include <miner.h>
@@ -112,8 +113,13 @@ TestingSetup::TestingSetup(const std::string& chainName) : BasicTestingSetup(cha
         LOCK(cs_main);
 
         pcustomcsDB.reset();
-        pcustomcsDB = std::make_unique<CStorageLevelDB>(GetDataDir() / "enhancedcs", nMinDbCache << 20, true, true);
+        pcustomcsDB = std::make_unique<CStoragePrefixRouter>(std::make_shared<CStorageLevelDB>(GetDataDir() / "enhancedcs", nMinDbCache << 20, true, true));
+        auto undoDB = std::make_shared<CStorageLevelDB>(GetDataDir() / "enhancedcs_undo", nMinDbCache << 20, true, true);
+        pcustomcsDB->Route(CUndosView::ByUndoKey::prefix(), undoDB);
+        pcustomcsDB->Route(CUndosView::ByUndoBundleKey::prefix(), undoDB);
         pcustomcsview = std::make_unique<CCustomCSView>(*pcustomcsDB.get());
+        pcustomcsview->EnableMasternodeRegistry();
+        phistoryCollector = std::make_unique<CHistoryCollector>(false, false);
 
         panchorauths.reset();
         panchorauths = std::make_unique<CAnchorAuthIndex>();
@@ -155,6 +161,7 @@ TestingSetup::~TestingSetup()
     panchors.reset();
     panchorAwaitingConfirms.reset();
     panchorauths.reset();
+    phistoryCollector.reset();
     pcustomcsview.reset();
     pcustomcsDB.reset();
 
@@ -6,6 +6,7 @@
 #include <key_io.h>
 #include <masternodes/accountshistory.h>
 #include <masternodes/masternodes.h>
+#include <masternodes/mn_checks.h>
 #include <rpc/rawtransaction_util.h>
 #include <test/setup_common.h>
 
@@ -117,11 +118,80 @@ BOOST_AUTO_TEST_CASE(undo)
     BOOST_CHECK(snap2.size() - snap1.size() == 1); // undo
     BOOST_CHECK(snap2.size() - snapStart.size() == 2); // onew new record + undo
 
-    pcustomcsview->OnUndoTx(uint256S("0x1"), 2); // fail
+    BOOST_CHECK(!pcustomcsview->OnUndoTx(uint256S("0x1"), 2)); // fail
     BOOST_CHECK(snap2 == TakeSnapshot(base_raw));
-    pcustomcsview->OnUndoTx(uint256S("0x2"), 1); // fail
+    BOOST_CHECK(!pcustomcsview->OnUndoTx(uint256S("0x2"), 1)); // fail
     BOOST_CHECK(snap2 == TakeSnapshot(base_raw));
-    pcustomcsview->OnUndoTx(uint256S("0x1"), 1); // success
+    BOOST_CHECK(pcustomcsview->OnUndoTx(uint256S("0x1"), 1)); // success
+    BOOST_CHECK(snapStart == TakeSnapshot(base_raw));
+
+    // undo above the height of the state is left by a crash and gets dropped
+    pcustomcsview->SetUndo(UndoKey{1, uint256S("0x1")}, undo);
+    pcustomcsview->SetUndo(UndoKey{2, uint256S("0x1")}, undo);
+    pcustomcsview->SetUndoBundle(2, CUndoBundle{});
+    BOOST_CHECK_EQUAL(pcustomcsview->EraseUndosAbove(1), 2u);
+    BOOST_CHECK(pcustomcsview->GetUndo(UndoKey{1, uint256S("0x1")}));
+    BOOST_CHECK(!pcustomcsview->GetUndo(UndoKey{2, uint256S("0x1")}));
+    BOOST_CHECK(!pcustomcsview->GetUndoBundle(2));
+}
+
+// Connects a block of two txs and a block level change, all changing the same key
+static void ConnectUndoBlock(uint32_t height, uint256 const & tx1, uint256 const & tx2)
+{
+    CCustomCSView block(*pcustomcsview);
+    for (const auto& [txid, value] : std::vector<std::pair<uint256, std::string>>{{tx1, "value1"}, {tx2, "value2"}, {uint256(), "value3"}}) {
+        CCustomCSView tx(block);
+        tx.Write("bundlekey", value);
+        auto undo = CUndo::Construct(block.GetStorage(), tx.GetStorage().GetRaw());
+        tx.Flush();
+        block.SetUndo(UndoKey{height, txid}, undo);
+    }
+    block.BundleUndos(height, {tx1, tx2});
+    block.Flush();
+}
+
+static void DisconnectUndoBlock(uint32_t height, uint256 const & tx1, uint256 const & tx2)
+{
+    CCustomCSView block(*pcustomcsview);
+    auto bundled = block.TakeUndoBundle(height);
+    block.OnUndoTx(uint256(), height, &bundled);
+    block.OnUndoTx(tx2, height, &bundled);
+    block.OnUndoTx(tx1, height, &bundled);
+    BOOST_CHECK(bundled.empty());
+    block.Flush();
+}
+
+BOOST_AUTO_TEST_CASE(undoBundle)
+{
+    CStorageKV & base_raw = pcustomcsview->GetStorage();
+    pcustomcsview->Write("bundlekey", "value0");
+    auto snapStart = TakeSnapshot(base_raw);
+
+    const uint32_t height = 5;
+    const auto tx1 = uint256S("0x1"), tx2 = uint256S("0x2");
+    ConnectUndoBlock(height, tx1, tx2);
+
+    // a single record in tx order, the block level change first
+    BOOST_CHECK_EQUAL(TakeSnapshot(base_raw).size(), snapStart.size() + 1);
+    BOOST_CHECK(!pcustomcsview->GetUndo(UndoKey{height, tx1}));
+    auto bundle = pcustomcsview->GetUndoBundle(height);
+    BOOST_REQUIRE(bundle);
+    BOOST_REQUIRE_EQUAL(bundle->undos.size(), 3u);
+    BOOST_CHECK(bundle->undos[0].first == uint256());
+    BOOST_CHECK(bundle->undos[1].first == tx1);
+    BOOST_CHECK(bundle->undos[2].first == tx2);
+
+    DisconnectUndoBlock(height, tx1, tx2);
+    BOOST_CHECK(snapStart == TakeSnapshot(base_raw));
+
+    // unpacked bundles are undone per tx
+    ConnectUndoBlock(height, tx1, tx2);
+    BOOST_CHECK_EQUAL(pcustomcsview->UnbundleUndos(), 1u);
+    BOOST_CHECK(!pcustomcsview->GetUndoBundle(height));
+    BOOST_CHECK(pcustomcsview->GetUndo(UndoKey{height, tx1}));
+    BOOST_CHECK_EQUAL(TakeSnapshot(base_raw).size(), snapStart.size() + 3);
+
+    DisconnectUndoBlock(height, tx1, tx2);
     BOOST_CHECK(snapStart == TakeSnapshot(base_raw));
 }
 
@@ -465,4 +535,304 @@ BOOST_AUTO_TEST_CASE(LowerBoundTest)
     }
 }
 
+BOOST_AUTO_TEST_CASE(historyChanges)
+{
+    CHistoryCollector collector(true, false);
+    BOOST_REQUIRE(collector.accountView && collector.burnView && !collector.vaultView);
+
+    CScript owner = CScript() << OP_TRUE;
+    collector.accountView->WriteAccountHistory({owner, 10, 1}, {uint256S("0x1"), 0, {{DCT_ID{0}, 100}}});
+    collector.burnView->WriteAccountHistory({owner, 10, 2}, {uint256S("0x2"), 0, {{DCT_ID{1}, 5}}});
+
+    // collected changes are journaled and the collector starts over
+    auto changes = collector.Take(uint256S("0xb"));
+    BOOST_CHECK(!changes.IsEmpty());
+    BOOST_CHECK_EQUAL(changes.accounts.size(), 1);
+    BOOST_CHECK_EQUAL(changes.burns.size(), 1);
+    BOOST_CHECK(changes.vaults.empty());
+    BOOST_CHECK(collector.Take(uint256S("0xc")).IsEmpty());
+
+    pcustomcsview->SetHistoryChanges(10, changes);
+    auto journaled = pcustomcsview->GetHistoryChanges(10);
+    BOOST_REQUIRE(journaled);
+    BOOST_CHECK(journaled->blockHash == uint256S("0xb"));
+
+    // replaying the journal writes the history
+    CAccountHistoryStorage history(GetDataDir() / "history", 1 << 20, true, true);
+    history.ApplyChanges(journaled->accounts);
+    BOOST_CHECK(history.Flush());
+    auto value = history.ReadAccountHistory({owner, 10, 1});
+    BOOST_REQUIRE(value);
+    BOOST_CHECK(value->txid == uint256S("0x1"));
+    BOOST_CHECK(!history.ReadAccountHistory({owner, 10, 2}));
+
+    // and erasing the written keys rewinds it
+    MapKV erased;
+    for (const auto& change : journaled->accounts) {
+        erased.emplace(change.first, std::nullopt);
+    }
+    history.ApplyChanges(erased);
+    BOOST_CHECK(history.Flush());
+    BOOST_CHECK(!history.ReadAccountHistory({owner, 10, 1}));
+
+    pcustomcsview->DelHistoryChanges(10);
+    BOOST_CHECK(!pcustomcsview->GetHistoryChanges(10));
+}
+
+BOOST_AUTO_TEST_CASE(balanceCheckpoints)
+{
+    const auto entries = nBalanceCheckpointEntries, blocks = nBalanceCheckpointBlocks;
+    nBalanceCheckpointEntries = 2;
+    nBalanceCheckpointBlocks = 0;
+
+    CHistoryCollector collector(true, false);
+    CAccountHistoryStorage history(GetDataDir() / "checkpoints", 1 << 20, true, true);
+    CScript owner = CScript() << OP_TRUE;
+    CScript other = CScript() << OP_FALSE;
+
+    // owner gets 10 DFI a block, and pays 1 BTC out of 5 at height 3
+    for (uint32_t height = 1; height <= 5; ++height) {
+        collector.accountView->WriteAccountHistory({owner, height, 1}, {uint256S("0x1"), 0, {{DCT_ID{0}, 10}}});
+        if (height == 3) {
+            collector.accountView->WriteAccountHistory({owner, height, 2}, {uint256S("0x2"), 0, {{DCT_ID{1}, -1}}});
+            collector.accountView->WriteAccountHistory({other, height, 2}, {uint256S("0x2"), 0, {{DCT_ID{1}, 1}}});
+        }
+        if (height == 1) {
+            collector.accountView->WriteAccountHistory({owner, height, 0}, {uint256S("0x3"), 0, {{DCT_ID{1}, 5}}});
+        }
+        auto changes = collector.Take(uint256()).accounts;
+        history.AddBalanceCheckpoints(changes, height);
+        history.ApplyChanges(changes);
+        BOOST_CHECK(history.Flush());
+    }
+
+    std::vector<uint32_t> checkpoints;
+    history.ForEachBalanceCheckpoint([&](BalanceCheckpointKey const & key, CLazySerialize<CBalances>) {
+        if (key.owner == owner) {
+            checkpoints.push_back(key.blockHeight);
+        }
+        return true;
+    });
+    BOOST_CHECK(checkpoints == std::vector<uint32_t>({5, 3, 1}));
+
+    for (uint32_t height = 1; height <= 5; ++height) {
+        auto balances = history.GetBalancesAt(owner, height);
+        BOOST_CHECK_EQUAL(balances.balances[DCT_ID{0}], CAmount(10 * height));
+        BOOST_CHECK_EQUAL(balances.balances[DCT_ID{1}], height < 3 ? 5 : 4);
+    }
+    BOOST_CHECK(history.GetBalancesAt(owner, 0).balances.empty());
+    BOOST_CHECK(history.GetBalancesAt(other, 2).balances.empty());
+    BOOST_CHECK_EQUAL(history.GetBalancesAt(other, 5).balances[DCT_ID{1}], 1);
+
+    nBalanceCheckpointEntries = entries;
+    nBalanceCheckpointBlocks = blocks;
+}
+
+BOOST_AUTO_TEST_CASE(settlementCredits)
+{
+    CScript owner = CScript() << OP_TRUE;
+    CScript full = CScript() << OP_FALSE;
+    const auto height = 10;
+    const auto type = uint8_t(CustomTxType::FutureSwapExecution);
+
+    // full can only take 15 more DFI, so one of its credits fails
+    std::map<CScript, std::vector<CSettlementCredit>> credits;
+    credits[owner] = {{{DCT_ID{0}, 10}, 9, type}, {{DCT_ID{0}, 20}, 8, type}, {{DCT_ID{1}, 5}, 7, type}};
+    credits[full] = {{{DCT_ID{0}, 10}, 6, type}, {{DCT_ID{0}, 10}, 5, type}, {{DCT_ID{0}, 5}, 4, type}};
+
+    CCustomCSView base(*pcustomcsview);
+    base.AddBalance(full, {DCT_ID{0}, std::numeric_limits<CAmount>::max() - 15});
+
+    // every credit as a transaction of its own
+    CCustomCSView perContract(base);
+    CHistoryCollector perContractHistory(true, false);
+    for (const auto& [creditOwner, ownerCredits] : credits) {
+        for (const auto& credit : ownerCredits) {
+            CHistoryWriters writers{perContractHistory.accountView.get(), nullptr, nullptr};
+            CAccountsHistoryWriter view(perContract, height, credit.txn, {}, credit.type, &writers);
+            view.AddBalance(creditOwner, credit.amount);
+            view.Flush();
+        }
+    }
+
+    CCustomCSView settled(base);
+    CHistoryCollector settledHistory(true, false);
+    ApplySettlementCredits(settled, height, credits, settledHistory.accountView.get());
+
+    for (const auto& script : {owner, full}) {
+        for (const auto id : {DCT_ID{0}, DCT_ID{1}}) {
+            BOOST_CHECK_EQUAL(settled.GetBalance(script, id).nValue, perContract.GetBalance(script, id).nValue);
+        }
+    }
+    BOOST_CHECK_EQUAL(settled.GetBalance(owner, DCT_ID{0}).nValue, 30);
+    BOOST_CHECK_EQUAL(settled.GetBalance(full, DCT_ID{0}).nValue, std::numeric_limits<CAmount>::max());
+
+    // the failed credit has no history entry
+    BOOST_CHECK(settledHistory.accountView->ReadAccountHistory({full, height, 4}));
+    BOOST_CHECK(!settledHistory.accountView->ReadAccountHistory({full, height, 5}));
+    const auto history = settledHistory.Take(uint256()).accounts;
+    BOOST_CHECK(history == perContractHistory.Take(uint256()).accounts);
+    BOOST_CHECK_EQUAL(history.size(), 5);
+}
+
+BOOST_AUTO_TEST_CASE(storageSnapshot)
+{
+    CStorageLevelDB db(GetDataDir() / "snapshot", 1 << 20, true, true);
+    BOOST_CHECK(db.Write(ToBytes("flushed"), ToBytes("value0")));
+    BOOST_CHECK(db.Write(ToBytes("erased"), ToBytes("value0")));
+    BOOST_CHECK(db.Flush());
+
+    // the overlay shadows the database, as it does in CFlushableStorageKV
+    MapKV changed;
+    changed.emplace(ToBytes("pending"), ToBytes("value1"));
+    changed.emplace(ToBytes("erased"), std::nullopt);
+    CStorageSnapshot snapshot(db, changed);
+
+    // later writes to the database stay invisible
+    BOOST_CHECK(db.Write(ToBytes("flushed"), ToBytes("value2")));
+    BOOST_CHECK(db.Write(ToBytes("later"), ToBytes("value2")));
+    BOOST_CHECK(db.Flush());
+
+    TBytes value;
+    BOOST_CHECK(snapshot.Read(ToBytes("flushed"), value));
+    BOOST_CHECK(value == ToBytes("value0"));
+    BOOST_CHECK(snapshot.Read(ToBytes("pending"), value));
+    BOOST_CHECK(value == ToBytes("value1"));
+    BOOST_CHECK(!snapshot.Exists(ToBytes("erased")));
+    BOOST_CHECK(!snapshot.Exists(ToBytes("later")));
+
+    auto contents = TakeSnapshot(snapshot);
+    BOOST_CHECK_EQUAL(contents.size(), 2);
+    BOOST_CHECK(contents.at(ToBytes("flushed")) == ToBytes("value0"));
+    BOOST_CHECK(contents.at(ToBytes("pending")) == ToBytes("value1"));
+
+    // views on top of it keep their changes to themselves
+    CCustomCSView view(snapshot);
+    BOOST_CHECK(view.Write("viewkey", "value3"));
+    BOOST_CHECK(!snapshot.Write(ToBytes("viewkey"), ToBytes("value3")));
+    BOOST_CHECK(!view.Flush());
+    BOOST_CHECK(!snapshot.Exists(ToBytes("viewkey")));
+}
+
+BOOST_AUTO_TEST_CASE(storagePrefixRouter)
+{
+    auto primary = std::make_shared<CStorageLevelDB>(GetDataDir() / "router", 1 << 20, true, true);
+    auto routed = std::make_shared<CStorageLevelDB>(GetDataDir() / "router_u", 1 << 20, true, true);
+    BOOST_CHECK(primary->Write(ToBytes("a1"), ToBytes("v")));
+    BOOST_CHECK(primary->Write(ToBytes("u1"), ToBytes("v")));
+    BOOST_CHECK(primary->Flush());
+
+    CStoragePrefixRouter router(primary);
+    router.Route('u', routed);
+
+    // existing keys of the prefix have to be moved over
+    size_t moved = 0;
+    BOOST_CHECK(MoveStoragePrefix(*primary, *routed, 'u', moved));
+    BOOST_CHECK_EQUAL(moved, 1);
+    BOOST_CHECK(!primary->Exists(ToBytes("u1")));
+    BOOST_CHECK(routed->Exists(ToBytes("u1")));
+    BOOST_CHECK(router.Exists(ToBytes("u1")));
+
+    for (const auto key : {"b1", "u2", "z1", "t1"}) {
+        BOOST_CHECK(router.Write(ToBytes(key), ToBytes("v")));
+    }
+    BOOST_CHECK(router.Erase(ToBytes("a1")));
+    BOOST_CHECK(router.Flush());
+    BOOST_CHECK(routed->Exists(ToBytes("u2")));
+    BOOST_CHECK(!primary->Exists(ToBytes("u2")));
+    BOOST_CHECK(primary->Exists(ToBytes("z1")));
+
+    // iteration merges both databases in key order, in both directions
+    std::vector<TBytes> expected{ToBytes("b1"), ToBytes("t1"), ToBytes("u1"), ToBytes("u2"), ToBytes("z1")};
+    std::vector<TBytes> keys;
+    auto it = router.NewIterator();
+    for (it->Seek({}); it->Valid(); it->Next()) {
+        keys.push_back(it->Key());
+    }
+    BOOST_CHECK(keys == expected);
+
+    keys.clear();
+    for (it->SeekToLast(); it->Valid(); it->Prev()) {
+        keys.insert(keys.begin(), it->Key());
+    }
+    BOOST_CHECK(keys == expected);
+
+    it->Seek(ToBytes("u2"));
+    it->Prev();
+    BOOST_CHECK(it->Key() == ToBytes("u1"));
+    it->Prev();
+    BOOST_CHECK(it->Key() == ToBytes("t1"));
+    it->Next();
+    it->Next();
+    BOOST_CHECK(it->Key() == ToBytes("u2"));
+    it->Next();
+    BOOST_CHECK(it->Key() == ToBytes("z1"));
+
+    // snapshots cover the routed database too
+    CStorageSnapshot snapshot(router, {});
+    BOOST_CHECK(router.Erase(ToBytes("u1")));
+    BOOST_CHECK(router.Flush());
+    BOOST_CHECK(!router.Exists(ToBytes("u1")));
+    BOOST_CHECK(snapshot.Exists(ToBytes("u1")));
+    BOOST_CHECK_EQUAL(TakeSnapshot(snapshot).size(), 5);
+
+    // and views on top of the router find the routed keys
+    CCustomCSView view(router);
+    BOOST_CHECK(view.Write("key", "value"));
+    BOOST_CHECK(view.SetUndo(UndoKey{1, uint256()}, CUndo{}));
+    BOOST_CHECK(view.Flush());
+    BOOST_CHECK(view.GetUndo(UndoKey{1, uint256()}));
+    BOOST_CHECK(router.Flush());
+    BOOST_CHECK(CCustomCSView(*routed).GetUndo(UndoKey{1, uint256()}));
+
+    // erasures of routed keys are only applied after the primary database is written
+    BOOST_CHECK(router.Erase(ToBytes("u2")));
+    BOOST_CHECK(router.Write(ToBytes("b2"), ToBytes("v")));
+    BOOST_CHECK(routed->Flush());
+    BOOST_CHECK(routed->Exists(ToBytes("u2")));
+    BOOST_CHECK(router.Flush());
+    BOOST_CHECK(primary->Exists(ToBytes("b2")));
+    BOOST_CHECK(!routed->Exists(ToBytes("u2")));
+
+    // and a write of the key after its erasure keeps it
+    BOOST_CHECK(router.Erase(ToBytes("u1")));
+    BOOST_CHECK(router.Write(ToBytes("u1"), ToBytes("v")));
+    BOOST_CHECK(router.Flush());
+    BOOST_CHECK(routed->Exists(ToBytes("u1")));
+}
+
+struct TestKeys { static constexpr uint8_t prefix() { return 0xF0; } };
+
+template<typename KeyType>
+static bool EncodedAsSerialized(const KeyType& key)
+{
+    return CStorageKey<TestKeys, KeyType>(key).Bytes() == DbTypeToBytes(std::make_pair(TestKeys::prefix(), key));
+}
+
+BOOST_AUTO_TEST_CASE(storageKeys)
+{
+    static_assert(UniqueStoragePrefixes<TestForward, TestBackward, TestKeys>());
+    static_assert(!UniqueStoragePrefixes<TestForward, TestKeys, TestForward>());
+
+    const auto txid = uint256S("0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef");
+    for (uint32_t n : {0u, 1u, 127u, 128u, 255u, 16511u, 16512u, 2097279u, 2097280u, std::numeric_limits<uint32_t>::max()}) {
+        BOOST_CHECK(EncodedAsSerialized(n));
+        BOOST_CHECK(EncodedAsSerialized(int64_t(n) - 1));
+        BOOST_CHECK(EncodedAsSerialized(DCT_ID{n}));
+        BOOST_CHECK(EncodedAsSerialized(std::make_pair(DCT_ID{n}, txid)));
+        BOOST_CHECK(EncodedAsSerialized(std::make_pair(n, txid)));
+    }
+    BOOST_CHECK(EncodedAsSerialized(uint8_t(7)));
+    BOOST_CHECK(EncodedAsSerialized(txid));
+    BOOST_CHECK(EncodedAsSerialized(std::make_pair(txid, uint256())));
+
+    // keys written serialized are found encoded
+    CCustomCSView view(*pcustomcsview);
+    BOOST_CHECK(view.WriteBy<TestKeys>(std::make_pair(DCT_ID{300}, txid), 5));
+    BOOST_CHECK(view.ExistsBy<TestKeys>(std::make_pair(DCT_ID{300}, txid)));
+    BOOST_CHECK(!view.ExistsBy<TestKeys>(std::make_pair(DCT_ID{301}, txid)));
+    auto value = view.ReadBy<TestKeys, int>(std::make_pair(DCT_ID{300}, txid));
+    BOOST_CHECK(value && *value == 5);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
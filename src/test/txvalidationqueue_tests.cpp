@@ -0,0 +1,88 @@
+// Copyright (c) 2021 The DeFi Blockchain Developers
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#include <protocol.h>
+#include <txvalidationqueue.h>
+#include <util/time.h>
+
+#include <test/setup_common.h>
+
+#include <condition_variable>
+#include <mutex>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(txvalidationqueue_tests, BasicTestingSetup)
+
+static CTransactionRef MakeTx(uint32_t lockTime)
+{
+    CMutableTransaction tx;
+    tx.nLockTime = lockTime;
+    return MakeTransactionRef(tx);
+}
+
+static void WaitFor(const CTxValidationQueue& queue, uint64_t processed)
+{
+    for (int i = 0; i < 5000 && queue.GetStats().processed < processed; ++i) {
+        MilliSleep(1);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(block_ahead_of_queued_txs)
+{
+    std::mutex mutex;
+    std::condition_variable cond;
+    bool release{false};
+
+    CTxValidationQueue queue([&](CNode*, const CTransactionRef&) {
+        std::unique_lock<std::mutex> lock(mutex);
+        cond.wait(lock, [&] { return release; });
+    }, 10, 2);
+    queue.Start();
+
+    CAddress addr(CService(), NODE_NONE);
+    CNode node(0, ServiceFlags(NODE_NETWORK), 0, INVALID_SOCKET, addr, 0, 0, CAddress(), "", /*fInboundIn=*/ true);
+    BOOST_CHECK(queue.CanProcess(node.GetId(), NetMsgType::TX));
+    BOOST_CHECK(queue.Push(&node, MakeTx(1)));
+    BOOST_CHECK(queue.Push(&node, MakeTx(2)));
+
+    // the peer's share is full and its other messages wait, but its blocks and headers don't
+    BOOST_CHECK(!queue.CanProcess(node.GetId(), NetMsgType::TX));
+    BOOST_CHECK(!queue.CanProcess(node.GetId(), NetMsgType::PING));
+    BOOST_CHECK(!queue.CanProcess(node.GetId(), NetMsgType::GETDATA));
+    BOOST_CHECK(queue.CanProcess(node.GetId(), NetMsgType::BLOCK));
+    BOOST_CHECK(queue.CanProcess(node.GetId(), NetMsgType::CMPCTBLOCK));
+    BOOST_CHECK(queue.CanProcess(node.GetId(), NetMsgType::BLOCKTXN));
+    BOOST_CHECK(queue.CanProcess(node.GetId(), NetMsgType::HEADERS));
+
+    {
+        // the block is processed with the peer's transactions still queued
+        CTxValidationQueue::BlockGuard guard(queue);
+        BOOST_CHECK(queue.GetStats().blockPending);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            release = true;
+        }
+        cond.notify_all();
+
+        // the validation in progress completes, the next one waits for the block
+        WaitFor(queue, 1);
+        MilliSleep(50);
+        auto stats = queue.GetStats();
+        BOOST_CHECK_EQUAL(stats.processed, 1U);
+        BOOST_CHECK_EQUAL(stats.queued, 1U);
+        BOOST_CHECK(!queue.CanProcess(node.GetId(), NetMsgType::PING));
+    }
+
+    WaitFor(queue, 2);
+    auto stats = queue.GetStats();
+    BOOST_CHECK_EQUAL(stats.processed, 2U);
+    BOOST_CHECK_EQUAL(stats.queued, 0U);
+    BOOST_CHECK(!stats.blockPending);
+    BOOST_CHECK(queue.CanProcess(node.GetId(), NetMsgType::PING));
+
+    queue.Stop();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
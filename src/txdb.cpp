@@ -271,7 +271,7 @@ bool CBlockTreeDB::LoadBlockIndexGuts(const Consensus::Params& consensusParams,
                 pindexNew->hashMerkleRoot = diskindex.hashMerkleRoot;
                 pindexNew->nTime          = diskindex.nTime;
                 pindexNew->nBits          = diskindex.nBits;
-                pindexNew->nStatus        = diskindex.nStatus;
+                pindexNew->nStatus        = diskindex.nStatus & ~BLOCK_HAVE_MINTER_KEY;
                 pindexNew->nTx            = diskindex.nTx;
 
                 //PoS
@@ -279,6 +279,7 @@ bool CBlockTreeDB::LoadBlockIndexGuts(const Consensus::Params& consensusParams,
                 pindexNew->deprecatedHeight = diskindex.deprecatedHeight;
                 pindexNew->mintedBlocks = diskindex.mintedBlocks;
                 pindexNew->sig = diskindex.sig;
+                pindexNew->minterKeyID = diskindex.minterKeyID;
                 if (pindexNew->nHeight && !skipSigCheck) {
                     if (!CPubKey::TryRecoverSigCompat(pindexNew->sig)) {
                         return error("%s: The block index #%d (%s) wasn't saved on disk correctly. Index content: %s", __func__, pindexNew->nHeight, pindexNew->GetBlockHash().ToString(), pindexNew->ToString());
@@ -37,6 +37,10 @@ static const int64_t nMaxBlockDBCache = 4;
 // Unlike for the UTXO database, for the txindex scenario the leveldb cache make
 // a meaningful difference: https://github.com/bitcoin/bitcoin/pull/8273#issuecomment-229601991
 static const int64_t nMaxTxIndexCache = 1024;
+//! Max memory allocated to each account, burn and vault history DB specific cache (MiB)
+static const int64_t nMaxHistoryDBCache = 32;
+//! Max memory allocated to custom state undo DB specific cache (MiB)
+static const int64_t nMaxCustomUndoDBCache = 64;
 //! Max memory allocated to all block filter index caches combined in MiB.
 static const int64_t max_filter_index_cache = 1024;
 //! Max memory allocated to coin DB specific cache (MiB)
@@ -32,7 +32,7 @@
 class CBlockIndex;
 class CChainParams;
 class CCustomCSView;
-extern CCriticalSection cs_main;
+extern WaitTimedRecursiveMutex cs_main;
 
 /** Fake height value used in Coin to signify they are only in the memory pool (since 0.8) */
 static const uint32_t MEMPOOL_HEIGHT = 0x7FFFFFFF;
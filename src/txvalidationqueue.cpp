@@ -0,0 +1,183 @@
+// Copyright (c) DeFi Blockchain Developers
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#include <txvalidationqueue.h>
+#include <protocol.h>
+#include <util/system.h>
+#include <util/time.h>
+
+std::unique_ptr<CTxValidationQueue> g_txvalidationqueue;
+
+CTxValidationQueue::BlockGuard::BlockGuard(CTxValidationQueue& queue_) : queue(queue_)
+{
+    LOCK(queue.cs);
+    ++queue.blocksPending;
+}
+
+CTxValidationQueue::BlockGuard::~BlockGuard()
+{
+    LOCK(queue.cs);
+    if (--queue.blocksPending == 0) {
+        queue.cond.notify_one();
+    }
+}
+
+CTxValidationQueue::CTxValidationQueue(Validator validator_, size_t maxSize_, size_t maxPeerSize_)
+    : validator(std::move(validator_)), maxSize(maxSize_), maxPeerSize(maxPeerSize_)
+{
+}
+
+CTxValidationQueue::~CTxValidationQueue()
+{
+    Stop();
+}
+
+void CTxValidationQueue::Start()
+{
+    {
+        LOCK(cs);
+        running = true;
+        interrupted = false;
+    }
+    thread = std::thread(&TraceThread<std::function<void()>>, "txvalidation",
+                         std::bind(&CTxValidationQueue::ThreadValidate, this));
+}
+
+void CTxValidationQueue::Interrupt()
+{
+    LOCK(cs);
+    interrupted = true;
+    cond.notify_one();
+}
+
+void CTxValidationQueue::Stop()
+{
+    Interrupt();
+    if (thread.joinable()) {
+        thread.join();
+    }
+
+    LOCK(cs);
+    running = false;
+    for (const auto& [id, queue] : queues) {
+        for (const auto& entry : queue) {
+            Release(entry);
+        }
+        stats.dropped += queue.size();
+    }
+    queues.clear();
+    size = 0;
+}
+
+bool CTxValidationQueue::CanProcess(NodeId id, const std::string& command) const
+{
+    if (IsBlockMessage(command)) {
+        return true;
+    }
+    LOCK(cs);
+    if (!running) {
+        return true;
+    }
+    auto it = queues.find(id);
+    if (command != NetMsgType::TX) {
+        return it == queues.end();
+    }
+    return size < maxSize && (it == queues.end() || it->second.size() < maxPeerSize);
+}
+
+bool CTxValidationQueue::Contains(const uint256& txid) const
+{
+    LOCK(cs);
+    return txids.count(txid) != 0;
+}
+
+bool CTxValidationQueue::Push(CNode* pfrom, const CTransactionRef& tx)
+{
+    LOCK(cs);
+    if (!running || interrupted) {
+        return false;
+    }
+    queues[pfrom->GetId()].push_back({pfrom->AddRef(), tx, GetTimeMicros()});
+    txids.insert(tx->GetHash());
+    ++size;
+    cond.notify_one();
+    return true;
+}
+
+CTxValidationQueue::Stats CTxValidationQueue::GetStats() const
+{
+    LOCK(cs);
+    auto result = stats;
+    result.queued = size;
+    result.peers = queues.size();
+    result.blockPending = blocksPending > 0;
+    return result;
+}
+
+bool CTxValidationQueue::IsBlockMessage(const std::string& command)
+{
+    return command == NetMsgType::BLOCK || command == NetMsgType::CMPCTBLOCK ||
+           command == NetMsgType::BLOCKTXN || command == NetMsgType::HEADERS;
+}
+
+void CTxValidationQueue::Release(const Entry& entry)
+{
+    txids.erase(txids.find(entry.tx->GetHash()));
+    entry.node->Release();
+}
+
+void CTxValidationQueue::ThreadValidate()
+{
+    while (true) {
+        Entry entry;
+        bool disconnected;
+        {
+            WAIT_LOCK(cs, lock);
+            while (!interrupted && (size == 0 || blocksPending > 0)) {
+                cond.wait(lock);
+            }
+            if (interrupted) {
+                return;
+            }
+
+            auto it = queues.upper_bound(lastPeer);
+            if (it == queues.end()) {
+                it = queues.begin();
+            }
+            lastPeer = it->first;
+
+            // stays queued while being validated, so that the peer's next messages keep waiting
+            entry = it->second.front();
+            disconnected = entry.node->fDisconnect;
+            if (disconnected) {
+                ++stats.dropped;
+            } else {
+                const auto waitTime = GetTimeMicros() - entry.time;
+                stats.waitTime += waitTime;
+                stats.maxWaitTime = std::max(stats.maxWaitTime, waitTime);
+            }
+        }
+
+        int64_t validationTime{0};
+        if (!disconnected) {
+            const auto start = GetTimeMicros();
+            validator(entry.node, entry.tx);
+            validationTime = GetTimeMicros() - start;
+        }
+
+        LOCK(cs);
+        if (!disconnected) {
+            ++stats.processed;
+            stats.validationTime += validationTime;
+            stats.maxValidationTime = std::max(stats.maxValidationTime, validationTime);
+        }
+        auto it = queues.find(lastPeer);
+        it->second.pop_front();
+        if (it->second.empty()) {
+            queues.erase(it);
+        }
+        --size;
+        Release(entry);
+    }
+}
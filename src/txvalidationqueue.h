@@ -0,0 +1,113 @@
+// Copyright (c) DeFi Blockchain Developers
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef DEFI_TXVALIDATIONQUEUE_H
+#define DEFI_TXVALIDATIONQUEUE_H
+
+#include <net.h>
+#include <primitives/transaction.h>
+#include <sync.h>
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <set>
+#include <thread>
+
+/** Default for -txvalidationthread */
+static const bool DEFAULT_TX_VALIDATION_THREAD = true;
+/** Default for -maxtxvalidationqueue, transactions waiting for validation over all peers */
+static const unsigned int DEFAULT_MAX_TX_VALIDATION_QUEUE = 5000;
+/** Transactions of a single peer waiting for validation, the rest of its messages wait in its receive queue */
+static const unsigned int MAX_PEER_TX_VALIDATION_QUEUE = 100;
+
+/**
+ * Validates the transactions received from peers on a thread of its own, so that
+ * the expensive custom tx checks don't hold up the message handler. Peers are
+ * served round robin, one transaction at a time, and transactions wait while
+ * blocks are being processed.
+ *
+ * A peer's messages other than transactions are held back until its queued
+ * transactions are done, which keeps the order of responses, and so are its
+ * transactions while its share of the queue is full. Blocks and headers don't
+ * depend on the order of transactions and go ahead of them.
+ */
+class CTxValidationQueue
+{
+public:
+    using Validator = std::function<void(CNode*, const CTransactionRef&)>;
+
+    struct Stats {
+        size_t queued{0};
+        size_t peers{0};
+        uint64_t processed{0};
+        uint64_t dropped{0}; // of disconnected peers
+        int64_t waitTime{0}; // microseconds in the queue, summed up
+        int64_t maxWaitTime{0};
+        int64_t validationTime{0}; // microseconds
+        int64_t maxValidationTime{0};
+        bool blockPending{false};
+    };
+
+    /** Holds back transaction validation for its lifetime */
+    class BlockGuard
+    {
+        CTxValidationQueue& queue;
+
+    public:
+        explicit BlockGuard(CTxValidationQueue& queue_);
+        ~BlockGuard();
+    };
+
+    CTxValidationQueue(Validator validator_, size_t maxSize_, size_t maxPeerSize_);
+    ~CTxValidationQueue();
+
+    void Start();
+    void Interrupt();
+    /** Joins the thread and releases the queued transactions, must be called before the nodes are deleted */
+    void Stop();
+
+    /** Whether the next message of a peer can be processed now */
+    bool CanProcess(NodeId id, const std::string& command) const;
+    bool Contains(const uint256& txid) const;
+    /** Queues a transaction, false if it has to be validated by the caller as the queue is stopped */
+    bool Push(CNode* pfrom, const CTransactionRef& tx);
+
+    Stats GetStats() const;
+
+    /** Block and header messages, they preempt the validation of transactions */
+    static bool IsBlockMessage(const std::string& command);
+
+private:
+    struct Entry {
+        CNode* node{nullptr};
+        CTransactionRef tx;
+        int64_t time{0}; // queued at
+    };
+
+    void ThreadValidate();
+    void Release(const Entry& entry) EXCLUSIVE_LOCKS_REQUIRED(cs);
+
+    const Validator validator;
+    const size_t maxSize;
+    const size_t maxPeerSize;
+
+    mutable Mutex cs;
+    std::condition_variable cond;
+    std::map<NodeId, std::deque<Entry>> queues GUARDED_BY(cs);
+    std::multiset<uint256> txids GUARDED_BY(cs); // the same tx may be queued by several peers
+    size_t size GUARDED_BY(cs){0};
+    NodeId lastPeer GUARDED_BY(cs){-1};
+    int blocksPending GUARDED_BY(cs){0};
+    bool running GUARDED_BY(cs){false};
+    bool interrupted GUARDED_BY(cs){false};
+    Stats stats GUARDED_BY(cs);
+    std::thread thread;
+};
+
+extern std::unique_ptr<CTxValidationQueue> g_txvalidationqueue;
+
+#endif // DEFI_TXVALIDATIONQUEUE_H
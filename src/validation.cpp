@@ -6,6 +6,7 @@
 #include <validation.h>
 
 #include <arith_uint256.h>
+#include <blockprefetcher.h>
 #include <chain.h>
 #include <chainparams.h>
 #include <checkqueue.h>
@@ -13,11 +14,13 @@
 #include <consensus/merkle.h>
 #include <consensus/tx_check.h>
 #include <consensus/tx_verify.h>
+#include <connectstats.h>
 #include <consensus/validation.h>
 #include <core_io.h> /// ValueFromAmount
 #include <cuckoocache.h>
 #include <flatfile.h>
 #include <hash.h>
+#include <index/historyindex.h>
 #include <index/txindex.h>
 #include <masternodes/accountshistory.h>
 #include <masternodes/anchors.h>
@@ -124,7 +127,7 @@ CChain& ChainActive() {
  * The transaction pool has a separate lock to allow reading from it and the
  * chainstate at the same time.
  */
-RecursiveMutex cs_main;
+WaitTimedRecursiveMutex cs_main;
 
 CBlockIndex *pindexBestHeader = nullptr;
 Mutex g_best_block_mutex;
@@ -162,8 +165,7 @@ CTxMemPool mempool(&feeEstimator);
 CScript COINBASE_FLAGS;
 
 // used for db compacting
-TBytes compactBegin;
-TBytes compactEnd;
+std::vector<std::pair<TBytes, TBytes>> compactRanges;
 
 // Internal stuff
 namespace {
@@ -1040,7 +1042,7 @@ static bool WriteBlockToDisk(const CBlock& block, FlatFilePos& pos, const CMessa
     return true;
 }
 
-bool ReadBlockFromDisk(CBlock& block, const FlatFilePos& pos, const Consensus::Params& consensusParams)
+static bool ReadBlockFromDiskUnchecked(CBlock& block, const FlatFilePos& pos)
 {
     block.SetNull();
 
@@ -1057,6 +1059,14 @@ bool ReadBlockFromDisk(CBlock& block, const FlatFilePos& pos, const Consensus::P
         return error("%s: Deserialize or I/O error - %s at %s", __func__, e.what(), pos.ToString());
     }
 
+    return true;
+}
+
+bool ReadBlockFromDisk(CBlock& block, const FlatFilePos& pos, const Consensus::Params& consensusParams)
+{
+    if (!ReadBlockFromDiskUnchecked(block, pos))
+        return false;
+
     // Check the header
     if (!pos::CheckHeaderSignature(block))
         return error("ReadBlockFromDisk: Errors in block header at %s", pos.ToString());
@@ -1073,16 +1083,29 @@ bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex, const Consensus
     }
 
     FlatFilePos blockPos;
+    CKeyID minterKeyID;
     {
         LOCK(cs_main);
         blockPos = pindex->GetBlockPos();
+        minterKeyID = pindex->minterKeyID;
     }
+    return ReadBlockFromDisk(block, blockPos, pindex->GetBlockHash(), minterKeyID);
+}
 
-    if (!ReadBlockFromDisk(block, blockPos, consensusParams))
+bool ReadBlockFromDisk(CBlock& block, const FlatFilePos& pos, const uint256& hash, const CKeyID& minterKeyID)
+{
+    if (!ReadBlockFromDiskUnchecked(block, pos))
         return false;
-    if (block.GetHash() != pindex->GetBlockHash())
+    if (block.GetHash() != hash)
         return error("ReadBlockFromDisk(CBlock&, CBlockIndex*): GetHash() doesn't match index for %s at %s",
-                pindex->ToString(), pindex->GetBlockPos().ToString());
+                hash.ToString(), pos.ToString());
+
+    // The index recovered the minter key from this very header when accepting it
+    if (!minterKeyID.IsNull()) {
+        block.SetMinterKey(minterKeyID);
+    } else if (!pos::CheckHeaderSignature(block)) {
+        return error("ReadBlockFromDisk: Errors in block header at %s", pos.ToString());
+    }
     return true;
 }
 
@@ -1542,7 +1565,7 @@ bool CheckInputs(const CTransaction& tx, CValidationState &state, const CCoinsVi
     return true;
 }
 
-static bool UndoWriteToDisk(const CBlockUndo& blockundo, FlatFilePos& pos, const uint256& hashBlock, const CMessageHeader::MessageStartChars& messageStart)
+static bool UndoWriteToDisk(const CBlockUndo& blockundo, unsigned int nSize, FlatFilePos& pos, const uint256& hashBlock, const CMessageHeader::MessageStartChars& messageStart)
 {
     // Open history file to append
     CAutoFile fileout(OpenUndoFile(pos), SER_DISK, CLIENT_VERSION);
@@ -1550,7 +1573,6 @@ static bool UndoWriteToDisk(const CBlockUndo& blockundo, FlatFilePos& pos, const
         return error("%s: OpenUndoFile failed", __func__);
 
     // Write index header
-    unsigned int nSize = GetSerializeSize(blockundo, fileout.GetVersion());
     fileout << messageStart << nSize;
 
     // Write undo data
@@ -1712,23 +1734,20 @@ DisconnectResult CChainState::DisconnectBlock(const CBlock& block, const CBlockI
         return DISCONNECT_FAILED;
     }
 
-    // special case: possible undo (first) of custom 'complex changes' for the whole block (expired orders and/or prices)
-    mnview.OnUndoTx(uint256(), (uint32_t) pindex->nHeight); // undo for "zero hash"
+    // undo of the custom txs of the block, in a single read if it got bundled
+    auto bundledUndos = mnview.TakeUndoBundle(pindex->nHeight);
 
-    if (pindex->nHeight >= Params().GetConsensus().FortCanningHeight) {
-        // erase auction fee history
-        pburnHistoryDB->EraseAccountHistory({Params().GetConsensus().burnAddress, uint32_t(pindex->nHeight), ~0u});
-        if (paccountHistoryDB) {
-            paccountHistoryDB->EraseAuctionHistoryHeight(pindex->nHeight);
-        }
-        if (pvaultHistoryDB) {
-            pvaultHistoryDB->EraseVaultHistory(pindex->nHeight);
-        }
-    }
+    // special case: possible undo (first) of custom 'complex changes' for the whole block (expired orders and/or prices)
+    mnview.OnUndoTx(uint256(), (uint32_t) pindex->nHeight, &bundledUndos); // undo for "zero hash"
 
     // Undo community balance increments
     ReverseGeneralCoinbaseTx(mnview, pindex->nHeight);
 
+    // custom txs applied since the undo got complete left an undo record each, see ApplyCustomTx
+    const auto undoCompleteHeight = mnview.GetUndoCompleteHeight();
+    const auto undoComplete = undoCompleteHeight && pindex->nHeight >= static_cast<int>(*undoCompleteHeight)
+                           && pindex->nHeight >= Params().GetConsensus().DakotaHeight;
+
     CKeyID minterKey;
     std::optional<uint256> nodeId;
 
@@ -1740,8 +1759,6 @@ DisconnectResult CChainState::DisconnectBlock(const CBlock& block, const CBlockI
         assert(nodeId);
     }
 
-    std::vector<AccountHistoryKey> eraseBurnEntries;
-
     // undo transactions in reverse order
     for (int i = block.vtx.size() - 1; i >= 0; i--) {
         const CTransaction &tx = *(block.vtx[i]);
@@ -1804,12 +1821,6 @@ DisconnectResult CChainState::DisconnectBlock(const CBlock& block, const CBlockI
                 if (!is_spent || tx.vout[o] != coin.out || pindex->nHeight != coin.nHeight || is_coinbase != coin.fCoinBase) {
                     fClean = false; // transaction output mismatch
                 }
-
-                // Check for burn outputs
-                if (tx.vout[o].scriptPubKey == Params().GetConsensus().burnAddress)
-                {
-                    eraseBurnEntries.push_back({Params().GetConsensus().burnAddress, static_cast<uint32_t>(pindex->nHeight), static_cast<uint32_t>(i)});
-                }
             }
         }
 
@@ -1831,14 +1842,20 @@ DisconnectResult CChainState::DisconnectBlock(const CBlock& block, const CBlockI
         }
 
         // process transactions revert for masternodes
-        mnview.OnUndoTx(tx.GetHash(), (uint32_t) pindex->nHeight);
-        CHistoryErasers erasers{paccountHistoryDB.get(), pburnHistoryDB.get(), pvaultHistoryDB.get()};
-        auto res = RevertCustomTx(mnview, view, tx, Params().GetConsensus(), (uint32_t) pindex->nHeight, i, erasers);
-        if (!res) {
-            LogPrintf("%s\n", res.msg);
+        if (!mnview.OnUndoTx(tx.GetHash(), (uint32_t) pindex->nHeight, &bundledUndos) && undoComplete && !is_coinbase) {
+            std::vector<unsigned char> metadata;
+            if (GuessCustomTxType(tx, metadata, pindex->nHeight >= Params().GetConsensus().FortCanningHeight) != CustomTxType::None) {
+                error("DisconnectBlock(): missing undo of custom tx %s", hash.ToString());
+                return DISCONNECT_FAILED;
+            }
         }
     }
 
+    if (!bundledUndos.empty()) {
+        error("DisconnectBlock(): block and custom undo data inconsistent");
+        return DISCONNECT_FAILED;
+    }
+
     // one time downgrade to revert CInterestRateV2 structure
     if (pindex->nHeight == Params().GetConsensus().FortCanningHillHeight) {
         auto time = GetTimeMillis();
@@ -1847,41 +1864,6 @@ DisconnectResult CChainState::DisconnectBlock(const CBlock& block, const CBlockI
         LogPrint(BCLog::BENCH, "    - Interest rate reverting took: %dms\n", GetTimeMillis() - time);
     }
 
-    // Remove burn balance transfers
-    if (pindex->nHeight == Params().GetConsensus().EunosHeight)
-    {
-        // Make sure to initialize lastTxOut, otherwise it never finds the block and
-        // ends up looping through uninitialized garbage value.
-        uint32_t lastTxOut = 0;
-        auto shouldContinueToNextAccountHistory = [&lastTxOut, block](AccountHistoryKey const & key, CLazySerialize<AccountHistoryValue> valueLazy) -> bool
-        {
-            if (key.owner != Params().GetConsensus().burnAddress) {
-                return false;
-            }
-
-            if (key.blockHeight != static_cast<uint32_t>(Params().GetConsensus().EunosHeight)) {
-                return false;
-            }
-
-            lastTxOut = key.txn;
-
-            return false;
-        };
-
-        AccountHistoryKey startKey({Params().GetConsensus().burnAddress, static_cast<uint32_t>(Params().GetConsensus().EunosHeight), std::numeric_limits<uint32_t>::max()});
-        pburnHistoryDB->ForEachAccountHistory(shouldContinueToNextAccountHistory, startKey);
-
-        for (uint32_t i = block.vtx.size(); i <= lastTxOut; ++i) {
-            pburnHistoryDB->EraseAccountHistory({Params().GetConsensus().burnAddress, static_cast<uint32_t>(Params().GetConsensus().EunosHeight), i});
-        }
-    }
-
-    // Erase any UTXO burns
-    for (const auto& entries : eraseBurnEntries)
-    {
-        pburnHistoryDB->EraseAccountHistory(entries);
-    }
-
     // move best block pointer to prevout block
     view.SetBestBlock(pindex->pprev->GetBlockHash());
 
@@ -1915,15 +1897,18 @@ void static FlushBlockFile(bool fFinalize = false)
 
 static bool FindUndoPos(CValidationState &state, int nFile, FlatFilePos &pos, unsigned int nAddSize);
 
-static bool WriteUndoDataForBlock(const CBlockUndo& blockundo, CValidationState& state, CBlockIndex* pindex, const CChainParams& chainparams)
+static bool WriteUndoDataForBlock(const CBlockUndo& blockundo, CValidationState& state, CBlockIndex* pindex, const CChainParams& chainparams, size_t* written = nullptr)
 {
     // Write undo information to disk
     if (pindex->GetUndoPos().IsNull()) {
+        const unsigned int nSize = ::GetSerializeSize(blockundo, CLIENT_VERSION);
         FlatFilePos _pos;
-        if (!FindUndoPos(state, pindex->nFile, _pos, ::GetSerializeSize(blockundo, CLIENT_VERSION) + 40))
+        if (!FindUndoPos(state, pindex->nFile, _pos, nSize + 40))
             return error("ConnectBlock(): FindUndoPos failed");
-        if (!UndoWriteToDisk(blockundo, _pos, pindex->pprev->GetBlockHash(), chainparams.MessageStart()))
+        if (!UndoWriteToDisk(blockundo, nSize, _pos, pindex->pprev->GetBlockHash(), chainparams.MessageStart()))
             return AbortNode(state, "Failed to write undo data");
+        if (written)
+            *written = nSize;
 
         // update nUndoPos in block index
         pindex->nUndoPos = _pos.nPos;
@@ -1934,6 +1919,14 @@ static bool WriteUndoDataForBlock(const CBlockUndo& blockundo, CValidationState&
     return true;
 }
 
+// Size of the custom state undo the view holds for the key, as serialized by SetUndo
+static size_t GetWrittenUndoSize(CCustomCSView& view, const UndoKey& key)
+{
+    const auto& raw = view.GetStorage().GetRaw();
+    auto it = raw.find(DbTypeToBytes(std::make_pair(CUndosView::ByUndoKey::prefix(), key)));
+    return it != raw.end() && it->second ? it->second->size() : 0;
+}
+
 static CCheckQueue<CScriptCheck> scriptcheckqueue(128);
 
 void ThreadScriptCheck(int worker_num) {
@@ -1941,6 +1934,81 @@ void ThreadScriptCheck(int worker_num) {
     scriptcheckqueue.Thread();
 }
 
+/**
+ * Recovers the public key of a compact signature. An invalid signature leaves
+ * the key invalid for the caller to report, so the check itself never fails.
+ */
+class CCompactSignatureCheck
+{
+private:
+    CCompactSignature* signature{nullptr};
+
+public:
+    CCompactSignatureCheck() = default;
+    explicit CCompactSignatureCheck(CCompactSignature& signatureIn) : signature(&signatureIn) {}
+
+    bool operator()() {
+        if (!signature->pubKey.RecoverCompact(signature->hash, signature->sig)) {
+            signature->pubKey = CPubKey{};
+        }
+        return true;
+    }
+
+    void swap(CCompactSignatureCheck& check) {
+        std::swap(signature, check.signature);
+    }
+};
+
+static CCheckQueue<CCompactSignatureCheck> sigrecoveryqueue(128);
+
+void ThreadSignatureRecovery(int worker_num) {
+    util::ThreadRename(strprintf("sigrecov.%i", worker_num));
+    sigrecoveryqueue.Thread();
+}
+
+void RecoverCompactSignatures(std::vector<CCompactSignature>& signatures)
+{
+    std::vector<CCompactSignatureCheck> vChecks;
+    vChecks.reserve(signatures.size());
+    for (auto& signature : signatures) {
+        vChecks.emplace_back(signature);
+    }
+
+    if (!nScriptCheckThreads || vChecks.size() < 2) {
+        for (auto& check : vChecks) {
+            check();
+        }
+        return;
+    }
+
+    CCheckQueueControl<CCompactSignatureCheck> control(&sigrecoveryqueue);
+    control.Add(vChecks);
+    control.Wait();
+}
+
+/** Recover the minter keys of a batch of headers in parallel, before it is accepted under cs_main */
+static void RecoverHeaderSignatures(const std::vector<CBlockHeader>& headers)
+{
+    if (!nScriptCheckThreads || headers.size() < 2) {
+        return;
+    }
+
+    std::vector<CCompactSignature> signatures;
+    signatures.reserve(headers.size());
+    for (const CBlockHeader& header : headers) {
+        signatures.push_back({header.GetHashToSign(), header.sig, {}});
+    }
+
+    RecoverCompactSignatures(signatures);
+
+    // invalid signatures are left for CheckBlockHeader to report
+    for (size_t i = 0; i < headers.size(); ++i) {
+        if (signatures[i].pubKey.IsValid()) {
+            headers[i].SetMinterKey(signatures[i].pubKey.GetID());
+        }
+    }
+}
+
 VersionBitsCache versionbitscache GUARDED_BY(cs_main);
 
 int32_t ComputeBlockVersion(const CBlockIndex* pindexPrev, const Consensus::Params& params)
@@ -2253,8 +2321,8 @@ void CChainState::ProcessEunosEvents(const CBlockIndex* pindex, CCustomCSView& c
                 cache.AddBalance(chainparams.GetConsensus().burnAddress, {subItem.first, subItem.second});
 
                 // Add transfer as additional TX in block
-                pburnHistoryDB->WriteAccountHistory({Params().GetConsensus().burnAddress, static_cast<uint32_t>(pindex->nHeight), GetNextBurnPosition()},
-                                                    {uint256{}, static_cast<uint8_t>(CustomTxType::AccountToAccount), {{subItem.first, subItem.second}}});
+                phistoryCollector->burnView->WriteAccountHistory({Params().GetConsensus().burnAddress, static_cast<uint32_t>(pindex->nHeight), GetNextBurnPosition()},
+                                                                 {uint256{}, static_cast<uint8_t>(CustomTxType::AccountToAccount), {{subItem.first, subItem.second}}});
             }
             else // Log burn failure
             {
@@ -2467,13 +2535,18 @@ bool StopOrInterruptConnect(const CBlockIndex *pIndex, CValidationState& state)
  *  Validity checks that depend on the UTXO set are also done; ConnectBlock()
  *  can fail if those validity checks fail (among other reasons). */
 bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pindex,
-                  CCoinsViewCache& view, CCustomCSView& mnview, const CChainParams& chainparams, std::vector<uint256> & rewardedAnchors, bool fJustCheck)
+                  CCoinsViewCache& view, CCustomCSView& mnview, const CChainParams& chainparams, std::vector<uint256> & rewardedAnchors, bool fJustCheck,
+                  CBlockConnectStats* stats, const std::vector<CCustomTxParsed>* customTxs,
+                  std::vector<uint256>* skippedTxs)
 {
     AssertLockHeld(cs_main);
     assert(pindex);
     assert(*pindex->phashBlock == block.GetHash());
     int64_t nTimeStart = GetTimeMicros();
 
+    CConnectPhases phases(stats);
+    phases.Start("checks");
+
     // Interrupt on hash or height requested. Invalidate the block.
     if (StopOrInterruptConnect(pindex, state))
         return false;
@@ -2484,6 +2557,9 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
     // Wipe burn map, we only want TXs added during ConnectBlock
     mapBurnAmounts.clear();
 
+    // Drop history left over by a block that was only checked or failed to connect
+    phistoryCollector->Discard();
+
     // Check it again in case a previous version let a bad block in
     // NOTE: We don't currently (re-)invoke ContextualCheckBlock() or
     // ContextualCheckBlockHeader() here. This means that if we add a new
@@ -2531,7 +2607,7 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
             pcustomcsview->CreateDFIToken();
             // init view|db with genesis here
             for (size_t i = 0; i < block.vtx.size(); ++i) {
-                CHistoryWriters writers{paccountHistoryDB.get(), nullptr, nullptr};
+                CHistoryWriters writers{phistoryCollector->accountView.get(), nullptr, nullptr};
                 const auto res = ApplyCustomTx(mnview, view, *block.vtx[i], chainparams.GetConsensus(), pindex->nHeight, pindex->GetBlockTime(), i, &writers);
                 if (!res.ok) {
                     return error("%s: Genesis block ApplyCustomTx failed. TX: %s Error: %s",
@@ -2611,6 +2687,7 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
 
     int64_t nTime1 = GetTimeMicros(); nTimeCheck += nTime1 - nTimeStart;
     LogPrint(BCLog::BENCH, "    - Sanity checks: %.2fms [%.2fs (%.2fms/blk)]\n", MILLI * (nTime1 - nTimeStart), nTimeCheck * MICRO, nTimeCheck * MILLI / nBlocksTotal);
+    phases.Start("forks");
 
     // Do not allow blocks that contain transactions which 'overwrite' older transactions,
     // unless those are already completely spent.
@@ -2712,6 +2789,7 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
 
     int64_t nTime2 = GetTimeMicros(); nTimeForks += nTime2 - nTime1;
     LogPrint(BCLog::BENCH, "    - Fork checks: %.2fms [%.2fs (%.2fms/blk)]\n", MILLI * (nTime2 - nTime1), nTimeForks * MICRO, nTimeForks * MILLI / nBlocksTotal);
+    phases.Start("transactions");
 
     CBlockUndo blockundo;
 
@@ -2799,8 +2877,24 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
                     tx.GetHash().ToString(), FormatStateMessage(state));
             }
 
-            CHistoryWriters writers{paccountHistoryDB.get(), pburnHistoryDB.get(), pvaultHistoryDB.get()};
-            const auto res = ApplyCustomTx(accountsView, view, tx, chainparams.GetConsensus(), pindex->nHeight, pindex->GetBlockTime(), i, &writers);
+            CHistoryWriters writers{phistoryCollector->accountView.get(), phistoryCollector->burnView.get(), phistoryCollector->vaultView.get(),
+                                    phistoryCollector->poolSwaps.get(), phistoryCollector->oracleView.get()};
+            std::optional<CConnectSample> txSample;
+            const CCustomTxParsed* parsed = customTxs ? &(*customTxs)[i] : nullptr;
+            std::optional<CCustomTxParsed> parsedHere;
+            if (stats) {
+                // the stats go by the type apply finds
+                if (!parsed) {
+                    parsed = &parsedHere.emplace(ParseCustomTx(tx, chainparams.GetConsensus(), pindex->nHeight));
+                }
+                txSample.emplace();
+            }
+            const auto res = ApplyCustomTx(accountsView, view, tx, chainparams.GetConsensus(), pindex->nHeight, pindex->GetBlockTime(), i, &writers, parsed);
+            if (txSample && parsed->type != CustomTxType::None) {
+                auto& txStats = stats->customTxs[ToString(parsed->type)];
+                txSample->AddTo(txStats);
+                txStats.undoSize += GetWrittenUndoSize(accountsView, UndoKey{static_cast<uint32_t>(pindex->nHeight), tx.GetHash()});
+            }
             if (!res.ok && (res.code & CustomTxErrCodes::Fatal)) {
                 if (pindex->nHeight >= chainparams.GetConsensus().EunosHeight) {
                     return state.Invalid(ValidationInvalidReason::CONSENSUS,
@@ -2812,6 +2906,9 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
                                 tx.GetHash().ToString(), res.msg);
                 }
             }
+            if (!res.ok && skippedTxs) {
+                skippedTxs->push_back(tx.GetHash());
+            }
             // log
             if (!fJustCheck && !res.msg.empty()) {
                 if (res.ok) {
@@ -2876,6 +2973,7 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
     LogPrint(BCLog::BENCH, "      - Connect %u transactions: %.2fms (%.3fms/tx, %.3fms/txin) [%.2fs (%.2fms/blk)]\n", (unsigned)block.vtx.size(), MILLI * (nTime3 - nTime2), MILLI * (nTime3 - nTime2) / block.vtx.size(), nInputs <= 1 ? 0 : MILLI * (nTime3 - nTime2) / (nInputs-1), nTimeConnect * MICRO, nTimeConnect * MILLI / nBlocksTotal);
 
     // chek main coinbase
+    phases.Start("coinbase");
     Res res = ApplyGeneralCoinbaseTx(accountsView, *block.vtx[0], pindex->nHeight, nFees, chainparams.GetConsensus());
     if (!res.ok) {
         return state.Invalid(ValidationInvalidReason::CONSENSUS,
@@ -2883,8 +2981,10 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
                              REJECT_INVALID, res.dbgMsg);
     }
 
+    phases.Start("scripts");
     if (!control.Wait())
         return state.Invalid(ValidationInvalidReason::CONSENSUS, error("%s: CheckQueue failed", __func__), REJECT_INVALID, "block-validation-failed");
+    phases.Start("splits");
 
     int64_t nTime4 = GetTimeMicros(); nTimeVerify += nTime4 - nTime2;
     LogPrint(BCLog::BENCH, "    - Verify %u txins: %.2fms (%.3fms/txin) [%.2fs (%.2fms/blk)]\n", nInputs - 1, MILLI * (nTime4 - nTime2), nInputs <= 1 ? 0 : MILLI * (nTime4 - nTime2) / (nInputs-1), nTimeVerify * MICRO, nTimeVerify * MILLI / nBlocksTotal);
@@ -2949,6 +3049,7 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
         return accountsView.Flush(); // keeps compatibility
 
     // validates account changes as well
+    phases.Start("accounts");
     if (pindex->nHeight >= chainparams.GetConsensus().EunosHeight
     && pindex->nHeight < chainparams.GetConsensus().EunosKampungHeight) {
         bool mutated;
@@ -2967,7 +3068,8 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
     // account changes are validated
     accountsView.Flush();
 
-    if (!WriteUndoDataForBlock(blockundo, state, pindex, chainparams))
+    phases.Start("coinsundo");
+    if (!WriteUndoDataForBlock(blockundo, state, pindex, chainparams, stats ? &stats->coinsUndoSize : nullptr))
         return false;
 
     if (!pindex->IsValid(BLOCK_VALID_SCRIPTS)) {
@@ -2984,9 +3086,11 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
         CCustomCSView cache(mnview);
 
         // calculate rewards to current block
+        phases.Start("rewards");
         ProcessRewardEvents(pindex, cache, chainparams);
 
         // close expired orders, refund all expired DFC HTLCs at this block height
+        phases.Start("icx");
         ProcessICXEvents(pindex, cache, chainparams);
 
         // Remove `Finalized` and/or `LPS` flags _possibly_set_ by bytecoded (cheated) txs before bayfront fork
@@ -2998,24 +3102,30 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
         ProcessEunosEvents(pindex, cache, chainparams);
 
         // set oracle prices
+        phases.Start("oracles");
         ProcessOracleEvents(pindex, cache, chainparams);
 
         // loan scheme, collateral ratio, liquidations
+        phases.Start("loans");
         ProcessLoanEvents(pindex, cache, chainparams);
 
         // Must be before set gov by height to clear futures in case there's a disabling of loan token in v3+
+        phases.Start("futures");
         ProcessFutures(pindex, cache, chainparams);
 
         // update governance variables
+        phases.Start("gov");
         ProcessGovEvents(pindex, cache, chainparams);
 
         // Migrate loan and collateral tokens to Gov vars.
         ProcessTokenToGovVar(pindex, cache, chainparams);
 
         // Loan splits
+        phases.Start("tokensplits");
         ProcessTokenSplits(block, pindex, cache, creationTxs, chainparams);
 
         // construct undo
+        phases.Start("undo");
         auto& flushable = cache.GetStorage();
         auto undo = CUndo::Construct(mnview.GetStorage(), flushable.GetRaw());
         // flush changes to underlying view
@@ -3024,12 +3134,25 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
         if (!undo.before.empty()) {
             mnview.SetUndo(UndoKey{static_cast<uint32_t>(pindex->nHeight), uint256() }, undo); // "zero hash"
         }
+        if (stats) {
+            stats->undoEntries = undo.before.size();
+            stats->undoSize = GetWrittenUndoSize(mnview, UndoKey{static_cast<uint32_t>(pindex->nHeight), uint256()});
+        }
+        if (fUndoBundles) {
+            std::vector<uint256> txids;
+            txids.reserve(block.vtx.size());
+            for (const auto& tx : block.vtx) {
+                txids.push_back(tx->GetHash());
+            }
+            mnview.BundleUndos(pindex->nHeight, txids);
+        }
     }
 
     // Write any UTXO burns
+    phases.Start("burnhistory");
     for (const auto& entries : writeBurnEntries)
     {
-        pburnHistoryDB->WriteAccountHistory(entries.first, entries.second);
+        phistoryCollector->burnView->WriteAccountHistory(entries.first, entries.second);
     }
 
     if (!fIsFakeNet) {
@@ -3044,6 +3167,7 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
     }
     mnview.SetLastHeight(pindex->nHeight);
 
+    phases.Start("pruning");
     auto &checkpoints = chainparams.Checkpoints().mapCheckpoints;
     auto it = checkpoints.lower_bound(pindex->nHeight);
     if (it != checkpoints.begin()) {
@@ -3051,20 +3175,34 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
         bool pruneStarted = false;
         auto time = GetTimeMillis();
         CCustomCSView pruned(mnview);
-        mnview.ForEachUndo([&](UndoKey const & key, CLazySerialize<CUndo>) {
-            if (key.height >= static_cast<uint32_t>(it->first)) { // don't erase checkpoint height
+        auto startPruning = [&](uint32_t height) {
+            if (height >= static_cast<uint32_t>(it->first)) { // don't erase checkpoint height
                 return false;
             }
             if (!pruneStarted) {
                 pruneStarted = true;
                 LogPrintf("Pruning undo data prior %d, it can take a while...\n", it->first);
             }
-            return pruned.DelUndo(key).ok;
+            return true;
+        };
+        mnview.ForEachUndo([&](UndoKey const & key, CLazySerialize<CUndo>) {
+            return startPruning(key.height) && pruned.DelUndo(key).ok;
+        });
+        // bundled undo is a single record per block
+        mnview.ForEachUndoBundle([&](UndoBundleKey const & key, CLazySerialize<CUndoBundle>) {
+            return startPruning(key.height) && pruned.DelUndoBundle(key.height).ok;
         });
         if (pruneStarted) {
+            // compact every prefix on its own, they may live in different databases
             auto& map = pruned.GetStorage().GetRaw();
-            compactBegin = map.begin()->first;
-            compactEnd = map.rbegin()->first;
+            compactRanges.clear();
+            for (auto prefix : {CUndosView::ByUndoKey::prefix(), CUndosView::ByUndoBundleKey::prefix()}) {
+                auto first = map.lower_bound(TBytes{prefix});
+                auto last = map.lower_bound(TBytes{static_cast<uint8_t>(prefix + 1)});
+                if (first != last) {
+                    compactRanges.emplace_back(first->first, std::prev(last)->first);
+                }
+            }
             pruned.Flush();
             LogPrintf("Pruning undo data finished.\n");
             LogPrint(BCLog::BENCH, "    - Pruning undo data takes: %dms\n", GetTimeMillis() - time);
@@ -3291,9 +3429,14 @@ void CChainState::ProcessLoanEvents(const CBlockIndex* pindex, CCustomCSView& ca
         cache.ForEachVaultCollateral([&](const CVaultId& vaultId, const CBalances& collaterals) {
             auto collateral = cache.GetLoanCollaterals(vaultId, collaterals, pindex->nHeight, pindex->nTime, useNextPrice, requireLivePrice);
             if (!collateral) {
+                // Frozen vaults have no ratio to be listed by
+                cache.EraseVaultRatio(vaultId);
                 return true;
             }
 
+            // Ratio index for listvaults, liquidation takes the vault out again
+            cache.SetVaultRatio(vaultId, collateral.val->ratio());
+
             auto vault = cache.GetVault(vaultId);
             assert(vault);
             auto scheme = cache.GetLoanScheme(vault->schemeId);
@@ -3363,15 +3506,15 @@ void CChainState::ProcessLoanEvents(const CBlockIndex* pindex, CCustomCSView& ca
             });
 
             // Store state in vault DB
-            if (pvaultHistoryDB) {
-                pvaultHistoryDB->WriteVaultState(cache, *pindex, vaultId, collateral.val->ratio());
+            if (auto vaultView = phistoryCollector->vaultView.get()) {
+                vaultView->WriteVaultState(cache, *pindex, vaultId, collateral.val->ratio());
             }
 
             return true;
         });
     }
 
-    CHistoryWriters writers{nullptr, pburnHistoryDB.get(), pvaultHistoryDB.get()};
+    CHistoryWriters writers{nullptr, phistoryCollector->burnView.get(), phistoryCollector->vaultView.get()};
     CAccountsHistoryWriter view(cache, pindex->nHeight, ~0u, {}, uint8_t(CustomTxType::AuctionBid), &writers);
 
     view.ForEachVaultAuction([&](const CVaultId& vaultId, const CAuctionData& data) {
@@ -3429,10 +3572,10 @@ void CChainState::ProcessLoanEvents(const CBlockIndex* pindex, CCustomCSView& ca
                     LogPrintf("AuctionBid: SubMintedTokens failed: %s\n", res.msg);
                 }
 
-                if (paccountHistoryDB) {
+                if (auto accountView = phistoryCollector->accountView.get()) {
                     AuctionHistoryKey key{data.liquidationHeight, bidOwner, vaultId, i};
                     AuctionHistoryValue value{bidTokenAmount, batch->collaterals.balances};
-                    paccountHistoryDB->WriteAuctionHistory(key, value);
+                    accountView->WriteAuctionHistory(key, value);
                 }
 
             } else {
@@ -3452,18 +3595,14 @@ void CChainState::ProcessLoanEvents(const CBlockIndex* pindex, CCustomCSView& ca
         view.EraseAuction(vaultId, pindex->nHeight);
 
         // Store state in vault DB
-        if (pvaultHistoryDB) {
-            pvaultHistoryDB->WriteVaultState(view, *pindex, vaultId);
+        if (auto vaultView = phistoryCollector->vaultView.get()) {
+            vaultView->WriteVaultState(view, *pindex, vaultId);
         }
 
         return true;
     }, pindex->nHeight);
 
     view.Flush();
-    pburnHistoryDB->Flush();
-    if (paccountHistoryDB) {
-        paccountHistoryDB->Flush();
-    }
 }
 
 void CChainState::ProcessFutures(const CBlockIndex* pindex, CCustomCSView& cache, const CChainParams& chainparams)
@@ -3567,27 +3706,48 @@ void CChainState::ProcessFutures(const CBlockIndex* pindex, CCustomCSView& cache
     auto dUsdToTokenSwapsCounter = 0;
     auto tokenTodUsdSwapsCounter = 0;
 
+    // Token metadata is the same for every contract of the settlement
+    std::map<DCT_ID, bool> isDUSDSource;
+    const auto isDUSD = [&](const DCT_ID& id) {
+        auto it = isDUSDSource.find(id);
+        if (it == isDUSDSource.end()) {
+            const auto loanToken = cache.GetLoanTokenByID(id);
+            assert(loanToken);
+            it = isDUSDSource.emplace(id, loanToken->symbol == "DUSD").first;
+        }
+        return it->second;
+    };
+    std::optional<DCT_ID> dUsdId;
+
+    // Settled amounts are applied to the view once per owner and token after all
+    // contracts are read, each contract keeps its own history entry.
+    std::map<CScript, std::vector<CSettlementCredit>> credits;
+    CBalances mints;
+    std::vector<std::pair<AccountHistoryKey, AccountHistoryValue>> historyEntries;
+    const auto accountHistory = phistoryCollector->accountView.get();
+
+    const auto settle = [&](const CScript& owner, const CTokenAmount& amount, uint32_t contractTxn, CustomTxType type) {
+        if (amount.nValue != 0) {
+            credits[owner].push_back({amount, contractTxn, uint8_t(type)});
+        }
+    };
+
     cache.ForEachFuturesUserValues([&](const CFuturesUserKey& key, const CFuturesUserValue& futuresValues){
 
-        CHistoryWriters writers{paccountHistoryDB.get(), nullptr, nullptr};
-        CAccountsHistoryWriter view(cache, pindex->nHeight, txn--, {}, uint8_t(CustomTxType::FutureSwapExecution), &writers);
+        const auto contractTxn = txn--;
 
         deletionPending.insert(key);
 
-        const auto source = view.GetLoanTokenByID(futuresValues.source.nTokenId);
-        assert(source);
-
-        if (source->symbol == "DUSD") {
+        if (isDUSD(futuresValues.source.nTokenId)) {
             const DCT_ID destId{futuresValues.destination};
-            const auto destToken = view.GetLoanTokenByID(destId);
-            assert(destToken);
+            isDUSD(destId); // asserts the destination is a loan token
             try {
                 const auto& premiumPrice = futuresPrices.at(destId).premium;
                 if (premiumPrice > 0) {
                     const auto total = DivideAmounts(futuresValues.source.nValue, premiumPrice);
-                    view.AddMintedTokens(destId, total);
                     CTokenAmount destination{destId, total};
-                    view.AddBalance(key.owner, destination);
+                    mints.Add(destination);
+                    settle(key.owner, destination, contractTxn, CustomTxType::FutureSwapExecution);
                     burned.Add(futuresValues.source);
                     minted.Add(destination);
                     dUsdToTokenSwapsCounter++;
@@ -3599,15 +3759,18 @@ void CChainState::ProcessFutures(const CBlockIndex* pindex, CCustomCSView& cache
             }
 
         } else {
-            const auto tokenDUSD = view.GetToken("DUSD");
-            assert(tokenDUSD);
+            if (!dUsdId) {
+                const auto tokenDUSD = cache.GetToken("DUSD");
+                assert(tokenDUSD);
+                dUsdId = tokenDUSD->first;
+            }
 
             try {
                 const auto& discountPrice = futuresPrices.at(futuresValues.source.nTokenId).discount;
                 const auto total = MultiplyAmounts(futuresValues.source.nValue, discountPrice);
-                view.AddMintedTokens(tokenDUSD->first, total);
-                CTokenAmount destination{tokenDUSD->first, total};
-                view.AddBalance(key.owner, destination);
+                CTokenAmount destination{*dUsdId, total};
+                mints.Add(destination);
+                settle(key.owner, destination, contractTxn, CustomTxType::FutureSwapExecution);
                 burned.Add(futuresValues.source);
                 minted.Add(destination);
                 tokenTodUsdSwapsCounter++;
@@ -3618,8 +3781,6 @@ void CChainState::ProcessFutures(const CBlockIndex* pindex, CCustomCSView& cache
             }
         }
 
-        view.Flush();
-
         return true;
     }, {static_cast<uint32_t>(pindex->nHeight), {}, std::numeric_limits<uint32_t>::max()});
 
@@ -3635,21 +3796,31 @@ void CChainState::ProcessFutures(const CBlockIndex* pindex, CCustomCSView& cache
     // Refund unpaid contracts
     for (const auto& [key, value] : unpaidContracts) {
 
-        CHistoryWriters subWriters{paccountHistoryDB.get(), nullptr, nullptr};
-        CAccountsHistoryWriter subView(cache, pindex->nHeight, txn--, {}, uint8_t(CustomTxType::FutureSwapRefund), &subWriters);
-        subView.SubBalance(*contractAddressValue, value.source);
-        subView.Flush();
+        const auto subTxn = txn--;
+        if (value.source.nValue != 0 && cache.SubBalance(*contractAddressValue, value.source) && accountHistory) {
+            historyEntries.emplace_back(AccountHistoryKey{*contractAddressValue, static_cast<uint32_t>(pindex->nHeight), subTxn},
+                                        AccountHistoryValue{{}, uint8_t(CustomTxType::FutureSwapRefund), {{value.source.nTokenId, -value.source.nValue}}});
+        }
 
-        CHistoryWriters addWriters{paccountHistoryDB.get(), nullptr, nullptr};
-        CAccountsHistoryWriter addView(cache, pindex->nHeight, txn--, {}, uint8_t(CustomTxType::FutureSwapRefund), &addWriters);
-        addView.AddBalance(key.owner, value.source);
-        addView.Flush();
+        settle(key.owner, value.source, txn--, CustomTxType::FutureSwapRefund);
 
         LogPrint(BCLog::FUTURESWAP, "ProcessFutures(): Refund Owner %s source %s destination %s\n",
                  key.owner.GetHex(), value.source.ToString(), value.source.ToString());
         balances.Sub(value.source);
     }
 
+    for (const auto& [id, amount] : mints.balances) {
+        cache.AddMintedTokens(id, amount);
+    }
+
+    ApplySettlementCredits(cache, pindex->nHeight, credits, accountHistory);
+
+    for (const auto& [historyKey, historyValue] : historyEntries) {
+        LogPrint(BCLog::ACCOUNTCHANGE, "AccountChange: txid=%s addr=%s change=%s\n", historyValue.txid.GetHex(),
+                 ScriptToString(historyKey.owner), (CBalances{historyValue.diff}.ToString()));
+        accountHistory->WriteAccountHistory(historyKey, historyValue);
+    }
+
     for (const auto& key : deletionPending) {
         cache.EraseFuturesUserValues(key);
     }
@@ -4654,6 +4825,10 @@ bool CChainState::FlushStateToDisk(
                     vBlocks.push_back(*it);
                     setDirtyBlockIndex.erase(it++);
                 }
+                // write back the keys recovered since the entries were loaded
+                for (auto pindex : TakeRecoveredMinterKeys()) {
+                    vBlocks.push_back(pindex);
+                }
                 if (!pblocktree->WriteBatchSync(vFiles, nLastBlockFile, vBlocks)) {
                     return AbortNode(state, "Failed to write to block index database");
                 }
@@ -4672,6 +4847,8 @@ bool CChainState::FlushStateToDisk(
             if (!pcustomcsview->Flush()) {
                 return AbortNode(state, "Failed to write db batch");
             }
+            // the next snapshot goes without a copy of the flushed changes
+            ResetCustomCSSnapshot();
             // Typical Coin structures on disk are around 48 bytes in size.
             // Pushing a new one to the database can cause it to be written
             // twice (once in the log, and once in the tables). This is already
@@ -4684,11 +4861,12 @@ bool CChainState::FlushStateToDisk(
             if (!CoinsTip().Flush() || !pcustomcsDB->Flush()) {
                 return AbortNode(state, "Failed to write to coin or masternode db to disk");
             }
-            if (!compactBegin.empty() && !compactEnd.empty()) {
+            if (!compactRanges.empty()) {
                 auto time = GetTimeMillis();
-                pcustomcsDB->Compact(compactBegin, compactEnd);
-                compactBegin.clear();
-                compactEnd.clear();
+                for (const auto& [compactBegin, compactEnd] : compactRanges) {
+                    pcustomcsDB->Compact(compactBegin, compactEnd);
+                }
+                compactRanges.clear();
                 LogPrint(BCLog::BENCH, "    - DB compacting takes: %dms\n", GetTimeMillis() - time);
             }
             nLastFlush = nNow;
@@ -4827,32 +5005,15 @@ bool CChainState::DisconnectTip(CValidationState& state, const CChainParams& cha
         assert(view.GetBestBlock() == pindexDelete->GetBlockHash());
         std::vector<CAnchorConfirmMessage> disconnectedConfirms;
         if (DisconnectBlock(block, pindexDelete, view, mnview, disconnectedConfirms) != DISCONNECT_OK) {
-            // no usable history
-            if (paccountHistoryDB) {
-                paccountHistoryDB->Discard();
-            }
-            if (pburnHistoryDB) {
-                pburnHistoryDB->Discard();
-            }
-            if (pvaultHistoryDB) {
-                pvaultHistoryDB->Discard();
-            }
             m_disconnectTip = false;
             return error("DisconnectTip(): DisconnectBlock %s failed", pindexDelete->GetBlockHash().ToString());
         }
         bool flushed = view.Flush() && mnview.Flush();
         assert(flushed);
 
-        // flush history
-        if (paccountHistoryDB) {
-            paccountHistoryDB->Flush();
-        }
-        if (pburnHistoryDB) {
-            pburnHistoryDB->Flush();
-        }
-        if (pvaultHistoryDB) {
-            pvaultHistoryDB->Flush();
-        }
+        // history indexes rewind on their own, drop changes they didn't apply yet
+        pcustomcsview->DelHistoryChanges(pindexDelete->nHeight);
+        ResetCustomCSSnapshot();
 
         if (!disconnectedConfirms.empty()) {
             for (auto const & confirm : disconnectedConfirms) {
@@ -4962,6 +5123,13 @@ public:
     }
 };
 
+static void CopyRecords(const MapKV& changes, uint8_t prefix, MapKV& records)
+{
+    for (auto it = changes.lower_bound({prefix}); it != changes.end() && it->first.front() == prefix; ++it) {
+        records.insert(*it);
+    }
+}
+
 /**
  * Connect a new block to m_chain. pblock is either nullptr or a pointer to a CBlock
  * corresponding to pindexNew, to bypass loading it again from disk.
@@ -4973,8 +5141,17 @@ bool CChainState::ConnectTip(CValidationState& state, const CChainParams& chainp
     assert(pindexNew->pprev == m_chain.Tip());
     // Read block from disk.
     int64_t nTime1 = GetTimeMicros();
+    std::optional<CBlockConnectStats> connectStats;
+    if (g_connectStats.IsActive()) {
+        connectStats.emplace(pindexNew->nHeight, pindexNew->GetBlockHash());
+    }
+    CConnectPhases phases(connectStats ? &*connectStats : nullptr);
+    phases.Start("read");
     std::shared_ptr<const CBlock> pthisBlock;
-    if (!pblock) {
+    std::shared_ptr<const CPrefetchedBlock> prefetched;
+    if (!pblock && g_blockprefetcher && (prefetched = g_blockprefetcher->Take(pindexNew))) {
+        pthisBlock = prefetched->block;
+    } else if (!pblock) {
         std::shared_ptr<CBlock> pblockNew = std::make_shared<CBlock>();
         if (!ReadBlockFromDisk(*pblockNew, pindexNew, chainparams.GetConsensus()))
             return AbortNode(state, "Failed to read block");
@@ -4991,39 +5168,39 @@ bool CChainState::ConnectTip(CValidationState& state, const CChainParams& chainp
         CCoinsViewCache view(&CoinsTip());
         CCustomCSView mnview(*pcustomcsview.get());
         std::vector<uint256> rewardedAnchors;
-        bool rv = ConnectBlock(blockConnecting, state, pindexNew, view, mnview, chainparams, rewardedAnchors);
+        auto customChanges = std::make_shared<CCustomChanges>();
+        phases.Stop();
+        bool rv = ConnectBlock(blockConnecting, state, pindexNew, view, mnview, chainparams, rewardedAnchors, false, connectStats ? &*connectStats : nullptr,
+                               prefetched ? &prefetched->customTxs : nullptr, &customChanges->skippedTxs);
         GetMainSignals().BlockChecked(blockConnecting, state);
         if (!rv) {
             if (state.IsInvalid()) {
                 InvalidBlockFound(pindexNew, state);
             }
-            // no usable history
-            if (paccountHistoryDB) {
-                paccountHistoryDB->Discard();
-            }
-            if (pburnHistoryDB) {
-                pburnHistoryDB->Discard();
-            }
-            if (pvaultHistoryDB) {
-                pvaultHistoryDB->Discard();
-            }
             return error("%s: ConnectBlock %s failed, %s", __func__, pindexNew->GetBlockHash().ToString(), FormatStateMessage(state));
         }
         nTime3 = GetTimeMicros(); nTimeConnectTotal += nTime3 - nTime2;
         LogPrint(BCLog::BENCH, "  - Connect total: %.2fms [%.2fs (%.2fms/blk)]\n", (nTime3 - nTime2) * MILLI, nTimeConnectTotal * MICRO, nTimeConnectTotal * MILLI / nBlocksTotal);
+        phases.Start("flush");
+        for (const auto prefix : {CPoolPairView::ByReserves::prefix(), COracleView::FixedIntervalPriceKey::prefix()}) {
+            CopyRecords(mnview.GetStorage().GetRaw(), prefix, customChanges->state);
+        }
         bool flushed = view.Flush() && mnview.Flush();
         assert(flushed);
 
-        // flush history
-        if (paccountHistoryDB) {
-            paccountHistoryDB->Flush();
-        }
-        if (pburnHistoryDB) {
-            pburnHistoryDB->Flush();
-        }
-        if (pvaultHistoryDB) {
-            pvaultHistoryDB->Flush();
+        // journal history changes for the history indexes
+        phases.Start("historyjournal");
+        phistoryCollector->CollectState(pindexNew->nHeight, pindexNew->GetBlockTime(), customChanges->state);
+        auto historyChanges = std::make_shared<const CHistoryChanges>(phistoryCollector->Take(pindexNew->GetBlockHash()));
+        if (!historyChanges->IsEmpty()) {
+            pcustomcsview->SetHistoryChanges(pindexNew->nHeight, *historyChanges);
         }
+        ResetCustomCSSnapshot();
+        PruneHistoryChanges(*pcustomcsview, m_chain);
+
+        customChanges->history = std::move(historyChanges);
+        phases.Start("flush");
+        GetMainSignals().CustomChangesConnected(pindexNew, std::move(customChanges));
 
         // anchor rewards re-voting etc...
         if (!rewardedAnchors.empty()) {
@@ -5036,8 +5213,10 @@ bool CChainState::ConnectTip(CValidationState& state, const CChainParams& chainp
     int64_t nTime4 = GetTimeMicros(); nTimeFlush += nTime4 - nTime3;
     LogPrint(BCLog::BENCH, "  - Flush: %.2fms [%.2fs (%.2fms/blk)]\n", (nTime4 - nTime3) * MILLI, nTimeFlush * MICRO, nTimeFlush * MILLI / nBlocksTotal);
     // Write the chain state to disk, if necessary.
+    phases.Start("chainstate");
     if (!FlushStateToDisk(chainparams, state, FlushStateMode::IF_NEEDED))
         return false;
+    phases.Start("postprocess");
     int64_t nTime5 = GetTimeMicros(); nTimeChainState += nTime5 - nTime4;
     LogPrint(BCLog::BENCH, "  - Writing chainstate: %.2fms [%.2fs (%.2fms/blk)]\n", (nTime5 - nTime4) * MILLI, nTimeChainState * MICRO, nTimeChainState * MILLI / nBlocksTotal);
     // Remove conflicting transactions from the mempool.;
@@ -5051,6 +5230,7 @@ bool CChainState::ConnectTip(CValidationState& state, const CChainParams& chainp
     if (pindexNew->nHeight >= Params().GetConsensus().DakotaHeight &&
             pindexNew->nHeight % Params().GetConsensus().mn.anchoringTeamChange == 0) {
         pcustomcsview->CalcAnchoringTeams(blockConnecting.stakeModifier, pindexNew);
+        ResetCustomCSSnapshot();
 
         // Delete old and now invalid anchor confirms
         panchorAwaitingConfirms->Clear();
@@ -5065,6 +5245,12 @@ bool CChainState::ConnectTip(CValidationState& state, const CChainParams& chainp
     LogPrint(BCLog::BENCH, "  - Connect postprocess: %.2fms [%.2fs (%.2fms/blk)]\n", (nTime6 - nTime5) * MILLI, nTimePostConnect * MICRO, nTimePostConnect * MILLI / nBlocksTotal);
     LogPrint(BCLog::BENCH, "- Connect block: %.2fms [%.2fs (%.2fms/blk)]\n", (nTime6 - nTime1) * MILLI, nTimeTotal * MICRO, nTimeTotal * MILLI / nBlocksTotal);
 
+    if (connectStats) {
+        phases.Stop();
+        connectStats->time = nTime6 - nTime1;
+        g_connectStats.Add(std::move(*connectStats));
+    }
+
     connectTrace.BlockConnected(pindexNew, std::move(pthisBlock));
     return true;
 }
@@ -5216,6 +5402,9 @@ bool CChainState::ActivateBestChainStep(CValidationState& state, const CChainPar
         // Connect new blocks.
         for (CBlockIndex *pindexConnect : reverse_iterate(vpindexToConnect)) {
             state = CValidationState();
+            if (g_blockprefetcher) {
+                g_blockprefetcher->Prefetch(pindexMostWork, pindexConnect->nHeight);
+            }
             if (!ConnectTip(state, chainparams, pindexConnect, pindexConnect == pindexMostWork ? pblock : std::shared_ptr<const CBlock>(), connectTrace, disconnectpool)) {
                 if (state.IsInvalid()) {
                     fContinue = false;
@@ -6197,9 +6386,17 @@ bool BlockManager::AcceptBlockHeader(const CBlockHeader& block, CValidationState
 }
 
 // Exposed wrapper for AcceptBlockHeader
+/** Time of the last header sync log line, and the headers accepted since */
+static int64_t nTimeHeadersLog GUARDED_BY(cs_main) = 0;
+static uint64_t nHeadersSinceLog GUARDED_BY(cs_main) = 0;
+
 bool ProcessNewBlockHeaders(const std::vector<CBlockHeader>& headers, CValidationState& state, const CChainParams& chainparams, const CBlockIndex** ppindex, CBlockHeader *first_invalid)
 {
     if (first_invalid != nullptr) first_invalid->SetNull();
+
+    // Signature recovery is the bulk of the header checks, get it done without holding cs_main
+    RecoverHeaderSignatures(headers);
+
     {
         LOCK(cs_main);
 
@@ -6216,12 +6413,17 @@ bool ProcessNewBlockHeaders(const std::vector<CBlockHeader>& headers, CValidatio
                 *ppindex = pindex;
             }
         }
+        nHeadersSinceLog += headers.size();
     }
     if (NotifyHeaderTip())
     {
         LOCK(cs_main);
         if (::ChainstateActive().IsInitialBlockDownload() && ppindex && *ppindex) {
-            LogPrintf("Synchronizing blockheaders, height: %d (~%.2f%%)\n", (*ppindex)->nHeight, 100.0/((*ppindex)->nHeight+(GetAdjustedTime() - (*ppindex)->GetBlockTime()) / Params().GetConsensus().pos.nTargetSpacing) * (*ppindex)->nHeight);
+            const int64_t nTimeNow = GetTimeMicros();
+            const double headersPerSecond = nTimeHeadersLog ? nHeadersSinceLog * 1000000.0 / std::max<int64_t>(nTimeNow - nTimeHeadersLog, 1) : 0.0;
+            LogPrintf("Synchronizing blockheaders, height: %d (~%.2f%%), %.0f headers/s\n", (*ppindex)->nHeight, 100.0/((*ppindex)->nHeight+(GetAdjustedTime() - (*ppindex)->GetBlockTime()) / Params().GetConsensus().pos.nTargetSpacing) * (*ppindex)->nHeight, headersPerSecond);
+            nTimeHeadersLog = nTimeNow;
+            nHeadersSinceLog = 0;
         }
     }
     return true;
@@ -7293,6 +7495,7 @@ void UnloadBlockIndex()
     vinfoBlockFile.clear();
     nLastBlockFile = 0;
     setDirtyBlockIndex.clear();
+    TakeRecoveredMinterKeys();
     setDirtyFileInfo.clear();
     versionbitscache.Clear();
     for (int b = 0; b < VERSIONBITS_NUM_BITS; b++) {
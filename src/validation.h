@@ -37,8 +37,10 @@
 
 class CAnchorConfirmMessage;
 struct CBalances;
+struct CBlockConnectStats;
 class CChainState;
 class CCustomCSView;
+struct CCustomTxParsed;
 class CBlockIndex;
 class CBlockTreeDB;
 class CBlockUndo;
@@ -148,7 +150,7 @@ struct BlockHasher
 };
 
 extern CScript COINBASE_FLAGS;
-extern CCriticalSection cs_main;
+extern WaitTimedRecursiveMutex cs_main;
 extern CBlockPolicyEstimator feeEstimator;
 extern CTxMemPool mempool;
 typedef std::unordered_map<uint256, CBlockIndex*, BlockHasher> BlockMap;
@@ -271,6 +273,20 @@ bool LoadChainTip(const CChainParams& chainparams) EXCLUSIVE_LOCKS_REQUIRED(cs_m
 void UnloadBlockIndex();
 /** Run an instance of the script checking thread */
 void ThreadScriptCheck(int worker_num);
+/** Run an instance of the signature recovery thread */
+void ThreadSignatureRecovery(int worker_num);
+
+/** A compact signature to recover the signer of */
+struct CCompactSignature
+{
+    uint256 hash;
+    std::vector<unsigned char> sig;
+    //! Recovered public key, invalid if the signature is
+    CPubKey pubKey;
+};
+
+/** Recover the public keys of a batch of compact signatures, in parallel if there are script check threads */
+void RecoverCompactSignatures(std::vector<CCompactSignature>& signatures);
 /** Retrieve a transaction (from memory pool, or from disk, if possible) */
 bool GetTransaction(const uint256& hash, CTransactionRef& tx, const Consensus::Params& params, uint256& hashBlock, const CBlockIndex* const blockIndex = nullptr);
 /**
@@ -391,6 +407,8 @@ void InitScriptExecutionCache();
 /** Functions for disk access for blocks */
 bool ReadBlockFromDisk(CBlock& block, const FlatFilePos& pos, const Consensus::Params& consensusParams);
 bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex, const Consensus::Params& consensusParams);
+/** Read the block of an index by its position and minter key, taken from the index under cs_main */
+bool ReadBlockFromDisk(CBlock& block, const FlatFilePos& pos, const uint256& hash, const CKeyID& minterKeyID);
 bool ReadRawBlockFromDisk(std::vector<uint8_t>& block, const FlatFilePos& pos, const CMessageHeader::MessageStartChars& message_start);
 bool ReadRawBlockFromDisk(std::vector<uint8_t>& block, const CBlockIndex* pindex, const CMessageHeader::MessageStartChars& message_start);
 
@@ -716,7 +734,9 @@ public:
     // Block (dis)connection on a given view:
     DisconnectResult DisconnectBlock(const CBlock& block, const CBlockIndex* pindex, CCoinsViewCache& view, CCustomCSView& cache, std::vector<CAnchorConfirmMessage> & disconnectedAnchorConfirms);
     bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pindex,
-                      CCoinsViewCache& view, CCustomCSView& cache, const CChainParams& chainparams, std::vector<uint256> & rewardedAnchors, bool fJustCheck = false) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+                      CCoinsViewCache& view, CCustomCSView& cache, const CChainParams& chainparams, std::vector<uint256> & rewardedAnchors, bool fJustCheck = false,
+                      CBlockConnectStats* stats = nullptr, const std::vector<CCustomTxParsed>* customTxs = nullptr,
+                      std::vector<uint256>* skippedTxs = nullptr) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
     // Apply the effects of a block disconnection on the UTXO set.
     bool DisconnectTip(CValidationState& state, const CChainParams& chainparams, DisconnectedBlockTransactions* disconnectpool) EXCLUSIVE_LOCKS_REQUIRED(cs_main, ::mempool.cs);
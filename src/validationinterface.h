@@ -12,11 +12,12 @@
 #include <functional>
 #include <memory>
 
-extern CCriticalSection cs_main;
+extern WaitTimedRecursiveMutex cs_main;
 class CBlock;
 class CBlockIndex;
 struct CBlockLocator;
 class CConnman;
+struct CCustomChanges;
 class CValidationInterface;
 class CValidationState;
 class uint256;
@@ -115,6 +116,13 @@ protected:
      * Called on a background thread.
      */
     virtual void BlockDisconnected(const std::shared_ptr<const CBlock> &block) {}
+    /**
+     * Notifies listeners of the DeFi changes of a block being connected,
+     * ahead of its BlockConnected callback.
+     *
+     * Called on a background thread.
+     */
+    virtual void CustomChangesConnected(const CBlockIndex *pindex, const std::shared_ptr<const CCustomChanges> &changes) {}
     /**
      * Notifies listeners of the new active block chain on-disk.
      *
@@ -179,6 +187,7 @@ public:
     void TransactionAddedToMempool(const CTransactionRef &);
     void BlockConnected(const std::shared_ptr<const CBlock> &, const CBlockIndex *pindex, const std::shared_ptr<const std::vector<CTransactionRef>> &);
     void BlockDisconnected(const std::shared_ptr<const CBlock> &);
+    void CustomChangesConnected(const CBlockIndex *, const std::shared_ptr<const CCustomChanges> &);
     void ChainStateFlushed(const CBlockLocator &);
     void BlockChecked(const CBlock&, const CValidationState&);
     void NewPoWValidBlock(const CBlockIndex *, const std::shared_ptr<const CBlock>&);
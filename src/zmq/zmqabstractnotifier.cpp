@@ -20,3 +20,13 @@ bool CZMQAbstractNotifier::NotifyTransaction(const CTransaction &/*transaction*/
 {
     return true;
 }
+
+bool CZMQAbstractNotifier::NotifyCustomChanges(const CBlockIndex * /*CBlockIndex*/, const CCustomChanges &/*changes*/)
+{
+    return true;
+}
+
+bool CZMQAbstractNotifier::NotifyBlockDisconnected(const CBlockIndex * /*CBlockIndex*/)
+{
+    return true;
+}
@@ -9,6 +9,7 @@
 
 class CBlockIndex;
 class CZMQAbstractNotifier;
+struct CCustomChanges;
 
 typedef CZMQAbstractNotifier* (*CZMQNotifierFactory)();
 
@@ -42,6 +43,8 @@ public:
 
     virtual bool NotifyBlock(const CBlockIndex *pindex);
     virtual bool NotifyTransaction(const CTransaction &transaction);
+    virtual bool NotifyCustomChanges(const CBlockIndex *pindex, const CCustomChanges &changes);
+    virtual bool NotifyBlockDisconnected(const CBlockIndex *pindex);
 
 protected:
     void *psocket;
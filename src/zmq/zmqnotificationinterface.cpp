@@ -37,6 +37,16 @@ std::list<const CZMQAbstractNotifier*> CZMQNotificationInterface::GetActiveNotif
     return result;
 }
 
+bool CZMQNotificationInterface::IsPublishing(const std::string& type) const
+{
+    for (const auto* n : notifiers) {
+        if (n->GetType() == type) {
+            return true;
+        }
+    }
+    return false;
+}
+
 CZMQNotificationInterface* CZMQNotificationInterface::Create()
 {
     CZMQNotificationInterface* notificationInterface = nullptr;
@@ -47,6 +57,12 @@ CZMQNotificationInterface* CZMQNotificationInterface::Create()
     factories["pubhashtx"] = CZMQAbstractNotifier::Create<CZMQPublishHashTransactionNotifier>;
     factories["pubrawblock"] = CZMQAbstractNotifier::Create<CZMQPublishRawBlockNotifier>;
     factories["pubrawtx"] = CZMQAbstractNotifier::Create<CZMQPublishRawTransactionNotifier>;
+    factories["pubaccountdiffs"] = CZMQAbstractNotifier::Create<CZMQPublishAccountDiffsNotifier>;
+    factories["pubpoolreserves"] = CZMQAbstractNotifier::Create<CZMQPublishPoolReservesNotifier>;
+    factories["pubvaultstates"] = CZMQAbstractNotifier::Create<CZMQPublishVaultStatesNotifier>;
+    factories["puboracleprices"] = CZMQAbstractNotifier::Create<CZMQPublishOraclePricesNotifier>;
+    factories["pubfutureswaps"] = CZMQAbstractNotifier::Create<CZMQPublishFutureSwapsNotifier>;
+    factories["pubdefiundo"] = CZMQAbstractNotifier::Create<CZMQPublishDeFiUndoNotifier>;
 
     for (const auto& entry : factories)
     {
@@ -192,6 +208,46 @@ void CZMQNotificationInterface::BlockDisconnected(const std::shared_ptr<const CB
         // Do a normal notify for each transaction removed in block disconnection
         TransactionAddedToMempool(ptx);
     }
+
+    const CBlockIndex* pindex;
+    {
+        LOCK(cs_main);
+        pindex = LookupBlockIndex(pblock->GetHash());
+    }
+    if (!pindex) {
+        return;
+    }
+
+    for (std::list<CZMQAbstractNotifier*>::iterator i = notifiers.begin(); i!=notifiers.end(); )
+    {
+        CZMQAbstractNotifier *notifier = *i;
+        if (notifier->NotifyBlockDisconnected(pindex))
+        {
+            i++;
+        }
+        else
+        {
+            notifier->Shutdown();
+            i = notifiers.erase(i);
+        }
+    }
+}
+
+void CZMQNotificationInterface::CustomChangesConnected(const CBlockIndex* pindex, const std::shared_ptr<const CCustomChanges>& changes)
+{
+    for (std::list<CZMQAbstractNotifier*>::iterator i = notifiers.begin(); i!=notifiers.end(); )
+    {
+        CZMQAbstractNotifier *notifier = *i;
+        if (notifier->NotifyCustomChanges(pindex, *changes))
+        {
+            i++;
+        }
+        else
+        {
+            notifier->Shutdown();
+            i = notifiers.erase(i);
+        }
+    }
 }
 
 CZMQNotificationInterface* g_zmq_notification_interface = nullptr;
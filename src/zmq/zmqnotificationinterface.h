@@ -20,6 +20,9 @@ public:
 
     std::list<const CZMQAbstractNotifier*> GetActiveNotifiers() const;
 
+    /// Whether a notifier of the given type (e.g. "pubaccountdiffs") is active
+    bool IsPublishing(const std::string& type) const;
+
     static CZMQNotificationInterface* Create();
 
 protected:
@@ -30,6 +33,7 @@ protected:
     void TransactionAddedToMempool(const CTransactionRef& tx) override;
     void BlockConnected(const std::shared_ptr<const CBlock>& pblock, const CBlockIndex* pindexConnected, const std::vector<CTransactionRef>& vtxConflicted) override;
     void BlockDisconnected(const std::shared_ptr<const CBlock>& pblock) override;
+    void CustomChangesConnected(const CBlockIndex* pindex, const std::shared_ptr<const CCustomChanges>& changes) override;
     void UpdatedBlockTip(const CBlockIndex *pindexNew, const CBlockIndex *pindexFork, bool fInitialDownload) override;
 
 private:
@@ -4,6 +4,13 @@
 
 #include <chain.h>
 #include <chainparams.h>
+#include <masternodes/accountshistory.h>
+#include <masternodes/auctionhistory.h>
+#include <masternodes/historychanges.h>
+#include <masternodes/mn_checks.h>
+#include <masternodes/oracles.h>
+#include <masternodes/poolpairs.h>
+#include <masternodes/vaulthistory.h>
 #include <streams.h>
 #include <zmq/zmqpublishnotifier.h>
 #include <validation.h>
@@ -16,6 +23,12 @@ static const char *MSG_HASHBLOCK = "hashblock";
 static const char *MSG_HASHTX    = "hashtx";
 static const char *MSG_RAWBLOCK  = "rawblock";
 static const char *MSG_RAWTX     = "rawtx";
+static const char *MSG_ACCOUNTDIFFS = "accountdiffs";
+static const char *MSG_POOLRESERVES = "poolreserves";
+static const char *MSG_VAULTSTATES  = "vaultstates";
+static const char *MSG_ORACLEPRICES = "oracleprices";
+static const char *MSG_FUTURESWAPS  = "futureswaps";
+static const char *MSG_DEFIUNDO     = "defiundo";
 
 // Internal function to send multipart message
 static int zmq_send_multipart(void *sock, const void* data, size_t size, ...)
@@ -60,6 +73,32 @@ static int zmq_send_multipart(void *sock, const void* data, size_t size, ...)
     return 0;
 }
 
+// Decodes the written records of a database prefix from raw changes
+template<typename By, typename KeyType, typename ValueType>
+static std::vector<std::pair<KeyType, ValueType>> DecodeRecords(const MapKV& changes)
+{
+    std::vector<std::pair<KeyType, ValueType>> records;
+    for (auto it = changes.lower_bound({By::prefix()}); it != changes.end() && it->first.front() == By::prefix(); ++it) {
+        std::pair<uint8_t, KeyType> key;
+        ValueType value;
+        if (it->second && BytesToDbType(it->first, key) && BytesToDbType(*it->second, value)) {
+            records.emplace_back(std::move(key.second), std::move(value));
+        }
+    }
+    return records;
+}
+
+// DeFi change messages are the block hash and height followed by the records
+template<typename... Records>
+static bool SendBlockRecords(CZMQAbstractPublishNotifier& notifier, const char *command, const CBlockIndex *pindex, const Records&... records)
+{
+    LogPrint(BCLog::ZMQ, "zmq: Publish %s %s\n", command, pindex->GetBlockHash().GetHex());
+    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    ss << pindex->GetBlockHash() << static_cast<uint32_t>(pindex->nHeight);
+    (ss << ... << records);
+    return notifier.SendMessage(command, &(*ss.begin()), ss.size());
+}
+
 bool CZMQAbstractPublishNotifier::Initialize(void *pcontext)
 {
     assert(!psocket);
@@ -206,3 +245,43 @@ bool CZMQPublishRawTransactionNotifier::NotifyTransaction(const CTransaction &tr
     ss << transaction;
     return SendMessage(MSG_RAWTX, &(*ss.begin()), ss.size());
 }
+
+bool CZMQPublishAccountDiffsNotifier::NotifyCustomChanges(const CBlockIndex *pindex, const CCustomChanges &changes)
+{
+    auto diffs = DecodeRecords<CAccountsHistoryView::ByAccountHistoryKey, AccountHistoryKey, AccountHistoryValue>(changes.history->accounts);
+    return diffs.empty() || SendBlockRecords(*this, MSG_ACCOUNTDIFFS, pindex, diffs);
+}
+
+bool CZMQPublishPoolReservesNotifier::NotifyCustomChanges(const CBlockIndex *pindex, const CCustomChanges &changes)
+{
+    auto reserves = DecodeRecords<CPoolPairView::ByReserves, DCT_ID, PoolReservesValue>(changes.state);
+    return reserves.empty() || SendBlockRecords(*this, MSG_POOLRESERVES, pindex, reserves);
+}
+
+bool CZMQPublishVaultStatesNotifier::NotifyCustomChanges(const CBlockIndex *pindex, const CCustomChanges &changes)
+{
+    auto states = DecodeRecords<CVaultHistoryView::ByVaultStateKey, VaultStateKey, VaultStateValue>(changes.history->vaults);
+    auto auctions = DecodeRecords<CAuctionHistoryView::ByAuctionHistoryKey, AuctionHistoryKey, AuctionHistoryValue>(changes.history->accounts);
+    return (states.empty() && auctions.empty()) || SendBlockRecords(*this, MSG_VAULTSTATES, pindex, states, auctions);
+}
+
+bool CZMQPublishOraclePricesNotifier::NotifyCustomChanges(const CBlockIndex *pindex, const CCustomChanges &changes)
+{
+    auto prices = DecodeRecords<COracleView::FixedIntervalPriceKey, CTokenCurrencyPair, CFixedIntervalPrice>(changes.state);
+    return prices.empty() || SendBlockRecords(*this, MSG_ORACLEPRICES, pindex, prices);
+}
+
+bool CZMQPublishFutureSwapsNotifier::NotifyCustomChanges(const CBlockIndex *pindex, const CCustomChanges &changes)
+{
+    auto settlements = DecodeRecords<CAccountsHistoryView::ByAccountHistoryKey, AccountHistoryKey, AccountHistoryValue>(changes.history->accounts);
+    settlements.erase(std::remove_if(settlements.begin(), settlements.end(), [](const auto& record) {
+        const auto category = CustomTxType(record.second.category);
+        return category != CustomTxType::FutureSwapExecution && category != CustomTxType::FutureSwapRefund;
+    }), settlements.end());
+    return settlements.empty() || SendBlockRecords(*this, MSG_FUTURESWAPS, pindex, settlements);
+}
+
+bool CZMQPublishDeFiUndoNotifier::NotifyBlockDisconnected(const CBlockIndex *pindex)
+{
+    return SendBlockRecords(*this, MSG_DEFIUNDO, pindex);
+}
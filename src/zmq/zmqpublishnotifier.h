@@ -52,4 +52,40 @@ public:
     bool NotifyTransaction(const CTransaction &transaction) override;
 };
 
+class CZMQPublishAccountDiffsNotifier : public CZMQAbstractPublishNotifier
+{
+public:
+    bool NotifyCustomChanges(const CBlockIndex *pindex, const CCustomChanges &changes) override;
+};
+
+class CZMQPublishPoolReservesNotifier : public CZMQAbstractPublishNotifier
+{
+public:
+    bool NotifyCustomChanges(const CBlockIndex *pindex, const CCustomChanges &changes) override;
+};
+
+class CZMQPublishVaultStatesNotifier : public CZMQAbstractPublishNotifier
+{
+public:
+    bool NotifyCustomChanges(const CBlockIndex *pindex, const CCustomChanges &changes) override;
+};
+
+class CZMQPublishOraclePricesNotifier : public CZMQAbstractPublishNotifier
+{
+public:
+    bool NotifyCustomChanges(const CBlockIndex *pindex, const CCustomChanges &changes) override;
+};
+
+class CZMQPublishFutureSwapsNotifier : public CZMQAbstractPublishNotifier
+{
+public:
+    bool NotifyCustomChanges(const CBlockIndex *pindex, const CCustomChanges &changes) override;
+};
+
+class CZMQPublishDeFiUndoNotifier : public CZMQAbstractPublishNotifier
+{
+public:
+    bool NotifyBlockDisconnected(const CBlockIndex *pindex) override;
+};
+
 #endif // DEFI_ZMQ_ZMQPUBLISHNOTIFIER_H
@@ -827,6 +827,28 @@ class ICXOrderbookTest (DefiTestFramework):
         self.nodes[0].generate(1)
         self.sync_blocks()
 
+        # Open orders of a pair are listed by direction, the best price first
+        orderTxCheap = self.nodes[0].icx_createorder({
+                                    'tokenFrom': idDFI,
+                                    'chainTo': "BTC",
+                                    'ownerAddress': accountDFI,
+                                    'receivePubkey': '037f9563f30c609b19fd435a19b8bde7d6db703012ba1aba72e9f42a87366d1941',
+                                    'amountFrom': 1,
+                                    'orderPrice':0.005})["txid"]
+
+        self.nodes[0].generate(1)
+        self.sync_blocks()
+
+        orders = self.nodes[0].icx_listorders({"token": symbolDFI, "chain": "BTC"})
+        assert_equal([tx for tx in orders if tx in [orderTxDFI, orderTxCheap, orderTxBTC]], [orderTxCheap, orderTxDFI, orderTxBTC])
+
+        self.nodes[0].icx_closeorder(orderTxCheap)
+        self.nodes[0].generate(1)
+        self.sync_blocks()
+
+        orders = self.nodes[0].icx_listorders({"token": symbolDFI, "chain": "BTC"})
+        assert(orderTxCheap not in orders)
+
         beforeOffer = self.nodes[1].getaccount(accountBTC, {}, True)[idDFI]
 
         offerTx = self.nodes[1].icx_makeoffer({
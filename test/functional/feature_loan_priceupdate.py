@@ -9,7 +9,7 @@ from test_framework.authproxy import JSONRPCException
 from test_framework.test_framework import DefiTestFramework
 from decimal import Decimal
 
-from test_framework.util import assert_equal
+from test_framework.util import assert_equal, assert_raises_rpc_error
 
 import calendar
 import time
@@ -19,7 +19,7 @@ class PriceUpdateTest (DefiTestFramework):
         self.num_nodes = 1
         self.setup_clean_chain = True
         self.extra_args = [
-                ['-txnotokens=0', '-amkheight=1', '-bayfrontheight=1', '-eunosheight=1', '-txindex=1', '-fortcanningheight=1']
+                ['-txnotokens=0', '-amkheight=1', '-bayfrontheight=1', '-eunosheight=1', '-txindex=1', '-fortcanningheight=1', '-oracleindex=1']
             ]
 
     def run_test(self):
@@ -297,6 +297,27 @@ class PriceUpdateTest (DefiTestFramework):
         assert_equal(fixedPrice['nextPriceBlock'], 354)
         assert_equal(fixedPrice['activePriceBlock'], 348)
 
+        # Price history keeps the transitions and the submissions
+        fixedPrice = self.nodes[0].getfixedintervalpriceat("TSLA/USD", 347)
+        assert_equal(fixedPrice['blockHeight'], 342)
+        assert_equal(fixedPrice['activePrice'], Decimal('22.50000000'))
+        assert_equal(fixedPrice['nextPrice'], Decimal('57.50000000'))
+        fixedPrice = self.nodes[0].getfixedintervalpriceat("TSLA/USD", 348)
+        assert_equal(fixedPrice['blockHeight'], 348)
+        assert_equal(fixedPrice['activePrice'], Decimal('57.50000000'))
+        assert_raises_rpc_error(-5, "No fixed interval price for TSLA/USD at height 1", self.nodes[0].getfixedintervalpriceat, "TSLA/USD", 1)
+
+        history = self.nodes[0].listfixedintervalpricehistory("TSLA/USD", {"maxBlockHeight": 348, "depth": 6})
+        assert_equal(history[0]['blockHeight'], 348)
+        assert_equal(history[-1]['blockHeight'], 342)
+        assert_equal(self.nodes[0].listfixedintervalpricehistory("TSLA/USD", {"limit": 1})[0]['blockHeight'], 348)
+
+        submissions = self.nodes[0].listoraclepricehistory("TSLA/USD", {"oracleid": oracle_id1, "limit": 1})
+        assert_equal(len(submissions), 1)
+        assert_equal(submissions[0]['blockHeight'], 341)
+        assert_equal(submissions[0]['rawprice'], Decimal('100.00000000'))
+        assert_equal(submissions[0]['oracleid'], oracle_id1)
+
         fixedPriceList = self.nodes[0].listfixedintervalprices()
         assert_equal(len(fixedPriceList), 3)
 
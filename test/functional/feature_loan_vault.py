@@ -595,6 +595,28 @@ class VaultTest (DefiTestFramework):
         assert("Vault does not have enough collateralization ratio defined by loan scheme - 176 < 200" in errorString)
         self.nodes[0].generate(1)
 
+    def listvaults_ratio_filtering(self):
+        ratio = self.nodes[0].getvault(self.vaults[1])['collateralRatio']
+        list_vault = self.nodes[0].listvaults({"minRatio": ratio - 1, "maxRatio": ratio + 1})
+        assert_equal([vault['vaultId'] for vault in list_vault], [self.vaults[1]])
+
+        list_vault = self.nodes[0].listvaults({"maxRatio": ratio - 1})
+        assert(self.vaults[1] not in [vault['vaultId'] for vault in list_vault])
+
+        # vaults under liquidation have no ratio and are listed by ratio, lowest first
+        list_vault = self.nodes[0].listvaults({"minRatio": 0, "verbose": True})
+        vault_ids = [vault['vaultId'] for vault in list_vault]
+        assert(self.vaults[0] not in vault_ids)
+        assert(self.vaults[1] in vault_ids)
+        ratios = [vault['collateralRatio'] for vault in list_vault if vault['collateralRatio'] >= 0]
+        assert_equal(ratios, sorted(ratios))
+
+        list_vault = self.nodes[0].listvaults({"minRatio": 0}, {"start": self.vaults[1], "including_start": True, "limit": 1})
+        assert_equal([vault['vaultId'] for vault in list_vault], [self.vaults[1]])
+
+        assert_raises_rpc_error(-8, "start vault has no collateralization ratio", self.nodes[0].listvaults, {"minRatio": 0}, {"start": self.vaults[0]})
+        assert_raises_rpc_error(-8, "minRatio out of range", self.nodes[0].listvaults, {"minRatio": -1})
+
     def closevault_with_active_loans(self):
         try:
             self.nodes[0].closevault(self.vaults[1], self.owner_addresses[1])
@@ -1074,6 +1096,7 @@ class VaultTest (DefiTestFramework):
         self.vault_enter_liquidation_updating_oracle()
         self.listvaults_state_filtering()
         self.updatevault_to_scheme_with_lower_collateralization_ratio()
+        self.listvaults_ratio_filtering()
         self.closevault_with_active_loans()
         self.test_closevault()
         self.estimatevault_with_invalid_params()
@@ -8,6 +8,7 @@ import os
 
 from test_framework.test_framework import DefiTestFramework
 from test_framework.test_node import ErrorMatch
+from test_framework.util import assert_equal
 
 
 class LoggingTest(DefiTestFramework):
@@ -70,6 +71,19 @@ class LoggingTest(DefiTestFramework):
         self.stop_node(0)
         self.start_node(0, ["-debuglogfile=%s" % os.devnull])
 
+        # check that the debug output thread writes the messages
+        self.restart_node(0, ["-logasync", "-debug=rpc"])
+        stats = self.nodes[0].getlogstats()
+        assert_equal(stats["async"], True)
+        assert_equal(stats["capacity"], 65536)
+        with self.nodes[0].assert_debug_log(["getlogstats"]):
+            self.nodes[0].getlogstats()
+        assert self.nodes[0].getlogstats()["written"] > stats["written"]
+        self.stop_node(0)
+        self.nodes[0].assert_start_raises_init_error(["-logasync", "-logasyncbuffer=0"], "Error: Invalid -logasyncbuffer=0, it has to be positive")
+        self.start_node(0)
+        assert_equal(self.nodes[0].getlogstats()["async"], False)
+
 
 if __name__ == '__main__':
     LoggingTest().main()
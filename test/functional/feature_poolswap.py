@@ -29,7 +29,7 @@ class PoolPairTest (DefiTestFramework):
         # node2: Non Foundation
         self.setup_clean_chain = True
         self.extra_args = [
-            ['-txnotokens=0', '-amkheight=50', '-bayfrontheight=50', '-bayfrontgardensheight=0', '-dakotaheight=160', '-fortcanningheight=163', '-fortcanninghillheight=170', '-fortcanningroadheight=177', '-acindex=1'],
+            ['-txnotokens=0', '-amkheight=50', '-bayfrontheight=50', '-bayfrontgardensheight=0', '-dakotaheight=160', '-fortcanningheight=163', '-fortcanninghillheight=170', '-fortcanningroadheight=177', '-acindex=1', '-poolindex=1'],
             ['-txnotokens=0', '-amkheight=50', '-bayfrontheight=50', '-bayfrontgardensheight=0', '-dakotaheight=160', '-fortcanningheight=163', '-fortcanninghillheight=170', '-fortcanningroadheight=177', '-acindex=1'],
             ['-txnotokens=0', '-amkheight=50', '-bayfrontheight=50', '-bayfrontgardensheight=0', '-dakotaheight=160', '-fortcanningheight=163', '-fortcanninghillheight=170', '-fortcanningroadheight=177'],
             ['-txnotokens=0', '-amkheight=50', '-bayfrontheight=50', '-bayfrontgardensheight=0', '-dakotaheight=160', '-fortcanningheight=163', '-fortcanninghillheight=170', '-fortcanningroadheight=177']]
@@ -216,6 +216,24 @@ class PoolPairTest (DefiTestFramework):
         assert_equal(str(silverCheckN1), "500.50000000")
         assert_equal(list_pool['1']['reserveB'], 1009) #1010 - 1 (commission)
 
+        # Pool history keeps the swap
+        candles = self.nodes[0].getpoolcandles(idGS, {"interval": 1000000000})
+        assert_equal(len(candles), 1)
+        assert_equal(candles[0]['swaps'], 1)
+        assert_equal(candles[0]['volumeB'], 10)
+        assert_equal(candles[0]['commissionB'], 1)
+        assert_equal(candles[0]['reserveA'], list_pool['1']['reserveA'])
+        assert_equal(candles[0]['reserveB'], list_pool['1']['reserveB'])
+        assert_equal(candles[0]['close'], list_pool['1']['reserveB/reserveA'])
+        assert(candles[0]['low'] <= candles[0]['close'] <= candles[0]['high'])
+        assert_equal(candles[0]['endHeight'], self.nodes[0].getblockcount())
+        assert_equal(self.nodes[0].getpoolcandles(idGS, {"startHeight": candles[0]['endHeight'] + 1}), [])
+        assert_equal(self.nodes[0].getpoolcandles(idGS, {"interval": 1000000000, "limit": 0}), candles)
+        times = [candle['time'] for candle in self.nodes[0].getpoolcandles(idGS, {"interval": 1, "limit": 0})]
+        assert_equal(times, sorted(set(times)))
+        assert_raises_rpc_error(-5, "Pool not found", self.nodes[0].getpoolcandles, "NOPOOL")
+        assert_raises_rpc_error(-32600, "-poolindex is needed for pool history", self.nodes[2].getpoolcandles, idGS)
+
         # 9 Fail swap: price higher than indicated
         price = list_pool['1']['reserveA/reserveB']
         try:
@@ -7,10 +7,11 @@
 - Start a single node and generate 3 blocks.
 - Stop the node and restart it with -reindex. Verify that the node has reindexed up to block 3.
 - Stop the node and restart it with -reindex-chainstate. Verify that the node has reindexed up to block 3.
+- Blocks are read ahead of connecting them, unless -blockprefetch=0.
 """
 
 from test_framework.test_framework import DefiTestFramework
-from test_framework.util import wait_until
+from test_framework.util import assert_equal, wait_until
 
 class ReindexTest(DefiTestFramework):
 
@@ -18,19 +19,25 @@ class ReindexTest(DefiTestFramework):
         self.setup_clean_chain = True
         self.num_nodes = 1
 
-    def reindex(self, justchainstate=False):
+    def reindex(self, justchainstate=False, prefetch=2):
         self.nodes[0].generate(3)
         blockcount = self.nodes[0].getblockcount()
         self.stop_nodes()
-        extra_args = [["-reindex-chainstate" if justchainstate else "-reindex"]]
+        extra_args = [["-reindex-chainstate" if justchainstate else "-reindex", "-blockprefetch={}".format(prefetch)]]
         self.start_nodes(extra_args)
         wait_until(lambda: self.nodes[0].getblockcount() == blockcount)
+        stats = self.nodes[0].getblockprefetchstats()
+        assert_equal(stats["threads"], prefetch)
+        if prefetch:
+            assert(stats["hits"] + stats["waits"] > 0)
+        else:
+            assert_equal(stats["hits"] + stats["waits"] + stats["misses"], 0)
         self.log.info("Success")
 
     def run_test(self):
         self.reindex(False)
         self.reindex(True)
-        self.reindex(False)
+        self.reindex(False, prefetch=0)
         self.reindex(True)
 
 if __name__ == '__main__':
@@ -10,6 +10,7 @@ import time
 from test_framework.test_framework import DefiTestFramework
 from test_framework.util import (
     assert_equal,
+    connect_nodes,
 )
 from test_framework.authproxy import JSONRPCException
 
@@ -19,7 +20,7 @@ class RPCstats(DefiTestFramework):
         self.setup_clean_chain = True
         self.extra_args = [
             ['-acindex=1', '-txnotokens=0', '-amkheight=50', '-bayfrontheight=50', '-bayfrontgardensheight=50'],
-            ['-acindex=1', '-txnotokens=0', '-amkheight=50', '-bayfrontheight=50', '-bayfrontgardensheight=50', '-rpcstats=0'],
+            ['-acindex=1', '-txnotokens=0', '-amkheight=50', '-bayfrontheight=50', '-bayfrontgardensheight=50', '-rpcstats=0', '-connectstats=0', '-dboption=history.bloombits=12'],
         ]
 
     def run_test(self):
@@ -51,6 +52,15 @@ class RPCstats(DefiTestFramework):
         assert(historyEntry1 not in getrpcstats["history"])
         assert_equal(getrpcstats["history"][0], historyEntry2)
 
+        # latency distribution, lock wait and worker threads
+        assert_equal(sum(getrpcstats["histogram"]), 6)
+        assert(getrpcstats["percentiles"]["p50"] <= getrpcstats["percentiles"]["p90"] <= getrpcstats["percentiles"]["p99"])
+        assert(getrpcstats["lockWait"]["total"] >= 0)
+        assert(getrpcstats["execution"]["total"] > 0)
+        assert_equal(getrpcstats["inFlight"], 0)
+        assert(getrpcstats["maxInFlight"] >= 1)
+        assert_equal(sum(thread["count"] for thread in getrpcstats["threads"].values()), 6)
+
         try:
             self.nodes[0].getrpcstats("WRONGCMD")
         except JSONRPCException as e:
@@ -69,5 +79,87 @@ class RPCstats(DefiTestFramework):
             errorString = e.error['message']
         assert("Rpcstats is desactivated." in errorString)
 
+        # block connect stats
+        blocks = self.nodes[0].getblockconnectstats()
+        assert_equal(len(blocks), 10)
+        assert_equal(blocks[0]["height"], 101)
+        assert_equal(blocks[0]["hash"], self.nodes[0].getblockhash(101))
+        assert("transactions" in blocks[0]["phases"])
+        assert("rewards" in blocks[0]["phases"])
+
+        blocks = self.nodes[0].getblockconnectstats({"minHeight": 50, "maxHeight": 59, "limit": 0})
+        assert_equal(sorted(block["height"] for block in blocks), list(range(50, 60)))
+
+        blocks = self.nodes[0].getblockconnectstats({"slowest": True, "limit": 3})
+        assert_equal(len(blocks), 3)
+        assert(blocks[0]["time"] >= blocks[1]["time"] >= blocks[2]["time"])
+
+        try:
+            self.nodes[1].getblockconnectstats()
+        except JSONRPCException as e:
+            errorString = e.error['message']
+        assert("Block connect stats are disabled" in errorString)
+
+        # database stats, history databases are tuned by their defaults and -dboption
+        dbs = {db["name"]: db for db in self.nodes[0].getdbstats()}
+        assert("enhancedcs" in dbs and "history" in dbs and "chainstate" in dbs)
+        assert_equal(dbs["history"]["options"]["compression"], True)
+        assert_equal(dbs["history"]["options"]["bloomBits"], 10)
+        assert_equal(dbs["enhancedcs"]["options"]["compression"], False)
+        assert(dbs["enhancedcs"]["options"]["blockCache"] > dbs["history"]["options"]["blockCache"])
+        assert(len(dbs["enhancedcs"]["stats"]) > 0)
+
+        db = self.nodes[1].getdbstats("history")
+        assert_equal(len(db), 1)
+        assert_equal(db[0]["options"]["bloomBits"], 12)
+
+        try:
+            self.nodes[0].getdbstats("unknown")
+        except JSONRPCException as e:
+            errorString = e.error['message']
+        assert("Database unknown is not open" in errorString)
+
+        # undo of the custom state lives in enhancedcs_undo, switching it off and on moves it
+        assert("enhancedcs_undo" in dbs)
+        tip = self.nodes[0].getbestblockhash()
+        for undodb in [0, 1]:
+            self.restart_node(0, self.extra_args[0] + ['-enhancedcsundodb={}'.format(undodb)])
+            names = [db["name"] for db in self.nodes[0].getdbstats()]
+            assert_equal("enhancedcs_undo" in names, undodb == 1)
+            self.nodes[0].invalidateblock(tip)
+            self.nodes[0].reconsiderblock(tip)
+            assert_equal(self.nodes[0].getbestblockhash(), tip)
+
+        # undo of the custom txs of a block is bundled, switching it off unpacks the bundles
+        address = self.nodes[0].getnewaddress("", "legacy")
+        self.nodes[0].utxostoaccount({address: "1@DFI"})
+        self.nodes[0].generate(1)
+        block = self.nodes[0].getbestblockhash()
+        self.nodes[0].generate(1)
+        tip = self.nodes[0].getbestblockhash()
+        for bundles in [1, 0]:
+            self.restart_node(0, self.extra_args[0] + ['-undobundles={}'.format(bundles)])
+            self.nodes[0].invalidateblock(block)
+            assert_equal(self.nodes[0].getaccount(address), [])
+            self.nodes[0].reconsiderblock(block)
+            assert_equal(self.nodes[0].getbestblockhash(), tip)
+            assert_equal(self.nodes[0].getaccount(address), ["1.00000000@DFI"])
+
+        # transactions of peers are validated on a thread of its own
+        connect_nodes(self.nodes[0], 1)
+        self.sync_blocks()
+        self.nodes[0].sendtoaddress(self.nodes[1].getnewaddress(), 1)
+        self.sync_mempools()
+        stats = self.nodes[1].gettxvalidationstats()
+        assert_equal(stats["active"], True)
+        assert_equal(stats["queued"], 0)
+        assert(stats["processed"] >= 1)
+        assert(stats["validationtime"]["max"] >= stats["validationtime"]["avg"] > 0)
+
+        self.restart_node(1, self.extra_args[1] + ['-txvalidationthread=0'])
+        stats = self.nodes[1].gettxvalidationstats()
+        assert_equal(stats["active"], False)
+        assert_equal(stats["processed"], 0)
+
 if __name__ == '__main__':
     RPCstats().main ()
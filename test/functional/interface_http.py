@@ -8,6 +8,7 @@ from test_framework.test_framework import DefiTestFramework
 from test_framework.util import assert_equal, str_to_b64str
 
 import http.client
+import json
 import urllib.parse
 
 class HTTPBasicsTest (DefiTestFramework):
@@ -103,6 +104,29 @@ class HTTPBasicsTest (DefiTestFramework):
         out1 = conn.getresponse()
         assert_equal(out1.status, http.client.BAD_REQUEST)
 
+        # Listing RPCs stream their results as a chunked reply
+        address = self.nodes[2].getnewaddress("", "legacy")
+        self.nodes[2].utxostoaccount({address: "1@DFI"})
+        self.nodes[2].generate(1)
+
+        conn = http.client.HTTPConnection(urlNode2.hostname, urlNode2.port)
+        conn.connect()
+        conn.request('POST', '/', '{"method": "listaccounts", "params": [{}, false], "id": 1}', headers)
+        out1 = conn.getresponse()
+        assert_equal(out1.status, http.client.OK)
+        assert_equal(out1.getheader('Transfer-Encoding'), 'chunked')
+        reply = json.loads(out1.read())
+        assert_equal(reply['error'], None)
+        assert_equal(reply['id'], 1)
+        assert_equal(reply['result'], self.nodes[2].listaccounts({}, False))
+        assert address in [account['owner'] for account in reply['result']]
+
+        # the connection stays usable after a streamed reply
+        conn.request('POST', '/', '{"method": "getbestblockhash"}', headers)
+        out1 = conn.getresponse().read()
+        assert b'"error":null' in out1
+        conn.close()
+
 
 if __name__ == '__main__':
     HTTPBasicsTest ().main ()
@@ -60,6 +60,24 @@ class RPCInterfaceTest(DefiTestFramework):
         assert_equal(result_by_id[3]['error'], None)
         assert result_by_id[3]['result'] is not None
 
+    def test_parallel_batch_request(self):
+        self.log.info("Testing JSON-RPC batch request order with parallel and serial calls...")
+
+        self.nodes[0].generate(10)
+        address = self.nodes[0].getnewaddress("", "legacy")
+        requests = [{"method": "getblockhash", "params": [i % 11], "id": i} for i in range(40)]
+        # write calls split the batch and run in order
+        requests.insert(20, {"method": "setlabel", "params": [address, "batch"], "id": 100})
+        requests.append({"method": "getaddressesbylabel", "params": ["batch"], "id": 101})
+        results = self.nodes[0].batch(requests)
+
+        assert_equal([res["id"] for res in results], [req["id"] for req in requests])
+        for res in results[:20] + results[21:-1]:
+            assert_equal(res['error'], None)
+            assert_equal(res['result'], self.nodes[0].getblockhash(res["id"] % 11))
+        assert_equal(results[20]['error'], None)
+        assert address in results[-1]['result']
+
     def test_http_status_codes(self):
         self.log.info("Testing HTTP status codes for JSON-RPC requests...")
 
@@ -70,6 +88,7 @@ class RPCInterfaceTest(DefiTestFramework):
         self.test_getrpcinfo()
         self.test_batch_request()
         self.test_http_status_codes()
+        self.test_parallel_batch_request()
 
 
 if __name__ == '__main__':
@@ -48,6 +48,7 @@ class ZMQTest (DefiTestFramework):
         try:
             self.test_basic()
             self.test_reorg()
+            self.test_defi_changes()
         finally:
             # Destroy the ZMQ context.
             self.log.debug("Destroying ZMQ context")
@@ -151,5 +152,39 @@ class ZMQTest (DefiTestFramework):
         # Should receive nodes[1] tip
         assert_equal(self.nodes[1].getbestblockhash(), hashblock.receive().hex())
 
+    def test_defi_changes(self):
+        import zmq
+        address = 'tcp://127.0.0.1:28556'
+        socket = self.ctx.socket(zmq.SUB)
+        socket.set(zmq.RCVTIMEO, 60000)
+        accountdiffs = ZMQSubscriber(socket, b'accountdiffs')
+        defiundo = ZMQSubscriber(socket, b'defiundo')
+
+        self.restart_node(0, ['-txnotokens=0', '-amkheight=50'] + ['-zmqpub%s=%s' % (sub.topic.decode(), address) for sub in [accountdiffs, defiundo]])
+        socket.connect(address)
+        # Relax so that the subscriber is ready before publishing zmq messages
+        sleep(0.2)
+
+        if not self.is_wallet_compiled():
+            return
+
+        self.log.info("Balance diffs are published with their block")
+        owner = self.nodes[0].getnewaddress("", "legacy")
+        self.nodes[0].utxostoaccount({owner: "1@DFI"})
+        blockhash = self.nodes[0].generate(nblocks=1, address=ADDRESS_BCRT1_UNSPENDABLE)[0]
+        height = self.nodes[0].getblockcount()
+
+        body = accountdiffs.receive()
+        assert_equal(body[:32][::-1].hex(), blockhash)
+        assert_equal(struct.unpack('<I', body[32:36])[0], height)
+        assert len(body) > 36
+
+        self.log.info("Reverted blocks are published to the undo topic")
+        self.nodes[0].invalidateblock(blockhash)
+        body = defiundo.receive()
+        assert_equal(body[:32][::-1].hex(), blockhash)
+        assert_equal(struct.unpack('<I', body[32:36])[0], height)
+        self.nodes[0].reconsiderblock(blockhash)
+
 if __name__ == '__main__':
     ZMQTest().main()
@@ -8,7 +8,8 @@
 from test_framework.test_framework import DefiTestFramework
 
 from test_framework.util import (
-    assert_equal
+    assert_equal,
+    assert_raises_rpc_error,
 )
 
 class TokensRPCGetAccountHistory(DefiTestFramework):
@@ -17,7 +18,7 @@ class TokensRPCGetAccountHistory(DefiTestFramework):
         self.setup_clean_chain = True
         self.extra_args = [
             ['-acindex=1', '-txnotokens=0', '-amkheight=50', '-bayfrontheight=50', '-bayfrontgardensheight=50'],
-            ['-acindex=1', '-txnotokens=0', '-amkheight=50', '-bayfrontheight=50', '-bayfrontgardensheight=50'],
+            ['-acindex=1', '-txnotokens=0', '-amkheight=50', '-bayfrontheight=50', '-bayfrontgardensheight=50', '-acbalancecheckpointentries=1'],
             ['-acindex=1', '-txnotokens=0', '-amkheight=50', '-bayfrontheight=50', '-bayfrontgardensheight=50'],
         ]
 
@@ -78,5 +79,17 @@ class TokensRPCGetAccountHistory(DefiTestFramework):
         assert_equal(history['txn'], expected['txn'])
         assert_equal(history['type'], expected['type'])
 
+        # Balances at a height come from the account history, node 1 checkpoints every entry
+        mint_height = self.nodes[0].getblockcount()
+        self.nodes[0].minttokens(["200@" + token_a])
+        self.nodes[0].generate(1)
+        self.sync_blocks([self.nodes[0], self.nodes[1]])
+        for node in self.nodes[0:2]:
+            assert_equal(node.getaccount(collateral_a, {}, True, mint_height - 1), {})
+            assert_equal(node.getaccount(collateral_a, {}, True, mint_height), {token_a: 300})
+            assert_equal(node.getaccount(collateral_a, {}, True, mint_height + 1), {token_a: 500})
+            assert_equal(node.getaccount(collateral_a, {}, True, mint_height + 1), node.getaccount(collateral_a, {}, True))
+            assert_raises_rpc_error(-8, "Block height out of range", node.getaccount, collateral_a, {}, True, mint_height + 2)
+
 if __name__ == '__main__':
     TokensRPCGetAccountHistory().main ()
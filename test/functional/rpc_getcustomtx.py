@@ -8,7 +8,7 @@
 from test_framework.test_framework import DefiTestFramework
 
 from test_framework.authproxy import JSONRPCException
-from test_framework.util import assert_equal, disconnect_nodes
+from test_framework.util import assert_equal, assert_raises_rpc_error, disconnect_nodes
 from decimal import Decimal
 import calendar
 import time
@@ -18,7 +18,7 @@ class TokensRPCGetCustomTX(DefiTestFramework):
         self.num_nodes = 3
         self.setup_clean_chain = True
         self.extra_args = [['-txnotokens=0', '-amkheight=50', '-bayfrontheight=50', '-bayfrontgardensheight=50', '-dakotaheight=120', '-eunosheight=120', '-eunospayaheight=120', '-fortcanningheight=120', '-fortcanninghillheight=122'], # Wallet TXs
-                           ['-txnotokens=0', '-amkheight=50', '-bayfrontheight=50', '-bayfrontgardensheight=50', '-dakotaheight=120', '-eunosheight=120', '-eunospayaheight=120', '-fortcanningheight=120', '-fortcanninghillheight=122', '-txindex=1'], # Transaction index
+                           ['-txnotokens=0', '-amkheight=50', '-bayfrontheight=50', '-bayfrontgardensheight=50', '-dakotaheight=120', '-eunosheight=120', '-eunospayaheight=120', '-fortcanningheight=120', '-fortcanninghillheight=122', '-txindex=1', '-customtxindex=1'], # Transaction index
                            ['-txnotokens=0', '-amkheight=50', '-bayfrontheight=50', '-bayfrontgardensheight=50', '-dakotaheight=120', '-eunosheight=120', '-fortcanningheight=120', '-fortcanninghillheight=122']] # Will not find historical TXs
 
     def check_result(self, result):
@@ -63,6 +63,18 @@ class TokensRPCGetCustomTX(DefiTestFramework):
         assert_equal(result['results']['tradeable'], True)
         assert_equal(result['results']['finalized'], False)
 
+        # Custom transaction index lists the creation by type
+        self.nodes[1].syncwithvalidationinterfacequeue()
+        listed = self.nodes[1].listcustomtxs("CreateToken", {"minHeight": 102})
+        assert_equal(len(listed), 1)
+        assert_equal(listed[0]['txid'], create_token_tx)
+        assert_equal(listed[0]['blockHeight'], 102)
+        assert_equal(listed[0]['valid'], True)
+        assert_equal(self.nodes[1].listcustomtxs("CreateToken", {"start": create_token_tx}), [])
+        assert_equal(self.nodes[1].listcustomtxs("CreateToken", {"start": create_token_tx, "including_start": True})[0]['txid'], create_token_tx)
+        assert_equal(self.nodes[1].isappliedcustomtx(create_token_tx, 102), True)
+        assert_raises_rpc_error(-1, "Custom transaction index is not enabled", self.nodes[0].listcustomtxs, "CreateToken")
+
         # Get token ID
         list_tokens = self.nodes[0].listtokens()
         for idx, token in list_tokens.items():
@@ -141,6 +141,7 @@ class MasternodesRpcBasicTest (DefiTestFramework):
         # resignTx is removed for a block
         assert_equal(self.nodes[0].getrawmempool(), [fundingTx])
         assert_equal(self.nodes[0].listmasternodes()[idnode0]['state'], "ENABLED")
+        assert_equal(self.nodes[0].getmininginfo()['activemasternodes'], 9)
 
         # Revert creation!
         self.start_node(2)
@@ -150,6 +151,7 @@ class MasternodesRpcBasicTest (DefiTestFramework):
         self.sync_blocks(self.nodes[0:3])
 
         assert_equal(len(self.nodes[0].listmasternodes()), 8)
+        assert_equal(self.nodes[0].getmininginfo()['activemasternodes'], 8)
         mempool = self.nodes[0].getrawmempool()
         assert_equal(len(mempool), 1) # auto auth
 